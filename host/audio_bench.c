@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Streams a clip bank through audio_clip.c in DMA-buffer sized chunks, as
+ * the device does, and prints the decode cost per sample and the error
+ * against the source. Without arguments it codes a synthetic clip (the
+ * encoder below follows tools/gen_audio_bank.py); with a bank image from
+ * that tool it plays every clip in it.
+ *
+ *   audio_bench [audio.bin]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "audio_clip.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#endif
+
+#define BENCH_RATE          16000
+#define BENCH_SECONDS       4
+#define BENCH_SAMPLES       (BENCH_RATE * BENCH_SECONDS)
+#define BENCH_DMA_FRAMES    240     /* AUDIO_DMA_FRAMES of audio_player.c */
+#define BENCH_PASSES        50
+
+static const int16_t s_steps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static double host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v & 0xffff);
+    put16(p + 2, v >> 16);
+}
+
+/* a theremin-like sweep with tremolo and a little noise */
+static void bench_source(int16_t *pcm, size_t n)
+{
+    double phase = 0;
+    uint32_t noise = 1;
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / BENCH_RATE;
+        phase += 2 * M_PI * (300 + 200 * sin(2 * M_PI * 0.5 * t)) / BENCH_RATE;
+        noise = noise * 1103515245u + 12345u;
+        double v = 0.6 * sin(phase) * (0.7 + 0.3 * sin(2 * M_PI * 6 * t)) + 0.02 * ((int32_t)(noise >> 16) - 32768) / 32768.0;
+        pcm[i] = (int16_t)(v * 32767);
+    }
+}
+
+/* one-clip bank in the layout of audio_clip.h */
+static uint8_t *bench_encode(const int16_t *pcm, size_t n, size_t *size)
+{
+    const size_t head = AUDIO_CLIP_HEADER_BYTES + AUDIO_CLIP_DIR_ENTRY_BYTES;
+    size_t blocks = (n + AUDIO_CLIP_BLOCK_SAMPLES - 1) / AUDIO_CLIP_BLOCK_SAMPLES;
+    uint8_t *bank = calloc(1, head + blocks * AUDIO_CLIP_BLOCK_BYTES);
+    put32(bank, AUDIO_CLIP_MAGIC);
+    put16(bank + 4, AUDIO_CLIP_VERSION);
+    put16(bank + 6, 1);
+    put32(bank + 8, BENCH_RATE);
+    put32(bank + 12, head);
+    put32(bank + 16, n);
+
+    uint8_t *p = bank + head;
+    int index = 0;
+    for (size_t start = 0; start < n; start += AUDIO_CLIP_BLOCK_SAMPLES) {
+        size_t len = n - start < AUDIO_CLIP_BLOCK_SAMPLES ? n - start : AUDIO_CLIP_BLOCK_SAMPLES;
+        int32_t predictor = pcm[start];
+        put16(p, (uint16_t)predictor);
+        p[2] = index;
+        p += AUDIO_CLIP_BLOCK_HEADER;
+        for (size_t i = 0; i < len; i++) {
+            /* quantize, then track what the decoder will reconstruct */
+            int32_t step = s_steps[index];
+            int32_t diff = pcm[start + i] - predictor;
+            uint8_t code = 0;
+            if (diff < 0) {
+                code = 8;
+                diff = -diff;
+            }
+            if (diff >= step) {
+                code |= 4;
+                diff -= step;
+            }
+            if (diff >= step >> 1) {
+                code |= 2;
+                diff -= step >> 1;
+            }
+            if (diff >= step >> 2)
+                code |= 1;
+            audio_adpcm_t state = { .predictor = (int16_t)predictor, .index = (uint8_t)index };
+            int16_t out;
+            audio_adpcm_decode(&state, &code, 0, 1, AUDIO_CLIP_GAIN_UNITY, &out);
+            predictor = state.predictor;
+            index = state.index;
+            p[i >> 1] |= code << ((i & 1) * 4);
+        }
+        p += (len + 1) / 2;
+    }
+    *size = p - bank;
+    return bank;
+}
+
+static uint8_t *bench_load(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(*size);
+    if (fread(data, 1, *size, f) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+/* decode a clip the way the I2S interrupt does, BENCH_PASSES times */
+static void bench_clip(const audio_bank_t *bank, uint16_t clip, const int16_t *source)
+{
+    uint32_t samples = audio_bank_clip_samples(bank, clip);
+    int16_t *out = malloc((samples + BENCH_DMA_FRAMES) * sizeof(int16_t));
+    audio_stream_t stream;
+    double ns = 0;
+#ifdef BENCH_CYCLES
+    uint64_t cycles = 0;
+#endif
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        audio_stream_start(&stream, bank, clip, false);
+        size_t pos = 0;
+        double t0 = host_ns();
+#ifdef BENCH_CYCLES
+        uint64_t c0 = BENCH_CYCLES();
+#endif
+        while (!audio_stream_done(&stream))
+            pos += audio_stream_fill(&stream, out + pos, BENCH_DMA_FRAMES);
+#ifdef BENCH_CYCLES
+        cycles += BENCH_CYCLES() - c0;
+#endif
+        ns += host_ns() - t0;
+    }
+
+    size_t bytes = samples / AUDIO_CLIP_BLOCK_SAMPLES * AUDIO_CLIP_BLOCK_BYTES;
+    if (samples % AUDIO_CLIP_BLOCK_SAMPLES)
+        bytes += AUDIO_CLIP_BLOCK_HEADER + (samples % AUDIO_CLIP_BLOCK_SAMPLES + 1) / 2;
+    printf("clip %u: %6.2f s, %6.1f kB flash (%.2f bit/sample)  %5.2f ns/sample", clip,
+           (double)samples / bank->sample_rate, bytes / 1024.0, samples ? 8.0 * bytes / samples : 0,
+           samples ? ns / BENCH_PASSES / samples : 0);
+#ifdef BENCH_CYCLES
+    printf("  %5.1f host cycles/sample", samples ? (double)cycles / BENCH_PASSES / samples : 0);
+#endif
+    if (source) {
+        double sig = 0, err = 0;
+        for (uint32_t i = 0; i < samples; i++) {
+            sig += (double)source[i] * source[i];
+            err += (double)(source[i] - out[i]) * (source[i] - out[i]);
+        }
+        printf("  SNR %.1f dB", err > 0 ? 10 * log10(sig / err) : 99.0);
+    }
+    printf("\n");
+    free(out);
+}
+
+int main(int argc, char **argv)
+{
+    size_t size;
+    uint8_t *image;
+    int16_t *source = NULL;
+
+    if (argc > 1) {
+        image = bench_load(argv[1], &size);
+        if (!image) {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        source = malloc(BENCH_SAMPLES * sizeof(int16_t));
+        bench_source(source, BENCH_SAMPLES);
+        image = bench_encode(source, BENCH_SAMPLES, &size);
+    }
+
+    audio_bank_t bank;
+    if (!audio_bank_open(&bank, image, size)) {
+        fprintf(stderr, "not a valid clip bank\n");
+        return 1;
+    }
+    printf("audio bank: %u clip(s) at %u Hz, %zu bytes; %u interrupts/s with %d-sample DMA buffers\n",
+           bank.clip_count, (unsigned)bank.sample_rate, size, (unsigned)(bank.sample_rate / BENCH_DMA_FRAMES),
+           BENCH_DMA_FRAMES);
+    for (uint16_t i = 0; i < bank.clip_count; i++)
+        bench_clip(&bank, i, source);
+
+    free(source);
+    free(image);
+    return 0;
+}
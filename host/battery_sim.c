@@ -0,0 +1,446 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Discrete-event battery-life simulator. Plays a night's schedule of On/Off
+ * and level commands through a simulated sleepy end device: commands wait in
+ * the parent until the next poll, polls follow poll_scheduler.c (or a fixed
+ * keep-alive), writes go through light_coalesce.c into light_driver.c on the
+ * mock HAL. Everything runs on the mock clock.
+ *
+ *   battery_sim [--schedule file] [--hours h] [--capacity mAh] [--budget-ma mA]
+ *
+ * Schedule lines are "HH:MM[:SS] on|off|level <n>|slider <from> <to> <writes>",
+ * counted from 00:00 of the simulated day (25:30 is half past one the next
+ * night), '#' starts a comment. --budget-ma fails the run when the first (default
+ * firmware) configuration draws more than that on average.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sdkconfig.h"
+#include "light_driver.h"
+#include "light_hal_mock.h"
+#include "light_coalesce.h"
+#include "light_state.h"
+#include "poll_scheduler.h"
+
+#define SEC_US              1000000LL
+#define HOUR_US             (3600 * SEC_US)
+#define SCHEDULE_MAX        512
+#define SLIDER_WRITE_US     50000       /* CurrentLevel writes of a slider drag */
+#define POLLS_PER_STEP      4           /* POLL_BACKOFF_POLLS_PER_STEP */
+
+/**
+ * ESP32-C6 currents and radio timings, on top of light_hal_mock. The mock
+ * already charges the light sleep floor, LEDC, the LED and the CPU wakeup of
+ * every poll; these add the radio and the command handling.
+ */
+typedef struct {
+    double active_ma;       /* CPU running, radio off */
+    double tx_ma;           /* 802.15.4 TX at the maximum power the firmware sets */
+    double rx_ma;           /* 802.15.4 RX */
+    uint32_t poll_tx_us;    /* MAC data request */
+    uint32_t poll_rx_us;    /* MAC ack and the window for pending data */
+    uint32_t cmd_rx_us;     /* one ZCL command frame */
+    uint32_t cmd_tx_us;     /* APS ack plus ZCL default response */
+    uint32_t cmd_cpu_us;    /* stack and handler time of one command */
+} sim_model_t;
+
+#define SIM_MODEL_DEFAULT()     \
+    {                           \
+        .active_ma = 25.0,      \
+        .tx_ma = 150.0,         \
+        .rx_ma = 75.0,          \
+        .poll_tx_us = 800,      \
+        .poll_rx_us = 1500,     \
+        .cmd_rx_us = 1600,      \
+        .cmd_tx_us = 2200,      \
+        .cmd_cpu_us = 1500,     \
+    }
+
+/** firmware choices that do not need a separate light_driver.c build */
+typedef struct {
+    const char *name;
+    bool sleep;             /* CONFIG_HALLOWEEN_ENABLE_SLEEP */
+    bool adaptive_poll;     /* poll_scheduler.c, else a fixed keep-alive */
+    uint32_t keep_alive_ms; /* ED_KEEP_ALIVE, or the idle interval of the scheduler */
+} sim_config_t;
+
+static const sim_config_t s_configs[] = {
+    { "sleep, adaptive poll",   true,  true,  CONFIG_HALLOWEEN_POLL_IDLE_MS },
+    { "sleep, keep-alive 4 s",  true,  false, 4000 },
+    { "sleep, keep-alive 3 s",  true,  false, 3000 },
+    { "no sleep, adaptive",     false, true,  CONFIG_HALLOWEEN_POLL_IDLE_MS },
+};
+
+typedef enum {
+    CMD_ON,
+    CMD_OFF,
+    CMD_LEVEL,
+} sim_cmd_type_t;
+
+typedef struct {
+    int64_t time_us;
+    sim_cmd_type_t type;
+    uint8_t level;
+} sim_cmd_t;
+
+typedef struct {
+    double radio_uc;        /* radio and CPU charge of polls and commands */
+    uint32_t polls;
+    uint32_t commands;
+    int64_t latency_sum_us;
+    int64_t latency_max_us;
+} sim_counters_t;
+
+static const char *s_default_schedule[] = {
+    "18:00 on",
+    "18:00:01 level 200",
+    "19:30 slider 200 60 40",
+    "21:00 level 254",
+    "22:30 slider 254 30 30",
+    "23:30 off",
+};
+
+static sim_model_t s_model = SIM_MODEL_DEFAULT();
+static sim_cmd_t s_schedule[SCHEDULE_MAX];
+static size_t s_schedule_count;
+
+/* state of one run */
+static const sim_config_t *s_config;
+static sim_counters_t s_count;
+static int64_t s_start_us;          /* mock time of the schedule's 00:00 */
+static size_t s_next_cmd;           /* first command not yet delivered */
+static poll_scheduler_t s_poll;
+static light_hal_timer_t s_poll_timer;
+static light_hal_timer_t s_step_timer;
+static light_hal_timer_t s_coalesce_timer;
+
+static void sim_charge(double ma, uint32_t us)
+{
+    s_count.radio_uc += ma * us / 1000.0;
+}
+
+/********************* schedule **************************/
+
+static void schedule_add(int64_t time_us, sim_cmd_type_t type, uint8_t level)
+{
+    if (s_schedule_count == SCHEDULE_MAX) {
+        fprintf(stderr, "schedule too long, max %d commands\n", SCHEDULE_MAX);
+        exit(1);
+    }
+    s_schedule[s_schedule_count++] = (sim_cmd_t) { time_us, type, level };
+}
+
+static int schedule_cmp(const void *a, const void *b)
+{
+    const sim_cmd_t *x = a, *y = b;
+    return (x->time_us > y->time_us) - (x->time_us < y->time_us);
+}
+
+static bool schedule_parse_line(const char *line)
+{
+    unsigned h, m, s = 0, from, to, writes;
+    char what[16];
+    int n = 0;
+
+    if (sscanf(line, "%u:%u:%u %15s %n", &h, &m, &s, what, &n) < 4 &&
+            (s = 0, sscanf(line, "%u:%u %15s %n", &h, &m, what, &n) < 3)) {
+        return false;
+    }
+    int64_t t = ((int64_t)h * 3600 + m * 60 + s) * SEC_US;
+    const char *args = line + n;
+
+    if (!strcmp(what, "on")) {
+        schedule_add(t, CMD_ON, 0);
+    } else if (!strcmp(what, "off")) {
+        schedule_add(t, CMD_OFF, 0);
+    } else if (!strcmp(what, "level") && sscanf(args, "%u", &from) == 1 && from <= 255) {
+        schedule_add(t, CMD_LEVEL, (uint8_t)from);
+    } else if (!strcmp(what, "slider") && sscanf(args, "%u %u %u", &from, &to, &writes) == 3 && from <= 255 &&
+               to <= 255 && writes > 1) {
+        for (unsigned i = 0; i < writes; i++) {
+            int level = (int)from + ((int)to - (int)from) * (int)i / (int)(writes - 1);
+            schedule_add(t + i * SLIDER_WRITE_US, CMD_LEVEL, (uint8_t)level);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void schedule_load(const char *path)
+{
+    char line[256];
+    unsigned lineno = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (!schedule_parse_line(line)) {
+            fprintf(stderr, "%s:%u: cannot parse \"%s\"\n", path, lineno, strtok(line, "\r\n"));
+            exit(1);
+        }
+    }
+    fclose(f);
+}
+
+/********************* simulated device **************************/
+
+static void sim_set_level(uint8_t channel, uint8_t level)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    light_driver_set_brightness(channel, level);
+#endif
+}
+
+static void sim_coalesce_flush(void *arg)
+{
+    light_coalesce_flush();
+}
+
+static void sim_coalesce_schedule(uint32_t delay_ms)
+{
+    light_hal_timer_start_once(s_coalesce_timer, delay_ms * 1000ULL);
+}
+
+static uint32_t sim_poll_interval_ms(void)
+{
+    return s_config->adaptive_poll ? s_poll.interval_ms : s_config->keep_alive_ms;
+}
+
+/* esp_zb_zdo_pim_set_long_poll_interval(): the next poll is one new interval away */
+static void sim_poll_apply(void)
+{
+    light_hal_timer_start_once(s_poll_timer, sim_poll_interval_ms() * 1000ULL);
+}
+
+static void sim_poll_step(void *arg)
+{
+    uint32_t delay_ms = poll_scheduler_step(&s_poll);
+
+    sim_poll_apply();
+    if (delay_ms) {
+        light_hal_timer_start_once(s_step_timer, delay_ms * 1000ULL);
+    }
+}
+
+/* zb_poll_activity() */
+static void sim_poll_activity(void)
+{
+    if (!s_config->adaptive_poll) {
+        return;
+    }
+    bool was_fast = s_poll.interval_ms == s_poll.fast_ms;
+    uint32_t delay_ms = poll_scheduler_activity(&s_poll);
+
+    light_hal_timer_stop(s_step_timer);
+    if (!was_fast) {
+        sim_poll_apply();
+    }
+    light_hal_timer_start_once(s_step_timer, delay_ms * 1000ULL);
+}
+
+/* One frame from the parent's queue: its own data request, the frame, acks and the handler */
+static void sim_deliver(const sim_cmd_t *cmd, int64_t now_us)
+{
+    int64_t latency = now_us - cmd->time_us;
+
+    sim_charge(s_model.tx_ma, s_model.poll_tx_us + s_model.cmd_tx_us);
+    sim_charge(s_model.rx_ma, s_model.cmd_rx_us);
+    sim_charge(s_model.active_ma, s_model.cmd_cpu_us);
+    s_count.commands++;
+    s_count.latency_sum_us += latency;
+    if (latency > s_count.latency_max_us) {
+        s_count.latency_max_us = latency;
+    }
+
+    sim_poll_activity();
+    switch (cmd->type) {
+    case CMD_ON:
+    case CMD_OFF:
+        light_coalesce_power(0, cmd->type == CMD_ON);
+        break;
+    case CMD_LEVEL:
+        light_coalesce_level(0, cmd->level);
+        break;
+    }
+}
+
+static void sim_poll(void *arg)
+{
+    int64_t now = light_hal_time_us() - s_start_us;
+
+    sim_charge(s_model.tx_ma, s_model.poll_tx_us);
+    sim_charge(s_model.rx_ma, s_model.poll_rx_us);
+    s_count.polls++;
+    while (s_next_cmd < s_schedule_count && s_schedule[s_next_cmd].time_us <= now) {
+        sim_deliver(&s_schedule[s_next_cmd++], now);
+    }
+    light_hal_timer_start_once(s_poll_timer, sim_poll_interval_ms() * 1000ULL);
+}
+
+typedef struct {
+    double average_ma;
+    double light_ma;        /* sleep floor, LEDC and LED share of average_ma */
+    sim_counters_t count;
+    uint32_t wakeups;
+} sim_result_t;
+
+static void sim_setup(void)
+{
+    light_hal_mock_model_t model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+
+    model.active_high = CONFIG_HALLOWEEN_LED_LEVEL_HIGH;
+    light_hal_mock_reset(&model);
+    const light_state_t boot = LIGHT_STATE_DEFAULT();
+    const bool off[LIGHT_CHANNELS] = { [0 ... LIGHT_CHANNELS - 1] = LIGHT_DEFAULT_OFF };
+    light_driver_init(off, boot.level, boot.effect);
+    light_hal_timer_create(sim_poll, NULL, "poll", &s_poll_timer);
+    light_hal_timer_create(sim_poll_step, NULL, "poll_step", &s_step_timer);
+    light_hal_timer_create(sim_coalesce_flush, NULL, "coalesce", &s_coalesce_timer);
+}
+
+static sim_result_t sim_run(const sim_config_t *config, int64_t duration_us)
+{
+    const light_hal_mock_model_t model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+    light_hal_mock_stats_t st;
+    sim_result_t result = { 0 };
+
+    s_config = config;
+    memset(&s_count, 0, sizeof(s_count));
+    s_next_cmd = 0;
+    sim_setup();
+    s_start_us = light_hal_time_us();
+    poll_scheduler_init(&s_poll, CONFIG_HALLOWEEN_POLL_FAST_MS, config->keep_alive_ms,
+                        CONFIG_HALLOWEEN_POLL_FAST_WINDOW_MS, POLLS_PER_STEP);
+    const light_coalesce_ops_t coalesce_ops = {
+        .set_power = light_driver_set_power,
+        .set_level = sim_set_level,
+        .schedule = sim_coalesce_schedule,
+        .now_us = light_hal_time_us,
+    };
+    light_coalesce_init(&coalesce_ops, CONFIG_HALLOWEEN_COALESCE_WINDOW_MS);
+
+    light_hal_mock_clear_stats();
+    sim_poll_apply();
+    light_hal_mock_advance(duration_us);
+    light_hal_mock_get_stats(&st);
+
+    double light_mah = st.charge_mah;
+    if (!config->sleep) {
+        /* the CPU never stops: no wakeup cost, active current all along */
+        light_mah -= st.wakeups * model.wakeup_uc / 3600000.0;
+        light_mah += (s_model.active_ma - model.sleep_ma) * st.elapsed_us / (double)HOUR_US;
+    }
+    result.light_ma = light_mah * HOUR_US / st.elapsed_us;
+    result.average_ma = result.light_ma + s_count.radio_uc / 1000.0 / (st.elapsed_us / (double)SEC_US);
+    result.count = s_count;
+    result.wakeups = st.wakeups;
+    return result;
+}
+
+/*
+ * light_driver.c initializes only once per process, so every configuration
+ * runs in a child of its own and starts from the same freshly booted driver.
+ */
+static bool sim_run_isolated(const sim_config_t *config, int64_t duration_us, sim_result_t *result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        sim_result_t r = sim_run(config, duration_us);
+        _exit(write(fds[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (got != sizeof(*result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: simulation failed\n", config->name);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *schedule = NULL;
+    double hours = 24.0;
+    double capacity_mah = 2500.0;
+    double budget_ma = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--schedule") && i + 1 < argc) {
+            schedule = argv[++i];
+        } else if (!strcmp(argv[i], "--hours") && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--capacity") && i + 1 < argc) {
+            capacity_mah = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--budget-ma") && i + 1 < argc) {
+            budget_ma = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--schedule file] [--hours h] [--capacity mAh] [--budget-ma mA]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (schedule) {
+        schedule_load(schedule);
+    } else {
+        for (size_t i = 0; i < sizeof(s_default_schedule) / sizeof(s_default_schedule[0]); i++) {
+            schedule_parse_line(s_default_schedule[i]);
+        }
+    }
+    qsort(s_schedule, s_schedule_count, sizeof(s_schedule[0]), schedule_cmp);
+
+    const int64_t duration_us = (int64_t)(hours * HOUR_US);
+    bool over_budget = false;
+
+    printf("variant: %s, %zu commands over %.1f h, %.0f mAh battery\n", LIGHT_BENCH_VARIANT, s_schedule_count, hours,
+           capacity_mah);
+    for (size_t i = 0; i < sizeof(s_configs) / sizeof(s_configs[0]); i++) {
+        sim_result_t r;
+        if (!sim_run_isolated(&s_configs[i], duration_us, &r)) {
+            return 1;
+        }
+        double mah = r.average_ma * hours;
+        printf("%-24s %8.3f mA  (light %7.3f, radio+cpu %6.3f)  %7.2f mAh  %6.1f days  polls=%-6u wake=%-6u latency avg/max %5.0f/%5.0f ms\n",
+               s_configs[i].name, r.average_ma, r.light_ma, r.average_ma - r.light_ma, mah,
+               capacity_mah / r.average_ma / 24.0, (unsigned)r.count.polls, (unsigned)r.wakeups,
+               r.count.commands ? r.count.latency_sum_us / 1000.0 / r.count.commands : 0.0,
+               r.count.latency_max_us / 1000.0);
+        if (i == 0 && budget_ma > 0 && r.average_ma > budget_ma) {
+            fprintf(stderr, "%s: %s draws %.3f mA, budget %.3f mA\n", LIGHT_BENCH_VARIANT, s_configs[i].name,
+                    r.average_ma, budget_ma);
+            over_budget = true;
+        }
+    }
+    return over_budget ? 1 : 0;
+}
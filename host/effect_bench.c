@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Runs every procedural effect of effect_gen.c through the batching of
+ * light_effect.c (whole keyframes packed into one hardware fade of at most
+ * LIGHT_HAL_FADE_RANGES_MAX ranges) and prints the cost of generating a
+ * keyframe and its fade ranges, and the CPU wakeups the effect causes.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "effect_gen.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#endif
+
+#define BENCH_FREQ_HZ       1000    /* CONFIG_HALLOWEEN_BRIGHTNESS_FREQ default */
+#define BENCH_DUTY_MAX      1023
+#define BENCH_FRAMES        1000000
+
+static const char *const s_names[EFFECT_GEN_MAX] = {
+    [EFFECT_GEN_CANDLE] = "candle",
+    [EFFECT_GEN_LIGHTNING] = "lightning",
+    [EFFECT_GEN_HEARTBEAT] = "heartbeat",
+    [EFFECT_GEN_DYING_BULB] = "dying bulb",
+};
+
+static double host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t bench_duty(uint8_t level)
+{
+    return (uint32_t)level * BENCH_DUTY_MAX / 255;
+}
+
+static void bench_effect(effect_gen_kind_t kind)
+{
+    effect_gen_t gen;
+    light_keyframe_t frame;
+    light_hal_fade_range_t ranges[LIGHT_HAL_FADE_RANGES_MAX];
+    size_t used = 0;
+    uint32_t duty = 0, batches = 1, ranges_total = 0;
+    uint64_t effect_ms = 0;
+
+    /* the generator alone */
+    uint32_t sum = 0;
+    effect_gen_init(&gen, kind, 1);
+    double g0 = host_ns();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        effect_gen_next(&gen, &frame);
+        sum += frame.level + frame.fade_ms + frame.hold_ms;
+    }
+    double gen_ns = host_ns() - g0;
+
+    /* generator plus fade ranges, as light_effect.c runs it */
+    effect_gen_init(&gen, kind, 1);
+    double t0 = host_ns();
+#ifdef BENCH_CYCLES
+    uint64_t c0 = BENCH_CYCLES();
+#endif
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        effect_gen_next(&gen, &frame);
+        uint32_t to = bench_duty(frame.level);
+        size_t need = effect_program_frame_ranges(&frame, duty, to, BENCH_FREQ_HZ, NULL);
+        if (used + need > LIGHT_HAL_FADE_RANGES_MAX) {
+            /* the fade-end interrupt of this batch is the effect's wakeup */
+            effect_ms += effect_program_ranges_ms(ranges, used, BENCH_FREQ_HZ);
+            batches++;
+            used = 0;
+        }
+        used += effect_program_frame_ranges(&frame, duty, to, BENCH_FREQ_HZ, &ranges[used]);
+        ranges_total += need;
+        duty = to;
+    }
+#ifdef BENCH_CYCLES
+    uint64_t cycles = BENCH_CYCLES() - c0;
+#endif
+    double ns = host_ns() - t0;
+    effect_ms += effect_program_ranges_ms(ranges, used, BENCH_FREQ_HZ);
+
+    printf("%-11s generate %5.1f ns, with ranges %6.1f ns/keyframe", s_names[kind], gen_ns / BENCH_FRAMES,
+           ns / BENCH_FRAMES);
+#ifdef BENCH_CYCLES
+    printf(" %6.1f host cycles/keyframe", (double)cycles / BENCH_FRAMES);
+#endif
+    printf("  %.2f ranges/keyframe  %5.1f keyframes/wakeup  %6.1f wakeups/min  (%.0f ms/keyframe)\n",
+           (double)ranges_total / BENCH_FRAMES, (double)BENCH_FRAMES / batches,
+           effect_ms ? batches * 60000.0 / effect_ms : 0, (double)effect_ms / BENCH_FRAMES);
+    if (sum == 0)
+        printf("(empty effect)\n");
+}
+
+int main(void)
+{
+    printf("effects at %d Hz, up to %d fade ranges per wakeup\n", BENCH_FREQ_HZ, LIGHT_HAL_FADE_RANGES_MAX);
+    for (int kind = 0; kind < EFFECT_GEN_MAX; kind++)
+        bench_effect(kind);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Drains a small battery through light_driver.c on the mock HAL, once at the
+ * requested level and once with battery_governor.c capping it, and prints
+ * how long each one lasts against the runtime target. The battery voltage
+ * the governor sees follows from the charge the mock counted, through the
+ * same LiPo curve the governor uses.
+ *
+ *   governor_sim [--capacity mAh] [--runtime-h h] [--level n] [--check]
+ *
+ * --check fails when the governed light goes dark before the target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sdkconfig.h"
+#include "light_driver.h"
+#include "light_hal_mock.h"
+#include "battery_governor.h"
+
+#define SEC_US              1000000LL
+#define SAMPLE_US           (60 * SEC_US)      /* CONFIG_HALLOWEEN_BATTERY_SAMPLE_S default */
+#define EMPTY_PERCENT       0
+
+typedef struct {
+    double capacity_mah;
+    double runtime_h;
+    uint8_t level;
+} sim_args_t;
+
+static uint32_t sim_load(uint8_t cap, void *ctx)
+{
+    return light_driver_load(cap);
+}
+
+/* resting voltage for a state of charge, the inverse of battery_governor_percent() */
+static uint32_t sim_battery_mv(double percent)
+{
+    uint32_t mv = 3300;
+    while (mv < 4200 && battery_governor_percent(mv + 5) <= percent)
+        mv += 5;
+    return mv;
+}
+
+static int sim_run(const sim_args_t *args, bool governed)
+{
+    light_hal_mock_model_t model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+    battery_governor_config_t config = BATTERY_GOVERNOR_CONFIG_DEFAULT();
+    battery_governor_t gov;
+    light_hal_mock_stats_t st;
+    const bool on[LIGHT_CHANNELS] = { [0 ... LIGHT_CHANNELS - 1] = true };
+    uint8_t level[LIGHT_CHANNELS];
+    int64_t target_us = (int64_t)(args->runtime_h * 3600 * SEC_US);
+    double cap_sum = 0;
+    uint32_t samples = 0;
+
+    memset(level, args->level, sizeof(level));
+    light_hal_mock_reset(&model);
+    light_driver_init(on, level, LIGHT_DRIVER_EFFECT_NONE);
+    config.capacity_mah = (uint16_t)args->capacity_mah;
+    config.led_ma = (uint16_t)model.led_ma;
+    config.base_ma = 0;
+    battery_governor_init(&gov, &config);
+    battery_governor_set_deadline(&gov, light_hal_time_us() + target_us);
+    light_hal_mock_clear_stats();
+
+    for (;;) {
+        light_hal_mock_advance(SAMPLE_US);
+        light_hal_mock_get_stats(&st);
+        double percent = 100.0 * (1.0 - st.charge_mah / args->capacity_mah);
+        if (percent <= EMPTY_PERCENT || st.elapsed_us >= 2 * target_us)
+            break;
+        battery_governor_sample(&gov, sim_battery_mv(percent));
+        if (governed && battery_governor_update(&gov, light_hal_time_us(), sim_load, NULL))
+            light_driver_set_level_cap(gov.cap);
+        cap_sum += gov.cap;
+        samples++;
+    }
+    double hours = st.elapsed_us / (3600.0 * SEC_US);
+    printf("%-10s lasted %5.2f h (target %.2f h), average level cap %5.1f, %6.1f mAh\n",
+           governed ? "governed" : "full", hours, args->runtime_h, samples ? cap_sum / samples : 255.0, st.charge_mah);
+    return st.elapsed_us >= target_us ? 0 : 3;
+}
+
+/* light_driver.c initializes only once per process, so each run gets a child */
+static int sim_run_isolated(const sim_args_t *args, bool governed)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        int rc = sim_run(args, governed);
+        fflush(stdout);
+        _exit(rc);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+int main(int argc, char **argv)
+{
+    sim_args_t args = { .capacity_mah = 300, .runtime_h = 6, .level = 254 };
+    bool check = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--capacity") && i + 1 < argc) {
+            args.capacity_mah = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--runtime-h") && i + 1 < argc) {
+            args.runtime_h = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--level") && i + 1 < argc) {
+            args.level = (uint8_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else {
+            fprintf(stderr, "usage: %s [--capacity mAh] [--runtime-h h] [--level n] [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+    printf("variant: %s, %d string(s) at level %d, %.0f mAh battery\n", LIGHT_BENCH_VARIANT, LIGHT_CHANNELS, args.level,
+           args.capacity_mah);
+    if (sim_run_isolated(&args, false) == 1)
+        return 1;
+    int governed = sim_run_isolated(&args, true);
+    if (governed == 3 && check) {
+        fprintf(stderr, "%s: the governed light went dark before %.2f h\n", LIGHT_BENCH_VARIANT, args.runtime_h);
+        return 1;
+    }
+    return governed == 1 ? 1 : 0;
+}
@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the IDF esp_attr.h: one kind of memory, the placement attributes are empty. */
+
+#pragma once
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the IDF esp_log.h. Output is off unless LIGHT_HOST_LOG is set. */
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int esp_host_log_enabled(void);
+
+#define ESP_HOST_LOG(level, tag, format, ...) do {                          \
+        if (esp_host_log_enabled()) {                                       \
+            printf(level " (%s) " format "\n", tag, ##__VA_ARGS__);         \
+        }                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_HOST_LOG("D", tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
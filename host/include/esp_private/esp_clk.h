@@ -0,0 +1,18 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the IDF esp_private/esp_clk.h. */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int esp_clk_cpu_freq(void);
+
+#ifdef __cplusplus
+}
+#endif
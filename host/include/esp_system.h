@@ -0,0 +1,19 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the IDF esp_system.h. */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* returns on the host, zcl_stub.c counts the restarts */
+void esp_restart(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,383 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Host stand-in for the esp-zigbee-lib esp_zigbee_core.h, just enough for
+ * esp_zb_light.c and zcl_utility.c with every option of the host builds.
+ * host/zcl_stub.c implements it on the simulated clock of the mock HAL.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK    0x07FFF800U
+#define ESP_ZB_AF_HA_PROFILE_ID                 0x0104
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+typedef void (*esp_zb_callback_t)(uint8_t param);
+
+/* device and platform configuration */
+typedef enum {
+    ESP_ZB_DEVICE_TYPE_COORDINATOR = 0x00,
+    ESP_ZB_DEVICE_TYPE_ROUTER = 0x01,
+    ESP_ZB_DEVICE_TYPE_ED = 0x02,
+} esp_zb_nwk_device_type_t;
+
+typedef enum {
+    ESP_ZB_ED_AGING_TIMEOUT_64MIN = 0x06,
+} esp_zb_aging_timeout_t;
+
+typedef struct {
+    uint8_t ed_timeout;
+    uint32_t keep_alive;
+} esp_zb_zed_cfg_t;
+
+typedef struct {
+    esp_zb_nwk_device_type_t esp_zb_role;
+    bool install_code_policy;
+    union {
+        esp_zb_zed_cfg_t zed_cfg;
+    } nwk_cfg;
+} esp_zb_cfg_t;
+
+typedef enum {
+    ZB_RADIO_MODE_NATIVE = 0,
+} esp_zb_radio_mode_t;
+
+typedef enum {
+    ZB_HOST_CONNECTION_MODE_NONE = 0,
+} esp_zb_host_connection_mode_t;
+
+typedef struct {
+    struct {
+        esp_zb_radio_mode_t radio_mode;
+    } radio_config;
+    struct {
+        esp_zb_host_connection_mode_t host_connection_mode;
+    } host_config;
+} esp_zb_platform_config_t;
+
+/* signals */
+typedef enum {
+    ESP_ZB_ZDO_SIGNAL_DEFAULT_START = 0x00,
+    ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP = 0x01,
+    ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START = 0x05,
+    ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT = 0x06,
+    ESP_ZB_BDB_SIGNAL_STEERING = 0x0a,
+    ESP_ZB_COMMON_SIGNAL_CAN_SLEEP = 0x16,
+} esp_zb_app_signal_type_t;
+
+typedef struct {
+    uint32_t *p_app_signal;
+    esp_err_t esp_err_status;
+} esp_zb_app_signal_t;
+
+#define ESP_ZB_BDB_MODE_INITIALIZATION      0x00
+#define ESP_ZB_BDB_MODE_NETWORK_STEERING    0x02
+
+/* ZCL */
+typedef enum {
+    ESP_ZB_ZCL_STATUS_SUCCESS = 0x00,
+    ESP_ZB_ZCL_STATUS_FAIL = 0x01,
+    ESP_ZB_ZCL_STATUS_INVALID_VALUE = 0x87,
+} esp_zb_zcl_status_t;
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00,
+    ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10,
+    ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20,
+    ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21,
+    ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23,
+    ESP_ZB_ZCL_ATTR_TYPE_S16 = 0x29,
+    ESP_ZB_ZCL_ATTR_TYPE_S32 = 0x2b,
+    ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30,
+    ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+    ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42,
+    ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME = 0xe2,
+} esp_zb_zcl_attr_type_t;
+
+#define ESP_ZB_ZCL_CLUSTER_ID_BASIC                 0x0000
+#define ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG          0x0001
+#define ESP_ZB_ZCL_CLUSTER_ID_SCENES                0x0005
+#define ESP_ZB_ZCL_CLUSTER_ID_ON_OFF                0x0006
+#define ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL         0x0008
+#define ESP_ZB_ZCL_CLUSTER_ID_TIME                  0x000a
+#define ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE           0x0019
+
+#define ESP_ZB_ZCL_CLUSTER_SERVER_ROLE              0x01
+#define ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE              0x02
+
+#define ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID                      0x0004
+#define ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID                       0x0005
+#define ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID                                0x0000
+#define ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID                  0x0000
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID                 0x0020
+#define ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID    0x0021
+#define ESP_ZB_ZCL_ATTR_TIME_TIME_ID                                    0x0000
+#define ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID                               0x0002
+#define ESP_ZB_ZCL_ATTR_TIME_DST_START_ID                               0x0003
+#define ESP_ZB_ZCL_ATTR_TIME_DST_END_ID                                 0x0004
+#define ESP_ZB_ZCL_ATTR_TIME_DST_SHIFT_ID                               0x0005
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID                  0xfff1
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID                      0xfff2
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID                      0xfff3
+
+#define ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY            0x01
+#define ESP_ZB_ZCL_ATTR_ACCESS_WRITE_ONLY           0x02
+#define ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE           0x03
+#define ESP_ZB_ZCL_ATTR_ACCESS_REPORTING            0x04
+
+#define ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV             0x00
+#define ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI             0x01
+#define ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT        0x02
+
+typedef struct {
+    uint16_t id;
+    uint8_t type;
+    uint8_t access;
+    uint16_t manuf_code;
+    void *data_p;
+} esp_zb_zcl_attr_t;
+
+typedef struct {
+    esp_zb_zcl_attr_type_t type;
+    uint16_t size;
+    void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct {
+    uint16_t id;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+/* callbacks of zb_action_handler() and their messages */
+typedef enum {
+    ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+    ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID = 0x0001,
+    ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID = 0x0002,
+    ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID = 0x0004,
+    ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID = 0x1031,
+    ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID = 0x1051,
+} esp_zb_core_action_callback_id_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+} esp_zb_device_cb_common_info_t;
+
+typedef struct {
+    esp_zb_zcl_status_t status;
+    struct {
+        uint32_t addr_type;
+        union {
+            uint16_t short_addr;
+            esp_zb_ieee_addr_t ieee_addr;
+        } u;
+    } src_address;
+    uint8_t src_endpoint;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+    uint16_t profile;
+    struct {
+        uint8_t id;
+        uint8_t direction;
+        uint8_t is_common;
+    } command;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_set_attr_value_message_t;
+
+typedef struct {
+    esp_zb_zcl_cmd_info_t info;
+    uint16_t size;
+    void *data;
+} esp_zb_zcl_privilege_command_message_t;
+
+typedef struct {
+    esp_zb_zcl_cmd_info_t info;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_custom_cluster_command_message_t;
+
+typedef struct {
+    union {
+        uint16_t addr_short;
+        esp_zb_ieee_addr_t addr_long;
+    } dst_addr_u;
+    uint8_t dst_endpoint;
+    uint8_t src_endpoint;
+} esp_zb_zcl_basic_cmd_t;
+
+typedef struct {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    uint8_t address_mode;
+    uint16_t clusterID;
+    uint8_t direction;
+    uint16_t attributeID;
+} esp_zb_zcl_report_attr_cmd_t;
+
+typedef struct {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    uint8_t address_mode;
+    uint16_t profile_id;
+    uint16_t cluster_id;
+    uint16_t custom_cmd_id;
+    uint8_t direction;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_custom_cluster_cmd_resp_t;
+
+/* Scenes */
+typedef struct esp_zb_zcl_scenes_extension_field_s {
+    uint16_t cluster_id;
+    uint8_t length;
+    uint8_t *extension_field_attribute_value_list;
+    struct esp_zb_zcl_scenes_extension_field_s *next;
+} esp_zb_zcl_scenes_extension_field_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+} esp_zb_zcl_store_scene_message_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint16_t transition_time;
+    esp_zb_zcl_scenes_extension_field_t *field_set;
+} esp_zb_zcl_recall_scene_message_t;
+
+/* OTA Upgrade client */
+typedef enum {
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START = 0x0000,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY = 0x0001,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE = 0x0002,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH = 0x0003,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT = 0x0004,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK = 0x0005,
+} esp_zb_zcl_ota_upgrade_status_t;
+
+typedef struct {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_ota_upgrade_status_t upgrade_status;
+    struct {
+        uint16_t manufacturer_code;
+        uint16_t image_type;
+        uint32_t file_version;
+        uint32_t image_size;
+    } ota_header;
+    uint16_t payload_size;
+    const uint8_t *payload;
+} esp_zb_zcl_ota_upgrade_value_message_t;
+
+typedef struct {
+    uint32_t ota_upgrade_file_version;
+    uint32_t ota_upgrade_downloaded_file_ver;
+    uint16_t ota_upgrade_manufacturer;
+    uint16_t ota_upgrade_image_type;
+} esp_zb_ota_cluster_cfg_t;
+
+typedef struct {
+    uint16_t timer_query;
+    uint16_t hw_version;
+    uint8_t max_data_size;
+} esp_zb_zcl_ota_upgrade_client_variable_t;
+
+/* data model */
+typedef struct esp_zb_attribute_list_s esp_zb_attribute_list_t;
+typedef struct esp_zb_cluster_list_s esp_zb_cluster_list_t;
+typedef struct esp_zb_ep_list_s esp_zb_ep_list_t;
+
+typedef struct {
+    uint8_t main_voltage;
+} esp_zb_power_config_cluster_cfg_t;
+
+typedef struct {
+    uint32_t time;
+    uint8_t time_status;
+} esp_zb_time_cluster_cfg_t;
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t app_profile_id;
+    uint16_t app_device_id;
+    uint32_t app_device_version;
+} esp_zb_endpoint_config_t;
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void);
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list,
+                                esp_zb_endpoint_config_t endpoint_config);
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list);
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id);
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id,
+                                                         uint8_t role_mask);
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id);
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type,
+                                                uint8_t attr_access, void *value_p);
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_zb_attribute_list_t *esp_zb_power_config_cluster_create(esp_zb_power_config_cluster_cfg_t *power_cfg);
+esp_err_t esp_zb_power_config_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_zb_attribute_list_t *esp_zb_time_cluster_create(esp_zb_time_cluster_cfg_t *time_cfg);
+esp_err_t esp_zb_time_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg);
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                 uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_power_config_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                       uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_time_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                               uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                              uint8_t role_mask);
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check);
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id);
+esp_err_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req);
+esp_err_t esp_zb_zcl_add_privilege_command(uint8_t endpoint, uint16_t cluster, uint16_t command);
+uint8_t esp_zb_zcl_custom_cluster_cmd_resp(esp_zb_zcl_custom_cluster_cmd_resp_t *cmd_req);
+
+/* stack */
+void esp_zb_core_action_handler_register(esp_err_t (*cb)(esp_zb_core_action_callback_id_t callback_id, const void *message));
+void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_s);
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config);
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg);
+esp_err_t esp_zb_start(bool autostart);
+void esp_zb_stack_main_loop(void);
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask);
+void esp_zb_set_tx_power(int8_t power);
+void esp_zb_sleep_enable(bool enable);
+void esp_zb_sleep_now(void);
+void esp_zb_sleep_set_threshold(uint32_t threshold_ms);
+bool esp_zb_lock_acquire(TickType_t block_ticks);
+void esp_zb_lock_release(void);
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param);
+
+/* network */
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask);
+bool esp_zb_bdb_is_factory_new(void);
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal);
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id);
+uint16_t esp_zb_get_pan_id(void);
+uint8_t esp_zb_get_current_channel(void);
+uint16_t esp_zb_get_short_address(void);
+void esp_zb_zdo_pim_set_long_poll_interval(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the FreeRTOS.h of the IDF. The host builds run on one thread, critical sections are empty. */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define pdPASS                          1
+#define pdFAIL                          0
+#define portMAX_DELAY                   ((TickType_t)0xffffffffUL)
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+
+#ifdef __cplusplus
+}
+#endif
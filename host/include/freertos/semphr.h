@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the FreeRTOS semphr.h of the IDF: mutexes only. */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+/**
+ * @brief Takes the mutex; the host builds run on one thread, so taking a held mutex aborts instead of blocking forever.
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t block_ticks);
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the FreeRTOS task.h of the IDF. */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+/**
+ * @brief Runs @p task to its end before returning: the host stack loop returns once it is set up.
+ */
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *param, uint32_t priority,
+                       TaskHandle_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the esp-zigbee-lib ha/esp_zigbee_ha_standard.h: the two light devices of esp_zb_light.c. */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID            0x0100
+#define ESP_ZB_HA_COLOR_DIMMABLE_LIGHT_DEVICE_ID    0x0102
+
+typedef struct {
+    uint8_t zcl_version;
+    uint8_t power_source;
+} esp_zb_basic_cluster_cfg_t;
+
+typedef struct {
+    bool on_off;
+} esp_zb_on_off_cluster_cfg_t;
+
+typedef struct {
+    uint8_t current_level;
+} esp_zb_level_cluster_cfg_t;
+
+typedef struct {
+    esp_zb_basic_cluster_cfg_t basic_cfg;
+    esp_zb_on_off_cluster_cfg_t on_off_cfg;
+} esp_zb_on_off_light_cfg_t;
+
+typedef struct {
+    esp_zb_basic_cluster_cfg_t basic_cfg;
+    esp_zb_on_off_cluster_cfg_t on_off_cfg;
+    esp_zb_level_cluster_cfg_t level_cfg;
+} esp_zb_color_dimmable_light_cfg_t;
+
+#define ESP_ZB_DEFAULT_ON_OFF_LIGHT_CONFIG()                    \
+    {                                                           \
+        .basic_cfg = { .zcl_version = 3, .power_source = 0 },   \
+        .on_off_cfg = { .on_off = false },                      \
+    }
+
+#define ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG()            \
+    {                                                           \
+        .basic_cfg = { .zcl_version = 3, .power_source = 0 },   \
+        .on_off_cfg = { .on_off = false },                      \
+        .level_cfg = { .current_level = 0xff },                 \
+    }
+
+esp_zb_cluster_list_t *esp_zb_on_off_light_clusters_create(esp_zb_on_off_light_cfg_t *light_cfg);
+esp_zb_cluster_list_t *esp_zb_color_dimmable_light_clusters_create(esp_zb_color_dimmable_light_cfg_t *light_cfg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/* Host stand-in for the IDF hal/ieee802154_ll.h. */
+
+#pragma once
+
+#define IEEE802154_TXPOWER_VALUE_MAX    20
+#define IEEE802154_TXPOWER_VALUE_MIN    -15
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Host defaults for the options in main/Kconfig.projbuild. host/CMakeLists.txt
+ * overrides them per build variant with -DCONFIG_...=0/1.
+ */
+
+#pragma once
+
+#ifndef CONFIG_HALLOWEEN_LED_LEVEL_HIGH
+#define CONFIG_HALLOWEEN_LED_LEVEL_HIGH 1
+#endif
+
+#ifndef CONFIG_HALLOWEEN_LED_CHANNELS
+#define CONFIG_HALLOWEEN_LED_CHANNELS 1
+#endif
+
+#if CONFIG_HALLOWEEN_LED_CHANNELS >= 2 && !defined(CONFIG_HALLOWEEN_LED_GPIO_2)
+#define CONFIG_HALLOWEEN_LED_GPIO_2 6
+#define CONFIG_HALLOWEEN_LED_GPIO_3 7
+#define CONFIG_HALLOWEEN_LED_GPIO_4 19
+#define CONFIG_HALLOWEEN_LED_GPIO_5 20
+#define CONFIG_HALLOWEEN_LED_GPIO_6 21
+#endif
+
+#ifndef CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+#define CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE 1
+#endif
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE && !defined(CONFIG_HALLOWEEN_BRIGHTNESS_FREQ)
+#define CONFIG_HALLOWEEN_BRIGHTNESS_FREQ 1000
+#endif
+
+#ifndef CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+#define CONFIG_HALLOWEEN_BRIGHTNESS_DITHER 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_TRACE_ENABLE
+#define CONFIG_HALLOWEEN_TRACE_ENABLE 0
+#endif
+
+#if CONFIG_HALLOWEEN_TRACE_ENABLE && !defined(CONFIG_HALLOWEEN_TRACE_ENTRIES)
+#define CONFIG_HALLOWEEN_TRACE_ENTRIES 256
+#endif
+
+#ifndef CONFIG_HALLOWEEN_BLINK_ENABLE
+#define CONFIG_HALLOWEEN_BLINK_ENABLE 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_SYNC_ENABLE
+#define CONFIG_HALLOWEEN_SYNC_ENABLE 0
+#endif
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE && !defined(CONFIG_HALLOWEEN_SYNC_POLL_MS)
+#define CONFIG_HALLOWEEN_SYNC_POLL_MS 20
+#endif
+
+/* the mock HAL plays the LP core queue itself */
+#ifndef CONFIG_HALLOWEEN_EFFECT_LP_CORE
+#define CONFIG_HALLOWEEN_EFFECT_LP_CORE 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_AUDIO_ENABLE
+#define CONFIG_HALLOWEEN_AUDIO_ENABLE 0
+#endif
+
+/* the I2S clip player has no mock, host builds keep the square wave */
+#ifndef CONFIG_HALLOWEEN_AUDIO_CLIPS
+#define CONFIG_HALLOWEEN_AUDIO_CLIPS 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_ENABLE_SLEEP
+#define CONFIG_HALLOWEEN_ENABLE_SLEEP 1
+#endif
+
+#ifndef CONFIG_HALLOWEEN_BATTERY_DEVICE
+#define CONFIG_HALLOWEEN_BATTERY_DEVICE 1
+#endif
+
+/* the ADC has no mock, only zcl_replay_full turns the monitor on over a stub battery */
+#ifndef CONFIG_HALLOWEEN_BATTERY_MONITOR
+#define CONFIG_HALLOWEEN_BATTERY_MONITOR 0
+#endif
+
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR && !defined(CONFIG_HALLOWEEN_BATTERY_SAMPLE_S)
+#define CONFIG_HALLOWEEN_BATTERY_SAMPLE_S 60
+#endif
+
+#ifndef CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+#define CONFIG_HALLOWEEN_BATTERY_GOVERNOR 0
+#endif
+
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR && !defined(CONFIG_HALLOWEEN_BATTERY_CAPACITY_MAH)
+#define CONFIG_HALLOWEEN_BATTERY_CAPACITY_MAH 2000
+#define CONFIG_HALLOWEEN_BATTERY_LED_MA 300
+#define CONFIG_HALLOWEEN_BATTERY_RUNTIME_MIN 360
+#endif
+
+#ifndef CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+#define CONFIG_HALLOWEEN_SCHEDULE_ENABLE 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_SCENES_ENABLE
+#define CONFIG_HALLOWEEN_SCENES_ENABLE 0
+#endif
+
+#ifndef CONFIG_HALLOWEEN_OTA_ENABLE
+#define CONFIG_HALLOWEEN_OTA_ENABLE 0
+#endif
+
+#if CONFIG_HALLOWEEN_OTA_ENABLE && !defined(CONFIG_HALLOWEEN_OTA_MANUFACTURER)
+#define CONFIG_HALLOWEEN_OTA_MANUFACTURER 0x131B
+#define CONFIG_HALLOWEEN_OTA_IMAGE_TYPE 0x1011
+#define CONFIG_HALLOWEEN_OTA_FILE_VERSION 0x00000001
+#define CONFIG_HALLOWEEN_OTA_QUERY_MIN 1440
+#endif
+
+#ifndef CONFIG_HALLOWEEN_POLL_FAST_MS
+#define CONFIG_HALLOWEEN_POLL_FAST_MS 250
+#endif
+
+#ifndef CONFIG_HALLOWEEN_POLL_FAST_WINDOW_MS
+#define CONFIG_HALLOWEEN_POLL_FAST_WINDOW_MS 10000
+#endif
+
+#ifndef CONFIG_HALLOWEEN_POLL_IDLE_MS
+#define CONFIG_HALLOWEEN_POLL_IDLE_MS 4000
+#endif
+
+#ifndef CONFIG_HALLOWEEN_COALESCE_WINDOW_MS
+#define CONFIG_HALLOWEEN_COALESCE_WINDOW_MS 20
+#endif
+
+#ifndef CONFIG_HALLOWEEN_REPORT_ENABLE
+#define CONFIG_HALLOWEEN_REPORT_ENABLE 1
+#endif
+
+#if CONFIG_HALLOWEEN_REPORT_ENABLE && !defined(CONFIG_HALLOWEEN_REPORT_MIN_S)
+#define CONFIG_HALLOWEEN_REPORT_MIN_S 2
+#define CONFIG_HALLOWEEN_REPORT_MAX_S 1800
+#define CONFIG_HALLOWEEN_REPORT_LEVEL_CHANGE 8
+#endif
+
+#ifndef CONFIG_HALLOWEEN_STATE_COMMIT_DELAY_MS
+#define CONFIG_HALLOWEEN_STATE_COMMIT_DELAY_MS 5000
+#endif
+
+#ifndef CONFIG_IDF_TARGET
+#define CONFIG_IDF_TARGET "esp32c6"
+#endif
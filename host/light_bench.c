@@ -0,0 +1,344 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Runs light_driver.c against the mock HAL and prints the hardware activity
+ * and estimated charge of a few typical usage patterns.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "light_driver.h"
+#include "light_hal_mock.h"
+#include "light_coalesce.h"
+#include "light_state.h"
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+#include "light_effect.h"
+#endif
+
+#define SEC_US  1000000LL
+#define HOUR_US (3600 * SEC_US)
+
+static double host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_report(const char *name, double ns_per_call)
+{
+    light_hal_mock_stats_t st;
+    light_hal_mock_get_stats(&st);
+    printf("%-22s %8.1f s  duty=%-6u fade=%-5u pause=%-5u resume=%-5u hold=%-5u wake=%-6u led_on=%6.1f %%  %7.3f mAh/h",
+           name, st.elapsed_us / 1e6, (unsigned)st.duty_changes, (unsigned)st.fades, (unsigned)st.timer_pauses,
+           (unsigned)st.timer_resumes, (unsigned)st.gpio_holds, (unsigned)st.wakeups,
+           st.elapsed_us ? 100.0 * st.led_on_us / st.elapsed_us : 0.0, light_hal_mock_average_ma(&st));
+    if (ns_per_call > 0) {
+        printf("  %6.1f ns/call", ns_per_call);
+    }
+    if (st.lp_wakeups) {
+        printf("  lp=%u", (unsigned)st.lp_wakeups);
+    }
+    printf("\n");
+}
+
+static void bench_steady_on(void)
+{
+    light_hal_mock_clear_stats();
+    light_driver_set_power(0, true);
+    light_hal_mock_advance(HOUR_US);
+    bench_report("steady on, 1 h", 0);
+}
+
+static void bench_power_toggle(void)
+{
+    light_hal_mock_clear_stats();
+    double ns = 0;
+    for (int i = 0; i < 360; i++) {
+        light_hal_mock_wakeup();
+        double t0 = host_ns();
+        light_driver_set_power(0, i & 1);
+        ns += (host_ns() - t0) / 360;
+        light_hal_mock_advance(10 * SEC_US);
+    }
+    bench_report("toggle every 10 s", ns);
+    light_driver_set_power(0, true);
+}
+
+static void bench_brightness_sweep(void)
+{
+    light_hal_mock_clear_stats();
+    light_driver_set_power(0, true);
+    double ns = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int v = 0; v <= 255; v++) {
+            light_hal_mock_wakeup();
+            double t0 = host_ns();
+            light_driver_set_brightness(0, pass ? 255 - v : v);
+            ns += (host_ns() - t0) / 512;
+            light_hal_mock_advance(20000);
+        }
+    }
+    bench_report("slider sweep 0-255-0", ns);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    light_driver_set_brightness(0, LIGHT_DEFAULT_BRIGHTNESS);
+#endif
+}
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+static light_hal_timer_t s_coalesce_timer;
+
+static void bench_coalesce_flush(void *arg)
+{
+    light_coalesce_flush();
+}
+
+static void bench_coalesce_schedule(uint32_t delay_ms)
+{
+    light_hal_timer_start_once(s_coalesce_timer, delay_ms * 1000ULL);
+}
+
+/* 100 CurrentLevel writes 5 ms apart, as sent while dragging a slider */
+static void bench_slider_burst(bool coalesce)
+{
+    light_hal_mock_clear_stats();
+    light_driver_set_power(0, true);
+    for (int i = 0; i < 100; i++) {
+        uint8_t level = 20 + 2 * i;
+        light_hal_mock_wakeup();
+        if (coalesce)
+            light_coalesce_level(0, level);
+        else
+            light_driver_set_brightness(0, level);
+        light_hal_mock_advance(5000);
+    }
+    light_hal_mock_advance(SEC_US);
+    bench_report(coalesce ? "slider burst, 20 ms" : "slider burst, direct", 0);
+    light_driver_set_brightness(0, LIGHT_DEFAULT_BRIGHTNESS);
+}
+
+static void bench_level_transition(void)
+{
+    light_hal_mock_clear_stats();
+    light_driver_set_power(0, true);
+    light_hal_mock_wakeup();
+    light_driver_fade_brightness(0, 10, 5000, NULL, NULL);
+    light_hal_mock_advance(6 * SEC_US);
+    bench_report("5 s dim (MoveToLevel)", 0);
+    light_driver_set_brightness(0, LIGHT_DEFAULT_BRIGHTNESS);
+}
+#endif
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE && LIGHT_CHANNELS > 1
+/* every string at half brightness: peak current with and without staggered turn-on points */
+static void bench_channels(void)
+{
+    light_hal_mock_clear_stats();
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++) {
+        light_driver_set_brightness(ch, 180);
+    }
+    light_hal_mock_advance(HOUR_US);
+    bench_report("all channels, 1 h", 0);
+    printf("peak LED current: %.0f mA staggered, %.0f mA aligned\n", light_hal_mock_peak_ma(false),
+           light_hal_mock_peak_ma(true));
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++) {
+        light_driver_set_power(ch, false);
+    }
+}
+#endif
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE && LIGHT_CHANNELS > 1
+/* LEDC channel of each string, as in light_driver.c */
+static const uint8_t bench_ledc_ch[] = { 1, 0, 3, 4, 5, 2 };
+
+/* every other string to its own level in one command, then a 2 s ramp of the lit ones; 1 for a wrong output */
+static unsigned bench_scene(void)
+{
+    light_scene_t scene = { .effect = LIGHT_DRIVER_EFFECT_NONE };
+    unsigned wrong = 0;
+
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++) {
+        scene.on |= (ch % 2 == 0) << ch;
+        scene.level[ch] = 60 + 30 * ch;
+    }
+    light_hal_mock_clear_stats();
+    light_driver_set_scene(&scene, 0);
+    light_hal_mock_wakeup();
+    light_hal_mock_advance(SEC_US);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++)
+        wrong += (light_hal_mock_pwm_output(bench_ledc_ch[ch]) > 0.0) != (scene.on >> ch & 1);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++)
+        scene.level[ch] = 250;
+    light_driver_set_scene(&scene, 2000);
+    light_hal_mock_wakeup();
+    light_hal_mock_advance(3 * SEC_US);
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++)
+        wrong += (light_hal_mock_pwm_output(bench_ledc_ch[ch]) > 0.9) != (scene.on >> ch & 1);
+    bench_report("scene recall, 2 s ramp", 0);
+    if (wrong)
+        fprintf(stderr, "light_bench: scene left %u outputs wrong\n", wrong);
+
+    scene.on = 0;
+    light_driver_set_scene(&scene, 0);
+    light_hal_mock_advance(SEC_US);
+    return wrong;
+}
+#endif
+
+static void bench_idle_off(void)
+{
+    light_driver_set_power(0, false);
+    light_hal_mock_clear_stats();
+    light_hal_mock_advance(HOUR_US);
+    bench_report("off, 1 h", 0);
+}
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+/*
+ * Every effect for 10 minutes. The clock, and so the generator seed, is the
+ * same in every variant: with and without CONFIG_HALLOWEEN_EFFECT_LP_CORE the
+ * LED on-time must match, only the wakeups move to the LP core.
+ */
+static void bench_effects(void)
+{
+    static const char *const names[LIGHT_DRIVER_EFFECT_MAX] = {
+        [LIGHT_DRIVER_EFFECT_BLINK] = "blink, 10 min",
+        [LIGHT_DRIVER_EFFECT_CANDLE] = "candle, 10 min",
+        [LIGHT_DRIVER_EFFECT_LIGHTNING] = "lightning, 10 min",
+        [LIGHT_DRIVER_EFFECT_HEARTBEAT] = "heartbeat, 10 min",
+        [LIGHT_DRIVER_EFFECT_DYING_BULB] = "dying bulb, 10 min",
+    };
+
+    for (uint8_t effect = LIGHT_DRIVER_EFFECT_BLINK; effect < LIGHT_DRIVER_EFFECT_MAX; effect++) {
+        light_driver_set_effect(effect);
+        light_hal_mock_clear_stats();
+        light_driver_set_power(0, true);
+        light_hal_mock_advance(600 * SEC_US);
+        light_driver_set_power(0, false);
+        bench_report(names[effect], 0);
+    }
+    light_driver_set_effect(LIGHT_DRIVER_EFFECT_BLINK);
+}
+#endif
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+#define SYNC_LED_GPIO           4           /* MM_LED_GPIO of light_driver.c */
+#define SYNC_LED_LEDC_CH        1
+#define SYNC_BLINK_ON_US        1100000     /* blink_frames of light_driver.c */
+#define SYNC_BLINK_PERIOD_US    1900000
+#define SYNC_CLOCK_PPM          200         /* local clock against the shared one */
+#define SYNC_CLOCK_OFFSET_US    987654321LL
+#define SYNC_EDGE_US            20000       /* allowed around the shared blink edges */
+
+static int64_t s_sync_known_us = INT64_MAX; /* simulated time the shared clock becomes known at */
+
+static int64_t bench_sync_clock(void)
+{
+    int64_t now = light_hal_time_us();
+    if (now < s_sync_known_us)
+        return LIGHT_EFFECT_NO_CLOCK;
+    return now + now * SYNC_CLOCK_PPM / 1000000 + SYNC_CLOCK_OFFSET_US;
+}
+
+static bool bench_led_on(void)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    return light_hal_mock_pwm_output(SYNC_LED_LEDC_CH) > 0.0;
+#else
+    return light_hal_mock_gpio_level(SYNC_LED_GPIO) == CONFIG_HALLOWEEN_LED_LEVEL_HIGH;
+#endif
+}
+
+/*
+ * Blink on a shared clock 200 ppm off the local one, that only becomes known
+ * 10 s in. From 5 s later the LED has to be on for the first 1100 ms of every
+ * 1900 ms of shared time and off for the rest, give or take SYNC_EDGE_US.
+ * Free running, it would be 120 ms off by the end.
+ */
+static unsigned bench_sync_blink(void)
+{
+    unsigned probes = 0, wrong = 0;
+
+    light_driver_set_effect(LIGHT_DRIVER_EFFECT_BLINK);
+    light_hal_mock_clear_stats();
+    s_sync_known_us = light_hal_time_us() + 10 * SEC_US;
+    light_driver_set_power(0, true);
+    light_hal_mock_advance(15 * SEC_US);
+    for (int i = 0; i < 600000 / 37; i++) {
+        light_hal_mock_advance(37000);
+        int64_t phase = bench_sync_clock() % SYNC_BLINK_PERIOD_US;
+        if (phase < SYNC_EDGE_US || (phase > SYNC_BLINK_ON_US - SYNC_EDGE_US && phase < SYNC_BLINK_ON_US + SYNC_EDGE_US) ||
+            phase > SYNC_BLINK_PERIOD_US - SYNC_EDGE_US)
+            continue;
+        probes++;
+        wrong += bench_led_on() != (phase < SYNC_BLINK_ON_US);
+    }
+    light_driver_set_power(0, false);
+    bench_report("synced blink, 10 min", 0);
+    printf("synced blink: %u of %u probes off the shared phase\n", wrong, probes);
+
+    /* a generator restarting at every epoch */
+    light_driver_set_effect(LIGHT_DRIVER_EFFECT_CANDLE);
+    light_hal_mock_clear_stats();
+    light_driver_set_power(0, true);
+    light_hal_mock_advance(600 * SEC_US);
+    light_driver_set_power(0, false);
+    bench_report("synced candle, 10 min", 0);
+    light_driver_set_effect(LIGHT_DRIVER_EFFECT_BLINK);
+    return wrong;
+}
+#endif
+
+int main(void)
+{
+    light_hal_mock_model_t model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+    model.active_high = CONFIG_HALLOWEEN_LED_LEVEL_HIGH;
+    light_hal_mock_reset(&model);
+    const light_state_t boot = LIGHT_STATE_DEFAULT();
+    const bool off[LIGHT_CHANNELS] = { [0 ... LIGHT_CHANNELS - 1] = LIGHT_DEFAULT_OFF };
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    light_driver_set_clock(bench_sync_clock);
+#endif
+    light_driver_init(off, boot.level, boot.effect);
+
+    printf("variant: %s\n", LIGHT_BENCH_VARIANT);
+    bench_steady_on();
+    bench_power_toggle();
+    bench_brightness_sweep();
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    light_hal_timer_create(bench_coalesce_flush, NULL, "coalesce", &s_coalesce_timer);
+    const light_coalesce_ops_t coalesce_ops = {
+        .set_power = light_driver_set_power,
+        .set_level = light_driver_set_brightness,
+        .schedule = bench_coalesce_schedule,
+        .now_us = light_hal_time_us,
+    };
+    light_coalesce_init(&coalesce_ops, 20);
+    bench_slider_burst(false);
+    bench_slider_burst(true);
+    bench_level_transition();
+#endif
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE && LIGHT_CHANNELS > 1
+    bench_channels();
+    if (bench_scene())
+        return 1;
+#endif
+    bench_idle_off();
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    light_effect_stats_t effect;
+    light_effect_get_stats(&effect);
+    printf("effect wakeups: %u/min (esp_timer toggle: %u/min)\n",
+           (unsigned)light_effect_wakeups_per_min(&effect), 2 * 60000 / (1100 + 800));
+    bench_effects();
+#endif
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    if (bench_sync_blink())
+        return 1;
+#endif
+    return 0;
+}
@@ -0,0 +1,639 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <string.h>
+#include "light_hal_mock.h"
+
+#define MOCK_PWM_TIMERS     4
+#define MOCK_PWM_CHANNELS   8
+#define MOCK_GPIOS          32
+#define MOCK_TIMERS         16
+#define MOCK_EVENTS         4096
+
+#define US_PER_HOUR         3600000000.0
+#define UC_PER_MAH          3600000.0
+
+struct light_hal_timer_s {
+    bool used;
+    bool armed;
+    int64_t deadline_us;
+    light_hal_timer_cb_t cb;
+    void *arg;
+    const char *name;
+};
+
+typedef struct {
+    bool configured;
+    bool running;
+    uint32_t freq_hz;
+    uint8_t resolution_bits;
+} mock_pwm_timer_t;
+
+typedef struct {
+    bool configured;
+    bool stopped;
+    uint8_t timer;
+    uint32_t duty;
+    uint32_t hpoint;
+    uint32_t idle_level;
+    /* hardware fade in progress */
+    bool fading;
+    int64_t fade_start_us;
+    int64_t fade_end_us;
+    light_hal_fade_range_t fade_ranges[LIGHT_HAL_FADE_RANGES_MAX];
+    size_t fade_count;
+    light_hal_fade_cb_t fade_done;
+    void *fade_arg;
+} mock_pwm_channel_t;
+
+typedef struct {
+    bool initialized;
+    bool level;
+} mock_gpio_t;
+
+static light_hal_mock_model_t s_model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+static light_hal_mock_stats_t s_stats;
+static int64_t s_now_us;
+static int64_t s_stats_start_us;
+static int64_t s_accounted_us;
+static double s_charge_mausec;      /* mA * us accumulated by the continuous loads */
+static mock_pwm_timer_t s_pwm_timers[MOCK_PWM_TIMERS];
+static mock_pwm_channel_t s_pwm_channels[MOCK_PWM_CHANNELS];
+static mock_gpio_t s_gpios[MOCK_GPIOS];
+static struct light_hal_timer_s s_timers[MOCK_TIMERS];
+static light_hal_mock_event_t s_events[MOCK_EVENTS];
+static size_t s_event_count;
+static light_hal_mock_event_t s_event_view[MOCK_EVENTS];
+/* LP core playing s_lp_seq on s_lp_gpio, next step due at s_lp_deadline_us */
+static lp_seq_t s_lp_seq;
+static bool s_lp_running;
+static int s_lp_gpio;
+static int64_t s_lp_deadline_us;
+/* light task work function, run from light_hal_mock_advance() once woken */
+static light_hal_task_fn_t s_task_fn;
+static bool s_task_woken;
+
+static void mock_record(light_hal_mock_event_type_t type, uint8_t id, uint32_t value)
+{
+    light_hal_mock_event_t *ev = &s_events[s_event_count % MOCK_EVENTS];
+    ev->time_us = s_now_us;
+    ev->type = type;
+    ev->id = id;
+    ev->value = value;
+    s_event_count++;
+}
+
+static double mock_duty_output(const mock_pwm_channel_t *ch, uint32_t duty)
+{
+    const mock_pwm_timer_t *tm = &s_pwm_timers[ch->timer];
+    double frac = (double)duty / (double)(1u << tm->resolution_bits);
+    if (frac > 1.0) {
+        frac = 1.0;
+    }
+    return s_model.active_high ? frac : 1.0 - frac;
+}
+
+static double mock_period_us(const mock_pwm_channel_t *ch)
+{
+    return 1e6 / (double)s_pwm_timers[ch->timer].freq_hz;
+}
+
+/*
+ * Walk the fade steps of a channel. Returns the duty at time t and, when
+ * integral is given, adds the output on-time over [t0, t] to it.
+ */
+static uint32_t mock_fade_walk(const mock_pwm_channel_t *ch, int64_t t0, int64_t t, double *integral)
+{
+    const double period = mock_period_us(ch);
+    double seg_start = (double)ch->fade_start_us;
+    int64_t duty = ch->duty;
+
+    for (size_t r = 0; r < ch->fade_count; r++) {
+        const light_hal_fade_range_t *rg = &ch->fade_ranges[r];
+        const double seg_len = rg->cycle_num * period;
+        for (uint32_t step = 0; step < rg->step_num; step++) {
+            double seg_end = seg_start + seg_len;
+            if (integral) {
+                double a = seg_start > t0 ? seg_start : (double)t0;
+                double b = seg_end < t ? seg_end : (double)t;
+                if (b > a) {
+                    *integral += mock_duty_output(ch, (uint32_t)duty) * (b - a);
+                }
+            }
+            if (seg_end > t) {
+                return (uint32_t)duty;
+            }
+            duty += rg->increase ? rg->scale : -(int64_t)rg->scale;
+            if (duty < 0) {
+                duty = 0;
+            }
+            seg_start = seg_end;
+        }
+    }
+    if (integral && t > seg_start) {
+        double a = seg_start > t0 ? seg_start : (double)t0;
+        *integral += mock_duty_output(ch, (uint32_t)duty) * ((double)t - a);
+    }
+    return (uint32_t)duty;
+}
+
+bool light_hal_mock_gpio_level(int gpio)
+{
+    return gpio >= 0 && gpio < MOCK_GPIOS && s_gpios[gpio].level;
+}
+
+double light_hal_mock_pwm_output(uint8_t channel)
+{
+    if (channel >= MOCK_PWM_CHANNELS || !s_pwm_channels[channel].configured) {
+        return 0.0;
+    }
+    const mock_pwm_channel_t *ch = &s_pwm_channels[channel];
+    if (ch->stopped) {
+        return (ch->idle_level != 0) == s_model.active_high ? 1.0 : 0.0;
+    }
+    if (ch->fading) {
+        return mock_duty_output(ch, mock_fade_walk(ch, s_now_us, s_now_us, NULL));
+    }
+    return mock_duty_output(ch, ch->duty);
+}
+
+/* End a fade at the current time, leaving the duty it has reached */
+static void mock_fade_settle(mock_pwm_channel_t *ch)
+{
+    if (ch->fading) {
+        ch->duty = mock_fade_walk(ch, s_now_us, s_now_us, NULL);
+        ch->fading = false;
+    }
+}
+
+/* Integrate the continuous loads from the last accounted instant up to now. */
+static void mock_account(void)
+{
+    int64_t dt = s_now_us - s_accounted_us;
+    if (dt <= 0) {
+        return;
+    }
+    double ma = s_model.sleep_ma;
+    double led_on = 0.0;
+    double fade_on_us = 0.0;
+
+    for (int i = 0; i < MOCK_PWM_TIMERS; i++) {
+        if (s_pwm_timers[i].configured && s_pwm_timers[i].running) {
+            ma += s_model.pwm_timer_ma;
+        }
+    }
+    for (int i = 0; i < MOCK_PWM_CHANNELS; i++) {
+        const mock_pwm_channel_t *ch = &s_pwm_channels[i];
+        if (ch->configured && !ch->stopped && ch->fading) {
+            mock_fade_walk(ch, s_accounted_us, s_now_us, &fade_on_us);
+        } else {
+            led_on += light_hal_mock_pwm_output(i);
+        }
+    }
+    for (int i = 0; i < MOCK_GPIOS; i++) {
+        if (s_gpios[i].initialized && s_gpios[i].level == s_model.active_high) {
+            led_on += 1.0;
+        }
+    }
+    ma += led_on * s_model.led_ma;
+
+    s_charge_mausec += ma * (double)dt + fade_on_us * s_model.led_ma;
+    s_stats.led_on_us += led_on * (double)dt + fade_on_us;
+    s_accounted_us = s_now_us;
+}
+
+void light_hal_mock_reset(const light_hal_mock_model_t *model)
+{
+    light_hal_mock_model_t defaults = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+    s_model = model ? *model : defaults;
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_pwm_timers, 0, sizeof(s_pwm_timers));
+    memset(s_pwm_channels, 0, sizeof(s_pwm_channels));
+    memset(s_gpios, 0, sizeof(s_gpios));
+    memset(s_timers, 0, sizeof(s_timers));
+    memset(&s_lp_seq, 0, sizeof(s_lp_seq));
+    s_lp_running = false;
+    s_task_fn = NULL;
+    s_task_woken = false;
+    s_now_us = 0;
+    s_stats_start_us = 0;
+    s_accounted_us = 0;
+    s_charge_mausec = 0.0;
+    s_event_count = 0;
+}
+
+void light_hal_mock_clear_stats(void)
+{
+    mock_account();
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_charge_mausec = 0.0;
+    s_stats_start_us = s_now_us;
+}
+
+/* One run of lp_core/lp_effect_main.c */
+static void mock_lp_step(void)
+{
+    bool pin;
+    uint32_t ms = lp_seq_next(&s_lp_seq, &pin);
+
+    s_stats.lp_wakeups++;
+    if (ms) {
+        mock_account();
+        s_gpios[s_lp_gpio].level = pin;
+        mock_record(LIGHT_HAL_MOCK_EV_LP_STEP, (uint8_t)s_lp_gpio, pin);
+    }
+    s_lp_deadline_us = s_now_us + (int64_t)(ms ? ms : 100) * 1000;
+}
+
+/* The light task gets the CPU as soon as the posting code returns to the simulation */
+static void mock_task_run(void)
+{
+    while (s_task_woken) {
+        s_task_woken = false;
+        s_stats.task_runs++;
+        s_task_fn();
+    }
+}
+
+void light_hal_mock_advance(int64_t us)
+{
+    const int64_t target = s_now_us + us;
+
+    for (;;) {
+        mock_task_run();
+        struct light_hal_timer_s *next = NULL;
+        mock_pwm_channel_t *fade = NULL;
+        int64_t due = target + 1;
+
+        for (int i = 0; i < MOCK_TIMERS; i++) {
+            struct light_hal_timer_s *t = &s_timers[i];
+            if (t->used && t->armed && t->deadline_us < due) {
+                next = t;
+                due = t->deadline_us;
+            }
+        }
+        for (int i = 0; i < MOCK_PWM_CHANNELS; i++) {
+            mock_pwm_channel_t *ch = &s_pwm_channels[i];
+            if (ch->fading && ch->fade_end_us < due) {
+                fade = ch;
+                next = NULL;
+                due = ch->fade_end_us;
+            }
+        }
+        if (s_lp_running && s_lp_deadline_us < due) {
+            /* the LP core steps on its own, the HP core sleeps through it */
+            if (s_lp_deadline_us > s_now_us) {
+                s_now_us = s_lp_deadline_us;
+            }
+            mock_lp_step();
+            continue;
+        }
+        if (!next && !fade) {
+            break;
+        }
+        if (due > s_now_us) {
+            s_now_us = due;
+        }
+        mock_account();
+        s_stats.wakeups++;
+        if (fade) {
+            uint8_t channel = (uint8_t)(fade - s_pwm_channels);
+            mock_fade_settle(fade);
+            mock_record(LIGHT_HAL_MOCK_EV_PWM_FADE_END, channel, fade->duty);
+            if (fade->fade_done) {
+                fade->fade_done(channel, fade->fade_arg);
+            }
+        } else {
+            next->armed = false;
+            mock_record(LIGHT_HAL_MOCK_EV_TIMER_FIRE, (uint8_t)(next - s_timers), 0);
+            next->cb(next->arg);
+        }
+    }
+    mock_task_run();
+    s_now_us = target;
+    mock_account();
+}
+
+void light_hal_mock_wakeup(void)
+{
+    s_stats.wakeups++;
+}
+
+void light_hal_mock_get_stats(light_hal_mock_stats_t *stats)
+{
+    mock_account();
+    *stats = s_stats;
+    stats->elapsed_us = s_now_us - s_stats_start_us;
+    stats->charge_mah = s_charge_mausec / US_PER_HOUR +
+                        (s_stats.wakeups * s_model.wakeup_uc + s_stats.lp_wakeups * s_model.lp_wakeup_uc) / UC_PER_MAH;
+}
+
+size_t light_hal_mock_get_events(const light_hal_mock_event_t **events)
+{
+    size_t count = s_event_count < MOCK_EVENTS ? s_event_count : MOCK_EVENTS;
+    size_t first = s_event_count - count;
+    for (size_t i = 0; i < count; i++) {
+        s_event_view[i] = s_events[(first + i) % MOCK_EVENTS];
+    }
+    *events = s_event_view;
+    return count;
+}
+
+/* LED on-window of a channel within its PWM period, as [start, start + len) in periods */
+static bool mock_on_window(const mock_pwm_channel_t *ch, double *start, double *len)
+{
+    const mock_pwm_timer_t *tm = &s_pwm_timers[ch->timer];
+    const double period = (double)(1u << tm->resolution_bits);
+    uint32_t duty = ch->fading ? mock_fade_walk(ch, s_now_us, s_now_us, NULL) : ch->duty;
+    double high = duty / period > 1.0 ? 1.0 : duty / period;
+
+    if (ch->stopped || !tm->running) {
+        *start = 0.0;
+        *len = light_hal_mock_pwm_output((uint8_t)(ch - s_pwm_channels));
+        return *len > 0.0;
+    }
+    /* the output goes high at hpoint for duty counts; active-low LEDs light up in the rest */
+    *start = ch->hpoint / period + (s_model.active_high ? 0.0 : high);
+    *len = s_model.active_high ? high : 1.0 - high;
+    *start -= (int)*start;
+    return *len > 0.0;
+}
+
+double light_hal_mock_peak_ma(bool aligned)
+{
+    double starts[MOCK_PWM_CHANNELS], lens[MOCK_PWM_CHANNELS];
+    int count = 0;
+    double steady_ma = 0.0, peak = 0.0;
+
+    for (int i = 0; i < MOCK_GPIOS; i++) {
+        if (s_gpios[i].initialized && s_gpios[i].level == s_model.active_high) {
+            steady_ma += s_model.led_ma;
+        }
+    }
+    for (int i = 0; i < MOCK_PWM_CHANNELS; i++) {
+        if (s_pwm_channels[i].configured && mock_on_window(&s_pwm_channels[i], &starts[count], &lens[count])) {
+            if (aligned) {
+                starts[count] = 0.0;
+            }
+            count++;
+        }
+    }
+    /* the overlap is largest at the start of one of the windows */
+    for (int i = 0; i < count; i++) {
+        double ma = 0.0;
+        for (int j = 0; j < count; j++) {
+            double offset = starts[i] - starts[j];
+            if (offset < 0.0) {
+                offset += 1.0;
+            }
+            if (offset < lens[j]) {
+                ma += s_model.led_ma;
+            }
+        }
+        if (ma > peak) {
+            peak = ma;
+        }
+    }
+    return steady_ma + peak;
+}
+
+double light_hal_mock_average_ma(const light_hal_mock_stats_t *stats)
+{
+    if (stats->elapsed_us <= 0) {
+        return 0.0;
+    }
+    return stats->charge_mah * US_PER_HOUR / (double)stats->elapsed_us;
+}
+
+/********************* light_hal.h backend **************************/
+
+esp_err_t light_hal_pwm_timer_config(uint8_t timer, uint32_t freq_hz, uint8_t resolution_bits)
+{
+    if (timer >= MOCK_PWM_TIMERS || resolution_bits == 0 || resolution_bits > 20 || freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_account();
+    s_pwm_timers[timer] = (mock_pwm_timer_t) {
+        .configured = true,
+        .running = true,
+        .freq_hz = freq_hz,
+        .resolution_bits = resolution_bits,
+    };
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_TIMER_CONFIG, timer, freq_hz);
+    return ESP_OK;
+}
+
+esp_err_t light_hal_pwm_channel_config(uint8_t channel, int gpio, uint8_t timer, uint32_t duty, uint32_t hpoint)
+{
+    if (channel >= MOCK_PWM_CHANNELS || timer >= MOCK_PWM_TIMERS || !s_pwm_timers[timer].configured ||
+            gpio < 0 || gpio >= MOCK_GPIOS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_account();
+    s_pwm_channels[channel] = (mock_pwm_channel_t) {
+        .configured = true,
+        .timer = timer,
+        .duty = duty,
+        .hpoint = hpoint,
+    };
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_CHANNEL_CONFIG, channel, duty);
+    return ESP_OK;
+}
+
+void light_hal_pwm_set_duty(uint8_t channel, uint32_t duty)
+{
+    if (channel >= MOCK_PWM_CHANNELS) {
+        return;
+    }
+    mock_account();
+    s_pwm_channels[channel].fading = false;
+    s_pwm_channels[channel].duty = duty;
+    s_pwm_channels[channel].stopped = false;
+    s_stats.duty_changes++;
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_DUTY, channel, duty);
+}
+
+uint32_t light_hal_pwm_get_duty(uint8_t channel)
+{
+    if (channel >= MOCK_PWM_CHANNELS) {
+        return 0;
+    }
+    const mock_pwm_channel_t *ch = &s_pwm_channels[channel];
+    return ch->fading ? mock_fade_walk(ch, s_now_us, s_now_us, NULL) : ch->duty;
+}
+
+void light_hal_pwm_stop(uint8_t channel, uint32_t idle_level)
+{
+    if (channel >= MOCK_PWM_CHANNELS) {
+        return;
+    }
+    mock_account();
+    mock_fade_settle(&s_pwm_channels[channel]);
+    s_pwm_channels[channel].stopped = true;
+    s_pwm_channels[channel].idle_level = idle_level;
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_STOP, channel, idle_level);
+}
+
+void light_hal_pwm_timer_pause(uint8_t timer)
+{
+    if (timer >= MOCK_PWM_TIMERS) {
+        return;
+    }
+    mock_account();
+    s_pwm_timers[timer].running = false;
+    s_stats.timer_pauses++;
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_TIMER_PAUSE, timer, 0);
+}
+
+void light_hal_pwm_timer_resume(uint8_t timer)
+{
+    if (timer >= MOCK_PWM_TIMERS) {
+        return;
+    }
+    mock_account();
+    s_pwm_timers[timer].running = true;
+    s_stats.timer_resumes++;
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_TIMER_RESUME, timer, 0);
+}
+
+esp_err_t light_hal_pwm_fade_install(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t light_hal_pwm_fade(uint8_t channel, uint32_t start_duty, const light_hal_fade_range_t *ranges, size_t count,
+                             light_hal_fade_cb_t done, void *arg)
+{
+    if (channel >= MOCK_PWM_CHANNELS || !s_pwm_channels[channel].configured || !ranges || count == 0 ||
+            count > LIGHT_HAL_FADE_RANGES_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_pwm_channel_t *ch = &s_pwm_channels[channel];
+    uint64_t cycles = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (ranges[i].step_num == 0 || ranges[i].cycle_num == 0 || ranges[i].step_num > LIGHT_HAL_FADE_PARAM_MAX ||
+                ranges[i].cycle_num > LIGHT_HAL_FADE_PARAM_MAX || ranges[i].scale > LIGHT_HAL_FADE_PARAM_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        cycles += (uint64_t)ranges[i].step_num * ranges[i].cycle_num;
+    }
+    mock_account();
+    memcpy(ch->fade_ranges, ranges, count * sizeof(ranges[0]));
+    ch->fade_count = count;
+    ch->duty = start_duty;
+    ch->stopped = false;
+    ch->fading = true;
+    ch->fade_start_us = s_now_us;
+    ch->fade_end_us = s_now_us + (int64_t)(cycles * mock_period_us(ch) + 0.5);
+    ch->fade_done = done;
+    ch->fade_arg = arg;
+    s_stats.fades++;
+    mock_record(LIGHT_HAL_MOCK_EV_PWM_FADE, channel, (uint32_t)count);
+    return ESP_OK;
+}
+
+void light_hal_pwm_fade_stop(uint8_t channel)
+{
+    if (channel >= MOCK_PWM_CHANNELS) {
+        return;
+    }
+    mock_account();
+    mock_fade_settle(&s_pwm_channels[channel]);
+}
+
+void light_hal_gpio_init(int gpio)
+{
+    if (gpio < 0 || gpio >= MOCK_GPIOS) {
+        return;
+    }
+    mock_account();
+    s_gpios[gpio].initialized = true;
+    s_gpios[gpio].level = !s_model.active_high;
+}
+
+void light_hal_gpio_set(int gpio, bool level)
+{
+    if (gpio < 0 || gpio >= MOCK_GPIOS) {
+        return;
+    }
+    mock_account();
+    s_gpios[gpio].level = level;
+    s_stats.gpio_holds++;
+    mock_record(LIGHT_HAL_MOCK_EV_GPIO_HOLD, (uint8_t)gpio, level);
+}
+
+esp_err_t light_hal_task_start(light_hal_task_fn_t fn)
+{
+    if (s_task_fn) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_task_fn = fn;
+    return ESP_OK;
+}
+
+void light_hal_task_wake(void)
+{
+    s_task_woken = s_task_fn != NULL;
+}
+
+esp_err_t light_hal_lp_seq_start(int gpio)
+{
+    if (gpio < 0 || gpio >= MOCK_GPIOS || !s_gpios[gpio].initialized) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_lp_gpio = gpio;
+    s_lp_running = true;
+    /* ulp_lp_core_run() wakes the LP core right away */
+    mock_lp_step();
+    return ESP_OK;
+}
+
+void light_hal_lp_seq_stop(void)
+{
+    s_lp_running = false;
+}
+
+lp_seq_t *light_hal_lp_seq(void)
+{
+    return &s_lp_seq;
+}
+
+esp_err_t light_hal_timer_create(light_hal_timer_cb_t cb, void *arg, const char *name, light_hal_timer_t *out)
+{
+    for (int i = 0; i < MOCK_TIMERS; i++) {
+        if (!s_timers[i].used) {
+            s_timers[i] = (struct light_hal_timer_s) {
+                .used = true,
+                .cb = cb,
+                .arg = arg,
+                .name = name,
+            };
+            *out = &s_timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void light_hal_timer_start_once(light_hal_timer_t timer, uint64_t timeout_us)
+{
+    timer->armed = true;
+    timer->deadline_us = s_now_us + (int64_t)timeout_us;
+    mock_record(LIGHT_HAL_MOCK_EV_TIMER_START, (uint8_t)(timer - s_timers), (uint32_t)timeout_us);
+}
+
+void light_hal_timer_stop(light_hal_timer_t timer)
+{
+    if (timer->armed) {
+        mock_record(LIGHT_HAL_MOCK_EV_TIMER_STOP, (uint8_t)(timer - s_timers), 0);
+    }
+    timer->armed = false;
+}
+
+int64_t light_hal_time_us(void)
+{
+    return s_now_us;
+}
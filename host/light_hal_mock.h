@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "light_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** recorded hardware operation */
+typedef enum {
+    LIGHT_HAL_MOCK_EV_PWM_TIMER_CONFIG,
+    LIGHT_HAL_MOCK_EV_PWM_CHANNEL_CONFIG,
+    LIGHT_HAL_MOCK_EV_PWM_DUTY,
+    LIGHT_HAL_MOCK_EV_PWM_STOP,
+    LIGHT_HAL_MOCK_EV_PWM_FADE,
+    LIGHT_HAL_MOCK_EV_PWM_FADE_END,
+    LIGHT_HAL_MOCK_EV_PWM_TIMER_PAUSE,
+    LIGHT_HAL_MOCK_EV_PWM_TIMER_RESUME,
+    LIGHT_HAL_MOCK_EV_GPIO_HOLD,
+    LIGHT_HAL_MOCK_EV_TIMER_START,
+    LIGHT_HAL_MOCK_EV_TIMER_STOP,
+    LIGHT_HAL_MOCK_EV_TIMER_FIRE,
+    LIGHT_HAL_MOCK_EV_LP_STEP,
+} light_hal_mock_event_type_t;
+
+typedef struct {
+    int64_t time_us;
+    light_hal_mock_event_type_t type;
+    uint8_t id;         /* channel, timer, gpio or software timer index */
+    uint32_t value;     /* duty, level, frequency or timeout */
+} light_hal_mock_event_t;
+
+/** current model used to turn the event stream into charge */
+typedef struct {
+    bool active_high;       /* LED driver polarity, CONFIG_HALLOWEEN_LED_LEVEL_HIGH */
+    double led_ma;          /* LED string current at 100 % duty */
+    double pwm_timer_ma;    /* LEDC timer kept alive through light sleep */
+    double sleep_ma;        /* board floor in light sleep */
+    double wakeup_uc;       /* charge of one CPU wakeup (timer expiry) */
+    double lp_wakeup_uc;    /* charge of one LP core step, the HP core stays asleep */
+} light_hal_mock_model_t;
+
+typedef struct {
+    int64_t elapsed_us;
+    double led_on_us;       /* duty-weighted time the LED output was on */
+    double charge_mah;
+    uint32_t duty_changes;
+    uint32_t fades;
+    uint32_t timer_pauses;
+    uint32_t timer_resumes;
+    uint32_t gpio_holds;
+    uint32_t wakeups;       /* timer expiries, fade completions and light_hal_mock_wakeup() */
+    uint32_t lp_wakeups;    /* LP core steps */
+    uint32_t task_runs;     /* light task work function runs, each takes all commands posted before it */
+} light_hal_mock_stats_t;
+
+/** ESP32-C6 + MOSFET board defaults */
+#define LIGHT_HAL_MOCK_MODEL_DEFAULT()  \
+    {                                   \
+        .active_high = true,            \
+        .led_ma = 60.0,                 \
+        .pwm_timer_ma = 0.25,           \
+        .sleep_ma = 0.18,               \
+        .wakeup_uc = 45.0,              \
+        .lp_wakeup_uc = 0.5,            \
+    }
+
+/**
+ * @brief Reset clock, timers, outputs, log and counters.
+ */
+void light_hal_mock_reset(const light_hal_mock_model_t *model);
+
+/**
+ * @brief Restart statistics at the current simulated time, keeping hardware and timer state.
+ */
+void light_hal_mock_clear_stats(void);
+
+/**
+ * @brief Advance the simulated clock, firing due timers in order.
+ *
+ * A light task woken by light_hal_task_wake() runs first, and again after
+ * any callback that wakes it.
+ */
+void light_hal_mock_advance(int64_t us);
+
+/**
+ * @brief Count a CPU wakeup that did not come from a driver timer (e.g. a radio frame).
+ */
+void light_hal_mock_wakeup(void);
+
+/**
+ * @brief Snapshot of the accumulated statistics up to the current simulated time.
+ */
+void light_hal_mock_get_stats(light_hal_mock_stats_t *stats);
+
+/**
+ * @brief Recorded events, oldest first. Only the most recent ones are kept.
+ */
+size_t light_hal_mock_get_events(const light_hal_mock_event_t **events);
+
+/**
+ * @brief Level of a GPIO set with light_hal_gpio_set() or by the LP core.
+ */
+bool light_hal_mock_gpio_level(int gpio);
+
+/**
+ * @brief Output of a PWM channel as a 0.0 - 1.0 on-fraction.
+ */
+double light_hal_mock_pwm_output(uint8_t channel);
+
+/**
+ * @brief Peak LED current within one PWM period, from the duty and hpoint of every channel.
+ *
+ * @param aligned Ignore the hpoints, as if every channel turned on at the start of the period
+ */
+double light_hal_mock_peak_ma(bool aligned);
+
+/**
+ * @brief Average current over the elapsed simulated time in mA (equals mAh per hour).
+ */
+double light_hal_mock_average_ma(const light_hal_mock_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
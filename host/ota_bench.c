@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Size of a firmware update over the Zigbee OTA cluster, raw, compressed
+ * and as a delta against the image the device runs, and the cost of
+ * decoding it with main/ota_delta.c: decoder RAM and throughput. Every
+ * stream is decoded fed one OTA block at a time and in chunks of random size,
+ * and compared with the image.
+ *
+ *   ota_bench [--block bytes] [--check] new.bin [old.bin]
+ *
+ * --check fails when a decoded image differs, or a delta against a changed
+ * reference is not refused.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ota_delta.h"
+#include "ota_encode.h"
+
+#define OTA_FILE_OVERHEAD   (56 + 6)    /* OTA file header and element header */
+#define DECODE_MIN_NS       200e6       /* decode for at least this long for the throughput */
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} bench_file_t;
+
+/* the partition the image is written to, and the one the device runs */
+typedef struct {
+    const bench_file_t *old;
+    uint8_t *out;
+    size_t out_len;
+    size_t out_cap;
+} bench_flash_t;
+
+static uint32_t s_rng = 0x9e3779b9;
+
+static uint32_t bench_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool bench_load(const char *path, bench_file_t *file)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(len > 0 ? len : 1);
+    bool ok = data && len >= 0 && fread(data, 1, len, f) == (size_t)len;
+    fclose(f);
+    file->data = data;
+    file->len = ok ? (size_t)len : 0;
+    return ok;
+}
+
+static esp_err_t flash_read_old(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    const bench_flash_t *flash = ctx;
+    if (offset + len > flash->old->len)
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(buf, &flash->old->data[offset], len);
+    return ESP_OK;
+}
+
+static esp_err_t flash_read_out(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    const bench_flash_t *flash = ctx;
+    if (offset + len > flash->out_len)
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(buf, &flash->out[offset], len);
+    return ESP_OK;
+}
+
+static esp_err_t flash_write(void *ctx, const void *buf, size_t len)
+{
+    bench_flash_t *flash = ctx;
+    if (flash->out_len + len > flash->out_cap)
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(&flash->out[flash->out_len], buf, len);
+    flash->out_len += len;
+    return ESP_OK;
+}
+
+/* Decode @p stream in chunks of @p chunk bytes, or of random size up to it when @p random */
+static esp_err_t bench_decode(const uint8_t *stream, size_t len, bench_flash_t *flash, size_t chunk, bool random)
+{
+    static ota_delta_t delta;
+    const ota_delta_io_t io = {
+        .read_old = flash->old ? flash_read_old : NULL,
+        .read_out = flash_read_out,
+        .write = flash_write,
+        .ctx = flash,
+    };
+
+    flash->out_len = 0;
+    ota_delta_init(&delta, &io);
+    for (size_t pos = 0; pos < len;) {
+        size_t n = random ? 1 + bench_rand() % chunk : chunk;
+        n = n < len - pos ? n : len - pos;
+        esp_err_t err = ota_delta_feed(&delta, &stream[pos], n);
+        if (err != ESP_OK)
+            return err;
+        pos += n;
+    }
+    return ota_delta_done(&delta) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+static size_t bench_blocks(size_t len, size_t block)
+{
+    return (len + OTA_FILE_OVERHEAD + block - 1) / block;
+}
+
+/* Encode, report, and check the round trip; false on a mismatch */
+static bool bench_stream(const char *name, const bench_file_t *new_img, const bench_file_t *old_img, size_t block)
+{
+    bench_flash_t flash = { .old = old_img, .out = malloc(new_img->len), .out_cap = new_img->len };
+    uint8_t *stream = NULL;
+    bool ok = true;
+
+    double t0 = host_ns();
+    size_t len = ota_encode(old_img ? old_img->data : NULL, old_img ? old_img->len : 0, new_img->data, new_img->len,
+                            &stream);
+    double encode_ns = host_ns() - t0;
+    if (!len || !flash.out) {
+        fprintf(stderr, "ota_bench: out of memory\n");
+        free(flash.out);
+        return false;
+    }
+
+    unsigned runs = 0;
+    t0 = host_ns();
+    do {
+        ok = ok && bench_decode(stream, len, &flash, block, false) == ESP_OK;
+        runs++;
+    } while (ok && host_ns() - t0 < DECODE_MIN_NS);
+    double decode_ns = (host_ns() - t0) / runs;
+    ok = ok && flash.out_len == new_img->len && !memcmp(flash.out, new_img->data, new_img->len);
+    ok = ok && bench_decode(stream, len, &flash, block, true) == ESP_OK && !memcmp(flash.out, new_img->data, new_img->len);
+
+    printf("%-12s %9zu B %6.1f %% %7zu blocks   decode %7.1f MB/s   encode %6.2f s%s\n", name, len,
+           100.0 * len / new_img->len, bench_blocks(len, block), new_img->len / decode_ns * 1e3, encode_ns / 1e9,
+           ok ? "" : "   MISMATCH");
+
+    /* a device that runs anything else than the reference has to refuse the delta */
+    if (ok && old_img && old_img->len) {
+        bench_file_t changed = { .data = malloc(old_img->len), .len = old_img->len };
+        memcpy((uint8_t *)changed.data, old_img->data, old_img->len);
+        ((uint8_t *)changed.data)[old_img->len / 2] ^= 0x01;
+        flash.old = &changed;
+        if (bench_decode(stream, len, &flash, block, false) != ESP_ERR_INVALID_CRC) {
+            printf("delta against a changed reference was not refused\n");
+            ok = false;
+        }
+        free((void *)changed.data);
+    }
+    free(stream);
+    free(flash.out);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *paths[2] = { NULL, NULL };
+    size_t block = 64;
+    bool check = false;
+    int count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else if (!strcmp(argv[i], "--block") && i + 1 < argc) {
+            block = (size_t)atoi(argv[++i]);
+        } else if (count < 2 && argv[i][0] != '-') {
+            paths[count++] = argv[i];
+        } else {
+            count = 0;
+            break;
+        }
+    }
+    if (count == 0 || block == 0) {
+        fprintf(stderr, "usage: %s [--block bytes] [--check] new.bin [old.bin]\n", argv[0]);
+        return 2;
+    }
+
+    bench_file_t new_img, old_img;
+    if (!bench_load(paths[0], &new_img) || (paths[1] && !bench_load(paths[1], &old_img))) {
+        fprintf(stderr, "ota_bench: cannot read %s\n", paths[1] && new_img.len ? paths[1] : paths[0]);
+        return 2;
+    }
+    printf("image %s: %zu bytes, OTA blocks of %zu bytes\n", paths[0], new_img.len, block);
+    printf("raw          %9zu B %6.1f %% %7zu blocks\n", new_img.len, 100.0, bench_blocks(new_img.len, block));
+    bool ok = bench_stream("compressed", &new_img, NULL, block);
+    if (paths[1]) {
+        printf("reference %s: %zu bytes\n", paths[1], old_img.len);
+        ok = bench_stream("delta", &new_img, &old_img, block) && ok;
+    }
+    printf("decoder RAM: %zu B state + %d B stack, no window\n", sizeof(ota_delta_t), OTA_DELTA_CHUNK);
+    return check && !ok ? 1 : 0;
+}
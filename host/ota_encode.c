@@ -0,0 +1,248 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ota_delta.h"
+#include "ota_encode.h"
+
+#define HASH_BITS   16
+#define CHAIN_MAX   48          /* candidates per source and position */
+#define NO_POS      UINT32_MAX
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    bool failed;
+} enc_out_t;
+
+/* positions of a buffer by the hash of the 4 bytes they start */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    uint32_t *head;
+    uint32_t *prev;
+} enc_index_t;
+
+typedef struct {
+    uint8_t op;
+    uint32_t len;
+    uint32_t arg;
+    uint32_t from;              /* copy old: where in the reference */
+    long gain;                  /* literal bytes saved */
+} enc_match_t;
+
+typedef struct {
+    enc_index_t old;
+    enc_index_t cur;
+    uint32_t old_pos;           /* end of the previous copy old */
+    enc_out_t out;
+} enc_t;
+
+static void out_byte(enc_out_t *o, uint8_t b)
+{
+    if (o->len == o->cap) {
+        size_t cap = o->cap ? o->cap * 2 : 4096;
+        uint8_t *data = realloc(o->data, cap);
+        if (!data) {
+            o->failed = true;
+            return;
+        }
+        o->data = data;
+        o->cap = cap;
+    }
+    o->data[o->len++] = b;
+}
+
+static void out_u32(enc_out_t *o, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out_byte(o, (uint8_t)(v >> (8 * i)));
+}
+
+static void out_varint(enc_out_t *o, uint32_t v)
+{
+    while (v >= 0x80) {
+        out_byte(o, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out_byte(o, (uint8_t)v);
+}
+
+static size_t varint_len(uint32_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static void out_token(enc_out_t *o, uint8_t op, uint32_t n)
+{
+    if (n < OTA_DELTA_LEN_EXT) {
+        out_byte(o, (uint8_t)(op << 6 | n));
+    } else {
+        out_byte(o, (uint8_t)(op << 6 | OTA_DELTA_LEN_EXT));
+        out_varint(o, n - OTA_DELTA_LEN_EXT);
+    }
+}
+
+static size_t token_len(uint32_t n)
+{
+    return n < OTA_DELTA_LEN_EXT ? 1 : 1 + varint_len(n - OTA_DELTA_LEN_EXT);
+}
+
+static uint32_t zigzag(int64_t d)
+{
+    return d >= 0 ? (uint32_t)(d << 1) : (uint32_t)((-d << 1) - 1);
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+    uint32_t v = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static bool index_init(enc_index_t *idx, const uint8_t *data, size_t len)
+{
+    idx->data = data;
+    idx->len = len;
+    idx->head = malloc(sizeof(uint32_t) << HASH_BITS);
+    idx->prev = malloc(sizeof(uint32_t) * (len ? len : 1));
+    if (!idx->head || !idx->prev)
+        return false;
+    memset(idx->head, 0xff, sizeof(uint32_t) << HASH_BITS);
+    return true;
+}
+
+static void index_free(enc_index_t *idx)
+{
+    free(idx->head);
+    free(idx->prev);
+}
+
+static void index_insert(enc_index_t *idx, size_t pos)
+{
+    if (pos + OTA_DELTA_MIN_MATCH > idx->len)
+        return;
+    uint32_t h = hash4(&idx->data[pos]);
+    idx->prev[pos] = idx->head[h];
+    idx->head[h] = (uint32_t)pos;
+}
+
+static uint32_t match_len(const uint8_t *a, size_t a_max, const uint8_t *b, size_t b_max)
+{
+    size_t max = a_max < b_max ? a_max : b_max;
+    size_t n = 0;
+    while (n < max && a[n] == b[n])
+        n++;
+    return (uint32_t)n;
+}
+
+static void consider(enc_match_t *best, uint8_t op, uint32_t len, uint32_t arg, uint32_t from)
+{
+    if (len < OTA_DELTA_MIN_MATCH)
+        return;
+    long gain = (long)len - (long)token_len(len - OTA_DELTA_MIN_MATCH) - (long)varint_len(arg);
+    if (gain > best->gain)
+        *best = (enc_match_t) { .op = op, .len = len, .arg = arg, .from = from, .gain = gain };
+}
+
+static void enc_best(const enc_t *e, size_t i, enc_match_t *best)
+{
+    const uint8_t *cur = &e->cur.data[i];
+    size_t max = e->cur.len - i;
+
+    *best = (enc_match_t) { 0 };
+    if (max < OTA_DELTA_MIN_MATCH)
+        return;
+    if (e->old.len) {
+        /* right where the previous copy ended is the cheapest place, and the likeliest after a small change */
+        if (e->old_pos < e->old.len)
+            consider(best, OTA_DELTA_OP_COPY_OLD, match_len(&e->old.data[e->old_pos], e->old.len - e->old_pos, cur, max),
+                     0, e->old_pos);
+        uint32_t pos = e->old.head[hash4(cur)];
+        for (int depth = 0; pos != NO_POS && depth < CHAIN_MAX; depth++, pos = e->old.prev[pos]) {
+            uint32_t len = match_len(&e->old.data[pos], e->old.len - pos, cur, max);
+            consider(best, OTA_DELTA_OP_COPY_OLD, len, zigzag((int64_t)pos - e->old_pos), pos);
+        }
+    }
+    uint32_t pos = e->cur.head[hash4(cur)];
+    for (int depth = 0; pos != NO_POS && depth < CHAIN_MAX; depth++, pos = e->cur.prev[pos]) {
+        if (pos >= i)
+            continue;
+        consider(best, OTA_DELTA_OP_COPY_OUT, match_len(&e->cur.data[pos], max, cur, max), (uint32_t)(i - pos), pos);
+    }
+}
+
+static void enc_literals(enc_t *e, size_t from, size_t to)
+{
+    if (to == from)
+        return;
+    out_token(&e->out, OTA_DELTA_OP_LITERAL, (uint32_t)(to - from - 1));
+    for (size_t k = from; k < to; k++)
+        out_byte(&e->out, e->cur.data[k]);
+}
+
+size_t ota_encode(const uint8_t *old_img, size_t old_len, const uint8_t *new_img, size_t new_len, uint8_t **out)
+{
+    enc_t e = { 0 };
+    enc_match_t m, next;
+    size_t i = 0, lit = 0;
+
+    if (!old_img)
+        old_len = 0;
+    if (!index_init(&e.old, old_img, old_len) || !index_init(&e.cur, new_img, new_len)) {
+        index_free(&e.old);
+        index_free(&e.cur);
+        return 0;
+    }
+    for (size_t k = 0; k < old_len; k++)
+        index_insert(&e.old, k);
+
+    out_u32(&e.out, OTA_DELTA_MAGIC);
+    out_u32(&e.out, (uint32_t)new_len);
+    out_u32(&e.out, ota_delta_crc32(0, new_img, new_len));
+    out_u32(&e.out, (uint32_t)old_len);
+    out_u32(&e.out, old_len ? ota_delta_crc32(0, old_img, old_len) : 0);
+
+    while (i < new_len) {
+        enc_best(&e, i, &m);
+        index_insert(&e.cur, i);
+        if (m.gain <= 0) {
+            i++;
+            continue;
+        }
+        /* a better copy one byte later is worth a literal */
+        enc_best(&e, i + 1, &next);
+        if (next.gain > m.gain + 1) {
+            i++;
+            continue;
+        }
+        enc_literals(&e, lit, i);
+        out_token(&e.out, m.op, m.len - OTA_DELTA_MIN_MATCH);
+        out_varint(&e.out, m.arg);
+        if (m.op == OTA_DELTA_OP_COPY_OLD)
+            e.old_pos = m.from + m.len;
+        for (size_t k = i + 1; k < i + m.len; k++)
+            index_insert(&e.cur, k);
+        i += m.len;
+        lit = i;
+    }
+    enc_literals(&e, lit, new_len);
+
+    index_free(&e.old);
+    index_free(&e.cur);
+    if (e.out.failed) {
+        free(e.out.data);
+        return 0;
+    }
+    *out = e.out.data;
+    return e.out.len;
+}
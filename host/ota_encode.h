@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encoder of the stream main/ota_delta.c decodes, for ota_pack and
+ * ota_bench. Greedy matching with one position of lookahead over hash
+ * chains of the reference and of the new image itself; a copy is taken when
+ * it costs less than the literals it replaces.
+ */
+
+/**
+ * @brief Encode @p new_img, as a delta against @p old_img or compressed on its own.
+ *
+ * @param old_img Reference image, NULL for plain compression
+ * @param[out] out The stream, to be freed by the caller
+ * @return Length of the stream, 0 when out of memory
+ */
+size_t ota_encode(const uint8_t *old_img, size_t old_len, const uint8_t *new_img, size_t new_len, uint8_t **out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Packs an application image (build/light_bulb.bin) into a Zigbee OTA
+ * upgrade file for the OTA server of the coordinator. The image goes into
+ * one element: compressed (tag OTA_DELTA_ELEMENT_TAG), as a delta against
+ * the image the lights run now with --old, or as is (tag 0x0000) with --raw.
+ *
+ *   ota_pack --version v [--manufacturer code] [--image-type type] [--old old.bin | --raw] new.bin out.ota
+ *
+ * The version, manufacturer code and image type have to match
+ * CONFIG_HALLOWEEN_OTA_FILE_VERSION (of the new image), _MANUFACTURER and
+ * _IMAGE_TYPE.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ota_delta.h"
+#include "ota_encode.h"
+
+#define OTA_FILE_ID             0x0BEEF11E
+#define OTA_HEADER_VERSION      0x0100
+#define OTA_HEADER_LEN          56
+#define OTA_STACK_ZIGBEE_PRO    0x0002
+#define OTA_TAG_UPGRADE_IMAGE   0x0000
+#define OTA_ELEMENT_HEADER_LEN  6
+
+static uint8_t *pack_load(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = size > 0 ? malloc(size) : NULL;
+    if (data && fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = data ? (size_t)size : 0;
+    return data;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long version = 0, manufacturer = 0x131B, image_type = 0x1011;
+    const char *old_path = NULL, *paths[2] = { NULL, NULL };
+    bool raw = false, have_version = false;
+    int count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--version") && i + 1 < argc) {
+            version = strtoul(argv[++i], NULL, 0);
+            have_version = true;
+        } else if (!strcmp(argv[i], "--manufacturer") && i + 1 < argc) {
+            manufacturer = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--image-type") && i + 1 < argc) {
+            image_type = strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "--old") && i + 1 < argc) {
+            old_path = argv[++i];
+        } else if (!strcmp(argv[i], "--raw")) {
+            raw = true;
+        } else if (count < 2 && argv[i][0] != '-') {
+            paths[count++] = argv[i];
+        } else {
+            count = 0;
+            break;
+        }
+    }
+    if (count != 2 || !have_version || (raw && old_path)) {
+        fprintf(stderr, "usage: %s --version v [--manufacturer code] [--image-type type] [--old old.bin | --raw] "
+                        "new.bin out.ota\n", argv[0]);
+        return 2;
+    }
+
+    size_t new_len, old_len = 0, body_len;
+    uint8_t *new_img = pack_load(paths[0], &new_len);
+    uint8_t *old_img = old_path ? pack_load(old_path, &old_len) : NULL;
+    uint8_t *body = NULL;
+    if (!new_img || (old_path && !old_img)) {
+        fprintf(stderr, "ota_pack: cannot read %s\n", new_img ? old_path : paths[0]);
+        return 1;
+    }
+    if (raw) {
+        body = new_img;
+        body_len = new_len;
+    } else {
+        body_len = ota_encode(old_img, old_len, new_img, new_len, &body);
+        if (!body_len) {
+            fprintf(stderr, "ota_pack: out of memory\n");
+            return 1;
+        }
+    }
+
+    uint8_t header[OTA_HEADER_LEN + OTA_ELEMENT_HEADER_LEN] = { 0 };
+    uint32_t total = sizeof(header) + body_len;
+    put_le(&header[0], OTA_FILE_ID, 4);
+    put_le(&header[4], OTA_HEADER_VERSION, 2);
+    put_le(&header[6], OTA_HEADER_LEN, 2);
+    put_le(&header[8], 0, 2);                           /* no optional fields */
+    put_le(&header[10], manufacturer, 2);
+    put_le(&header[12], image_type, 2);
+    put_le(&header[14], version, 4);
+    put_le(&header[18], OTA_STACK_ZIGBEE_PRO, 2);
+    strncpy((char *)&header[20], "halloween-zigbee-lights", 32);
+    put_le(&header[52], total, 4);
+    put_le(&header[56], raw ? OTA_TAG_UPGRADE_IMAGE : OTA_DELTA_ELEMENT_TAG, 2);
+    put_le(&header[58], body_len, 4);
+
+    FILE *f = fopen(paths[1], "wb");
+    if (!f || fwrite(header, 1, sizeof(header), f) != sizeof(header) || fwrite(body, 1, body_len, f) != body_len) {
+        fprintf(stderr, "ota_pack: cannot write %s\n", paths[1]);
+        return 1;
+    }
+    fclose(f);
+    printf("%s: version 0x%08lx, %s, %zu of %zu bytes\n", paths[1], version,
+           raw ? "raw" : old_img ? "delta" : "compressed", body_len, new_len);
+    return 0;
+}
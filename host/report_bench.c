@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Replays one night of attribute changes of a four channel light through
+ * attr_report.c and compares it with reporting every change at once and
+ * every heartbeat on its own timer, which is what the stack does without a
+ * policy. Prints the reports and the radio wakes (TX bursts) per hour, and
+ * exits non-zero when a change is still unreported once its minimum interval
+ * has passed, or when the policy does not save radio wakes.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "attr_report.h"
+#include "effect_gen.h"
+
+#define BENCH_CHANNELS      4
+#define BENCH_HOURS         8
+#define BENCH_MIN_S         2       /* CONFIG_HALLOWEEN_REPORT_* defaults */
+#define BENCH_MAX_S         1800
+#define BENCH_LEVEL_CHANGE  8
+#define BENCH_US_PER_S      1000000LL
+
+typedef struct {
+    int64_t at_us;
+    int index;
+    int32_t value;
+} bench_event_t;
+
+typedef struct {
+    uint32_t reports;
+    uint32_t wakes;
+} bench_result_t;
+
+/* on/off, level per channel, then the effect */
+#define BENCH_ATTRS         (2 * BENCH_CHANNELS + 1)
+#define BENCH_ON(ch)        (2 * (ch))
+#define BENCH_LEVEL(ch)     (2 * (ch) + 1)
+#define BENCH_EFFECT        (2 * BENCH_CHANNELS)
+
+static bench_event_t s_events[20000];
+static size_t s_event_count;
+
+static void bench_event(int64_t at_us, int index, int32_t value)
+{
+    if (s_event_count < sizeof(s_events) / sizeof(s_events[0]))
+        s_events[s_event_count++] = (bench_event_t) { at_us, index, value };
+}
+
+/*
+ * Scene recalls every few minutes (all channels change within ~100 ms of
+ * each other as their transitions end), an effect change now and then, and
+ * short bursts of Step commands on one channel.
+ */
+static void bench_night(void)
+{
+    effect_gen_t rng;
+    int64_t t = 0, end = BENCH_HOURS * 3600 * BENCH_US_PER_S;
+
+    effect_gen_init(&rng, EFFECT_GEN_CANDLE, 31);
+    while (t < end) {
+        uint32_t r = effect_gen_rand(&rng);
+        t += (60 + (r % 420)) * BENCH_US_PER_S;
+        if (r & 0x100) {
+            for (int ch = 0; ch < BENCH_CHANNELS; ch++) {
+                int64_t at = t + ch * 30000;
+                bench_event(at, BENCH_ON(ch), (r >> (9 + ch)) & 1);
+                bench_event(at + 5000, BENCH_LEVEL(ch), (int32_t)(effect_gen_rand(&rng) & 0xff));
+            }
+        } else if (r & 0x200) {
+            bench_event(t, BENCH_EFFECT, (int32_t)((r >> 12) % 6));
+        } else {
+            int ch = (r >> 12) % BENCH_CHANNELS;
+            int32_t level = (int32_t)((r >> 16) & 0xff);
+            for (int step = 0; step < 6; step++) {
+                level = (level + 3) & 0xff;
+                bench_event(t + step * 400000, BENCH_LEVEL(ch), level);
+            }
+        }
+    }
+}
+
+static bench_result_t bench_immediate(void)
+{
+    bench_result_t res = { 0 };
+    int64_t last_us[BENCH_ATTRS] = { 0 };
+    int64_t wake_us = -1;
+    int64_t end = BENCH_HOURS * 3600 * BENCH_US_PER_S;
+
+    for (size_t e = 0; e <= s_event_count; e++) {
+        int64_t at = e < s_event_count ? s_events[e].at_us : end;
+        /* heartbeats due before this change, each on its own */
+        for (int i = 0; i < BENCH_ATTRS; i++) {
+            while (last_us[i] + BENCH_MAX_S * BENCH_US_PER_S <= at) {
+                last_us[i] += BENCH_MAX_S * BENCH_US_PER_S;
+                res.reports++;
+                res.wakes++;
+            }
+        }
+        if (e == s_event_count)
+            break;
+        res.reports++;
+        if (at != wake_us)
+            res.wakes++;
+        wake_us = at;
+        last_us[s_events[e].index] = at;
+    }
+    return res;
+}
+
+/* mirrors esp_zb_light.c: one alarm, moved earlier by a change but never later */
+static void bench_policy_run(attr_report_t *rep, int64_t now, bench_result_t *res, int64_t *due)
+{
+    uint32_t next_ms;
+    uint32_t mask = attr_report_due(rep, now, &next_ms);
+
+    if (mask) {
+        res->wakes++;
+        res->reports += __builtin_popcount(mask);
+    }
+    *due = next_ms == ATTR_REPORT_IDLE ? INT64_MAX : now + (int64_t)next_ms * 1000;
+}
+
+static bench_result_t bench_policy(attr_report_t *rep)
+{
+    bench_result_t res = { 0 };
+    const attr_report_cfg_t cfg = { .min_s = BENCH_MIN_S, .max_s = BENCH_MAX_S };
+    const attr_report_cfg_t level_cfg = { .min_s = BENCH_MIN_S, .max_s = BENCH_MAX_S, .change = BENCH_LEVEL_CHANGE };
+    int64_t end = BENCH_HOURS * 3600 * BENCH_US_PER_S;
+    int64_t due = 0;
+    size_t e = 0;
+
+    attr_report_init(rep);
+    for (int i = 0; i < BENCH_ATTRS; i++)
+        attr_report_add(rep, i != BENCH_EFFECT && (i & 1) ? &level_cfg : &cfg, 0);
+    for (;;) {
+        int64_t next_event = e < s_event_count ? s_events[e].at_us : end;
+        if (due <= next_event && due < end) {
+            bench_policy_run(rep, due, &res, &due);
+        } else if (e < s_event_count) {
+            attr_report_set(rep, s_events[e].index, s_events[e].value);
+            e++;
+            if (next_event + ATTR_REPORT_GATHER_MS * 1000 < due)
+                due = next_event + ATTR_REPORT_GATHER_MS * 1000;
+        } else {
+            break;
+        }
+    }
+    return res;
+}
+
+int main(void)
+{
+    attr_report_t rep;
+    int failures = 0;
+
+    bench_night();
+    bench_result_t naive = bench_immediate();
+    bench_result_t policy = bench_policy(&rep);
+
+    printf("report bench: %zu changes over %d h, %d attributes, min %d s, max %d s, level change %d\n",
+           s_event_count, BENCH_HOURS, BENCH_ATTRS, BENCH_MIN_S, BENCH_MAX_S, BENCH_LEVEL_CHANGE);
+    printf("  immediate %6.1f reports/h %6.1f radio wakes/h\n", (double)naive.reports / BENCH_HOURS,
+           (double)naive.wakes / BENCH_HOURS);
+    printf("  policy    %6.1f reports/h %6.1f radio wakes/h\n", (double)policy.reports / BENCH_HOURS,
+           (double)policy.wakes / BENCH_HOURS);
+
+    /* the last changes go out once their minimum interval has passed */
+    int64_t settle = BENCH_HOURS * 3600 * BENCH_US_PER_S;
+    for (size_t e = 0; e < s_event_count; e++) {
+        if (s_events[e].at_us > settle)
+            settle = s_events[e].at_us;
+    }
+    settle += BENCH_MIN_S * BENCH_US_PER_S + ATTR_REPORT_GATHER_MS * 1000;
+    bench_result_t tail = { 0 };
+    int64_t due;
+    bench_policy_run(&rep, settle, &tail, &due);
+    for (int i = 0; i < BENCH_ATTRS; i++) {
+        if (rep.attrs[i].reported != rep.attrs[i].value) {
+            printf("FAIL: attribute %d reported %ld, value %ld\n", i, (long)rep.attrs[i].reported,
+                   (long)rep.attrs[i].value);
+            failures++;
+        }
+    }
+    if (policy.wakes >= naive.wakes) {
+        printf("FAIL: policy %u radio wakes, immediate %u\n", (unsigned)policy.wakes, (unsigned)naive.wakes);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Runs schedule.c through the awkward days: both DST changes of a central
+ * European year, a southern hemisphere zone, entries around midnight,
+ * sunset offsets that end up on the next day, weekday masks and polar day.
+ * Prints one line per case and exits 1 when any of them is off.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "schedule.h"
+
+#define DAY_S       86400
+#define HOUR_S      3600
+#define MIN_S       60
+
+static int s_failures;
+
+/* ZCL time of a UTC civil date and time (days_from_civil, proleptic Gregorian) */
+static uint32_t zb_time(int y, int m, int d, int hh, int mm)
+{
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468 - 10957;     /* 1970 -> 2000 */
+    return (uint32_t)(days * DAY_S + hh * HOUR_S + mm * MIN_S);
+}
+
+static void check(const char *what, bool ok, uint32_t got, uint32_t want)
+{
+    printf("%-52s %s", what, ok ? "ok" : "FAILED");
+    if (!ok) {
+        printf("  got %u (%+d s from %u)", got, (int)(got - want), want);
+        s_failures++;
+    }
+    printf("\n");
+}
+
+static void check_next(const char *what, const schedule_t *sched, uint32_t now, uint32_t want)
+{
+    uint32_t at = 0;
+    bool found = schedule_next(sched, now, &at);
+    check(what, found && at == want, at, want);
+}
+
+static void check_near(const char *what, const schedule_t *sched, uint32_t now, uint32_t want, uint32_t tolerance)
+{
+    uint32_t at = 0;
+    bool found = schedule_next(sched, now, &at);
+    check(what, found && (at > want ? at - want : want - at) <= tolerance, at, want);
+}
+
+static schedule_entry_t entry(uint8_t days, schedule_anchor_t anchor, int minute, schedule_action_t action)
+{
+    return (schedule_entry_t) {
+        .days = days, .anchor = anchor, .minute = (int16_t)minute, .channel = SCHEDULE_CHANNEL_ALL, .action = action,
+    };
+}
+
+/* Prague 2025: CET/CEST, changes at 01:00 UTC on the last Sundays of March and October */
+static schedule_t prague(void)
+{
+    return (schedule_t) {
+        .zone = {
+            .zone_s = HOUR_S,
+            .dst_shift_s = HOUR_S,
+            .dst_start = zb_time(2025, 3, 30, 1, 0),
+            .dst_end = zb_time(2025, 10, 26, 1, 0),
+            .latitude = 5008,
+            .longitude = 1442,
+        },
+    };
+}
+
+static void check_dst(void)
+{
+    schedule_t s = prague();
+    s.entries[s.count++] = entry(0x7f, SCHEDULE_AT_TIME, 2 * 60 + 30, SCHEDULE_ACTION_ON);
+
+    check_next("02:30 on a normal winter night", &s, zb_time(2025, 3, 28, 12, 0), zb_time(2025, 3, 29, 1, 30));
+    check_next("02:30 skipped by the spring change fires at 03:00", &s, zb_time(2025, 3, 29, 12, 0),
+               zb_time(2025, 3, 30, 1, 0));
+    check_next("02:30 the night after the spring change", &s, zb_time(2025, 3, 30, 12, 0), zb_time(2025, 3, 31, 0, 30));
+    check_next("02:30 twice in the autumn night fires the first", &s, zb_time(2025, 10, 25, 12, 0),
+               zb_time(2025, 10, 26, 0, 30));
+    check_next("... and not the second", &s, zb_time(2025, 10, 26, 0, 30), zb_time(2025, 10, 27, 1, 30));
+    check("the autumn change day fires it once", __builtin_popcount(schedule_due(&s, zb_time(2025, 10, 26, 0, 0),
+          zb_time(2025, 10, 26, 23, 0))) == 1, 0, 0);
+}
+
+static void check_midnight(void)
+{
+    schedule_t s = prague();
+    schedule_state_t state;
+
+    s.entries[s.count++] = entry(0x7f, SCHEDULE_AT_TIME, 23 * 60 + 50, SCHEDULE_ACTION_OFF);
+    s.entries[s.count++] = entry(0x7f, SCHEDULE_AT_TIME, 10, SCHEDULE_ACTION_ON);
+
+    check_next("23:50 next", &s, zb_time(2025, 1, 10, 22, 0), zb_time(2025, 1, 10, 22, 50));
+    check_next("00:10 next day after 23:50", &s, zb_time(2025, 1, 10, 22, 55), zb_time(2025, 1, 10, 23, 10));
+    schedule_state(&s, zb_time(2025, 1, 10, 23, 5), &state);
+    check("off between 23:50 and 00:10", state.on[0] == 0, (uint32_t)state.on[0], 0);
+    schedule_state(&s, zb_time(2025, 1, 10, 23, 15), &state);
+    check("on after 00:10", state.on[0] == 1, (uint32_t)state.on[0], 1);
+    check("23:50 and 00:10 both due across midnight",
+          schedule_due(&s, zb_time(2025, 1, 10, 22, 0), zb_time(2025, 1, 10, 23, 30)) == 0x3, 0, 0);
+}
+
+static void check_sun(void)
+{
+    schedule_t s = prague();
+    schedule_state_t state;
+
+    s.entries[s.count++] = entry(0x7f, SCHEDULE_AT_SUNSET, 30, SCHEDULE_ACTION_ON);
+    /* sunset at Prague on 2025-06-21 is 21:14 CEST, 19:14 UTC */
+    check_near("sunset + 30 min at midsummer", &s, zb_time(2025, 6, 21, 12, 0), zb_time(2025, 6, 21, 19, 44), 3 * MIN_S);
+    /* 2025-12-21: 16:02 CET, 15:02 UTC */
+    check_near("sunset + 30 min at midwinter", &s, zb_time(2025, 12, 21, 12, 0), zb_time(2025, 12, 21, 15, 32), 3 * MIN_S);
+
+    s.entries[0] = entry(0x7f, SCHEDULE_AT_SUNSET, 6 * 60, SCHEDULE_ACTION_OFF);
+    check_near("sunset + 6 h lands after midnight", &s, zb_time(2025, 6, 21, 22, 0), zb_time(2025, 6, 22, 1, 14), 3 * MIN_S);
+    schedule_state(&s, zb_time(2025, 6, 22, 2, 0), &state);
+    check("state after a next-day sunset entry", state.on[0] == 0, (uint32_t)state.on[0], 0);
+
+    s.zone.latitude = 7822;     /* Longyearbyen, midnight sun */
+    s.zone.longitude = 1565;
+    uint32_t at;
+    check("no sunset in polar day", !schedule_next(&s, zb_time(2025, 6, 21, 12, 0), &at), at, 0);
+}
+
+static void check_weekdays(void)
+{
+    schedule_t s = prague();
+
+    /* 2025-01-12 is a Sunday */
+    s.entries[s.count++] = entry(1u << 1, SCHEDULE_AT_TIME, 18 * 60, SCHEDULE_ACTION_ON);
+    check_next("Monday only, asked on Sunday", &s, zb_time(2025, 1, 12, 12, 0), zb_time(2025, 1, 13, 17, 0));
+    check_next("Monday only, asked Monday evening", &s, zb_time(2025, 1, 13, 20, 0), zb_time(2025, 1, 20, 17, 0));
+}
+
+static void check_south(void)
+{
+    /* Sydney 2025: AEST +10, AEDT from 2024-10-06 to 2025-04-06 and from 2025-10-05 (16:00 UTC the day before) */
+    schedule_t s = {
+        .zone = {
+            .zone_s = 10 * HOUR_S,
+            .dst_shift_s = HOUR_S,
+            .dst_start = zb_time(2025, 10, 4, 16, 0),
+            .dst_end = zb_time(2025, 4, 5, 16, 0),
+        },
+    };
+    s.entries[s.count++] = entry(0x7f, SCHEDULE_AT_TIME, 20 * 60, SCHEDULE_ACTION_ON);
+    check_next("20:00 AEDT in January", &s, zb_time(2025, 1, 10, 0, 0), zb_time(2025, 1, 10, 9, 0));
+    check_next("20:00 AEST in July", &s, zb_time(2025, 7, 10, 0, 0), zb_time(2025, 7, 10, 10, 0));
+    check_next("20:00 AEDT in December", &s, zb_time(2025, 12, 10, 0, 0), zb_time(2025, 12, 10, 9, 0));
+}
+
+int main(void)
+{
+    check_dst();
+    check_midnight();
+    check_sun();
+    check_weekdays();
+    check_south();
+    if (s_failures)
+        fprintf(stderr, "schedule_check: %d case(s) failed\n", s_failures);
+    return s_failures ? 1 : 0;
+}
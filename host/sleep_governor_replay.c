@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Replays a trace of idle gaps through sleep_governor.c and compares its
+ * charge with sleeping on every gap and with the stack's fixed threshold.
+ * Exits non-zero when the governor loses to either, learns a threshold
+ * below break-even or outside its limits, or never skips a gap.
+ *
+ *   sleep_governor_replay [trace]
+ *
+ * The trace is either the decoded binary log of a device built with
+ * CONFIG_HALLOWEEN_SLEEP_GOVERNOR_TRACE ("Sleep gap <us> us, awake <us> us"
+ * lines, see tools/blog_decode.py) or "gap_us,awake_us[,scheduled_us]" CSV
+ * lines. scheduled_us is the sleep the stack offered, a received frame can
+ * end it early; it defaults to the gap. Without a trace a synthetic one is
+ * used: 4 s polls with bursts of frames a few ms apart and a report. sleep_gaps.csv is a
+ * short trace in the same shape, the bench target runs both.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sleep_governor.h"
+
+#define ACTIVE_MA       22.0    /* CPU on, radio idle */
+#define TRANSITION_MA   32.0    /* sleep entry/exit: context save, PLL relock, radio recalibration */
+#define SLEEP_MA        0.18    /* light sleep floor */
+#define STACK_THRESHOLD_MS  20  /* esp_zb_sleep_set_threshold() default */
+
+typedef struct {
+    uint32_t gap_us;
+    uint32_t awake_us;      /* measured entry/exit overhead of that sleep */
+    uint32_t scheduled_us;  /* sleep the stack offered, the stack threshold applies to this */
+} gap_t;
+
+typedef struct {
+    double charge_uc;
+    uint32_t sleeps;
+    sleep_governor_t gov;   /* governed replay: the governor as the trace left it */
+} replay_result_t;
+
+static gap_t *s_gaps;
+static size_t s_count;
+static size_t s_cap;
+
+static void add_gap(uint32_t gap_us, uint32_t awake_us, uint32_t scheduled_us)
+{
+    if (s_count == s_cap) {
+        s_cap = s_cap ? 2 * s_cap : 1024;
+        s_gaps = realloc(s_gaps, s_cap * sizeof(*s_gaps));
+        if (!s_gaps) {
+            exit(1);
+        }
+    }
+    s_gaps[s_count++] = (gap_t) { gap_us, awake_us, scheduled_us };
+}
+
+static void load_trace(FILE *f)
+{
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned gap, awake, scheduled;
+        const char *p = strstr(line, "Sleep gap ");
+        if (p && sscanf(p, "Sleep gap %u us, awake %u us", &gap, &awake) == 2) {
+            add_gap(gap, awake, gap);
+        } else {
+            int n = sscanf(line, "%u,%u,%u", &gap, &awake, &scheduled);
+            if (n >= 2) {
+                add_gap(gap, awake, n == 3 ? scheduled : gap);
+            }
+        }
+    }
+}
+
+static void synthetic_trace(void)
+{
+    srand(1);
+    for (int poll = 0; poll < 900; poll++) {
+        add_gap(4000000, 1800 + rand() % 400, 4000000);
+        if (poll % 30 == 0) {
+            /* a command exchange: the stack sleeps up to its APS ack timeout, MAC and APS frames cut it short */
+            for (int i = 0; i < 40; i++) {
+                uint32_t gap_us = 1200 + rand() % 1500;
+                uint32_t awake_us = 1800 + rand() % 400;
+                add_gap(gap_us, awake_us < gap_us ? awake_us : gap_us, 50000);
+            }
+            /* then the report, on its jitter and retry timers */
+            for (int i = 0; i < 5; i++) {
+                uint32_t gap_us = 5000 + rand() % 10000;
+                add_gap(gap_us, 1800 + rand() % 400, gap_us);
+            }
+        }
+    }
+}
+
+/* charge of one gap, either slept through or spent awake; a gap shorter than the entry/exit overruns */
+static double gap_charge_uc(const gap_t *gap, bool sleep)
+{
+    if (!sleep) {
+        return ACTIVE_MA * gap->gap_us / 1000.0;
+    }
+    uint32_t asleep_us = gap->gap_us > gap->awake_us ? gap->gap_us - gap->awake_us : 0;
+    return (TRANSITION_MA * gap->awake_us + SLEEP_MA * asleep_us) / 1000.0;
+}
+
+/* governed, or a fixed stack threshold (0: sleep on every gap) */
+static replay_result_t replay(bool governed, uint32_t fixed_ms)
+{
+    sleep_governor_config_t config = SLEEP_GOVERNOR_CONFIG_DEFAULT();
+    replay_result_t result = { 0 };
+    sleep_governor_t *gov = &result.gov;
+    int64_t now = 0;
+
+    sleep_governor_init(gov, &config);
+    for (size_t i = 0; i < s_count; i++) {
+        gap_t gap = s_gaps[i];
+        /* the stack only offers sleeps above its threshold */
+        uint32_t threshold_ms = governed ? gov->threshold_ms : fixed_ms;
+        bool sleep = gap.scheduled_us >= threshold_ms * 1000;
+        if (sleep && governed && !sleep_governor_should_sleep(gov, now)) {
+            /* declined: the stack offers the rest again on its next loop, taken once the probe is due */
+            int64_t wait_us = gov->last_sleep_us + (int64_t)config.probe_ms * 1000 - now;
+            if (wait_us < 0) {
+                wait_us = 0;
+            }
+            sleep = wait_us < gap.gap_us && gap.scheduled_us - wait_us >= threshold_ms * 1000;
+            if (sleep) {
+                gap_t awake = { .gap_us = (uint32_t)wait_us };
+                result.charge_uc += gap_charge_uc(&awake, false);
+                now += wait_us;
+                gap.gap_us -= (uint32_t)wait_us;
+                gap.scheduled_us -= (uint32_t)wait_us;
+                gap.awake_us = gap.awake_us < gap.gap_us ? gap.awake_us : gap.gap_us;
+                sleep = sleep_governor_should_sleep(gov, now);
+            }
+        }
+        result.charge_uc += gap_charge_uc(&gap, sleep);
+        now += gap.gap_us;
+        if (sleep) {
+            result.sleeps++;
+            if (governed) {
+                sleep_governor_record(gov, now, gap.gap_us, gap.awake_us);
+            }
+        }
+    }
+    return result;
+}
+
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        FILE *f = fopen(argv[1], "r");
+        if (!f) {
+            perror(argv[1]);
+            return 1;
+        }
+        load_trace(f);
+        fclose(f);
+    } else {
+        synthetic_trace();
+    }
+    if (s_count == 0) {
+        fprintf(stderr, "no gaps in trace\n");
+        return 1;
+    }
+
+    double total_s = 0;
+    for (size_t i = 0; i < s_count; i++) {
+        total_s += s_gaps[i].gap_us / 1e6;
+    }
+    replay_result_t always = replay(false, 0);
+    replay_result_t fixed = replay(false, STACK_THRESHOLD_MS);
+    replay_result_t governed = replay(true, 0);
+    printf("%zu gaps over %.1f s\n", s_count, total_s);
+    printf("sleep on every gap   %6u sleeps  %8.4f mA average\n", (unsigned)always.sleeps,
+           always.charge_uc / 1000.0 / total_s);
+    printf("stack threshold      %6u sleeps  %8.4f mA average\n", (unsigned)fixed.sleeps,
+           fixed.charge_uc / 1000.0 / total_s);
+    printf("sleep governor       %6u sleeps  %8.4f mA average\n", (unsigned)governed.sleeps,
+           governed.charge_uc / 1000.0 / total_s);
+
+    const sleep_governor_t *gov = &governed.gov;
+    uint32_t break_even_us = (uint32_t)((uint64_t)gov->overhead_us * gov->config.break_even_pct / 100);
+    printf("governor: overhead %u us, threshold %u ms, %u opportunities skipped\n", (unsigned)gov->overhead_us,
+           (unsigned)gov->threshold_ms, (unsigned)gov->skipped);
+    check(governed.charge_uc <= always.charge_uc, "governor draws more than sleeping on every gap");
+    check(governed.charge_uc <= fixed.charge_uc, "governor draws more than the stack threshold");
+    check(gov->threshold_ms >= gov->config.min_threshold_ms && gov->threshold_ms <= gov->config.max_threshold_ms,
+          "threshold outside its limits");
+    check(gov->threshold_ms * 1000 >= break_even_us, "threshold below break-even");
+    check(gov->skipped > 0, "no gap skipped");
+    return s_failures ? 1 : 0;
+}
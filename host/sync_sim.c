@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * A yard of sleepy lights with drifting clocks, each running time_sync.c on
+ * the beacons the coordinator broadcasts. A beacon waits at the parent until
+ * the light next polls: at the idle poll interval, or every sync poll while
+ * the light listens around the time it expects the beacon. Prints, per hour,
+ * how far the lights' idea of the shared time is off and how far apart they
+ * are, and the effect keyframe error that adds the LEDC clock error of one
+ * effect batch.
+ *
+ *   sync_sim [--lights n] [--hours h] [--beacon-s s] [--sync-poll-ms ms] [--idle-poll-ms ms]
+ *            [--drift-ppm ppm] [--ledc-ppm ppm] [--batch-ms ms] [--relay-ms ms] [--check]
+ *
+ * --relay-ms puts every other light behind a router that holds each broadcast
+ * for up to that long before passing it on (64 ms in the Zigbee stack). Those
+ * delays are not bounded by the poll wait, so those lights fall back to the
+ * lowest line and stay within a few tens of ms.
+ * --check fails when the lights are more than 10 ms apart after the first hour.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "time_sync.h"
+
+#define SEC_US              1000000.0
+#define LIGHTS_MAX          64
+#define WARMUP_US           (3600 * SEC_US)
+#define CHECK_SPREAD_US     10000.0
+#define PROBES_PER_BEACON   8
+#define MAC_LATENCY_US      3000.0      /* poll to frame received */
+#define MAC_JITTER_US       2000.0
+#define WANDER_PPM          0.5         /* drift random walk per beacon */
+
+typedef struct {
+    int lights;
+    double hours;
+    double beacon_s;
+    double sync_poll_ms;
+    double idle_poll_ms;
+    double drift_ppm;
+    double ledc_ppm;
+    double batch_ms;
+    double relay_ms;
+} sim_args_t;
+
+/* one light: its clock is local = anchor_local + (t - anchor_t) * (1 + drift) */
+typedef struct {
+    time_sync_t sync;
+    double anchor_t;
+    double anchor_local;
+    double drift;
+    double idle_phase_us;       /* local time of some idle poll */
+} sim_light_t;
+
+static uint32_t s_rng = 0x2545f491;
+
+static double sim_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return (s_rng >> 8) / (double)(1 << 24);
+}
+
+static double light_local(const sim_light_t *l, double t)
+{
+    return l->anchor_local + (t - l->anchor_t) * (1.0 + l->drift);
+}
+
+/* first idle poll at or after local time @p local */
+static double light_idle_poll(const sim_light_t *l, double local, double idle_us)
+{
+    return l->idle_phase_us + ceil((local - l->idle_phase_us) / idle_us) * idle_us;
+}
+
+/*
+ * Local time @p l gets the beacon that is ready at the parent at true time
+ * @p ready, and how long it can have waited there as the light sees it.
+ */
+static double light_receive(const sim_light_t *l, const sim_args_t *args, double ready, double *wait_us)
+{
+    double idle_us = args->idle_poll_ms * 1000;
+    double fast_us = args->sync_poll_ms * 1000;
+    double at = light_local(l, ready);
+    int64_t open, close;
+
+    if (time_sync_window(&l->sync, (int64_t)fast_us, &open, &close) && at <= close) {
+        if (at <= open) {
+            /* already there when the window opens, or at an idle poll before */
+            double poll = light_idle_poll(l, at, idle_us);
+            *wait_us = poll <= open ? idle_us : open - (poll - idle_us);
+            return poll <= open ? poll : open;
+        }
+        *wait_us = fast_us;
+        return open + ceil((at - open) / fast_us) * fast_us;
+    }
+    *wait_us = idle_us;
+    return light_idle_poll(l, at, idle_us);
+}
+
+typedef struct {
+    double max_err;
+    double max_spread;
+    double sum_spread;
+    uint32_t probes;
+} sim_stats_t;
+
+int main(int argc, char **argv)
+{
+    sim_args_t args = {
+        .lights = 24, .hours = 6, .beacon_s = 120, .sync_poll_ms = 20, .idle_poll_ms = 4000,
+        .drift_ppm = 300, .ledc_ppm = 500, .batch_ms = 1900,
+    };
+    static sim_light_t lights[LIGHTS_MAX];
+    bool check = false;
+
+    for (int i = 1; i < argc; i++) {
+        double *opt = NULL;
+        if (!strcmp(argv[i], "--check")) {
+            check = true;
+            continue;
+        } else if (!strcmp(argv[i], "--lights") && i + 1 < argc) {
+            args.lights = atoi(argv[++i]);
+            continue;
+        } else if (!strcmp(argv[i], "--hours")) {
+            opt = &args.hours;
+        } else if (!strcmp(argv[i], "--beacon-s")) {
+            opt = &args.beacon_s;
+        } else if (!strcmp(argv[i], "--sync-poll-ms")) {
+            opt = &args.sync_poll_ms;
+        } else if (!strcmp(argv[i], "--idle-poll-ms")) {
+            opt = &args.idle_poll_ms;
+        } else if (!strcmp(argv[i], "--drift-ppm")) {
+            opt = &args.drift_ppm;
+        } else if (!strcmp(argv[i], "--ledc-ppm")) {
+            opt = &args.ledc_ppm;
+        } else if (!strcmp(argv[i], "--batch-ms")) {
+            opt = &args.batch_ms;
+        } else if (!strcmp(argv[i], "--relay-ms")) {
+            opt = &args.relay_ms;
+        }
+        if (!opt || i + 1 >= argc || args.lights < 2 || args.lights > LIGHTS_MAX) {
+            fprintf(stderr, "usage: %s [--lights 2-%d] [--hours h] [--beacon-s s] [--sync-poll-ms ms] [--idle-poll-ms ms]\n"
+                            "       [--drift-ppm ppm] [--ledc-ppm ppm] [--batch-ms ms] [--relay-ms ms] [--check]\n", argv[0], LIGHTS_MAX);
+            return 2;
+        }
+        *opt = atof(argv[++i]);
+    }
+
+    for (int i = 0; i < args.lights; i++) {
+        sim_light_t *l = &lights[i];
+        time_sync_init(&l->sync);
+        l->anchor_t = 0;
+        l->anchor_local = sim_rand() * 3600 * SEC_US;              /* booted at different times */
+        l->drift = (sim_rand() * 2 - 1) * args.drift_ppm * 1e-6;
+        l->idle_phase_us = sim_rand() * args.idle_poll_ms * 1000;
+    }
+
+    printf("%d lights, beacon every %.0f s, sync poll %.0f ms, idle poll %.0f ms, drift +-%.0f ppm\n", args.lights,
+           args.beacon_s, args.sync_poll_ms, args.idle_poll_ms, args.drift_ppm);
+    printf("hour  max error  max spread  mean spread   keyframe error (LEDC %.0f ppm over %.0f ms)\n", args.ledc_ppm,
+           args.batch_ms);
+
+    double beacon_us = args.beacon_s * SEC_US;
+    double end_us = args.hours * 3600 * SEC_US;
+    double ledc_us = args.ledc_ppm * 1e-6 * args.batch_ms * 1000;
+    sim_stats_t hour = { 0 };
+    double worst_spread = 0;
+    int hour_index = 0;
+
+    for (double t = beacon_us; t < end_us; t += beacon_us) {
+        double ready = t + MAC_LATENCY_US + sim_rand() * MAC_JITTER_US;
+
+        for (int i = 0; i < args.lights; i++) {
+            sim_light_t *l = &lights[i];
+            double wait_us;
+            double relay = args.relay_ms > 0 && i % 2 ? sim_rand() * args.relay_ms * 1000 : 0;
+            double local = light_receive(l, &args, ready + relay, &wait_us);
+            time_sync_add(&l->sync, (int64_t)local, (int64_t)t, (int64_t)wait_us);
+        }
+
+        /* how far off the lights are until the next beacon, then their clocks wander */
+        for (int p = 1; p <= PROBES_PER_BEACON; p++) {
+            double probe = t + beacon_us * p / (PROBES_PER_BEACON + 1);
+            double lo = INFINITY, hi = -INFINITY;
+            for (int i = 0; i < args.lights; i++) {
+                double err = time_sync_remote(&lights[i].sync, (int64_t)light_local(&lights[i], probe)) - probe;
+                lo = fmin(lo, err);
+                hi = fmax(hi, err);
+                hour.max_err = fmax(hour.max_err, fabs(err));
+            }
+            hour.max_spread = fmax(hour.max_spread, hi - lo);
+            hour.sum_spread += hi - lo;
+            hour.probes++;
+            if (probe >= WARMUP_US)
+                worst_spread = fmax(worst_spread, hi - lo);
+        }
+        for (int i = 0; i < args.lights; i++) {
+            sim_light_t *l = &lights[i];
+            double next = t + beacon_us;
+            l->anchor_local = light_local(l, next);
+            l->anchor_t = next;
+            l->drift += (sim_rand() * 2 - 1) * WANDER_PPM * 1e-6;
+        }
+
+        if (t + beacon_us >= (hour_index + 1) * 3600 * SEC_US || t + beacon_us >= end_us) {
+            printf("%4d  %7.2f ms  %7.2f ms  %8.2f ms   %7.2f ms\n", hour_index + 1, hour.max_err / 1000,
+                   hour.max_spread / 1000, hour.sum_spread / hour.probes / 1000, (hour.max_spread + ledc_us) / 1000);
+            hour = (sim_stats_t) { 0 };
+            hour_index++;
+        }
+    }
+    if (check && worst_spread > CHECK_SPREAD_US) {
+        fprintf(stderr, "sync_sim: lights %.2f ms apart after the first hour\n", worst_spread / 1000);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1317 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Replays ZCL message traces through the handlers of esp_zb_light.c, built
+ * unchanged on top of zcl_stub.c and the light driver on the mock HAL, and
+ * checks the state the light ends up in: attributes, driver level, LED
+ * output and what light_state.c has stored. Prints the handler throughput
+ * and its slowest call.
+ *
+ *   zcl_replay [--trace file] [--dump] [--fuzz n] [--seed s] [--check]
+ *
+ * Trace lines are "<ms> <message>", ms since boot and not decreasing, '#'
+ * starts a comment:
+ *
+ *   <ms> attr <endpoint> <cluster> <attribute> <type> <value>|<string hex>|null [<status>]
+ *   <ms> cmd <endpoint> <cluster> <command> [<payload hex>]
+ *   <ms> expect <endpoint> on|off <level>[-<max level>]
+ *   <ms> store <endpoint> <group> <scene>
+ *   <ms> recall <endpoint> <group> <scene> <transition s> [on|off|- [<level>]]
+ *   <ms> custom <endpoint> <cluster> <command> [<payload hex>]
+ *   <ms> ota <endpoint> <upgrade status> [<payload hex>] [0x<status>]
+ *
+ * attr is a write as the stack hands it to the handler (type in ZCL
+ * numbering, 0x10 bool, 0x20 U8, ...; an octet string in hex, length byte
+ * first), cmd a Level Control command, expect a check (of a level in a range
+where a ramp was cut short). store and recall are
+ * StoreScene and RecallScene, the latter with the On/Off and CurrentLevel
+ * fields of the stack's scene entry; custom a command of a manufacturer
+ * cluster; ota a step of an image download (ZCL status numbering, 0 start
+ * with the image size as a U32, 2 a received block, ...). Without --trace a
+ * generated trace is played: bursts of On/Off writes, slider drags, level
+ * commands, malformed messages and bursts that arrive shuffled, with the
+ * optional handlers built in also scenes, schedule entries that fire, and
+ * sync, trace and OTA commands, each followed by its expected state; --dump
+ * prints it instead. --fuzz appends n random messages, overlapping
+ * transitions included, and checks at quiet points that attributes, driver,
+ * output and stored state agree. --check returns 1 on any failed check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_zigbee_core.h"
+#include "esp_zb_light.h"
+#include "level_transition.h"
+#include "light_driver.h"
+#include "light_hal_mock.h"
+#include "light_state.h"
+#include "zcl_utility.h"
+#include "zcl_stub.h"
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+#include "schedule.h"
+#endif
+
+#define REPLAY_MSGS_MAX     100000
+#define REPLAY_DATA_MAX     40      /* a schedule of four entries */
+#define REPLAY_SETTLE_MS    (CONFIG_HALLOWEEN_STATE_COMMIT_DELAY_MS + 6000) /* longest generated transition, then the commit */
+#define REPLAY_QUIET_MS     400     /* past the coalescing window and a report gather */
+#define REPLAY_MONDAY_NOON  814881600u  /* ZCL time of 2025-10-27 12:00 UTC, where generated traces set the clock */
+#define REPLAY_SCENES       8       /* group 1-2, scene 1-4: fewer than the scene table evicts at */
+
+/* handlers of optional features the generators have messages for */
+#define REPLAY_FEATURES     (CONFIG_HALLOWEEN_SCENES_ENABLE || CONFIG_HALLOWEEN_SCHEDULE_ENABLE || \
+                             CONFIG_HALLOWEEN_BLINK_ENABLE || CONFIG_HALLOWEEN_SYNC_ENABLE ||      \
+                             CONFIG_HALLOWEEN_TRACE_ENABLE || CONFIG_HALLOWEEN_OTA_ENABLE ||       \
+                             CONFIG_HALLOWEEN_BATTERY_GOVERNOR)
+
+typedef enum {
+    REPLAY_ATTR,
+    REPLAY_CMD,
+    REPLAY_EXPECT,
+    REPLAY_STORE,
+    REPLAY_RECALL,
+    REPLAY_CUSTOM,
+    REPLAY_OTA,
+} replay_kind_t;
+
+/* scene entry fields of a recall */
+#define REPLAY_FIELD_ON_OFF 0x01
+#define REPLAY_FIELD_LEVEL  0x02
+
+typedef struct {
+    uint32_t ms;
+    uint8_t kind;               /* replay_kind_t */
+    uint8_t endpoint;
+    uint16_t cluster;
+    uint16_t id;                /* attribute, command, scene group or OTA status */
+    uint8_t type;               /* of the attribute */
+    uint8_t status;
+    bool null_value;
+    bool on;                    /* expected, or in the scene entry */
+    uint8_t level;
+    uint8_t level_max;          /* expected up to, where not exactly level */
+    uint8_t scene;
+    uint8_t fields;             /* REPLAY_FIELD_* of the scene entry */
+    uint16_t transition_s;
+    uint8_t size;
+    uint8_t data[REPLAY_DATA_MAX] __attribute__((aligned(4)));  /* as the stack's attribute values are */
+    unsigned line;
+} replay_msg_t;
+
+/* light model of the generator: the state every channel settles in */
+typedef struct {
+    bool on;
+    uint8_t level;
+} replay_channel_t;
+
+/* a scene the generator stored */
+typedef struct {
+    bool stored;
+    replay_channel_t state[LIGHT_CHANNELS];
+} replay_scene_t;
+
+static replay_msg_t s_msgs[REPLAY_MSGS_MAX];
+static size_t s_msg_count;
+static uint32_t s_rng = 0x2545f491;
+static unsigned s_failures;
+
+/* LEDC channel of each LED channel, see LIGHT_CHANNEL_LEDC in light_driver.c */
+static const uint8_t replay_ledc_ch[] = { 1, 0, 3, 4, 5, 2 };
+
+static uint32_t replay_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t replay_range(uint32_t lo, uint32_t hi)
+{
+    return lo + replay_rand() % (hi - lo + 1);
+}
+
+static replay_msg_t *replay_add(uint32_t ms, replay_kind_t kind, uint8_t endpoint)
+{
+    if (s_msg_count == REPLAY_MSGS_MAX) {
+        fprintf(stderr, "more than %d messages\n", REPLAY_MSGS_MAX);
+        exit(2);
+    }
+    replay_msg_t *msg = &s_msgs[s_msg_count++];
+    *msg = (replay_msg_t) { .ms = ms, .kind = kind, .endpoint = endpoint };
+    return msg;
+}
+
+static size_t replay_type_size(uint8_t type)
+{
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+    case ESP_ZB_ZCL_ATTR_TYPE_S16:
+        return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+    case ESP_ZB_ZCL_ATTR_TYPE_S32:
+    case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+static bool replay_type_is_string(uint8_t type)
+{
+    return type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING || type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING;
+}
+
+static void replay_attr(uint32_t ms, uint8_t channel, uint16_t cluster, uint16_t attr_id, uint8_t type, uint32_t value)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_ATTR, LIGHT_CHANNEL_ENDPOINT(channel));
+    msg->cluster = cluster;
+    msg->id = attr_id;
+    msg->type = type;
+    msg->size = replay_type_size(type);
+    for (size_t i = 0; i < msg->size; i++)
+        msg->data[i] = value >> (8 * i);
+}
+
+static void replay_cmd(uint32_t ms, uint8_t channel, uint8_t cmd_id, const uint8_t *payload, uint8_t size)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_CMD, LIGHT_CHANNEL_ENDPOINT(channel));
+    msg->cluster = ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL;
+    msg->id = cmd_id;
+    msg->size = size;
+    if (size)
+        memcpy(msg->data, payload, size);
+}
+
+static void replay_expect(uint32_t ms, uint8_t channel, const replay_channel_t *state)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_EXPECT, LIGHT_CHANNEL_ENDPOINT(channel));
+    msg->on = state->on;
+    msg->level = state->level;
+}
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE || CONFIG_HALLOWEEN_TRACE_ENABLE
+static void replay_custom(uint32_t ms, uint16_t cluster, uint8_t cmd_id, const void *payload, uint8_t size)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_CUSTOM, HA_ESP_LIGHT_ENDPOINT);
+    msg->cluster = cluster;
+    msg->id = cmd_id;
+    msg->size = size;
+    if (size)
+        memcpy(msg->data, payload, size);
+}
+#endif
+
+/* Generated trace */
+
+static uint32_t gen_toggle_burst(uint32_t ms, uint8_t channel, replay_channel_t *state)
+{
+    for (uint32_t n = replay_range(2, 8); n > 0; n--) {
+        state->on = replay_rand() & 1;
+        replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL,
+                    state->on);
+        ms += replay_range(1, 15);
+    }
+    return ms;
+}
+
+static uint32_t gen_slider(uint32_t ms, uint8_t channel, replay_channel_t *state)
+{
+    int level = state->level;
+
+    for (uint32_t n = replay_range(5, 25); n > 0; n--) {
+        level += (int)replay_range(0, 60) - 30;
+        level = level < 1 ? 1 : level > 254 ? 254 : level;
+        state->level = level;
+        replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                    ESP_ZB_ZCL_ATTR_TYPE_U8, state->level);
+        ms += replay_range(5, 40);
+    }
+    return ms;
+}
+
+/* One level command of each kind, the transition runs to its end */
+static uint32_t gen_level_command(uint32_t ms, uint8_t channel, replay_channel_t *state)
+{
+    bool with_on_off = replay_rand() & 1;
+    uint8_t payload[4];
+    uint32_t time_ms = 0;
+    int target;
+
+    switch (replay_range(0, 2)) {
+    case 0: {
+        uint16_t tenths = replay_range(0, 30);
+        target = replay_range(0, 255);
+        payload[0] = target;
+        payload[1] = tenths;
+        payload[2] = tenths >> 8;
+        replay_cmd(ms, channel, with_on_off ? LEVEL_CMD_MOVE_TO_LEVEL_WITH_ON_OFF : LEVEL_CMD_MOVE_TO_LEVEL, payload, 3);
+        target = target > LEVEL_TRANSITION_MAX_LEVEL ? LEVEL_TRANSITION_MAX_LEVEL : target;
+        time_ms = tenths * 100;
+        break;
+    }
+    case 1: {
+        bool down = replay_rand() & 1;
+        uint8_t step = replay_range(1, 120);
+        uint16_t tenths = replay_range(0, 20);
+        payload[0] = down;
+        payload[1] = step;
+        payload[2] = tenths;
+        payload[3] = tenths >> 8;
+        replay_cmd(ms, channel, with_on_off ? LEVEL_CMD_STEP_WITH_ON_OFF : LEVEL_CMD_STEP, payload, 4);
+        target = down ? state->level - step : state->level + step;
+        target = target < LEVEL_TRANSITION_MIN_LEVEL ? LEVEL_TRANSITION_MIN_LEVEL :
+                 target > LEVEL_TRANSITION_MAX_LEVEL ? LEVEL_TRANSITION_MAX_LEVEL : target;
+        time_ms = tenths * 100;
+        break;
+    }
+    default: {
+        bool down = replay_rand() & 1;
+        uint8_t rate = replay_range(50, 255);
+        payload[0] = down;
+        payload[1] = rate;
+        replay_cmd(ms, channel, with_on_off ? LEVEL_CMD_MOVE_WITH_ON_OFF : LEVEL_CMD_MOVE, payload, 2);
+        target = down ? LEVEL_TRANSITION_MIN_LEVEL : LEVEL_TRANSITION_MAX_LEVEL;
+        time_ms = abs(target - state->level) * 1000 / (rate == 0xff ? LEVEL_TRANSITION_DEFAULT_RATE : rate);
+        break;
+    }
+    }
+    if (with_on_off && target > LEVEL_TRANSITION_MIN_LEVEL)
+        state->on = true;
+    state->level = target;
+    if (with_on_off && target <= LEVEL_TRANSITION_MIN_LEVEL)
+        state->on = false;
+    return ms + time_ms;
+}
+
+/*
+ * A MoveToLevel switched off part way: the channel keeps the level the ramp
+ * reached, not its target, and comes back on at it. A CurrentLevel write
+ * then brings the model back to a known level.
+ */
+static uint32_t gen_cut_ramp(uint32_t ms, uint8_t channel, replay_channel_t *state)
+{
+    uint16_t tenths = replay_range(20, 30);
+    int from = state->level;
+    int target = from < 128 ? replay_range(from + 60, LEVEL_TRANSITION_MAX_LEVEL) : replay_range(1, from - 60);
+    uint8_t payload[3] = { target, tenths, tenths >> 8 };
+    replay_msg_t *msg;
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    /* a ramp under an effect jumps to its end */
+    replay_attr(ms, 0, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
+                LIGHT_DRIVER_EFFECT_NONE);
+#endif
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    /* and one under the battery cap stops at the cap */
+    replay_attr(ms, 0, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_RUNTIME_MIN_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, 0);
+#endif
+    state->on = true;
+    replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 1);
+    ms += REPLAY_QUIET_MS;
+    replay_cmd(ms, channel, LEVEL_CMD_MOVE_TO_LEVEL, payload, sizeof(payload));
+    /* early on: the ramp's whole steps may take it to its target in half its time, holding it the rest */
+    ms += tenths * 100 * replay_range(15, 45) / 100;
+    replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0);
+    ms += tenths * 100 + REPLAY_QUIET_MS;
+    for (int on = 0; on <= 1; on++) {
+        msg = replay_add(ms, REPLAY_EXPECT, LIGHT_CHANNEL_ENDPOINT(channel));
+        msg->on = on;
+        msg->level = (from < target ? from : target) + 1;
+        msg->level_max = (from < target ? target : from) - 1;
+        if (!on) {
+            replay_attr(ms + 1, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+                        ESP_ZB_ZCL_ATTR_TYPE_BOOL, 1);
+            ms += REPLAY_QUIET_MS;
+        }
+    }
+    state->level = replay_range(1, 254);
+    replay_attr(ms + 1, channel, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                ESP_ZB_ZCL_ATTR_TYPE_U8, state->level);
+    return ms + 1;
+}
+
+/* Messages the handlers have to reject without touching the light */
+static uint32_t gen_malformed(uint32_t ms, uint8_t channel)
+{
+    replay_msg_t *msg;
+    uint8_t payload[4] = { 0 };
+
+    switch (replay_range(0, 7)) {
+    case 0:
+        msg = replay_add(ms, REPLAY_ATTR, LIGHT_CHANNEL_ENDPOINT(channel));
+        msg->cluster = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF;
+        msg->type = ESP_ZB_ZCL_ATTR_TYPE_BOOL;
+        msg->null_value = true;
+        break;
+    case 1:
+        msg = replay_add(ms, REPLAY_ATTR, LIGHT_CHANNEL_ENDPOINT(channel));
+        msg->cluster = ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL;
+        msg->type = ESP_ZB_ZCL_ATTR_TYPE_U8;
+        msg->null_value = true;
+        break;
+    case 2:
+        replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_U8,
+                    replay_rand());
+        break;
+    case 3:
+        replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                    replay_range(0, 1) ? ESP_ZB_ZCL_ATTR_TYPE_U16 : ESP_ZB_ZCL_ATTR_TYPE_BOOL, replay_rand());
+        break;
+    case 4:
+        /* a write the stack failed */
+        replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL,
+                    replay_rand() & 1);
+        s_msgs[s_msg_count - 1].status = ESP_ZB_ZCL_STATUS_INVALID_VALUE;
+        break;
+    case 5:
+        /* an endpoint without a channel */
+        replay_attr(ms, LIGHT_CHANNELS + replay_range(0, 3), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                    ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 1);
+        break;
+    case 6:
+        /* a level command cut short */
+        replay_cmd(ms, channel, replay_range(LEVEL_CMD_MOVE_TO_LEVEL, LEVEL_CMD_STEP), payload, replay_range(0, 1));
+        break;
+    default:
+        replay_cmd(ms, channel, replay_range(LEVEL_CMD_STOP_WITH_ON_OFF + 1, 0xff), payload, sizeof(payload));
+        break;
+    }
+    return ms + replay_range(0, 5);
+}
+
+/* Writes to every channel that arrive in a different order than they were sent: the last one delivered wins */
+static uint32_t gen_shuffled(uint32_t ms, replay_channel_t *state)
+{
+    const size_t count = s_msg_count;
+
+    for (uint32_t n = replay_range(4, 12); n > 0; n--) {
+        uint8_t channel = replay_range(0, LIGHT_CHANNELS - 1);
+        if (replay_rand() & 1)
+            ms = gen_toggle_burst(ms, channel, &state[channel]);
+        else
+            ms = gen_slider(ms, channel, &state[channel]);
+    }
+    for (size_t i = s_msg_count - 1; i > count; i--) {
+        size_t j = count + replay_rand() % (i - count + 1);
+        replay_msg_t tmp = s_msgs[i];
+        s_msgs[i] = s_msgs[j];
+        s_msgs[j] = tmp;
+    }
+    /* delivery keeps its times, only the content moved */
+    for (size_t i = count; i < s_msg_count; i++) {
+        replay_msg_t *msg = &s_msgs[i];
+        uint8_t channel = LIGHT_ENDPOINT_CHANNEL(msg->endpoint);
+        if (msg->cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF)
+            state[channel].on = msg->data[0];
+        else
+            state[channel].level = msg->data[0];
+    }
+    uint32_t t = s_msgs[count].ms;
+    for (size_t i = count; i < s_msg_count; i++) {
+        t += replay_range(1, 10);
+        s_msgs[i].ms = t;
+    }
+    return t;
+}
+
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+static void gen_store(uint32_t ms, uint16_t group, uint8_t scene)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_STORE, HA_ESP_LIGHT_ENDPOINT);
+    msg->id = group;
+    msg->scene = scene;
+}
+
+static replay_msg_t *gen_recall(uint32_t ms, uint8_t endpoint, uint16_t group, uint8_t scene, uint16_t transition_s)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_RECALL, endpoint);
+    msg->id = group;
+    msg->scene = scene;
+    msg->transition_s = transition_s;
+    return msg;
+}
+
+/*
+ * Store a scene, change the light, recall it: with the entry fields of the
+ * stored state the snapshot comes back, with other ones it is dropped and
+ * the light stays as it is (the stub has no recall of its own). Recalls of
+ * scenes never stored, or on the other endpoints, change nothing either.
+ */
+static uint32_t gen_scene(uint32_t ms, replay_channel_t *state, replay_scene_t *scenes)
+{
+    uint16_t group = replay_range(1, 2);
+    uint8_t scene = replay_range(1, REPLAY_SCENES / 2);
+    replay_scene_t *stored = &scenes[(group - 1) * (REPLAY_SCENES / 2) + scene - 1];
+    replay_msg_t *msg;
+
+    if (replay_range(0, 2)) {
+        gen_store(ms, group, scene);
+        stored->stored = true;
+        memcpy(stored->state, state, sizeof(stored->state));
+        ms += replay_range(10, 200);
+        for (uint32_t n = replay_range(1, 3); n > 0; n--) {
+            uint8_t channel = replay_range(0, LIGHT_CHANNELS - 1);
+            ms = gen_toggle_burst(ms, channel, &state[channel]) + replay_range(10, 100);
+            ms = gen_slider(ms, channel, &state[channel]) + replay_range(10, 100);
+        }
+        ms += REPLAY_QUIET_MS;
+    }
+    switch (replay_range(0, 3)) {
+    case 0:
+    case 1: {
+        uint16_t transition_s = replay_range(0, 1) ? 0 : replay_range(1, 3);
+        bool changed = replay_range(0, 3) == 0;
+        msg = gen_recall(ms, HA_ESP_LIGHT_ENDPOINT, group, scene, transition_s);
+        msg->fields = replay_range(0, 3);
+        msg->on = stored->state[0].on ^ changed;
+        msg->level = stored->state[0].level;
+        if (changed)
+            msg->fields |= REPLAY_FIELD_ON_OFF;
+        if (stored->stored && !changed)
+            memcpy(state, stored->state, sizeof(stored->state));
+        stored->stored = stored->stored && !changed;
+        ms += transition_s * 1000;
+        break;
+    }
+    case 2:
+        gen_recall(ms, HA_ESP_LIGHT_ENDPOINT, 0x100 + group, scene, 0);
+        break;
+    default:
+        gen_recall(ms, HA_ESP_LIGHT_ENDPOINT + replay_range(1, LIGHT_CHANNELS), group, scene, 0);
+        break;
+    }
+    return ms;
+}
+#endif //CONFIG_HALLOWEEN_SCENES_ENABLE
+
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+static void gen_time_attr(uint32_t ms, uint16_t attr_id, uint8_t type, uint32_t value)
+{
+    replay_attr(ms, 0, ESP_ZB_ZCL_CLUSTER_ID_TIME, attr_id, type, value);
+}
+
+static void gen_entries(uint32_t ms, const schedule_entry_t *entries, uint8_t count)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_ATTR, HA_ESP_LIGHT_ENDPOINT);
+    msg->cluster = ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE;
+    msg->id = ZCL_ATTR_HALLOWEEN_SCHEDULE_ENTRIES_ID;
+    msg->type = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING;
+    msg->data[0] = count * sizeof(schedule_entry_t);
+    memcpy(&msg->data[1], entries, count * sizeof(schedule_entry_t));
+    msg->size = 1 + msg->data[0];
+}
+
+/* Schedule writes the handler has to reject, and the position, which only moves sunrise and sunset */
+static uint32_t gen_schedule_malformed(uint32_t ms)
+{
+    schedule_entry_t entry = { .days = 1 << 0, .minute = 600, .action = SCHEDULE_ACTION_ON };
+    replay_msg_t *msg;
+
+    switch (replay_range(0, 5)) {
+    case 0:
+        entry.action = replay_range(SCHEDULE_ACTION_MAX, 0xff);
+        gen_entries(ms, &entry, 1);
+        break;
+    case 1:
+        /* a length byte past the data */
+        gen_entries(ms, &entry, 1);
+        s_msgs[s_msg_count - 1].data[0] = replay_range(2, 0xff) * sizeof(schedule_entry_t);
+        break;
+    case 2:
+        /* not a whole number of entries */
+        gen_entries(ms, &entry, 1);
+        s_msgs[s_msg_count - 1].data[0] = replay_range(1, sizeof(entry) - 1);
+        break;
+    case 3:
+        /* the Time attribute as a U32, or the time zone as a U16 */
+        if (replay_range(0, 1))
+            gen_time_attr(ms, ESP_ZB_ZCL_ATTR_TIME_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U32, REPLAY_MONDAY_NOON);
+        else
+            gen_time_attr(ms, ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, 3600);
+        break;
+    case 4:
+        msg = replay_add(ms, REPLAY_ATTR, HA_ESP_LIGHT_ENDPOINT);
+        msg->cluster = replay_range(0, 1) ? ESP_ZB_ZCL_CLUSTER_ID_TIME : ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE;
+        msg->id = replay_range(0, 1) ? ESP_ZB_ZCL_ATTR_TIME_DST_START_ID : ZCL_ATTR_HALLOWEEN_SCHEDULE_ENTRIES_ID;
+        msg->type = msg->id == ESP_ZB_ZCL_ATTR_TIME_DST_START_ID ? ESP_ZB_ZCL_ATTR_TYPE_U32 : ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING;
+        msg->null_value = true;
+        break;
+    default:
+        replay_attr(ms, 0, ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE,
+                    replay_range(0, 1) ? ZCL_ATTR_HALLOWEEN_SCHEDULE_LATITUDE_ID : ZCL_ATTR_HALLOWEEN_SCHEDULE_LONGITUDE_ID,
+                    ESP_ZB_ZCL_ATTR_TYPE_S16, replay_range(0, 0xffff));
+        break;
+    }
+    return ms + replay_range(1, 20);
+}
+
+/*
+ * Monday noon UTC without DST, and an entry for a minute later that the
+ * device runs on its own, a malformed write or two in between. The next
+ * round sets the clock back to noon, replacing the entry before it fires
+ * again.
+ */
+static uint32_t gen_schedule(uint32_t ms, replay_channel_t *state)
+{
+    uint8_t channel = replay_range(0, LIGHT_CHANNELS - 1);
+    schedule_entry_t entries[2] = {
+        { .days = 1 << 1, .minute = 12 * 60 + 1, .channel = channel, .action = replay_range(SCHEDULE_ACTION_OFF, SCHEDULE_ACTION_LEVEL),
+          .value = replay_range(1, 254) },
+        { 0 },                                      /* unused slot */
+    };
+
+    gen_time_attr(ms, ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID, ESP_ZB_ZCL_ATTR_TYPE_S32, 0);
+    gen_time_attr(ms + 1, ESP_ZB_ZCL_ATTR_TIME_DST_SHIFT_ID, ESP_ZB_ZCL_ATTR_TYPE_S32, 0);
+    gen_time_attr(ms + 2, ESP_ZB_ZCL_ATTR_TIME_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, REPLAY_MONDAY_NOON);
+    ms += 10;
+    for (uint32_t n = replay_range(0, 2); n > 0; n--)
+        ms = gen_schedule_malformed(ms);
+    if (channel == 0 && replay_range(0, 1))
+        entries[0].channel = SCHEDULE_CHANNEL_ALL;
+    gen_entries(ms, entries, replay_range(1, 2));
+    for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++) {
+        if (entries[0].channel != SCHEDULE_CHANNEL_ALL && entries[0].channel != ch)
+            continue;
+        if (entries[0].action == SCHEDULE_ACTION_LEVEL)
+            state[ch].level = entries[0].value;
+        else
+            state[ch].on = entries[0].action == SCHEDULE_ACTION_ON;
+    }
+    /* a second late, see zb_schedule_run() */
+    return ms + 62000;
+}
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+static void gen_ota(uint32_t ms, esp_zb_zcl_ota_upgrade_status_t status, uint32_t size)
+{
+    replay_msg_t *msg = replay_add(ms, REPLAY_OTA, HA_ESP_LIGHT_ENDPOINT);
+    msg->id = status;
+    if (status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START) {
+        msg->size = sizeof(size);
+        memcpy(msg->data, &size, sizeof(size));
+    } else if (status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE) {
+        msg->size = size;
+        for (uint32_t i = 0; i < size; i++)
+            msg->data[i] = replay_rand();
+    }
+}
+
+/* A download block by block: to the end, cut off, one block too many or a failed status */
+static uint32_t gen_ota_download(uint32_t ms)
+{
+    uint32_t size = replay_range(1, 8 * REPLAY_DATA_MAX);
+    uint32_t sent = 0;
+    bool complete = replay_range(0, 2);
+
+    gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, size);
+    while (sent < size) {
+        uint32_t block = replay_range(1, REPLAY_DATA_MAX);
+        block = block < size - sent ? block : size - sent;
+        if (!complete && replay_range(0, 3) == 0)
+            break;
+        ms += replay_range(5, 50);
+        gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, block);
+        sent += block;
+    }
+    ms += replay_range(5, 50);
+    switch (complete ? 0 : replay_range(1, 3)) {
+    case 0:
+        gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY, 0);
+        gen_ota(ms + 1, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, 0);
+        gen_ota(ms + 2, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH, 0);
+        break;
+    case 1:
+        gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT, 0);
+        break;
+    case 2:
+        gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, replay_range(1, REPLAY_DATA_MAX));
+        gen_ota(ms + 1, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, 0);
+        break;
+    default:
+        gen_ota(ms, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, 0);
+        s_msgs[s_msg_count - 1].status = ESP_ZB_ZCL_STATUS_FAIL;
+        break;
+    }
+    return ms + 3;
+}
+#endif //CONFIG_HALLOWEEN_OTA_ENABLE
+
+#if REPLAY_FEATURES
+/*
+ * One message of the optional handlers that leaves On/Off and level alone:
+ * effects, the battery runtime target, sync beacons, trace reads and OTA
+ * downloads, each well-formed or not. With @p fuzz also scenes and schedule
+ * writes, whose outcome the generator does not follow.
+ */
+static uint32_t gen_feature(uint32_t ms, bool fuzz)
+{
+    switch (replay_range(0, fuzz ? 7 : 5)) {
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    case 0:
+        /* a known effect, or one as the wrong type */
+        replay_attr(ms, 0, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID,
+                    replay_range(0, 3) ? ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM : ESP_ZB_ZCL_ATTR_TYPE_U8,
+                    replay_range(LIGHT_DRIVER_EFFECT_NONE, LIGHT_DRIVER_EFFECT_MAX - 1));
+        break;
+#endif
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    case 1:
+        replay_attr(ms, 0, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_RUNTIME_MIN_ID,
+                    replay_range(0, 3) ? ESP_ZB_ZCL_ATTR_TYPE_U16 : ESP_ZB_ZCL_ATTR_TYPE_U8,
+                    replay_range(0, 1) ? 0 : replay_range(1, 1440));
+        break;
+#endif
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    case 2: {
+        uint8_t payload[6];
+        uint32_t time_s = REPLAY_MONDAY_NOON + ms / 1000;
+        uint16_t time_ms = ms % 1000;
+        memcpy(payload, &time_s, sizeof(time_s));
+        memcpy(&payload[4], &time_ms, sizeof(time_ms));
+        /* a beacon, one cut short, or another command of the light cluster */
+        replay_custom(ms, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, replay_range(0, 3) ? ZCL_CMD_HALLOWEEN_LIGHT_SYNC : replay_range(1, 0xff),
+                      payload, replay_range(0, 3) ? sizeof(payload) : replay_range(0, sizeof(payload) - 1));
+        break;
+    }
+#endif
+#if CONFIG_HALLOWEEN_TRACE_ENABLE
+    case 3: {
+        /* TraceDump prints the whole ring, the generator leaves it to trace files */
+        uint32_t seq = replay_range(0, 1) ? 0 : replay_rand();
+        replay_custom(ms, ZCL_CLUSTER_ID_HALLOWEEN_STATS, replay_range(0, 3) ? ZCL_CMD_HALLOWEEN_STATS_TRACE_READ : replay_range(2, 0xff),
+                      &seq, replay_range(0, sizeof(seq)));
+        break;
+    }
+#endif
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+    case 4:
+        if (fuzz) {
+            /* any step at any time */
+            gen_ota(ms, replay_range(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK),
+                    replay_range(1, REPLAY_DATA_MAX));
+            if (replay_range(0, 7) == 0)
+                s_msgs[s_msg_count - 1].status = ESP_ZB_ZCL_STATUS_FAIL;
+        } else {
+            ms = gen_ota_download(ms);
+        }
+        break;
+#endif
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+    case 6: {
+        uint16_t group = replay_range(1, 2);
+        uint8_t scene = replay_range(1, REPLAY_SCENES / 2);
+        if (replay_range(0, 1)) {
+            gen_store(ms, group, scene);
+        } else {
+            replay_msg_t *msg = gen_recall(ms, HA_ESP_LIGHT_ENDPOINT, group, scene, replay_range(0, 5));
+            /* no fields match any snapshot, random ones most likely drop it */
+            msg->fields = replay_range(0, 1) ? 0 : replay_range(1, 3);
+            msg->on = replay_rand() & 1;
+            msg->level = replay_range(1, 254);
+        }
+        break;
+    }
+#endif
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    case 7:
+        if (replay_range(0, 1)) {
+            ms = gen_schedule_malformed(ms);
+        } else if (replay_range(0, 1)) {
+            /* Wednesday, where no generated entry fires */
+            gen_time_attr(ms, ESP_ZB_ZCL_ATTR_TIME_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME,
+                          REPLAY_MONDAY_NOON + 2 * 86400 + replay_range(0, 600));
+        } else {
+            schedule_entry_t entry = {
+                .days = 1 << 0, .minute = replay_range(0, 1439), .channel = replay_range(0, LIGHT_CHANNELS - 1),
+                .action = replay_range(SCHEDULE_ACTION_OFF, SCHEDULE_ACTION_MAX - 1), .value = replay_range(0, 255),
+            };
+            gen_entries(ms, &entry, 1);
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    return ms + replay_range(0, 5);
+}
+#endif //REPLAY_FEATURES
+
+/* kinds of generated rounds, the optional ones where their handlers are built */
+enum {
+    ROUND_TOGGLE,
+    ROUND_SLIDER,
+    ROUND_LEVEL_COMMAND,
+    ROUND_MALFORMED,
+    ROUND_CUT_RAMP,
+    ROUND_SHUFFLED,
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+    ROUND_SCENE,
+#endif
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    ROUND_SCHEDULE,
+#endif
+#if REPLAY_FEATURES
+    ROUND_FEATURE,
+#endif
+    ROUND_KINDS,
+};
+
+static void gen_trace(unsigned rounds)
+{
+    replay_channel_t state[LIGHT_CHANNELS];
+    const light_state_t boot = LIGHT_STATE_DEFAULT();
+    uint32_t ms = 1000;
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+    replay_scene_t scenes[REPLAY_SCENES] = { 0 };
+#endif
+
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++)
+        state[channel] = (replay_channel_t) { .on = boot.on[channel], .level = boot.level[channel] };
+    for (unsigned round = 0; round < rounds; round++) {
+        uint8_t channel = replay_range(0, LIGHT_CHANNELS - 1);
+        switch (round % ROUND_KINDS) {
+        case ROUND_TOGGLE:
+            ms = gen_toggle_burst(ms, channel, &state[channel]);
+            break;
+        case ROUND_SLIDER:
+            ms = gen_slider(ms, channel, &state[channel]);
+            break;
+        case ROUND_LEVEL_COMMAND:
+            ms = gen_level_command(ms, channel, &state[channel]);
+            break;
+        case ROUND_MALFORMED:
+            for (uint32_t n = replay_range(1, 6); n > 0; n--)
+                ms = gen_malformed(ms, channel);
+            break;
+        case ROUND_CUT_RAMP:
+            ms = gen_cut_ramp(ms, channel, &state[channel]);
+            break;
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+        case ROUND_SCENE:
+            ms = gen_scene(ms, state, scenes);
+            break;
+#endif
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+        case ROUND_SCHEDULE:
+            ms = gen_schedule(ms, state);
+            break;
+#endif
+#if REPLAY_FEATURES
+        case ROUND_FEATURE:
+            for (uint32_t n = replay_range(1, 4); n > 0; n--)
+                ms = gen_feature(ms, false);
+            break;
+#endif
+        default:
+            ms = gen_shuffled(ms, state);
+            break;
+        }
+        ms += REPLAY_QUIET_MS;
+        for (uint8_t ch = 0; ch < LIGHT_CHANNELS; ch++)
+            replay_expect(ms, ch, &state[ch]);
+        ms += replay_range(100, 3000);
+    }
+}
+
+/* Random messages, transitions overlapping whatever comes next, a quiet point now and then */
+static void gen_fuzz(unsigned count)
+{
+    uint32_t ms = s_msg_count ? s_msgs[s_msg_count - 1].ms + 1000 : 1000;
+    replay_channel_t scratch;
+
+    for (unsigned i = 0; i < count; i++) {
+        uint8_t channel = replay_range(0, LIGHT_CHANNELS - 1);
+        uint8_t level;
+
+        scratch = (replay_channel_t) { .level = replay_range(1, 254) };
+        switch (replay_range(0, REPLAY_FEATURES ? 11 : 9)) {
+        case 0:
+        case 1:
+        case 2:
+            replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+                        ESP_ZB_ZCL_ATTR_TYPE_BOOL, replay_rand() & 1);
+            break;
+        case 3:
+        case 4:
+            level = replay_range(0, 255);
+            replay_attr(ms, channel, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                        ESP_ZB_ZCL_ATTR_TYPE_U8, level);
+            break;
+        case 5:
+        case 6:
+            gen_level_command(ms, channel, &scratch);
+            break;
+        case 7: {
+            uint8_t stop = replay_rand() & 1 ? LEVEL_CMD_STOP_WITH_ON_OFF : LEVEL_CMD_STOP;
+            replay_cmd(ms, channel, stop, NULL, 0);
+            break;
+        }
+        case 8:
+        case 9:
+            gen_malformed(ms, channel);
+            break;
+        default:
+#if REPLAY_FEATURES
+            gen_feature(ms, true);
+#endif
+            break;
+        }
+        ms += replay_rand() & 1 ? replay_range(0, 30) : replay_range(30, 1500);
+        if (replay_range(0, 49) == 0 || i + 1 == count) {
+            /* quiet point: the state of every channel is checked against itself, see replay_run() */
+            ms += REPLAY_SETTLE_MS;
+            replay_add(ms, REPLAY_EXPECT, 0);
+            ms += replay_range(100, 2000);
+        }
+    }
+}
+
+/* Trace file */
+
+static bool parse_u32(const char *s, uint32_t *value)
+{
+    char *end;
+    if (!s)
+        return false;
+    *value = strtoul(s, &end, 0);
+    return *end == '\0';
+}
+
+/* hex bytes appended to the data of @p msg */
+static bool parse_hex(const char *s, replay_msg_t *msg)
+{
+    for (const char *p = s; p[0] && p[1] && msg->size < REPLAY_DATA_MAX; p += 2) {
+        unsigned byte;
+        if (sscanf(p, "%2x", &byte) != 1)
+            return false;
+        msg->data[msg->size++] = byte;
+    }
+    return true;
+}
+
+static void dump_hex(const replay_msg_t *msg)
+{
+    for (size_t b = 0; b < msg->size; b++)
+        printf("%02x", msg->data[b]);
+}
+
+static bool parse_line(char *line, unsigned line_no)
+{
+    char *tok[8] = { 0 };
+    size_t n = 0;
+    uint32_t ms, endpoint, a, b, c;
+
+    for (char *t = strtok(line, " \t\r\n"); t && n < 8; t = strtok(NULL, " \t\r\n"))
+        tok[n++] = t;
+    if (n == 0 || tok[0][0] == '#')
+        return true;
+    if (n < 3 || !parse_u32(tok[0], &ms) || !parse_u32(tok[2], &endpoint))
+        return false;
+    if (s_msg_count && ms < s_msgs[s_msg_count - 1].ms)
+        return false;
+    if (strcmp(tok[1], "attr") == 0) {
+        if (n < 7 || !parse_u32(tok[3], &a) || !parse_u32(tok[4], &b) || !parse_u32(tok[5], &c))
+            return false;
+        replay_msg_t *msg = replay_add(ms, REPLAY_ATTR, endpoint);
+        msg->cluster = a;
+        msg->id = b;
+        msg->type = c;
+        msg->null_value = strcmp(tok[6], "null") == 0;
+        if (msg->null_value) {
+            msg->size = replay_type_size(c);
+        } else if (replay_type_is_string(c)) {
+            if (!parse_hex(tok[6], msg))
+                return false;
+        } else {
+            if (!parse_u32(tok[6], &a))
+                return false;
+            msg->size = replay_type_size(c);
+            for (size_t i = 0; i < msg->size; i++)
+                msg->data[i] = a >> (8 * i);
+        }
+        if (n > 7 && parse_u32(tok[7], &a))
+            msg->status = a;
+    } else if (strcmp(tok[1], "cmd") == 0 || strcmp(tok[1], "custom") == 0) {
+        if (n < 5 || !parse_u32(tok[3], &a) || !parse_u32(tok[4], &b))
+            return false;
+        replay_msg_t *msg = replay_add(ms, strcmp(tok[1], "cmd") == 0 ? REPLAY_CMD : REPLAY_CUSTOM, endpoint);
+        msg->cluster = a;
+        msg->id = b;
+        if (n > 5 && !parse_hex(tok[5], msg))
+            return false;
+    } else if (strcmp(tok[1], "store") == 0 || strcmp(tok[1], "recall") == 0) {
+        bool recall = strcmp(tok[1], "recall") == 0;
+        if (n < 5 || !parse_u32(tok[3], &a) || !parse_u32(tok[4], &b) || (recall && !parse_u32(tok[5], &c)))
+            return false;
+        replay_msg_t *msg = replay_add(ms, recall ? REPLAY_RECALL : REPLAY_STORE, endpoint);
+        msg->id = a;
+        msg->scene = b;
+        if (recall) {
+            msg->transition_s = c;
+            if (n > 6 && strcmp(tok[6], "-") != 0) {
+                msg->fields |= REPLAY_FIELD_ON_OFF;
+                msg->on = strcmp(tok[6], "on") == 0;
+            }
+            if (n > 7) {
+                if (!parse_u32(tok[7], &a))
+                    return false;
+                msg->fields |= REPLAY_FIELD_LEVEL;
+                msg->level = a;
+            }
+        }
+    } else if (strcmp(tok[1], "ota") == 0) {
+        if (n < 4 || !parse_u32(tok[3], &a))
+            return false;
+        replay_msg_t *msg = replay_add(ms, REPLAY_OTA, endpoint);
+        msg->id = a;
+        for (size_t i = 4; i < n; i++) {
+            /* the payload is bare hex, the status has a 0x */
+            if (strncmp(tok[i], "0x", 2) == 0 ? !parse_u32(tok[i], &a) : !parse_hex(tok[i], msg))
+                return false;
+            if (strncmp(tok[i], "0x", 2) == 0)
+                msg->status = a;
+        }
+    } else if (strcmp(tok[1], "expect") == 0) {
+        char *range = n > 4 ? strchr(tok[4], '-') : NULL;
+        if (range)
+            *range++ = '\0';
+        if (n < 5 || !parse_u32(tok[4], &a) || (range && !parse_u32(range, &b)))
+            return false;
+        replay_msg_t *msg = replay_add(ms, REPLAY_EXPECT, endpoint);
+        msg->on = strcmp(tok[3], "on") == 0;
+        msg->level = a;
+        msg->level_max = range ? b : 0;
+    } else {
+        return false;
+    }
+    s_msgs[s_msg_count - 1].line = line_no;
+    return true;
+}
+
+static bool load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    unsigned line_no = 0;
+
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (!parse_line(line, ++line_no)) {
+            fprintf(stderr, "%s:%u: invalid line\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void dump_trace(void)
+{
+    for (size_t i = 0; i < s_msg_count; i++) {
+        const replay_msg_t *msg = &s_msgs[i];
+        switch (msg->kind) {
+        case REPLAY_ATTR: {
+            uint32_t value = 0;
+            for (size_t b = 0; b < msg->size; b++)
+                value |= (uint32_t)msg->data[b] << (8 * b);
+            printf("%u attr %u 0x%04x 0x%04x 0x%02x ", (unsigned)msg->ms, msg->endpoint, msg->cluster, msg->id, msg->type);
+            if (msg->null_value)
+                printf("null");
+            else if (replay_type_is_string(msg->type))
+                dump_hex(msg);
+            else
+                printf("%u", (unsigned)value);
+            if (msg->status)
+                printf(" 0x%02x", msg->status);
+            printf("\n");
+            break;
+        }
+        case REPLAY_CMD:
+        case REPLAY_CUSTOM:
+            printf("%u %s %u 0x%04x 0x%02x ", (unsigned)msg->ms, msg->kind == REPLAY_CMD ? "cmd" : "custom", msg->endpoint,
+                   msg->cluster, msg->id);
+            dump_hex(msg);
+            printf("\n");
+            break;
+        case REPLAY_STORE:
+            printf("%u store %u 0x%04x %u\n", (unsigned)msg->ms, msg->endpoint, msg->id, msg->scene);
+            break;
+        case REPLAY_RECALL:
+            printf("%u recall %u 0x%04x %u %u", (unsigned)msg->ms, msg->endpoint, msg->id, msg->scene, msg->transition_s);
+            if (msg->fields)
+                printf(" %s", msg->fields & REPLAY_FIELD_ON_OFF ? (msg->on ? "on" : "off") : "-");
+            if (msg->fields & REPLAY_FIELD_LEVEL)
+                printf(" %u", msg->level);
+            printf("\n");
+            break;
+        case REPLAY_OTA:
+            printf("%u ota %u %u ", (unsigned)msg->ms, msg->endpoint, msg->id);
+            dump_hex(msg);
+            if (msg->status)
+                printf(" 0x%02x", msg->status);
+            printf("\n");
+            break;
+        default:
+            if (msg->endpoint && msg->level_max)
+                printf("%u expect %u %s %u-%u\n", (unsigned)msg->ms, msg->endpoint, msg->on ? "on" : "off", msg->level,
+                       msg->level_max);
+            else if (msg->endpoint)
+                printf("%u expect %u %s %u\n", (unsigned)msg->ms, msg->endpoint, msg->on ? "on" : "off", msg->level);
+            else
+                printf("# %u quiet point\n", (unsigned)msg->ms);
+            break;
+        }
+    }
+}
+
+/* Replay */
+
+static void replay_fail(const replay_msg_t *msg, uint8_t channel, const char *what, int expected, int actual)
+{
+    if (s_failures++ < 20)
+        printf("FAIL at %u ms (line %u): channel %u %s %d, expected %d\n", (unsigned)msg->ms, msg->line, channel, what,
+               actual, expected);
+}
+
+/* Attributes, driver and LED output agree with @p on and @p level */
+static void replay_check(const replay_msg_t *msg, uint8_t channel, bool on, uint8_t level)
+{
+    uint8_t attr_on = 0, attr_level = 0;
+    uint8_t endpoint = LIGHT_CHANNEL_ENDPOINT(channel);
+
+    zcl_stub_attr_u8(endpoint, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &attr_on);
+    zcl_stub_attr_u8(endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                     &attr_level);
+    if (attr_on != on)
+        replay_fail(msg, channel, "OnOff", on, attr_on);
+    if (attr_level != level)
+        replay_fail(msg, channel, "CurrentLevel", level, attr_level);
+    if (light_driver_get_brightness(channel) != level)
+        replay_fail(msg, channel, "driver level", level, light_driver_get_brightness(channel));
+    bool lit = light_hal_mock_pwm_output(replay_ledc_ch[channel]) > 0.0;
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    uint8_t effect = LIGHT_DRIVER_EFFECT_NONE;
+    zcl_stub_attr_u8(HA_ESP_LIGHT_ENDPOINT, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, &effect);
+    /* an effect takes the output of channel 0 dark now and then */
+    if (channel == 0 && effect != LIGHT_DRIVER_EFFECT_NONE)
+        return;
+#endif
+    if (lit != (on && level > 0))
+        replay_fail(msg, channel, "LED lit", on && level > 0, lit);
+}
+
+/* A level anywhere in the expected range, the same in attributes, driver and output */
+static void replay_check_range(const replay_msg_t *msg, uint8_t channel)
+{
+    uint8_t level = 0;
+
+    zcl_stub_attr_u8(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                     ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &level);
+    if (level < msg->level)
+        replay_fail(msg, channel, "CurrentLevel", msg->level, level);
+    else if (level > msg->level_max)
+        replay_fail(msg, channel, "CurrentLevel", msg->level_max, level);
+    replay_check(msg, channel, msg->on, level);
+}
+
+/* Quiet point: every channel against its own attributes, and against what is stored for the next boot */
+static void replay_check_quiet(const replay_msg_t *msg)
+{
+    light_state_t stored;
+
+    light_state_load(&stored);
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        uint8_t on = 0, level = 0;
+        zcl_stub_attr_u8(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+                         &on);
+        zcl_stub_attr_u8(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                         ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &level);
+        replay_check(msg, channel, on, level);
+        if (stored.on[channel] != on)
+            replay_fail(msg, channel, "stored on", on, stored.on[channel]);
+        if (stored.level[channel] != level)
+            replay_fail(msg, channel, "stored level", level, stored.level[channel]);
+    }
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    uint8_t effect = 0;
+    zcl_stub_attr_u8(HA_ESP_LIGHT_ENDPOINT, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, &effect);
+    if (stored.effect != effect)
+        replay_fail(msg, 0, "stored effect", effect, stored.effect);
+#endif
+}
+
+static void replay_run(void)
+{
+    for (size_t i = 0; i < s_msg_count; i++) {
+        const replay_msg_t *msg = &s_msgs[i];
+        int64_t at_us = msg->ms * 1000LL;
+
+        if (at_us > light_hal_time_us())
+            zcl_stub_advance(at_us - light_hal_time_us());
+        switch (msg->kind) {
+        case REPLAY_ATTR: {
+            esp_zb_zcl_set_attr_value_message_t message = {
+                .info = { .status = msg->status, .dst_endpoint = msg->endpoint, .cluster = msg->cluster },
+                .attribute = {
+                    .id = msg->id,
+                    .data = { .type = msg->type, .size = msg->size, .value = msg->null_value ? NULL : (void *)msg->data },
+                },
+            };
+            zcl_stub_write_attr(&message);
+            break;
+        }
+        case REPLAY_CMD: {
+            esp_zb_zcl_privilege_command_message_t message = {
+                .info = {
+                    .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+                    .dst_endpoint = msg->endpoint,
+                    .cluster = msg->cluster,
+                    .profile = ESP_ZB_AF_HA_PROFILE_ID,
+                    .command = { .id = msg->id },
+                },
+                .size = msg->size,
+                .data = msg->size ? (void *)msg->data : NULL,
+            };
+            zcl_stub_action(ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID, &message);
+            break;
+        }
+        case REPLAY_STORE: {
+            esp_zb_zcl_store_scene_message_t message = {
+                .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = msg->endpoint, .cluster = ESP_ZB_ZCL_CLUSTER_ID_SCENES },
+                .group_id = msg->id,
+                .scene_id = msg->scene,
+            };
+            zcl_stub_action(ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID, &message);
+            break;
+        }
+        case REPLAY_RECALL: {
+            /* the stack's scene entry, On/Off first */
+            uint8_t on = msg->on, level = msg->level;
+            esp_zb_zcl_scenes_extension_field_t fields[2] = {
+                { .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, .length = 1, .extension_field_attribute_value_list = &on },
+                { .cluster_id = ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, .length = 1, .extension_field_attribute_value_list = &level },
+            };
+            esp_zb_zcl_scenes_extension_field_t *field_set = NULL;
+            for (int f = 1; f >= 0; f--) {
+                if (msg->fields & (1 << f)) {
+                    fields[f].next = field_set;
+                    field_set = &fields[f];
+                }
+            }
+            esp_zb_zcl_recall_scene_message_t message = {
+                .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = msg->endpoint, .cluster = ESP_ZB_ZCL_CLUSTER_ID_SCENES },
+                .group_id = msg->id,
+                .scene_id = msg->scene,
+                .transition_time = msg->transition_s,
+                .field_set = field_set,
+            };
+            zcl_stub_action(ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID, &message);
+            break;
+        }
+        case REPLAY_CUSTOM: {
+            esp_zb_zcl_custom_cluster_command_message_t message = {
+                .info = {
+                    .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+                    .dst_endpoint = msg->endpoint,
+                    .cluster = msg->cluster,
+                    .profile = ESP_ZB_AF_HA_PROFILE_ID,
+                    .command = { .id = msg->id },
+                },
+                .data = { .type = ESP_ZB_ZCL_ATTR_TYPE_NULL, .size = msg->size, .value = msg->size ? (void *)msg->data : NULL },
+            };
+            zcl_stub_action(ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID, &message);
+            break;
+        }
+        case REPLAY_OTA: {
+            esp_zb_zcl_ota_upgrade_value_message_t message = {
+                .info = { .status = msg->status, .dst_endpoint = msg->endpoint, .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE },
+                .upgrade_status = msg->id,
+                .payload_size = msg->size,
+                .payload = msg->data,
+            };
+            /* START carries the image size */
+            if (msg->id == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START && msg->size >= sizeof(uint32_t))
+                memcpy(&message.ota_header.image_size, msg->data, sizeof(uint32_t));
+            zcl_stub_action(ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID, &message);
+            break;
+        }
+        default:
+            /* the light task takes what the last message posted */
+            zcl_stub_advance(0);
+            if (msg->endpoint == 0)
+                replay_check_quiet(msg);
+            else if (LIGHT_ENDPOINT_IS_CHANNEL(msg->endpoint) && msg->level_max)
+                replay_check_range(msg, LIGHT_ENDPOINT_CHANNEL(msg->endpoint));
+            else if (LIGHT_ENDPOINT_IS_CHANNEL(msg->endpoint))
+                replay_check(msg, LIGHT_ENDPOINT_CHANNEL(msg->endpoint), msg->on, msg->level);
+            break;
+        }
+    }
+    zcl_stub_advance(REPLAY_SETTLE_MS * 1000LL);
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace = NULL;
+    unsigned fuzz = 0;
+    bool dump = false, check = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            trace = argv[++i];
+        else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc)
+            fuzz = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            s_rng = strtoul(argv[++i], NULL, 0) ?: s_rng;   /* xorshift stays at 0 */
+        else if (strcmp(argv[i], "--dump") == 0)
+            dump = true;
+        else if (strcmp(argv[i], "--check") == 0)
+            check = true;
+        else {
+            fprintf(stderr, "usage: %s [--trace file] [--dump] [--fuzz n] [--seed s] [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (trace) {
+        if (!load_trace(trace))
+            return 2;
+    } else {
+        gen_trace(500);
+    }
+    gen_fuzz(fuzz);
+    if (dump) {
+        dump_trace();
+        return 0;
+    }
+
+    light_hal_mock_model_t model = LIGHT_HAL_MOCK_MODEL_DEFAULT();
+    model.active_high = CONFIG_HALLOWEEN_LED_LEVEL_HIGH;
+    light_hal_mock_reset(&model);
+    zcl_stub_boot();
+    replay_run();
+
+    zcl_stub_stats_t st;
+    zcl_stub_get_stats(&st);
+    printf("zcl replay (%d channels): %zu lines, %u messages (%u rejected) over %.0f s\n", LIGHT_CHANNELS, s_msg_count,
+           (unsigned)st.actions, (unsigned)st.action_errors, light_hal_time_us() / 1e6);
+    printf("  handler %.0f ns/message, %.0f messages/s, slowest %.0f ns\n", st.actions ? st.action_ns / st.actions : 0.0,
+           st.action_ns > 0 ? st.actions * 1e9 / st.action_ns : 0.0, st.action_max_ns);
+    printf("  %u alarms, %u reports, %u state commits, %u failed checks\n", (unsigned)st.alarms, (unsigned)st.reports,
+           (unsigned)st.nvs_commits, s_failures);
+#if REPLAY_FEATURES
+    printf("  %u command responses, %u CAN_SLEEP signals, %u OTA images, %u restarts\n", (unsigned)st.responses,
+           (unsigned)st.sleeps, (unsigned)st.ota_images, (unsigned)st.restarts);
+#endif
+    return check && s_failures ? 1 : 0;
+}
@@ -0,0 +1,873 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "light_hal_mock.h"
+#include "light_stats.h"
+#include "boot_timeline.h"
+#include "battery_monitor.h"
+#include "ota_update.h"
+#include "zcl_utility.h"
+#include "zcl_stub.h"
+
+#define STUB_ATTRS_MAX      64
+#define STUB_ATTR_VALUE_MAX 132     /* the longest attribute, the schedule Entries string */
+#define STUB_CLUSTERS_MAX   48
+#define STUB_ALARMS_MAX     32
+#define STUB_TIMERS_MAX     4
+#define STUB_NVS_MAX        8
+#define STUB_NVS_BLOB_MAX   256     /* the scene table */
+#define STUB_ENDPOINTS_MAX  8
+/* idle gap the stack signals CAN_SLEEP for, its default sleep threshold */
+#define STUB_SLEEP_MIN_US   20000
+#define STUB_BATTERY_MV     3900
+/* longest clock step: alarms set by the light task in between fire at most this late */
+#define STUB_STEP_US        10000
+
+void app_main(void);
+
+/* a cluster, on an endpoint once its cluster list is added to the endpoint list */
+struct esp_zb_attribute_list_s {
+    uint16_t cluster;
+    esp_zb_cluster_list_t *list;
+};
+
+typedef struct {
+    esp_zb_attribute_list_t *cluster;
+    uint8_t value[STUB_ATTR_VALUE_MAX];
+    esp_zb_zcl_attr_t attr;
+} stub_attr_t;
+
+typedef struct {
+    esp_zb_callback_t cb;
+    uint8_t param;
+    int64_t at_us;
+    uint32_t seq;               /* alarms due at the same time fire in the order they were set */
+} stub_alarm_t;
+
+struct esp_timer {
+    esp_timer_cb_t cb;
+    void *arg;
+    int64_t at_us;
+    bool active;
+};
+
+typedef struct {
+    char ns[16];
+    char key[16];
+    uint8_t data[STUB_NVS_BLOB_MAX];
+    size_t size;
+} stub_nvs_t;
+
+struct esp_zb_cluster_list_s {
+    uint8_t endpoint;           /* 0 until added to the endpoint list */
+};
+
+struct esp_zb_ep_list_s {
+    int unused;
+};
+
+typedef struct {
+    bool running;
+    bool checked;
+    uint32_t size;
+    uint32_t received;
+} stub_ota_t;
+
+static stub_attr_t s_attrs[STUB_ATTRS_MAX];
+static size_t s_attr_count;
+static struct esp_zb_attribute_list_s s_clusters[STUB_CLUSTERS_MAX];
+static size_t s_cluster_count;
+static stub_alarm_t s_alarms[STUB_ALARMS_MAX];
+static size_t s_alarm_count;
+static uint32_t s_alarm_seq;
+static struct esp_timer s_timers[STUB_TIMERS_MAX];
+static size_t s_timer_count;
+static stub_nvs_t s_nvs[STUB_NVS_MAX];
+static size_t s_nvs_count;
+static char s_nvs_handles[STUB_NVS_MAX][16];   /* namespace of handle i + 1 */
+static struct esp_zb_cluster_list_s s_cluster_lists[STUB_ENDPOINTS_MAX];
+static size_t s_cluster_list_count;
+static struct esp_zb_ep_list_s s_ep_list;
+static esp_err_t (*s_action_handler)(esp_zb_core_action_callback_id_t callback_id, const void *message);
+static zcl_stub_stats_t s_stats;
+static int s_lock_depth;
+static int64_t s_wall_offset_us;    /* Unix time at boot */
+static stub_ota_t s_ota;
+
+static double stub_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Attribute table */
+
+/* Bytes of a value of @p type, strings with their length byte; 0 for anything the table does not hold */
+static size_t stub_attr_size(uint8_t type, const uint8_t *value)
+{
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_U8:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+        return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+    case ESP_ZB_ZCL_ATTR_TYPE_S16:
+        return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+    case ESP_ZB_ZCL_ATTR_TYPE_S32:
+    case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
+        return 4;
+    case ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+    case ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING:
+        return 1 + value[0] <= STUB_ATTR_VALUE_MAX ? 1 + value[0] : 0;
+    default:
+        return 0;
+    }
+}
+
+static stub_attr_t *stub_attr_find(uint8_t endpoint, uint16_t cluster, uint16_t attr_id)
+{
+    for (size_t i = 0; i < s_attr_count; i++) {
+        const esp_zb_attribute_list_t *c = s_attrs[i].cluster;
+        if (c->list && c->list->endpoint == endpoint && c->cluster == cluster && s_attrs[i].attr.id == attr_id)
+            return &s_attrs[i];
+    }
+    return NULL;
+}
+
+static esp_err_t stub_attr_add(esp_zb_attribute_list_t *cluster, uint16_t attr_id, uint8_t type, const void *value_p)
+{
+    if (!cluster || !value_p)
+        return ESP_ERR_INVALID_ARG;
+    if (s_attr_count == STUB_ATTRS_MAX)
+        abort();
+    stub_attr_t *a = &s_attrs[s_attr_count++];
+    *a = (stub_attr_t) {
+        .cluster = cluster,
+        .attr = { .id = attr_id, .type = type },
+    };
+    memcpy(a->value, value_p, stub_attr_size(type, value_p));
+    a->attr.data_p = a->value;
+    return ESP_OK;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role,
+                                                 uint16_t attr_id, void *value_p, bool check)
+{
+    stub_attr_t *a = stub_attr_find(endpoint, cluster_id, attr_id);
+    if (!a || !value_p)
+        return ESP_ZB_ZCL_STATUS_INVALID_VALUE;
+    memcpy(a->value, value_p, stub_attr_size(a->attr.type, value_p));
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id)
+{
+    stub_attr_t *a = stub_attr_find(endpoint, cluster_id, attr_id);
+    return a ? &a->attr : NULL;
+}
+
+bool zcl_stub_attr_u8(uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint8_t *value)
+{
+    stub_attr_t *a = stub_attr_find(endpoint, cluster, attr_id);
+    if (!a)
+        return false;
+    *value = a->value[0];
+    return true;
+}
+
+esp_err_t esp_zb_zcl_report_attr_cmd_req(esp_zb_zcl_report_attr_cmd_t *cmd_req)
+{
+    s_stats.reports++;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_zcl_add_privilege_command(uint8_t endpoint, uint16_t cluster, uint16_t command)
+{
+    return ESP_OK;
+}
+
+/* The answer to a custom command, TraceRead: an octet string that fits in the frame */
+uint8_t esp_zb_zcl_custom_cluster_cmd_resp(esp_zb_zcl_custom_cluster_cmd_resp_t *cmd_req)
+{
+    const uint8_t *value = cmd_req->data.value;
+
+    if (cmd_req->data.type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING && (!value || cmd_req->data.size != 1 + value[0]))
+        abort();
+    s_stats.responses++;
+    return 0;
+}
+
+/* Data model: every attribute of a cluster goes into the table, found once the cluster is on an endpoint */
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    if (s_cluster_count == STUB_CLUSTERS_MAX)
+        abort();
+    esp_zb_attribute_list_t *cluster = &s_clusters[s_cluster_count++];
+    cluster->cluster = cluster_id;
+    return cluster;
+}
+
+static esp_err_t stub_cluster_add(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list)
+{
+    if (!cluster_list || !attr_list || attr_list->list)
+        return ESP_ERR_INVALID_ARG;
+    attr_list->list = cluster_list;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type,
+                                                uint8_t attr_access, void *value_p)
+{
+    return stub_attr_add(attr_list, attr_id, attr_type, value_p);
+}
+
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return stub_attr_add(attr_list, attr_id, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING, value_p);
+}
+
+esp_zb_attribute_list_t *esp_zb_power_config_cluster_create(esp_zb_power_config_cluster_cfg_t *power_cfg)
+{
+    return esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG);
+}
+
+esp_err_t esp_zb_power_config_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return stub_attr_add(attr_list, attr_id, ESP_ZB_ZCL_ATTR_TYPE_U8, value_p);
+}
+
+esp_zb_attribute_list_t *esp_zb_time_cluster_create(esp_zb_time_cluster_cfg_t *time_cfg)
+{
+    esp_zb_attribute_list_t *cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_TIME);
+    stub_attr_add(cluster, ESP_ZB_ZCL_ATTR_TIME_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, &time_cfg->time);
+    return cluster;
+}
+
+esp_err_t esp_zb_time_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    bool is_signed = attr_id == ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID || attr_id == ESP_ZB_ZCL_ATTR_TIME_DST_SHIFT_ID;
+    return stub_attr_add(attr_list, attr_id, is_signed ? ESP_ZB_ZCL_ATTR_TYPE_S32 : ESP_ZB_ZCL_ATTR_TYPE_U32, value_p);
+}
+
+/* the client variables are no attribute the light reads or writes */
+esp_zb_attribute_list_t *esp_zb_ota_cluster_create(esp_zb_ota_cluster_cfg_t *ota_cfg)
+{
+    return esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE);
+}
+
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    return attr_list && value_p ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_zb_cluster_list_add_custom_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                 uint8_t role_mask)
+{
+    return stub_cluster_add(cluster_list, attr_list);
+}
+
+esp_err_t esp_zb_cluster_list_add_power_config_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                       uint8_t role_mask)
+{
+    return stub_cluster_add(cluster_list, attr_list);
+}
+
+esp_err_t esp_zb_cluster_list_add_time_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                               uint8_t role_mask)
+{
+    return stub_cluster_add(cluster_list, attr_list);
+}
+
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                              uint8_t role_mask)
+{
+    return stub_cluster_add(cluster_list, attr_list);
+}
+
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id,
+                                                         uint8_t role_mask)
+{
+    for (size_t i = 0; i < s_cluster_count; i++) {
+        if (s_clusters[i].list == cluster_list && s_clusters[i].cluster == cluster_id)
+            return &s_clusters[i];
+    }
+    return NULL;
+}
+
+static esp_zb_cluster_list_t *stub_cluster_list(void)
+{
+    if (s_cluster_list_count == STUB_ENDPOINTS_MAX)
+        abort();
+    esp_zb_cluster_list_t *list = &s_cluster_lists[s_cluster_list_count++];
+    stub_cluster_add(list, esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_BASIC));
+    return list;
+}
+
+static void stub_on_off_add(esp_zb_cluster_list_t *list, bool on_off)
+{
+    esp_zb_attribute_list_t *cluster = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_ON_OFF);
+    stub_attr_add(cluster, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, &on_off);
+    stub_cluster_add(list, cluster);
+}
+
+esp_zb_cluster_list_t *esp_zb_on_off_light_clusters_create(esp_zb_on_off_light_cfg_t *light_cfg)
+{
+    esp_zb_cluster_list_t *list = stub_cluster_list();
+    stub_on_off_add(list, light_cfg->on_off_cfg.on_off);
+    return list;
+}
+
+esp_zb_cluster_list_t *esp_zb_color_dimmable_light_clusters_create(esp_zb_color_dimmable_light_cfg_t *light_cfg)
+{
+    esp_zb_cluster_list_t *list = stub_cluster_list();
+    esp_zb_attribute_list_t *level = esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL);
+
+    stub_on_off_add(list, light_cfg->on_off_cfg.on_off);
+    stub_attr_add(level, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8,
+                  &light_cfg->level_cfg.current_level);
+    stub_cluster_add(list, level);
+    return list;
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void)
+{
+    return &s_ep_list;
+}
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list,
+                                esp_zb_endpoint_config_t endpoint_config)
+{
+    cluster_list->endpoint = endpoint_config.endpoint;
+    return ESP_OK;
+}
+
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id)
+{
+    for (size_t i = 0; i < s_cluster_list_count; i++) {
+        if (s_cluster_lists[i].endpoint == ep_id)
+            return &s_cluster_lists[i];
+    }
+    return NULL;
+}
+
+esp_err_t esp_zb_device_register(esp_zb_ep_list_t *ep_list)
+{
+    return ESP_OK;
+}
+
+/* Counters, boot timeline, OTA and battery: the parts of the firmware that need the chip */
+
+void light_stats_sleep_enter(void)
+{
+}
+
+void light_stats_sleep_exit(void)
+{
+}
+
+void light_stats_get(light_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+static boot_timeline_t s_boot;
+
+void boot_timeline_init(void)
+{
+    s_boot.boot_count = 1;
+}
+
+void boot_timeline_mark(boot_mark_t mark)
+{
+    s_boot.mark_ms[mark] = (uint32_t)(light_hal_time_us() / 1000);
+}
+
+void boot_timeline_retry(void)
+{
+    s_boot.retries++;
+}
+
+const boot_timeline_t *boot_timeline_get(void)
+{
+    return &s_boot;
+}
+
+void boot_timeline_report(void)
+{
+}
+
+/* An image the size the header gave, in order, checked before it is finished; nothing is written */
+esp_err_t ota_update_begin(uint32_t image_size)
+{
+    if (s_ota.running)
+        return ESP_ERR_INVALID_STATE;
+    s_ota = (stub_ota_t) { .running = true, .size = image_size };
+    return ESP_OK;
+}
+
+esp_err_t ota_update_write(const uint8_t *data, size_t len)
+{
+    if (!s_ota.running || s_ota.checked)
+        return ESP_ERR_INVALID_STATE;
+    if (!data || len > s_ota.size - s_ota.received)
+        return ESP_ERR_INVALID_SIZE;
+    s_ota.received += len;
+    return ESP_OK;
+}
+
+esp_err_t ota_update_check(void)
+{
+    if (!s_ota.running || s_ota.received != s_ota.size)
+        return ESP_ERR_INVALID_STATE;
+    s_ota.checked = true;
+    return ESP_OK;
+}
+
+esp_err_t ota_update_finish(void)
+{
+    if (!s_ota.checked)
+        return ESP_ERR_INVALID_STATE;
+    s_ota = (stub_ota_t) { 0 };
+    s_stats.ota_images++;
+    return ESP_OK;
+}
+
+bool ota_update_running(void)
+{
+    return s_ota.running;
+}
+
+void ota_update_abort(void)
+{
+    s_ota = (stub_ota_t) { 0 };
+}
+
+void ota_update_confirm(void)
+{
+}
+
+/* the device goes on where it was, as if it had booted the same state again */
+void esp_restart(void)
+{
+    s_stats.restarts++;
+}
+
+esp_err_t battery_monitor_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t battery_monitor_read(uint32_t *mv)
+{
+    *mv = STUB_BATTERY_MV;
+    return ESP_OK;
+}
+
+/* Wall clock: the simulated clock from whatever the last settimeofday() made of it, the host clock is never touched */
+
+int gettimeofday(struct timeval *tv, void *tz)
+{
+    int64_t us = s_wall_offset_us + light_hal_time_us();
+
+    tv->tv_sec = us / 1000000;
+    tv->tv_usec = us % 1000000;
+    return 0;
+}
+
+int settimeofday(const struct timeval *tv, const struct timezone *tz)
+{
+    s_wall_offset_us = tv->tv_sec * 1000000LL + tv->tv_usec - light_hal_time_us();
+    return 0;
+}
+
+/* Scheduler alarms and esp_timer on the mock clock */
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+    if (s_alarm_count == STUB_ALARMS_MAX)
+        abort();
+    s_alarms[s_alarm_count++] = (stub_alarm_t) {
+        .cb = cb, .param = param, .at_us = light_hal_time_us() + time * 1000LL, .seq = s_alarm_seq++,
+    };
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < s_alarm_count; i++) {
+        if (s_alarms[i].cb != cb || s_alarms[i].param != param)
+            s_alarms[kept++] = s_alarms[i];
+    }
+    s_alarm_count = kept;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return light_hal_time_us();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (s_timer_count == STUB_TIMERS_MAX)
+        return ESP_ERR_NO_MEM;
+    s_timers[s_timer_count] = (struct esp_timer) { .cb = create_args->callback, .arg = create_args->arg };
+    *out_handle = &s_timers[s_timer_count++];
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->active)
+        return ESP_ERR_INVALID_STATE;
+    timer->at_us = light_hal_time_us() + (int64_t)timeout_us;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->active)
+        return ESP_ERR_INVALID_STATE;
+    timer->active = false;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
+
+/* Fire the earliest alarm or timer due by now, false when there is none */
+static bool stub_fire_due(int64_t now, int64_t *next_us)
+{
+    int alarm = -1;
+    struct esp_timer *timer = NULL;
+    int64_t at = INT64_MAX;
+
+    for (size_t i = 0; i < s_alarm_count; i++) {
+        if (s_alarms[i].at_us < at || (alarm >= 0 && s_alarms[i].at_us == at && s_alarms[i].seq < s_alarms[alarm].seq)) {
+            at = s_alarms[i].at_us;
+            alarm = (int)i;
+        }
+    }
+    for (size_t i = 0; i < s_timer_count; i++) {
+        if (s_timers[i].active && s_timers[i].at_us < at) {
+            at = s_timers[i].at_us;
+            timer = &s_timers[i];
+        }
+    }
+    *next_us = at;
+    if (at > now)
+        return false;
+    if (timer) {
+        timer->active = false;
+        timer->cb(timer->arg);
+    } else {
+        stub_alarm_t fired = s_alarms[alarm];
+        s_alarms[alarm] = s_alarms[--s_alarm_count];
+        s_stats.alarms++;
+        fired.cb(fired.param);
+    }
+    return true;
+}
+
+static void stub_signal(esp_zb_app_signal_type_t signal, esp_err_t status);
+
+void zcl_stub_advance(int64_t us)
+{
+    const int64_t end = light_hal_time_us() + us;
+    int64_t next;
+    bool asleep = false;
+
+    for (;;) {
+        int64_t now = light_hal_time_us();
+        /* the light task first, it takes whatever the last callback posted */
+        light_hal_mock_advance(0);
+        if (stub_fire_due(now, &next)) {
+            asleep = false;
+            continue;
+        }
+        if (now >= end)
+            break;
+        int64_t to = next < end ? next : end;
+        /* nothing due for a while: the stack offers to sleep once, the handler may set alarms */
+        if (!asleep && next - now >= STUB_SLEEP_MIN_US) {
+            asleep = true;
+            s_stats.sleeps++;
+            stub_signal(ESP_ZB_COMMON_SIGNAL_CAN_SLEEP, ESP_OK);
+            continue;
+        }
+        light_hal_mock_advance((to - now < STUB_STEP_US ? to - now : STUB_STEP_US));
+    }
+}
+
+/* Stack */
+
+static void stub_signal(esp_zb_app_signal_type_t signal, esp_err_t status)
+{
+    uint32_t sig = signal;
+    esp_zb_app_signal_t signal_s = { .p_app_signal = &sig, .esp_err_status = status };
+    esp_zb_app_signal_handler(&signal_s);
+}
+
+static void stub_signal_cb(uint8_t signal)
+{
+    stub_signal(signal, ESP_OK);
+}
+
+void esp_zb_core_action_handler_register(esp_err_t (*cb)(esp_zb_core_action_callback_id_t callback_id, const void *message))
+{
+    s_action_handler = cb;
+}
+
+esp_err_t zcl_stub_action(esp_zb_core_action_callback_id_t callback_id, const void *message)
+{
+    double start = stub_host_ns();
+    esp_err_t err = s_action_handler(callback_id, message);
+    double ns = stub_host_ns() - start;
+
+    s_stats.actions++;
+    s_stats.action_errors += err != ESP_OK;
+    s_stats.action_ns += ns;
+    if (ns > s_stats.action_max_ns)
+        s_stats.action_max_ns = ns;
+    return err;
+}
+
+esp_err_t zcl_stub_write_attr(const esp_zb_zcl_set_attr_value_message_t *message)
+{
+    stub_attr_t *a = stub_attr_find(message->info.dst_endpoint, message->info.cluster, message->attribute.id);
+    const uint8_t *value = message->attribute.data.value;
+
+    if (message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS && a && value && message->attribute.data.type == a->attr.type) {
+        size_t size = stub_attr_size(a->attr.type, value);
+        if (size && size <= message->attribute.data.size)
+            memcpy(a->value, value, size);
+    }
+    return zcl_stub_action(ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID, message);
+}
+
+void zcl_stub_get_stats(zcl_stub_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void zcl_stub_boot(void)
+{
+    app_main();
+    /* the stack has restored its network data from flash */
+    stub_signal(ESP_ZB_ZDO_SIGNAL_SKIP_STARTUP, ESP_OK);
+    zcl_stub_advance(0);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *param, uint32_t priority,
+                       TaskHandle_t *handle)
+{
+    task(param);
+    return pdPASS;
+}
+
+struct host_semaphore {
+    bool held;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct host_semaphore));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t block_ticks)
+{
+    if (sem->held)
+        abort();
+    sem->held = true;
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (!sem->held)
+        return pdFAIL;
+    sem->held = false;
+    return pdPASS;
+}
+
+esp_err_t esp_zb_platform_config(esp_zb_platform_config_t *config)
+{
+    return ESP_OK;
+}
+
+void esp_zb_init(esp_zb_cfg_t *nwk_cfg)
+{
+}
+
+esp_err_t esp_zb_start(bool autostart)
+{
+    return ESP_OK;
+}
+
+void esp_zb_stack_main_loop(void)
+{
+}
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+    return ESP_OK;
+}
+
+void esp_zb_set_tx_power(int8_t power)
+{
+}
+
+void esp_zb_sleep_enable(bool enable)
+{
+}
+
+void esp_zb_sleep_now(void)
+{
+}
+
+void esp_zb_sleep_set_threshold(uint32_t threshold_ms)
+{
+}
+
+/* the stack lock is recursive, and everything here runs on one thread */
+bool esp_zb_lock_acquire(TickType_t block_ticks)
+{
+    s_lock_depth++;
+    return true;
+}
+
+void esp_zb_lock_release(void)
+{
+    if (--s_lock_depth < 0)
+        abort();
+}
+
+/* Network: a device that joined before, every commissioning step succeeds at once */
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+    esp_zb_scheduler_alarm(stub_signal_cb, mode_mask == ESP_ZB_BDB_MODE_NETWORK_STEERING ? ESP_ZB_BDB_SIGNAL_STEERING
+                                                                                         : ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT, 0);
+    return ESP_OK;
+}
+
+bool esp_zb_bdb_is_factory_new(void)
+{
+    return false;
+}
+
+const char *esp_zb_zdo_signal_to_string(esp_zb_app_signal_type_t signal)
+{
+    return "signal";
+}
+
+void esp_zb_get_extended_pan_id(esp_zb_ieee_addr_t ext_pan_id)
+{
+    memset(ext_pan_id, 0, sizeof(esp_zb_ieee_addr_t));
+}
+
+uint16_t esp_zb_get_pan_id(void)
+{
+    return 0x1a62;
+}
+
+uint8_t esp_zb_get_current_channel(void)
+{
+    return 11;
+}
+
+uint16_t esp_zb_get_short_address(void)
+{
+    return 0x1234;
+}
+
+void esp_zb_zdo_pim_set_long_poll_interval(uint32_t ms)
+{
+    s_stats.poll_interval_ms = ms;
+}
+
+/* NVS */
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    for (size_t i = 0; i < STUB_NVS_MAX; i++) {
+        if (!s_nvs_handles[i][0])
+            strncpy(s_nvs_handles[i], namespace_name, sizeof(s_nvs_handles[i]) - 1);
+        if (strcmp(s_nvs_handles[i], namespace_name) == 0) {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+static stub_nvs_t *stub_nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (size_t i = 0; i < s_nvs_count; i++) {
+        if (strcmp(s_nvs[i].ns, s_nvs_handles[handle - 1]) == 0 && strcmp(s_nvs[i].key, key) == 0)
+            return &s_nvs[i];
+    }
+    return NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    stub_nvs_t *entry = stub_nvs_find(handle, key);
+    if (!entry)
+        return ESP_ERR_NVS_NOT_FOUND;
+    if (out_value && *length < entry->size)
+        return ESP_ERR_INVALID_SIZE;
+    if (out_value)
+        memcpy(out_value, entry->data, entry->size);
+    *length = entry->size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    stub_nvs_t *entry = stub_nvs_find(handle, key);
+    if (length > STUB_NVS_BLOB_MAX)
+        return ESP_ERR_INVALID_SIZE;
+    if (!entry) {
+        if (s_nvs_count == STUB_NVS_MAX)
+            return ESP_ERR_NO_MEM;
+        entry = &s_nvs[s_nvs_count++];
+        strncpy(entry->ns, s_nvs_handles[handle - 1], sizeof(entry->ns) - 1);
+        strncpy(entry->key, key, sizeof(entry->key) - 1);
+    }
+    memcpy(entry->data, value, length);
+    entry->size = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    s_stats.nvs_commits++;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stand-in for the Zigbee stack around esp_zb_light.c: an attribute table,
+ * the scheduler alarms, esp_timer and the wall clock on the simulated clock
+ * of the mock HAL, NVS in RAM, an OTA partition that only counts bytes and a
+ * battery that stays charged. Everything runs on the calling thread; the
+ * light task runs whenever the clock advances, and the stack signals
+ * CAN_SLEEP before every idle gap.
+ */
+
+typedef struct {
+    uint32_t actions;           /* messages handed to the action handler */
+    uint32_t action_errors;     /* of them, the handler returned an error for */
+    double action_ns;           /* host time spent in the handler */
+    double action_max_ns;       /* longest single call */
+    uint32_t alarms;            /* scheduler alarms fired */
+    uint32_t reports;           /* attribute reports sent */
+    uint32_t responses;         /* custom command responses sent */
+    uint32_t sleeps;            /* CAN_SLEEP signals */
+    uint32_t nvs_commits;
+    uint32_t ota_images;        /* firmware images finished */
+    uint32_t restarts;          /* esp_restart() calls, the device goes on */
+    uint32_t poll_interval_ms;  /* long poll interval last set */
+} zcl_stub_stats_t;
+
+/**
+ * @brief Run app_main() and the Zigbee task, then bring the device up as one that joined before.
+ */
+void zcl_stub_boot(void);
+
+/**
+ * @brief A write to an attribute, as the stack hands it over.
+ *
+ * The attribute table takes the value first if it is non-NULL and of the
+ * attribute's type, as the stack does before calling the handler.
+ */
+esp_err_t zcl_stub_write_attr(const esp_zb_zcl_set_attr_value_message_t *message);
+
+/**
+ * @brief Any other message for the action handler.
+ */
+esp_err_t zcl_stub_action(esp_zb_core_action_callback_id_t callback_id, const void *message);
+
+/**
+ * @brief Advance the simulated clock, firing alarms and timers in order and running the light task.
+ */
+void zcl_stub_advance(int64_t us);
+
+/**
+ * @brief Current value of a boolean or 8-bit attribute, the first byte of any other one; false when there is no such attribute.
+ */
+bool zcl_stub_attr_u8(uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint8_t *value);
+
+void zcl_stub_get_stats(zcl_stub_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <stddef.h>
+#include "attr_report.h"
+
+#define US_PER_S    1000000LL
+
+void attr_report_init(attr_report_t *rep)
+{
+    rep->count = 0;
+}
+
+int attr_report_add(attr_report_t *rep, const attr_report_cfg_t *cfg, int32_t value)
+{
+    if (rep->count == ATTR_REPORT_MAX)
+        return -1;
+    rep->attrs[rep->count] = (attr_report_entry_t) {
+        .cfg = *cfg,
+        .value = value,
+        .reported = value,
+    };
+    return rep->count++;
+}
+
+void attr_report_configure(attr_report_t *rep, int index, const attr_report_cfg_t *cfg)
+{
+    if (index >= 0 && index < rep->count)
+        rep->attrs[index].cfg = *cfg;
+}
+
+void attr_report_set(attr_report_t *rep, int index, int32_t value)
+{
+    if (index >= 0 && index < rep->count)
+        rep->attrs[index].value = value;
+}
+
+void attr_report_seen(attr_report_t *rep, int index, int32_t value, int64_t now_us)
+{
+    if (index < 0 || index >= rep->count)
+        return;
+    attr_report_entry_t *attr = &rep->attrs[index];
+    attr->value = value;
+    attr->reported = value;
+    attr->known = true;
+    /* as good as a report: the heartbeat starts over */
+    attr->last_us = now_us;
+}
+
+static int64_t attr_min_at(const attr_report_entry_t *attr)
+{
+    return attr->known ? attr->last_us + attr->cfg.min_s * US_PER_S : 0;
+}
+
+static int64_t attr_max_at(const attr_report_entry_t *attr)
+{
+    return attr->last_us + attr->cfg.max_s * US_PER_S;
+}
+
+/* the change alone is worth a report */
+static bool attr_significant(const attr_report_entry_t *attr)
+{
+    if (!attr->known)
+        return true;
+    int64_t diff = (int64_t)attr->value - attr->reported;
+    if (diff < 0)
+        diff = -diff;
+    return diff != 0 && diff >= attr->cfg.change;
+}
+
+uint32_t attr_report_due(attr_report_t *rep, int64_t now_us, uint32_t *next_ms)
+{
+    bool urgent = false;
+    uint32_t mask = 0;
+    int64_t next_us = INT64_MAX;
+
+    for (uint8_t i = 0; i < rep->count; i++) {
+        const attr_report_entry_t *attr = &rep->attrs[i];
+        if ((attr_significant(attr) && now_us >= attr_min_at(attr)) ||
+                (attr->cfg.max_s && attr->known && now_us >= attr_max_at(attr))) {
+            urgent = true;
+            break;
+        }
+    }
+    for (uint8_t i = 0; i < rep->count; i++) {
+        attr_report_entry_t *attr = &rep->attrs[i];
+        bool changed = !attr->known || attr->value != attr->reported;
+        bool heartbeat = attr->cfg.max_s && attr->known &&
+                         now_us >= attr->last_us + attr->cfg.max_s * (US_PER_S / 2);
+
+        if (urgent && now_us >= attr_min_at(attr) && (changed || heartbeat)) {
+            mask |= 1u << i;
+            attr->reported = attr->value;
+            attr->known = true;
+            attr->last_us = now_us;
+        }
+        if (attr_significant(attr) && attr_min_at(attr) < next_us)
+            next_us = attr_min_at(attr);
+        if (attr->cfg.max_s && attr->known && attr_max_at(attr) < next_us)
+            next_us = attr_max_at(attr);
+    }
+    if (next_us == INT64_MAX)
+        *next_ms = ATTR_REPORT_IDLE;
+    else
+        *next_ms = next_us <= now_us ? 0 : (uint32_t)((next_us - now_us + 999) / 1000);
+    return mask;
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reporting policy of the attributes the light reports on its own, with the
+ * ZCL minimum/maximum interval and reportable change of each. Whenever one
+ * attribute has to be reported, every other attribute with an unreported
+ * change (of any size) whose minimum interval has passed goes along, and so
+ * does every heartbeat that is more than half way due, so that reports leave
+ * together in one radio wake instead of trickling out one by one.
+ */
+
+/** attributes one policy tracks */
+#define ATTR_REPORT_MAX         16
+/** delay from a change to attr_report_due(), so that changes arriving together (a scene, several channels) share a wake */
+#define ATTR_REPORT_GATHER_MS   150
+/** attr_report_due(): nothing pending */
+#define ATTR_REPORT_IDLE        UINT32_MAX
+
+typedef struct {
+    uint16_t min_s;         /* at least this long between two reports of the attribute */
+    uint16_t max_s;         /* report at least this often even without a change, 0 = never */
+    uint16_t change;        /* smallest change that triggers a report, 0 = any */
+} attr_report_cfg_t;
+
+typedef struct {
+    attr_report_cfg_t cfg;
+    int32_t value;          /* current value */
+    int32_t reported;       /* value the coordinator has seen */
+    int64_t last_us;        /* time of the last report */
+    bool known;             /* the coordinator has seen a value at all */
+} attr_report_entry_t;
+
+typedef struct {
+    attr_report_entry_t attrs[ATTR_REPORT_MAX];
+    uint8_t count;
+} attr_report_t;
+
+/**
+ * @brief Empty policy.
+ */
+void attr_report_init(attr_report_t *rep);
+
+/**
+ * @brief Track one more attribute, not reported yet.
+ *
+ * @return Its index, -1 when the policy is full
+ */
+int attr_report_add(attr_report_t *rep, const attr_report_cfg_t *cfg, int32_t value);
+
+/**
+ * @brief Change the intervals and threshold of an attribute (e.g. from a Configure Reporting command).
+ */
+void attr_report_configure(attr_report_t *rep, int index, const attr_report_cfg_t *cfg);
+
+/**
+ * @brief The attribute changed on the device (transition end, effect, restore...).
+ */
+void attr_report_set(attr_report_t *rep, int index, int32_t value);
+
+/**
+ * @brief The attribute changed to a value the coordinator already knows (it wrote it).
+ */
+void attr_report_seen(attr_report_t *rep, int index, int32_t value, int64_t now_us);
+
+/**
+ * @brief Pick the attributes to report now and mark them reported.
+ *
+ * @param[in]  rep      Policy
+ * @param[in]  now_us   Current time
+ * @param[out] next_ms  Delay until the next call is needed, ATTR_REPORT_IDLE when nothing is pending
+ * @return Bit mask of the attribute indices to send together
+ */
+uint32_t attr_report_due(attr_report_t *rep, int64_t now_us, uint32_t *next_ms);
+
+#ifdef __cplusplus
+}
+#endif
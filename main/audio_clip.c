@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "audio_clip.h"
+
+/* IMA ADPCM quantizer step sizes and step index adjustments */
+static const int16_t s_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t s_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* bytes taken by a clip of @p samples */
+static uint64_t clip_bytes(uint32_t samples)
+{
+    uint32_t full = samples / AUDIO_CLIP_BLOCK_SAMPLES;
+    uint32_t rest = samples % AUDIO_CLIP_BLOCK_SAMPLES;
+    uint64_t bytes = (uint64_t)full * AUDIO_CLIP_BLOCK_BYTES;
+    if (rest)
+        bytes += AUDIO_CLIP_BLOCK_HEADER + (rest + 1) / 2;
+    return bytes;
+}
+
+static const uint8_t *dir_entry(const audio_bank_t *bank, uint16_t clip)
+{
+    return bank->data + AUDIO_CLIP_HEADER_BYTES + (size_t)clip * AUDIO_CLIP_DIR_ENTRY_BYTES;
+}
+
+bool audio_bank_open(audio_bank_t *bank, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    if (!p || size < AUDIO_CLIP_HEADER_BYTES || rd32(p) != AUDIO_CLIP_MAGIC || rd16(p + 4) != AUDIO_CLIP_VERSION)
+        return false;
+
+    *bank = (audio_bank_t) {
+        .data = p,
+        .size = size,
+        .clip_count = rd16(p + 6),
+        .sample_rate = rd32(p + 8),
+    };
+    if (bank->sample_rate == 0 ||
+        AUDIO_CLIP_HEADER_BYTES + (size_t)bank->clip_count * AUDIO_CLIP_DIR_ENTRY_BYTES > size)
+        return false;
+
+    for (uint16_t i = 0; i < bank->clip_count; i++) {
+        const uint8_t *e = dir_entry(bank, i);
+        if ((uint64_t)rd32(e) + clip_bytes(rd32(e + 4)) > size)
+            return false;
+    }
+    return true;
+}
+
+uint32_t audio_bank_clip_samples(const audio_bank_t *bank, uint16_t clip)
+{
+    if (clip >= bank->clip_count)
+        return 0;
+    return rd32(dir_entry(bank, clip) + 4);
+}
+
+void audio_adpcm_decode(audio_adpcm_t *state, const uint8_t *codes, size_t first, size_t count, uint16_t gain,
+                        int16_t *out)
+{
+    int32_t predictor = state->predictor;
+    int index = state->index;
+
+    for (size_t i = first; i < first + count; i++) {
+        uint8_t code = (codes[i >> 1] >> ((i & 1) * 4)) & 0x0f;
+        int32_t step = s_step_table[index];
+        int32_t diff = step >> 3;
+        if (code & 4)
+            diff += step;
+        if (code & 2)
+            diff += step >> 1;
+        if (code & 1)
+            diff += step >> 2;
+        predictor += (code & 8) ? -diff : diff;
+        if (predictor > INT16_MAX)
+            predictor = INT16_MAX;
+        else if (predictor < INT16_MIN)
+            predictor = INT16_MIN;
+
+        index += s_index_table[code];
+        if (index < 0)
+            index = 0;
+        else if (index > 88)
+            index = 88;
+
+        int32_t sample = (predictor * gain) >> 8;
+        if (sample > INT16_MAX)
+            sample = INT16_MAX;
+        else if (sample < INT16_MIN)
+            sample = INT16_MIN;
+        *out++ = (int16_t)sample;
+    }
+    state->predictor = (int16_t)predictor;
+    state->index = (uint8_t)index;
+}
+
+bool audio_stream_start(audio_stream_t *stream, const audio_bank_t *bank, uint16_t clip, bool loop)
+{
+    if (clip >= bank->clip_count)
+        return false;
+    const uint8_t *e = dir_entry(bank, clip);
+    *stream = (audio_stream_t) {
+        .bank = bank,
+        .clip = bank->data + rd32(e),
+        .samples = rd32(e + 4),
+        .gain = AUDIO_CLIP_GAIN_UNITY,
+        .loop = loop,
+    };
+    return true;
+}
+
+void audio_stream_set_gain(audio_stream_t *stream, uint16_t gain)
+{
+    stream->gain = gain;
+}
+
+size_t audio_stream_fill(audio_stream_t *stream, int16_t *out, size_t count)
+{
+    size_t done = 0;
+    if (stream->samples == 0)
+        return 0;
+
+    while (done < count) {
+        if (stream->pos == stream->samples) {
+            if (!stream->loop)
+                break;
+            stream->pos = 0;
+        }
+        uint32_t offset = stream->pos % AUDIO_CLIP_BLOCK_SAMPLES;
+        const uint8_t *block = stream->clip + (size_t)(stream->pos / AUDIO_CLIP_BLOCK_SAMPLES) * AUDIO_CLIP_BLOCK_BYTES;
+        if (offset == 0) {
+            /* every block restarts the decoder, so a corrupt block cannot spoil the rest of the clip */
+            stream->adpcm.predictor = (int16_t)rd16(block);
+            stream->adpcm.index = block[2] > 88 ? 88 : block[2];
+        }
+
+        /* up to the end of the block, the clip or the buffer */
+        size_t n = AUDIO_CLIP_BLOCK_SAMPLES - offset;
+        if (n > stream->samples - stream->pos)
+            n = stream->samples - stream->pos;
+        if (n > count - done)
+            n = count - done;
+        audio_adpcm_decode(&stream->adpcm, block + AUDIO_CLIP_BLOCK_HEADER, offset, n, stream->gain, out + done);
+        stream->pos += n;
+        done += n;
+    }
+    return done;
+}
+
+bool audio_stream_done(const audio_stream_t *stream)
+{
+    return !stream->loop && stream->pos == stream->samples;
+}
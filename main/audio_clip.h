@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sound clip bank and the decoder that streams it. The bank is the raw
+ * content of the "audio" data partition (written by tools/gen_audio_bank.py)
+ * and is read in place, so on the device it can be the memory-mapped flash.
+ *
+ * Little-endian layout:
+ *
+ *   header     magic "HWAB", u16 version, u16 clip count, u32 sample rate
+ *   directory  per clip: u32 offset from the bank start, u32 samples
+ *   clips      IMA ADPCM blocks of AUDIO_CLIP_BLOCK_BYTES: i16 predictor,
+ *              u8 step index, u8 reserved, then 4-bit codes, low nibble first.
+ *              The last block of a clip may be shorter.
+ */
+
+#define AUDIO_CLIP_MAGIC            0x42415748u  /* "HWAB" */
+#define AUDIO_CLIP_VERSION          1
+#define AUDIO_CLIP_HEADER_BYTES     12
+#define AUDIO_CLIP_DIR_ENTRY_BYTES  8
+#define AUDIO_CLIP_BLOCK_BYTES      256
+#define AUDIO_CLIP_BLOCK_HEADER     4
+/** samples coded in one full block */
+#define AUDIO_CLIP_BLOCK_SAMPLES    (2 * (AUDIO_CLIP_BLOCK_BYTES - AUDIO_CLIP_BLOCK_HEADER))
+/** unity gain of audio_stream_set_gain() */
+#define AUDIO_CLIP_GAIN_UNITY       256
+
+/** a validated clip bank */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint16_t clip_count;
+    uint32_t sample_rate;
+} audio_bank_t;
+
+/** ADPCM decoder state */
+typedef struct {
+    int16_t predictor;
+    uint8_t index;
+} audio_adpcm_t;
+
+/** playback position in one clip */
+typedef struct {
+    const audio_bank_t *bank;
+    const uint8_t *clip;        /* first block of the clip */
+    uint32_t samples;           /* clip length */
+    uint32_t pos;               /* next sample */
+    audio_adpcm_t adpcm;
+    uint16_t gain;              /* Q8, AUDIO_CLIP_GAIN_UNITY is unity */
+    bool loop;
+} audio_stream_t;
+
+/**
+ * @brief Check a bank image and its directory.
+ *
+ * Every clip must lie inside @p size bytes, so a stream started on the bank
+ * never reads outside it.
+ *
+ * @return true when the image is a valid bank
+ */
+bool audio_bank_open(audio_bank_t *bank, const void *data, size_t size);
+
+/**
+ * @brief Length of clip @p clip in samples, 0 when there is no such clip.
+ */
+uint32_t audio_bank_clip_samples(const audio_bank_t *bank, uint16_t clip);
+
+/**
+ * @brief Decode @p count 4-bit codes, starting with code @p first of @p codes.
+ *
+ * @param state  Decoder state, updated
+ * @param codes  Packed codes, two per byte, low nibble first
+ * @param first  Index of the first code to decode
+ * @param count  Number of codes (samples)
+ * @param gain   Output gain, Q8
+ * @param out    Decoded samples
+ */
+void audio_adpcm_decode(audio_adpcm_t *state, const uint8_t *codes, size_t first, size_t count, uint16_t gain,
+                        int16_t *out);
+
+/**
+ * @brief Start streaming clip @p clip from its first sample, at unity gain.
+ *
+ * @return false when the bank has no such clip
+ */
+bool audio_stream_start(audio_stream_t *stream, const audio_bank_t *bank, uint16_t clip, bool loop);
+
+/**
+ * @brief Output gain for the following samples, Q8.
+ */
+void audio_stream_set_gain(audio_stream_t *stream, uint16_t gain);
+
+/**
+ * @brief Decode the next samples of the stream into @p out.
+ *
+ * A looping stream always fills the whole buffer, wrapping to the start of
+ * the clip. A one-shot stream stops at the end of the clip.
+ *
+ * @return Samples written, less than @p count only at the end of a one-shot clip
+ */
+size_t audio_stream_fill(audio_stream_t *stream, int16_t *out, size_t count);
+
+/**
+ * @brief Whether a one-shot stream has played to its end.
+ */
+bool audio_stream_done(const audio_stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * Sound clips from the memory-mapped "audio" partition, played through the
+ * I2S PDM transmitter. The DMA runs through a ring of AUDIO_DMA_DESC buffers
+ * of AUDIO_DMA_FRAMES samples; the interrupt at the end of each buffer
+ * decodes the next AUDIO_DMA_FRAMES samples straight from flash into it.
+ * The CPU wakes once per buffer instead of once per sample, and nothing is
+ * copied out of flash first. DMA does not run in light sleep, so a PM lock
+ * keeps the chip awake (but idle) while a clip plays.
+ */
+
+#include <inttypes.h>
+#include "audio_player.h"
+#include "audio_clip.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_pm.h"
+#include "driver/i2s_pdm.h"
+
+#define AUDIO_PARTITION_LABEL   "audio"
+#define AUDIO_DMA_DESC          4
+#define AUDIO_DMA_FRAMES        240
+
+static const char *TAG = "AUDIO";
+
+static audio_bank_t s_bank;
+static audio_stream_t s_stream;
+static uint16_t s_clip;
+static i2s_chan_handle_t s_tx;
+static esp_pm_lock_handle_t s_pm_lock;
+static bool s_playing;
+
+/* a buffer has been sent: refill it (the driver zeroed it) with the next samples */
+static bool audio_sent_isr(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    int16_t *buf = event->dma_buf;
+    size_t count = event->size / sizeof(int16_t);
+    size_t done = audio_stream_fill(&s_stream, buf, count);
+    if (done < count && audio_stream_done(&s_stream)) {
+        s_clip = (s_clip + 1) % s_bank.clip_count;
+        audio_stream_start(&s_stream, &s_bank, s_clip, false);
+        audio_stream_fill(&s_stream, buf + done, count - done);
+    }
+    return false;
+}
+
+esp_err_t audio_player_init(int gpio)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           AUDIO_PARTITION_LABEL);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "No \"%s\" partition", AUDIO_PARTITION_LABEL);
+
+    const void *data;
+    esp_partition_mmap_handle_t map;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &data, &map), TAG,
+                        "Failed to map the audio partition");
+    if (!audio_bank_open(&s_bank, data, part->size) || s_bank.clip_count == 0) {
+        esp_partition_munmap(map);
+        ESP_LOGW(TAG, "No sound clips in the audio partition");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = AUDIO_DMA_DESC;
+    chan_cfg.dma_frame_num = AUDIO_DMA_FRAMES;
+    chan_cfg.auto_clear_before_cb = true;
+    ESP_RETURN_ON_ERROR(i2s_new_channel(&chan_cfg, &s_tx, NULL), TAG, "Failed to create the I2S channel");
+
+    const i2s_pdm_tx_config_t pdm_cfg = {
+        .clk_cfg = I2S_PDM_TX_CLK_DEFAULT_CONFIG(s_bank.sample_rate),
+        .slot_cfg = I2S_PDM_TX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .clk = I2S_GPIO_UNUSED,
+            .dout = gpio,
+        },
+    };
+    ESP_RETURN_ON_ERROR(i2s_channel_init_pdm_tx_mode(s_tx, &pdm_cfg), TAG, "Failed to set up PDM output");
+
+    const i2s_event_callbacks_t cbs = {
+        .on_sent = audio_sent_isr,
+    };
+    ESP_RETURN_ON_ERROR(i2s_channel_register_event_callback(s_tx, &cbs, NULL), TAG, "Failed to register callback");
+    ESP_RETURN_ON_ERROR(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "audio", &s_pm_lock), TAG,
+                        "Failed to create PM lock");
+
+    /* the first start moves on to clip 0 */
+    s_clip = s_bank.clip_count - 1;
+    ESP_LOGI(TAG, "%d sound clip(s) at %" PRIu32 " Hz", s_bank.clip_count, s_bank.sample_rate);
+    return ESP_OK;
+}
+
+void audio_player_start(void)
+{
+    if (s_playing || !s_tx)
+        return;
+
+    s_clip = (s_clip + 1) % s_bank.clip_count;
+    audio_stream_start(&s_stream, &s_bank, s_clip, false);
+    esp_pm_lock_acquire(s_pm_lock);
+    ESP_ERROR_CHECK(i2s_channel_enable(s_tx));
+    s_playing = true;
+}
+
+void audio_player_stop(void)
+{
+    if (!s_playing)
+        return;
+
+    ESP_ERROR_CHECK(i2s_channel_disable(s_tx));
+    esp_pm_lock_release(s_pm_lock);
+    s_playing = false;
+}
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map the "audio" partition and set up the PDM output on @p gpio.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND when there is no audio
+ *         partition, ESP_ERR_INVALID_STATE when it holds no valid clip bank
+ */
+esp_err_t audio_player_init(int gpio);
+
+/**
+ * @brief Start playing the clips one after another, from the clip after the last one played.
+ */
+void audio_player_start(void);
+
+/**
+ * @brief Stop playback and allow light sleep again.
+ */
+void audio_player_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "battery_governor.h"
+
+#define US_PER_HOUR     3600000000LL
+
+/* resting voltage of a LiPo cell against its state of charge, descending */
+static const struct {
+    uint16_t mv;
+    uint8_t percent;
+} s_lipo_curve[] = {
+    { 4200, 100 }, { 4100, 90 }, { 4000, 79 }, { 3900, 66 }, { 3800, 51 }, { 3750, 41 },
+    { 3700, 30 }, { 3650, 19 }, { 3600, 11 }, { 3500, 5 }, { 3300, 0 },
+};
+#define LIPO_POINTS     (sizeof(s_lipo_curve) / sizeof(s_lipo_curve[0]))
+
+uint8_t battery_governor_percent(uint32_t mv)
+{
+    if (mv >= s_lipo_curve[0].mv)
+        return 100;
+    for (unsigned i = 1; i < LIPO_POINTS; i++) {
+        if (mv >= s_lipo_curve[i].mv) {
+            uint32_t span_mv = s_lipo_curve[i - 1].mv - s_lipo_curve[i].mv;
+            uint32_t span_pct = s_lipo_curve[i - 1].percent - s_lipo_curve[i].percent;
+            return (uint8_t)(s_lipo_curve[i].percent + (mv - s_lipo_curve[i].mv) * span_pct / span_mv);
+        }
+    }
+    return 0;
+}
+
+void battery_governor_init(battery_governor_t *gov, const battery_governor_config_t *config)
+{
+    *gov = (battery_governor_t) {
+        .config = *config,
+        .deadline_us = BATTERY_GOVERNOR_NO_DEADLINE,
+        .cap = 255,
+    };
+}
+
+void battery_governor_set_deadline(battery_governor_t *gov, int64_t deadline_us)
+{
+    gov->deadline_us = deadline_us;
+}
+
+void battery_governor_sample(battery_governor_t *gov, uint32_t mv)
+{
+    /* the LEDs pull the voltage down while they switch, average it over a few samples */
+    gov->mv = gov->mv ? (gov->mv * 3 + mv) / 4 : mv;
+    gov->percent = battery_governor_percent(gov->mv);
+}
+
+/* highest cap whose LED current stays within allowed_ua */
+static uint8_t governor_solve(const battery_governor_t *gov, int64_t allowed_ua, battery_governor_load_fn_t load, void *ctx)
+{
+    int lo = gov->config.min_level, hi = 255;
+
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if ((int64_t)gov->config.led_ma * load((uint8_t)mid, ctx) <= allowed_ua)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return (uint8_t)lo;
+}
+
+bool battery_governor_update(battery_governor_t *gov, int64_t now_us, battery_governor_load_fn_t load, void *ctx)
+{
+    uint8_t cap = 255;
+
+    if (gov->mv && gov->deadline_us != BATTERY_GOVERNOR_NO_DEADLINE && now_us < gov->deadline_us) {
+        int percent = gov->percent > gov->config.reserve_percent ? gov->percent - gov->config.reserve_percent : 0;
+        int64_t left_mah_us = (int64_t)gov->config.capacity_mah * percent / 100 * US_PER_HOUR;
+        int64_t allowed_ua = left_mah_us * 1000 / (gov->deadline_us - now_us) - gov->config.base_ma * 1000;
+        cap = allowed_ua > 0 ? governor_solve(gov, allowed_ua, load, ctx) : gov->config.min_level;
+        /* down right away, up only by a real step */
+        if (cap > gov->cap && cap < 255 && cap - gov->cap < gov->config.raise_step)
+            cap = gov->cap;
+    }
+    if (cap == gov->cap)
+        return false;
+    gov->cap = cap;
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint16_t capacity_mah;      /* full battery */
+    uint16_t led_ma;            /* one LED string at full duty */
+    uint16_t base_ma;           /* everything but the LEDs, averaged over sleep and wakes */
+    uint8_t reserve_percent;    /* charge still left at the deadline, covers the error of the voltage estimate */
+    uint8_t min_level;          /* the cap never goes below this level */
+    uint8_t raise_step;         /* the cap goes up only by at least this much, so voltage noise does not make it wander */
+} battery_governor_config_t;
+
+/** Beetle ESP32-C6 with a 2000 mAh LiPo and one 12 V string through the MOSFET board */
+#define BATTERY_GOVERNOR_CONFIG_DEFAULT()   \
+    {                                       \
+        .capacity_mah = 2000,               \
+        .led_ma = 300,                      \
+        .base_ma = 2,                       \
+        .reserve_percent = 5,               \
+        .min_level = 16,                    \
+        .raise_step = 8,                    \
+    }
+
+/** no deadline: the governor leaves the level alone */
+#define BATTERY_GOVERNOR_NO_DEADLINE    INT64_MAX
+
+/**
+ * @brief Summed duty of all LED strings if their level were capped at @p cap.
+ *
+ * @return Permille of one string at full duty, e.g. 1500 for two strings at 75 %
+ */
+typedef uint32_t (*battery_governor_load_fn_t)(uint8_t cap, void *ctx);
+
+/**
+ * Energy-aware dimming: from the state of charge, the time left until the
+ * deadline and what the LED strings draw at a given level, picks the highest
+ * level cap that lets the battery last until the deadline. Pure, the caller
+ * supplies the battery voltage, the time and the load.
+ */
+typedef struct {
+    battery_governor_config_t config;
+    uint32_t mv;                /* filtered battery voltage, 0 before the first sample */
+    uint8_t percent;            /* state of charge */
+    int64_t deadline_us;        /* the light has to last until then */
+    uint8_t cap;                /* highest level the strings may show, 255 = no cap */
+} battery_governor_t;
+
+/**
+ * @brief State of charge of a 1S LiPo cell, resting voltage.
+ *
+ * @param mv Cell voltage in mV
+ * @return 0-100 %
+ */
+uint8_t battery_governor_percent(uint32_t mv);
+
+/**
+ * @brief Set up a governor without a deadline and without a cap.
+ */
+void battery_governor_init(battery_governor_t *gov, const battery_governor_config_t *config);
+
+/**
+ * @brief Set when the battery has to last until, BATTERY_GOVERNOR_NO_DEADLINE to lift the cap.
+ */
+void battery_governor_set_deadline(battery_governor_t *gov, int64_t deadline_us);
+
+/**
+ * @brief Feed one battery voltage measurement (the first one is taken as is, later ones are averaged).
+ */
+void battery_governor_sample(battery_governor_t *gov, uint32_t mv);
+
+/**
+ * @brief Recompute the cap.
+ *
+ * @param now_us Current time
+ * @param load   Load of the LED strings at a given cap, must not decrease with the cap
+ * @param ctx    Argument of @p load
+ * @return true when cap changed and should be handed to the light driver
+ */
+bool battery_governor_update(battery_governor_t *gov, int64_t now_us, battery_governor_load_fn_t load, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
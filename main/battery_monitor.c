@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "battery_monitor.h"
+#include "sdkconfig.h"
+
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+#include "esp_check.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+
+#define BATTERY_ADC_SAMPLES     4
+
+static const char *TAG = "BATTERY";
+
+static adc_oneshot_unit_handle_t s_adc;
+static adc_cali_handle_t s_cali;
+static adc_channel_t s_channel;
+
+esp_err_t battery_monitor_init(void)
+{
+    adc_unit_t unit;
+
+    ESP_RETURN_ON_ERROR(adc_oneshot_io_to_channel(CONFIG_HALLOWEEN_BATTERY_ADC_GPIO, &unit, &s_channel), TAG,
+                        "GPIO%d has no ADC channel", CONFIG_HALLOWEEN_BATTERY_ADC_GPIO);
+    const adc_oneshot_unit_init_cfg_t unit_cfg = {
+        .unit_id = unit,
+        .ulp_mode = ADC_ULP_MODE_DISABLE,
+    };
+    ESP_RETURN_ON_ERROR(adc_oneshot_new_unit(&unit_cfg, &s_adc), TAG, "Failed to create ADC unit");
+    const adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ESP_RETURN_ON_ERROR(adc_oneshot_config_channel(s_adc, s_channel, &chan_cfg), TAG, "Failed to configure ADC channel");
+    const adc_cali_curve_fitting_config_t cali_cfg = {
+        .unit_id = unit,
+        .chan = s_channel,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ESP_RETURN_ON_ERROR(adc_cali_create_scheme_curve_fitting(&cali_cfg, &s_cali), TAG, "Failed to calibrate ADC");
+    return ESP_OK;
+}
+
+esp_err_t battery_monitor_read(uint32_t *mv)
+{
+    int sum = 0;
+
+    ESP_RETURN_ON_FALSE(s_adc, ESP_ERR_INVALID_STATE, TAG, "Not initialized");
+    for (int i = 0; i < BATTERY_ADC_SAMPLES; i++) {
+        int raw, pin_mv;
+        ESP_RETURN_ON_ERROR(adc_oneshot_read(s_adc, s_channel, &raw), TAG, "ADC read failed");
+        ESP_RETURN_ON_ERROR(adc_cali_raw_to_voltage(s_cali, raw, &pin_mv), TAG, "ADC calibration failed");
+        sum += pin_mv;
+    }
+    *mv = (uint32_t)(sum / BATTERY_ADC_SAMPLES) * CONFIG_HALLOWEEN_BATTERY_ADC_DIVIDER;
+    return ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_BATTERY_MONITOR
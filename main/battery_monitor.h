@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Battery voltage through the ADC. The caller decides when to sample: the
+ * light only reads it inside wakes that happen anyway (right before light
+ * sleep), never from a timer of its own.
+ */
+
+/**
+ * @brief Set up the ADC channel of the battery pin (CONFIG_HALLOWEEN_BATTERY_ADC_GPIO).
+ */
+esp_err_t battery_monitor_init(void);
+
+/**
+ * @brief Measure the battery voltage (a few conversions, ~100 us).
+ *
+ * @param[out] mv Battery voltage in mV, divider included
+ */
+esp_err_t battery_monitor_read(uint32_t *mv);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_private/esp_clk.h"
+#include "boot_timeline.h"
+
+#define TIMELINE_MAGIC  0x426f6f74  /* "Boot" */
+
+static const char *TAG = "BOOT";
+
+static const char *const s_mark_names[BOOT_MARK_MAX] = {
+    [BOOT_MARK_APP_START] = "app start",
+    [BOOT_MARK_APP_MAIN] = "app_main",
+    [BOOT_MARK_FIRST_LIGHT] = "first light",
+    [BOOT_MARK_PLATFORM_CONFIG] = "platform config",
+    [BOOT_MARK_ZB_START] = "esp_zb_start",
+    [BOOT_MARK_REBOOT_SIGNAL] = "reboot signal",
+    [BOOT_MARK_JOINED] = "joined",
+};
+
+/* not cleared on reset, only a power-on loses them (caught by the magic) */
+static RTC_NOINIT_ATTR uint32_t s_magic;
+static RTC_NOINIT_ATTR boot_timeline_t s_current;
+static RTC_NOINIT_ATTR boot_timeline_t s_previous;
+static bool s_has_previous;
+
+static uint32_t s_app_start_ms;
+
+static uint32_t timeline_now_ms(void)
+{
+    /* RTC timer: counts from reset, through the ROM and the bootloader */
+    uint32_t ms = (uint32_t)(esp_clk_rtc_time() / 1000);
+    return ms ? ms : 1;
+}
+
+/* runs from the startup code, before app_main */
+static void __attribute__((constructor)) boot_timeline_app_start(void)
+{
+    s_app_start_ms = timeline_now_ms();
+}
+
+void boot_timeline_init(void)
+{
+    uint32_t boot_count = 1;
+    esp_reset_reason_t reason = esp_reset_reason();
+
+    if (s_magic == TIMELINE_MAGIC && reason != ESP_RST_POWERON) {
+        s_previous = s_current;
+        s_has_previous = true;
+        boot_count = s_previous.boot_count + 1;
+    }
+    s_current = (boot_timeline_t) {
+        .boot_count = boot_count,
+        .reset_reason = reason,
+    };
+    s_current.mark_ms[BOOT_MARK_APP_START] = s_app_start_ms;
+    s_magic = TIMELINE_MAGIC;
+    boot_timeline_mark(BOOT_MARK_APP_MAIN);
+}
+
+void boot_timeline_mark(boot_mark_t mark)
+{
+    if (mark < BOOT_MARK_MAX && s_current.mark_ms[mark] == 0) {
+        s_current.mark_ms[mark] = timeline_now_ms();
+    }
+}
+
+void boot_timeline_retry(void)
+{
+    if (s_current.retries < UINT8_MAX) {
+        s_current.retries++;
+    }
+}
+
+const boot_timeline_t *boot_timeline_get(void)
+{
+    return &s_current;
+}
+
+const boot_timeline_t *boot_timeline_previous(void)
+{
+    return s_has_previous ? &s_previous : NULL;
+}
+
+static void timeline_log(const char *which, const boot_timeline_t *timeline)
+{
+    ESP_LOGI(TAG, "%s boot #%lu, reset reason %d, %d commissioning retries", which,
+             (unsigned long)timeline->boot_count, timeline->reset_reason, timeline->retries);
+    for (int mark = 0; mark < BOOT_MARK_MAX; mark++) {
+        if (timeline->mark_ms[mark]) {
+            ESP_LOGI(TAG, "  %-16s %6lu ms", s_mark_names[mark], (unsigned long)timeline->mark_ms[mark]);
+        } else {
+            ESP_LOGI(TAG, "  %-16s      -", s_mark_names[mark]);
+        }
+    }
+}
+
+void boot_timeline_report(void)
+{
+    if (s_has_previous && s_previous.mark_ms[BOOT_MARK_JOINED] == 0) {
+        timeline_log("Previous", &s_previous);
+    }
+    timeline_log("This", &s_current);
+}
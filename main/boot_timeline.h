@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** points of the way from reset to a working light on the network */
+typedef enum {
+    BOOT_MARK_APP_START,        /* ROM and bootloader done, first code of the app (constructor) */
+    BOOT_MARK_APP_MAIN,
+    BOOT_MARK_FIRST_LIGHT,      /* restored light state applied */
+    BOOT_MARK_PLATFORM_CONFIG,  /* esp_zb_platform_config() done */
+    BOOT_MARK_ZB_START,         /* esp_zb_start() called */
+    BOOT_MARK_REBOOT_SIGNAL,    /* ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT / FIRST_START */
+    BOOT_MARK_JOINED,           /* back on the network */
+    BOOT_MARK_MAX,
+} boot_mark_t;
+
+/** one boot, kept in RTC memory so that it survives the next reset */
+typedef struct {
+    uint32_t boot_count;            /* boots since power-on */
+    uint8_t reset_reason;           /* esp_reset_reason_t of this boot */
+    uint8_t retries;                /* commissioning retries before joining */
+    uint32_t mark_ms[BOOT_MARK_MAX];/* time since reset, 0 when not reached */
+} boot_timeline_t;
+
+/**
+ * @brief Start the timeline of this boot, first thing in app_main.
+ *
+ * Moves the timeline of the previous boot aside (unless this is a power-on)
+ * and records BOOT_MARK_APP_START and BOOT_MARK_APP_MAIN.
+ */
+void boot_timeline_init(void);
+
+/**
+ * @brief Record that @p mark has been reached, first time only.
+ */
+void boot_timeline_mark(boot_mark_t mark);
+
+/** @brief Count one commissioning retry of this boot. */
+void boot_timeline_retry(void);
+
+/**
+ * @brief Timeline of the current boot.
+ */
+const boot_timeline_t *boot_timeline_get(void);
+
+/**
+ * @brief Timeline of the previous boot, NULL after power-on.
+ */
+const boot_timeline_t *boot_timeline_previous(void);
+
+/**
+ * @brief Log the timeline of this boot, and of the previous one if it never joined.
+ */
+void boot_timeline_report(void);
+
+#ifdef __cplusplus
+}
+#endif
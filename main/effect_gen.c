@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "effect_gen.h"
+
+/* candle dips below full brightness, sorted: most draws barely move the flame, a few gutter it */
+static const uint8_t s_candle_dip[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 2,
+    2, 3, 3, 5, 5, 5, 6, 6, 6, 6, 8, 8, 10, 11, 11, 11,
+    12, 13, 15, 17, 18, 19, 20, 23, 23, 23, 24, 24, 25, 29, 30, 32,
+    35, 37, 39, 40, 46, 52, 54, 62, 69, 73, 87, 96, 97, 150, 150, 150,
+};
+
+/* peak of each strike in a lightning burst, the first one is the brightest */
+static const uint8_t s_strike_level[4] = { 255, 170, 220, 120 };
+
+/* one heartbeat; the rest at the end gets a random extension */
+static const light_keyframe_t s_heartbeat[] = {
+    { .level = 255, .fade_ms = 70,  .hold_ms = 30 },    /* lub */
+    { .level = 60,  .fade_ms = 110, .hold_ms = 0 },
+    { .level = 190, .fade_ms = 60,  .hold_ms = 20 },    /* dub */
+    { .level = 0,   .fade_ms = 180, .hold_ms = 450 },
+};
+#define HEARTBEAT_FRAMES    (sizeof(s_heartbeat) / sizeof(s_heartbeat[0]))
+
+#define DYING_STEADY_LEVEL  230
+#define DYING_AGE_STEP      3       /* age gained per steady keyframe, ~40 s from new to dead */
+
+uint32_t effect_gen_rand(effect_gen_t *gen)
+{
+    uint32_t x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return gen->rng = x;
+}
+
+/* uniform in [lo, hi] without a division */
+static uint32_t gen_range(effect_gen_t *gen, uint32_t lo, uint32_t hi)
+{
+    return lo + (uint32_t)(((uint64_t)effect_gen_rand(gen) * (hi - lo + 1)) >> 32);
+}
+
+static void gen_frame(light_keyframe_t *frame, uint8_t level, uint16_t fade_ms, uint16_t hold_ms)
+{
+    *frame = (light_keyframe_t) { .level = level, .fade_ms = fade_ms, .hold_ms = hold_ms };
+}
+
+void effect_gen_init(effect_gen_t *gen, effect_gen_kind_t kind, uint32_t seed)
+{
+    *gen = (effect_gen_t) {
+        .rng = seed ? seed : 0x9e3779b9u,
+        .kind = kind < EFFECT_GEN_MAX ? kind : EFFECT_GEN_CANDLE,
+    };
+}
+
+static void candle_next(effect_gen_t *gen, light_keyframe_t *frame)
+{
+    uint32_t r = effect_gen_rand(gen);
+    uint8_t dip = s_candle_dip[r & 63];
+    /* deep dips sink slowly and hang there a little, small ones are quick */
+    uint16_t fade = 30 + ((r >> 8) & 63) + dip;
+    uint16_t hold = (r >> 16) & 31;
+    gen_frame(frame, 255 - dip, fade, hold);
+}
+
+static void lightning_next(effect_gen_t *gen, light_keyframe_t *frame)
+{
+    if (gen->count == 0) {
+        /* dark sky, then a new burst */
+        gen->count = (uint8_t)gen_range(gen, 1, 4) * 2;
+        gen->phase = 0;
+        gen_frame(frame, 0, 400, (uint16_t)gen_range(gen, 2500, 12000));
+        return;
+    }
+    gen->count--;
+    if ((gen->phase & 1) == 0) {
+        /* strike */
+        gen_frame(frame, s_strike_level[(gen->phase >> 1) & 3], 0, (uint16_t)gen_range(gen, 20, 70));
+    } else if (gen->count) {
+        /* flicker of the channel between strikes */
+        gen_frame(frame, (uint8_t)gen_range(gen, 10, 40), 0, (uint16_t)gen_range(gen, 40, 140));
+    } else {
+        /* afterglow */
+        gen_frame(frame, 0, (uint16_t)gen_range(gen, 300, 900), 0);
+    }
+    gen->phase++;
+}
+
+static void heartbeat_next(effect_gen_t *gen, light_keyframe_t *frame)
+{
+    *frame = s_heartbeat[gen->phase];
+    if (gen->phase == HEARTBEAT_FRAMES - 1)
+        frame->hold_ms += (uint16_t)gen_range(gen, 0, 150);
+    gen->phase = (gen->phase + 1) % HEARTBEAT_FRAMES;
+}
+
+static void dying_bulb_next(effect_gen_t *gen, light_keyframe_t *frame)
+{
+    if (gen->count) {
+        /* inside a flicker burst: alternate dropouts and recoveries */
+        gen->count--;
+        if (gen->count & 1)
+            gen_frame(frame, (uint8_t)gen_range(gen, 0, 120), 0, (uint16_t)gen_range(gen, 15, 80));
+        else
+            gen_frame(frame, DYING_STEADY_LEVEL, 0, (uint16_t)gen_range(gen, 20, 160));
+        return;
+    }
+    if (gen->age >= 255 - DYING_AGE_STEP) {
+        /* dead for a while, then a fresh bulb warms up */
+        gen->age = 0;
+        gen_frame(frame, 0, 0, (uint16_t)gen_range(gen, 2000, 5000));
+        gen->count = 0;
+        gen->phase = 1;
+        return;
+    }
+    if (gen->phase) {
+        gen->phase = 0;
+        gen_frame(frame, DYING_STEADY_LEVEL, 1500, 500);
+        return;
+    }
+    gen->age += DYING_AGE_STEP;
+    if ((effect_gen_rand(gen) & 0xff) < gen->age) {
+        /* the older the bulb, the more often and the longer it flickers */
+        gen->count = (uint8_t)(2 + 2 * gen_range(gen, 0, gen->age >> 5));
+        gen_frame(frame, DYING_STEADY_LEVEL, 0, (uint16_t)gen_range(gen, 50, 200));
+        return;
+    }
+    gen_frame(frame, DYING_STEADY_LEVEL, 200, (uint16_t)gen_range(gen, 300, 900));
+}
+
+void effect_gen_next(effect_gen_t *gen, light_keyframe_t *frame)
+{
+    switch (gen->kind) {
+    case EFFECT_GEN_LIGHTNING:
+        lightning_next(gen, frame);
+        break;
+    case EFFECT_GEN_HEARTBEAT:
+        heartbeat_next(gen, frame);
+        break;
+    case EFFECT_GEN_DYING_BULB:
+        dying_bulb_next(gen, frame);
+        break;
+    default:
+        candle_next(gen, frame);
+        break;
+    }
+}
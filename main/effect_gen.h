@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "effect_program.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Procedural effects: an endless keyframe stream drawn from a xorshift PRNG
+ * and constant noise and envelope tables. Integer only, no allocation; all
+ * state is in effect_gen_t.
+ */
+
+typedef enum {
+    EFFECT_GEN_CANDLE,          /* restless flame with occasional deep gutters */
+    EFFECT_GEN_LIGHTNING,       /* darkness broken by bursts of 1-4 strikes */
+    EFFECT_GEN_HEARTBEAT,       /* lub-dub with a slightly irregular rest */
+    EFFECT_GEN_DYING_BULB,      /* steady light flickering more and more until it dies and recovers */
+    EFFECT_GEN_MAX,
+} effect_gen_kind_t;
+
+/** generator state */
+typedef struct {
+    uint32_t rng;
+    uint8_t kind;
+    uint8_t phase;      /* step within the current burst or envelope */
+    uint8_t count;      /* keyframes left in the current burst */
+    uint8_t age;        /* dying bulb: how far gone it is */
+} effect_gen_t;
+
+/**
+ * @brief Start a generator of @p kind.
+ *
+ * @param gen   Generator state
+ * @param kind  Effect
+ * @param seed  PRNG seed, any value (0 is replaced)
+ */
+void effect_gen_init(effect_gen_t *gen, effect_gen_kind_t kind, uint32_t seed);
+
+/**
+ * @brief Produce the next keyframe. The stream never ends.
+ */
+void effect_gen_next(effect_gen_t *gen, light_keyframe_t *frame);
+
+/**
+ * @brief Next PRNG value (xorshift32).
+ */
+uint32_t effect_gen_rand(effect_gen_t *gen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "effect_program.h"
+
+#define PARAM_MAX LIGHT_HAL_FADE_PARAM_MAX
+
+static uint32_t clamp_param(uint32_t v)
+{
+    return v > PARAM_MAX ? PARAM_MAX : v;
+}
+
+static uint32_t ms_to_cycles(uint32_t ms, uint32_t freq_hz)
+{
+    return (uint32_t)(((uint64_t)ms * freq_hz) / 1000);
+}
+
+/* Move the duty by delta over roughly `cycles` PWM periods (a jump for 0) */
+static size_t emit_move(uint32_t delta, bool up, uint32_t cycles, light_hal_fade_range_t *out, uint32_t *used)
+{
+    size_t n = 0;
+    uint32_t steps = delta < cycles ? delta : cycles;
+    uint32_t min_steps = (delta + PARAM_MAX - 1) / PARAM_MAX;
+
+    if (steps < min_steps) {
+        steps = min_steps;
+    }
+    steps = clamp_param(steps ? steps : 1);
+
+    uint32_t scale = clamp_param(delta / steps);
+    uint32_t cycle_num = clamp_param(cycles / steps ? cycles / steps : 1);
+    uint32_t rem = delta - scale * steps;
+
+    if (out) {
+        out[n] = (light_hal_fade_range_t) {
+            .step_num = steps, .cycle_num = cycle_num, .scale = scale, .increase = up,
+        };
+    }
+    n++;
+    *used = steps * cycle_num;
+    if (rem) {
+        if (out) {
+            out[n] = (light_hal_fade_range_t) {
+                .step_num = 1, .cycle_num = 1, .scale = clamp_param(rem), .increase = up,
+            };
+        }
+        n++;
+        *used += 1;
+    }
+    return n;
+}
+
+/* Keep the duty for `cycles` PWM periods, split into step_num x cycle_num */
+static size_t emit_hold(uint32_t cycles, light_hal_fade_range_t *out)
+{
+    if (cycles == 0) {
+        return 0;
+    }
+    uint32_t cycle_num = clamp_param((cycles + PARAM_MAX - 1) / PARAM_MAX);
+    uint32_t steps = clamp_param(cycles / cycle_num);
+
+    if (out) {
+        out[0] = (light_hal_fade_range_t) {
+            .step_num = steps, .cycle_num = cycle_num, .scale = 0, .increase = true,
+        };
+    }
+    return 1;
+}
+
+/* Ramp from_duty -> to_duty over fade_ms, then hold until total_ms */
+static size_t emit_segment(uint32_t from_duty, uint32_t to_duty, uint32_t fade_ms, uint32_t total_ms,
+                           uint32_t freq_hz, light_hal_fade_range_t *out)
+{
+    uint32_t fade_cycles = ms_to_cycles(fade_ms, freq_hz);
+    uint32_t total_cycles = ms_to_cycles(total_ms, freq_hz);
+    uint32_t used = 0;
+    size_t n = 0;
+
+    if (to_duty != from_duty) {
+        bool up = to_duty > from_duty;
+        n += emit_move(up ? to_duty - from_duty : from_duty - to_duty, up, fade_cycles, out, &used);
+    }
+    if (total_cycles > used) {
+        n += emit_hold(total_cycles - used, out ? out + n : NULL);
+    }
+    return n;
+}
+
+size_t effect_program_frame_ranges(const light_keyframe_t *frame, uint32_t from_duty, uint32_t to_duty,
+                                   uint32_t freq_hz, light_hal_fade_range_t *out)
+{
+    return emit_segment(from_duty, to_duty, frame->fade_ms, (uint32_t)frame->fade_ms + frame->hold_ms, freq_hz, out);
+}
+
+size_t effect_program_ramp_ranges(uint32_t from_duty, uint32_t to_duty, uint32_t fade_ms, uint32_t freq_hz,
+                                  light_hal_fade_range_t *out)
+{
+    return emit_segment(from_duty, to_duty, fade_ms, fade_ms, freq_hz, out);
+}
+
+uint32_t effect_program_ranges_ms(const light_hal_fade_range_t *ranges, size_t count, uint32_t freq_hz)
+{
+    uint64_t cycles = 0;
+    for (size_t i = 0; i < count; i++) {
+        cycles += (uint64_t)ranges[i].step_num * ranges[i].cycle_num;
+    }
+    return freq_hz ? (uint32_t)(cycles * 1000 / freq_hz) : 0;
+}
+
+uint32_t effect_program_ranges_end_duty(const light_hal_fade_range_t *ranges, size_t count, uint32_t start_duty)
+{
+    int64_t duty = start_duty;
+    for (size_t i = 0; i < count; i++) {
+        int64_t delta = (int64_t)ranges[i].step_num * ranges[i].scale;
+        duty += ranges[i].increase ? delta : -delta;
+    }
+    return duty < 0 ? 0 : (uint32_t)duty;
+}
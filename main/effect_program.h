@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "light_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * One step of a light effect: ramp to @c level over @c fade_ms, then stay
+ * there for @c hold_ms. Levels are relative, 255 is the current brightness.
+ */
+typedef struct {
+    uint8_t level;
+    uint16_t fade_ms;
+    uint16_t hold_ms;
+} light_keyframe_t;
+
+/**
+ * Keyframe sequence: a fixed table, or a generator that produces the
+ * keyframes one by one (then frames and count are unused).
+ */
+typedef struct {
+    const light_keyframe_t *frames;
+    uint8_t count;
+    bool loop;          /* restart from the first frame after the last one */
+    bool (*next)(void *ctx, light_keyframe_t *frame);  /* generator, false when it is finished */
+    void *ctx;          /* generator argument */
+    void (*restart)(void *ctx, uint32_t seed);      /* generator, start over from @p seed (synced playback), may be NULL */
+} light_effect_program_t;
+
+/** upper bound of ranges effect_program_frame_ranges() emits for one keyframe */
+#define EFFECT_PROGRAM_FRAME_RANGES_MAX 3
+
+/**
+ * @brief Translate one keyframe into hardware fade ranges.
+ *
+ * @param[in]  frame     Keyframe
+ * @param[in]  from_duty Duty the output has when the keyframe starts
+ * @param[in]  to_duty   Duty the keyframe ends at
+ * @param[in]  freq_hz   PWM frequency of the output
+ * @param[out] out       Ranges, room for EFFECT_PROGRAM_FRAME_RANGES_MAX; may be NULL to only count
+ * @return number of ranges (0 for a keyframe that neither moves nor holds)
+ */
+size_t effect_program_frame_ranges(const light_keyframe_t *frame, uint32_t from_duty, uint32_t to_duty,
+                                   uint32_t freq_hz, light_hal_fade_range_t *out);
+
+/**
+ * @brief Translate a single ramp into hardware fade ranges.
+ *
+ * Same as a keyframe without hold, but for ramps longer than a keyframe can
+ * describe (up to ~1000 s at 1 kHz).
+ *
+ * @param[in]  from_duty Start duty
+ * @param[in]  to_duty   End duty
+ * @param[in]  fade_ms   Ramp time
+ * @param[in]  freq_hz   PWM frequency of the output
+ * @param[out] out       Ranges, room for EFFECT_PROGRAM_FRAME_RANGES_MAX; may be NULL to only count
+ * @return number of ranges
+ */
+size_t effect_program_ramp_ranges(uint32_t from_duty, uint32_t to_duty, uint32_t fade_ms, uint32_t freq_hz,
+                                  light_hal_fade_range_t *out);
+
+/**
+ * @brief Duration of fade ranges in milliseconds at @p freq_hz.
+ */
+uint32_t effect_program_ranges_ms(const light_hal_fade_range_t *ranges, size_t count, uint32_t freq_hz);
+
+/**
+ * @brief Duty reached at the end of fade ranges that start at @p start_duty.
+ */
+uint32_t effect_program_ranges_end_duty(const light_hal_fade_range_t *ranges, size_t count, uint32_t start_duty);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,9 +9,39 @@
 #include "nvs_flash.h"
 #include "ha/esp_zigbee_ha_standard.h"
 #include "esp_zb_light.h"
+#include "level_transition.h"
+#include "light_stats.h"
+#include "light_trace.h"
+#include "light_blog.h"
+#include "light_coalesce.h"
+#include "light_state.h"
+#include "boot_timeline.h"
+#include "poll_scheduler.h"
+#include "sleep_governor.h"
+#include "attr_report.h"
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+#include "battery_monitor.h"
+#include "battery_governor.h"
+#endif
+#include "esp_cpu.h"
+#include "esp_timer.h"
 #include "esp_pm.h"
 #include "esp_private/esp_clk.h"
 #include "esp_sleep.h"
+#include <string.h>
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+#include <sys/time.h>
+#include "schedule.h"
+#include "schedule_store.h"
+#endif
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+#include "light_effect.h"
+#include "time_sync.h"
+#endif
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+#include "scene_store.h"
+#endif
+#include "ota_update.h"
 #include <hal/ieee802154_ll.h>
 
 #if !defined ZB_ED_ROLE
@@ -22,17 +52,780 @@ static const char *TAG = "Halloween";
 
 /********************* Define functions **************************/
 
-static esp_err_t deferred_driver_init(void)
+static light_state_t s_light_state = LIGHT_STATE_DEFAULT();   /* restored in app_main() */
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+/* level each channel is at or ramping to as this task last set it, where Move and Step start from */
+static uint8_t s_level_target[LIGHT_CHANNELS];
+
+/*
+ * A level transition reports its outcome from the light task, after
+ * whatever was written to the channel in the meantime. Writes are counted
+ * here, and a transition leaves an attribute written since it began to
+ * that write.
+ */
+static uint8_t s_power_writes[LIGHT_CHANNELS];
+static uint8_t s_level_writes[LIGHT_CHANNELS];
+
+#define zb_transition_arg(channel, with_on_off) \
+    ((void *)(uintptr_t)(s_level_writes[channel] << 16 | s_power_writes[channel] << 8 | (with_on_off)))
+#endif
+
+static uint8_t s_commissioning_retries;
+static poll_scheduler_t s_poll;
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+static time_sync_t s_sync;
+static time_sync_line_t s_sync_line;            /* copy of s_sync.line the light task reads */
+static bool s_sync_locked;
+static portMUX_TYPE s_sync_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_sync_listen_us = -1;           /* polling fast for the beacon since then, -1 while not */
+static int64_t s_sync_open_us;                  /* window the next beacon is expected in, local time */
+static int64_t s_sync_close_us;
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR
+static sleep_governor_t s_sleep_gov;
+#endif
+
+
+#if CONFIG_HALLOWEEN_REPORT_ENABLE
+/* an attribute the light reports on its own */
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster;
+    uint16_t attr_id;
+} zb_report_attr_t;
+
+static attr_report_t s_report;
+static zb_report_attr_t s_report_attrs[ATTR_REPORT_MAX];   /* by attr_report_t index */
+static int s_report_on_off[LIGHT_CHANNELS];
+static int s_report_level[LIGHT_CHANNELS];
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+static int s_report_effect = -1;
+#endif
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+static int s_report_battery_voltage = -1;
+static int s_report_battery_remaining = -1;
+#endif
+static bool s_report_joined;
+static int64_t s_report_alarm_us = INT64_MAX;  /* when the pending alarm fires */
+
+static int zb_report_track(uint8_t endpoint, uint16_t cluster, uint16_t attr_id, uint16_t change, int32_t value)
+{
+    const attr_report_cfg_t cfg = {
+        .min_s = CONFIG_HALLOWEEN_REPORT_MIN_S,
+        .max_s = CONFIG_HALLOWEEN_REPORT_MAX_S,
+        .change = change,
+    };
+    int index = attr_report_add(&s_report, &cfg, value);
+    if (index >= 0)
+        s_report_attrs[index] = (zb_report_attr_t) { endpoint, cluster, attr_id };
+    return index;
+}
+
+/* Every attribute starts out unreported, so the restored state goes out once the device has joined */
+static void zb_report_init(void)
+{
+    attr_report_init(&s_report);
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        s_report_on_off[channel] = zb_report_track(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                                   ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, 0, s_light_state.on[channel]);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        s_report_level[channel] = zb_report_track(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                                  ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+                                                  CONFIG_HALLOWEEN_REPORT_LEVEL_CHANGE, s_light_state.level[channel]);
+#else
+        s_report_level[channel] = -1;
+#endif
+    }
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    s_report_effect = zb_report_track(HA_ESP_LIGHT_ENDPOINT, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT,
+                                      ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, 0, s_light_state.effect);
+#endif
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+    /* in the attribute units: 100 mV and half percent */
+    s_report_battery_voltage = zb_report_track(HA_ESP_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
+                                               ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID, 1, 0xff);
+    s_report_battery_remaining = zb_report_track(HA_ESP_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
+                                                 ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID, 4, 0xff);
+#endif
+}
+
+static void zb_report_send(const zb_report_attr_t *attr)
+{
+    esp_zb_zcl_report_attr_cmd_t cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = 0x0000,    /* coordinator */
+            .dst_endpoint = 1,
+            .src_endpoint = attr->endpoint,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = attr->cluster,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .attributeID = attr->attr_id,
+    };
+    esp_zb_zcl_report_attr_cmd_req(&cmd);
+}
+
+static void zb_report_schedule(uint32_t delay_ms);
+
+/* Send everything the policy groups into this wake, then sleep until the next report or heartbeat */
+static void zb_report_cb(uint8_t param)
+{
+    uint32_t next_ms;
+    uint32_t mask = attr_report_due(&s_report, esp_timer_get_time(), &next_ms);
+
+    s_report_alarm_us = INT64_MAX;
+
+    if (mask)
+        LIGHT_BLOG(TAG, REPORT_SENT, mask);
+    while (mask) {
+        int index = __builtin_ctz(mask);
+        mask &= mask - 1;
+        zb_report_send(&s_report_attrs[index]);
+    }
+    zb_report_schedule(next_ms);
+}
+
+/* Arm the alarm for @p delay_ms unless it already fires earlier */
+static void zb_report_schedule(uint32_t delay_ms)
+{
+    if (!s_report_joined || delay_ms == ATTR_REPORT_IDLE)
+        return;
+    int64_t at_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+    if (at_us >= s_report_alarm_us)
+        return;
+    esp_zb_scheduler_alarm_cancel(zb_report_cb, 0);
+    esp_zb_scheduler_alarm(zb_report_cb, 0, delay_ms);
+    s_report_alarm_us = at_us;
+}
+
+/*
+ * An attribute changed. A change the coordinator made itself (an attribute
+ * write) needs no report; one the device made (end of a transition, Stop)
+ * is reported as the policy allows.
+ */
+static void zb_report_update(int index, int32_t value, bool local)
+{
+    if (index < 0)
+        return;
+    if (local) {
+        attr_report_set(&s_report, index, value);
+        zb_report_schedule(ATTR_REPORT_GATHER_MS);
+    } else {
+        attr_report_seen(&s_report, index, value, esp_timer_get_time());
+    }
+}
+
+static void zb_report_joined(void)
+{
+    s_report_joined = true;
+    zb_report_schedule(0);
+}
+
+#define zb_report_on_off(channel, on, local)    zb_report_update(s_report_on_off[channel], (on), (local))
+#define zb_report_level(channel, level, local)  zb_report_update(s_report_level[channel], (level), (local))
+#define zb_report_effect(effect, local)         zb_report_update(s_report_effect, (effect), (local))
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+#define zb_report_battery(mv, percent)          do { zb_report_update(s_report_battery_voltage, (mv) / 100, true); \
+                                                     zb_report_update(s_report_battery_remaining, (percent) * 2, true); } while (0)
+#endif
+#else
+#define zb_report_init()
+#define zb_report_joined()
+#define zb_report_on_off(channel, on, local)
+#define zb_report_level(channel, level, local)
+#define zb_report_effect(effect, local)
+#define zb_report_battery(mv, percent)
+#endif //CONFIG_HALLOWEEN_REPORT_ENABLE
+
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+static battery_governor_t s_battery;
+static bool s_battery_ok;
+
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+static uint32_t zb_battery_load(uint8_t cap, void *ctx)
+{
+    return light_driver_load(cap);
+}
+
+/* minutes from now the battery has to last, 0 for no limit */
+static void zb_battery_set_runtime(uint16_t minutes)
+{
+    int64_t now = esp_timer_get_time();
+    battery_governor_set_deadline(&s_battery, minutes ? now + minutes * 60 * 1000000LL : BATTERY_GOVERNOR_NO_DEADLINE);
+    if (battery_governor_update(&s_battery, now, zb_battery_load, NULL))
+        light_driver_set_level_cap(s_battery.cap);
+}
+#endif //CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+
+/*
+ * Measure the battery. Runs from the stack task right before sleeping, so
+ * the ADC only ever works inside a wake that happens anyway, and at most
+ * every CONFIG_HALLOWEEN_BATTERY_SAMPLE_S.
+ */
+static void zb_battery_sample(void)
+{
+    static int64_t last_sample_us;
+    int64_t now = esp_timer_get_time();
+    uint32_t mv;
+
+    if (!s_battery_ok || (last_sample_us && now - last_sample_us < CONFIG_HALLOWEEN_BATTERY_SAMPLE_S * 1000000LL))
+        return;
+    last_sample_us = now;
+    if (battery_monitor_read(&mv) != ESP_OK)
+        return;
+    battery_governor_sample(&s_battery, mv);
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    if (battery_governor_update(&s_battery, now, zb_battery_load, NULL))
+        light_driver_set_level_cap(s_battery.cap);
+#endif
+    LIGHT_BLOG(TAG, BATTERY_SAMPLE, s_battery.mv, s_battery.percent, s_battery.cap);
+    esp_zcl_utility_set_battery(HA_ESP_LIGHT_ENDPOINT, s_battery.mv, s_battery.percent);
+    zb_report_battery(s_battery.mv, s_battery.percent);
+}
+
+static void zb_battery_init(void)
 {
-	light_driver_init(LIGHT_DEFAULT_ON);
+    battery_governor_config_t config = BATTERY_GOVERNOR_CONFIG_DEFAULT();
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    config.capacity_mah = CONFIG_HALLOWEEN_BATTERY_CAPACITY_MAH;
+    config.led_ma = CONFIG_HALLOWEEN_BATTERY_LED_MA;
+#endif
+    battery_governor_init(&s_battery, &config);
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    zb_battery_set_runtime(CONFIG_HALLOWEEN_BATTERY_RUNTIME_MIN);
+#endif
+    s_battery_ok = battery_monitor_init() == ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_BATTERY_MONITOR
+
+/* Driver changes that the user would expect to survive a reboot; a transition still to report leaves them be */
+static void zb_light_set_power(uint8_t channel, bool on)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    s_power_writes[channel]++;
+#endif
+    light_driver_set_power(channel, on);
+    light_state_set_power(channel, on);
+}
+
+static void zb_light_set_level(uint8_t channel, uint8_t level)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    s_level_writes[channel]++;
+    s_level_target[channel] = level;
+    light_driver_set_brightness(channel, level);
+#endif
+    light_state_set_level(channel, level);
+}
+
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+static schedule_t s_schedule;
+static RTC_DATA_ATTR bool s_time_valid;         /* clock set by the coordinator, kept through deep sleep */
+static RTC_DATA_ATTR uint32_t s_schedule_last;  /* entries up to this ZCL time have been applied */
+
+static uint32_t zb_schedule_now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint32_t)(tv.tv_sec - SCHEDULE_UNIX_OFFSET);
+}
+
+/* Run one scheduled action on @p channel as if the coordinator had sent it, and report the result */
+static void zb_schedule_apply(uint8_t channel, schedule_action_t action, uint8_t value)
+{
+    uint8_t endpoint = LIGHT_CHANNEL_ENDPOINT(channel);
+
+    switch (action) {
+    case SCHEDULE_ACTION_OFF:
+    case SCHEDULE_ACTION_ON: {
+        bool on = action == SCHEDULE_ACTION_ON;
+        esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                     ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &on, false);
+        zb_light_set_power(channel, on);
+        zb_report_on_off(channel, on, true);
+        break;
+    }
+    case SCHEDULE_ACTION_LEVEL:
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                     ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &value, false);
+        zb_report_level(channel, value, true);
+#endif
+        zb_light_set_level(channel, value);
+        break;
+    case SCHEDULE_ACTION_EFFECT:
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+        if (channel == 0 && light_driver_set_effect(value)) {
+            esp_zb_zcl_set_attribute_val(endpoint, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                         ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, &value, false);
+            light_state_set_effect(value);
+            zb_report_effect(value, true);
+        }
+#endif
+        break;
+    default:
+        break;
+    }
+}
+
+static void zb_schedule_apply_entry(const schedule_entry_t *entry)
+{
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        if (entry->channel == SCHEDULE_CHANNEL_ALL || entry->channel == channel)
+            zb_schedule_apply(channel, entry->action, entry->value);
+    }
+}
+
+/* Bring the light into the state the last week of entries left it in, once the clock is first known */
+static void zb_schedule_apply_state(uint32_t now)
+{
+    schedule_state_t state;
+
+    schedule_state(&s_schedule, now, &state);
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        if (state.level[channel] >= 0)
+            zb_schedule_apply(channel, SCHEDULE_ACTION_LEVEL, (uint8_t)state.level[channel]);
+        if (state.on[channel] >= 0)
+            zb_schedule_apply(channel, state.on[channel] ? SCHEDULE_ACTION_ON : SCHEDULE_ACTION_OFF, 0);
+    }
+    if (state.effect >= 0)
+        zb_schedule_apply(0, SCHEDULE_ACTION_EFFECT, (uint8_t)state.effect);
+}
+
+#if CONFIG_HALLOWEEN_SCHEDULE_DEEP_SLEEP
+/* Every string is off and nothing is scheduled for a while */
+static bool zb_schedule_can_deep_sleep(uint32_t *sleep_s)
+{
+    uint32_t now = zb_schedule_now();
+    uint32_t next;
+
+    if (!schedule_next(&s_schedule, now, &next) || next - now < CONFIG_HALLOWEEN_SCHEDULE_DEEP_SLEEP_MIN_S)
+        return false;
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+    /* a download goes on through the off period, it would start over after the wakeup */
+    if (ota_update_running())
+        return false;
+#endif
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                                           ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID);
+        if (!attr || *(bool *)attr->data_p)
+            return false;
+    }
+    *sleep_s = next - now - SCHEDULE_DEEP_SLEEP_EARLY_S;
+    return true;
+}
+
+/*
+ * Runs SCHEDULE_DEEP_SLEEP_DELAY_MS after an entry, once its reports are out.
+ * The LED pins stay latched by the RTC GPIO hold of light_hal_gpio_set();
+ * the device boots again shortly before the next entry and rejoins.
+ */
+static void zb_schedule_deep_sleep_cb(uint8_t param)
+{
+    uint32_t sleep_s;
+
+    light_coalesce_flush();
+    if (!zb_schedule_can_deep_sleep(&sleep_s))
+        return;
+    ESP_LOGI(TAG, "Deep sleep for %" PRIu32 " s until the next schedule entry", sleep_s);
+    light_state_commit();
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_s * 1000000);
+    esp_deep_sleep_start();
+}
+#endif //CONFIG_HALLOWEEN_SCHEDULE_DEEP_SLEEP
+
+static void zb_schedule_cb(uint8_t param);
+
+/* Apply the entries that fired since the last run, then sleep until the next one */
+static void zb_schedule_run(void)
+{
+    uint32_t now, next;
+
+    esp_zb_scheduler_alarm_cancel(zb_schedule_cb, 0);
+    if (!s_time_valid)
+        return;
+    now = zb_schedule_now();
+    if (now > s_schedule_last && now - s_schedule_last <= SCHEDULE_CATCH_UP_S) {
+        uint32_t mask = schedule_due(&s_schedule, s_schedule_last, now);
+        if (mask) {
+            LIGHT_BLOG(TAG, SCHEDULE_RUN, mask, now);
+            /* writes still held back by the coalescing window are older than the entries */
+            light_coalesce_flush();
+        }
+        while (mask) {
+            int index = __builtin_ctz(mask);
+            mask &= mask - 1;
+            zb_schedule_apply_entry(&s_schedule.entries[index]);
+        }
+    }
+    s_schedule_last = now;
+
+    /* a second late rather than a wake too early, and never asleep for long on a drifting alarm */
+    uint32_t delay_s = SCHEDULE_RECHECK_S;
+    if (schedule_next(&s_schedule, now, &next) && next - now < SCHEDULE_RECHECK_S)
+        delay_s = next - now + 1;
+    esp_zb_scheduler_alarm(zb_schedule_cb, 0, delay_s * 1000);
+#if CONFIG_HALLOWEEN_SCHEDULE_DEEP_SLEEP
+    esp_zb_scheduler_alarm_cancel(zb_schedule_deep_sleep_cb, 0);
+    esp_zb_scheduler_alarm(zb_schedule_deep_sleep_cb, 0, SCHEDULE_DEEP_SLEEP_DELAY_MS);
+#endif
+}
+
+static void zb_schedule_cb(uint8_t param)
+{
+    zb_schedule_run();
+}
+
+static void zb_schedule_set_time(uint32_t time)
+{
+    struct timeval tv = { .tv_sec = (time_t)time + SCHEDULE_UNIX_OFFSET };
+    bool first = !s_time_valid;
+
+    settimeofday(&tv, NULL);
+    s_time_valid = true;
+    ESP_LOGI(TAG, "Time set to %" PRIu32 " (ZCL)", time);
+    if (first) {
+        light_coalesce_flush();
+        zb_schedule_apply_state(time);
+        s_schedule_last = time;
+    }
+    zb_schedule_run();
+}
+
+/* The value of a schedule attribute write, NULL unless it has the type and size of @p type */
+static const void *zb_schedule_value(const esp_zb_zcl_attribute_t *attribute, esp_zb_zcl_attr_type_t type, uint16_t size)
+{
+    const uint8_t *value = attribute->data.value;
+
+    if (!value || attribute->data.type != type || attribute->data.size < size) {
+        ESP_LOGW(TAG, "Invalid schedule attribute(0x%x): type 0x%x, %d bytes", attribute->id, attribute->data.type,
+                 attribute->data.size);
+        return NULL;
+    }
+    /* an octet string also needs the length byte that leads it */
+    if (type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING && attribute->data.size < 1 + value[0]) {
+        ESP_LOGW(TAG, "Invalid schedule attribute(0x%x): %d bytes for a %d byte string", attribute->id,
+                 attribute->data.size, value[0]);
+        return NULL;
+    }
+    return value;
+}
+
+/* Time and time zone from the Time cluster, entries and position from the schedule cluster */
+static esp_err_t zb_schedule_attribute(uint16_t cluster, const esp_zb_zcl_attribute_t *attribute)
+{
+    const void *value;
+    schedule_zone_t *zone = &s_schedule.zone;
+
+    if (cluster == ESP_ZB_ZCL_CLUSTER_ID_TIME) {
+        switch (attribute->id) {
+        case ESP_ZB_ZCL_ATTR_TIME_TIME_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME, sizeof(uint32_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zb_schedule_set_time(*(const uint32_t *)value);
+            return ESP_OK;
+        case ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_S32, sizeof(int32_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->zone_s = *(const int32_t *)value;
+            break;
+        case ESP_ZB_ZCL_ATTR_TIME_DST_START_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_U32, sizeof(uint32_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->dst_start = *(const uint32_t *)value;
+            break;
+        case ESP_ZB_ZCL_ATTR_TIME_DST_END_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_U32, sizeof(uint32_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->dst_end = *(const uint32_t *)value;
+            break;
+        case ESP_ZB_ZCL_ATTR_TIME_DST_SHIFT_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_S32, sizeof(int32_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->dst_shift_s = *(const int32_t *)value;
+            break;
+        default:
+            return ESP_OK;
+        }
+    } else {
+        switch (attribute->id) {
+        case ZCL_ATTR_HALLOWEEN_SCHEDULE_ENTRIES_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, 1);
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            ESP_RETURN_ON_ERROR(esp_zcl_utility_parse_schedule(value, &s_schedule), TAG, "Rejected schedule");
+            break;
+        case ZCL_ATTR_HALLOWEEN_SCHEDULE_LATITUDE_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_S16, sizeof(int16_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->latitude = *(const int16_t *)value;
+            break;
+        case ZCL_ATTR_HALLOWEEN_SCHEDULE_LONGITUDE_ID:
+            value = zb_schedule_value(attribute, ESP_ZB_ZCL_ATTR_TYPE_S16, sizeof(int16_t));
+            if (!value)
+                return ESP_ERR_INVALID_ARG;
+            zone->longitude = *(const int16_t *)value;
+            break;
+        default:
+            return ESP_OK;
+        }
+    }
+    schedule_store_save(&s_schedule);
+    zb_schedule_run();
     return ESP_OK;
 }
+#else
+#define zb_schedule_run()
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+
+#if CONFIG_HALLOWEEN_ENABLE_SLEEP
+/*
+ * Copy the counters into the statistics cluster. Runs from the stack task
+ * right before sleeping, at most every STATS_REFRESH_INTERVAL_US, so reading
+ * the cluster never costs a wakeup of its own.
+ */
+static void zb_stats_refresh(void)
+{
+    static int64_t last_refresh_us;
+    int64_t now = esp_timer_get_time();
+    light_stats_t stats;
+    const boot_timeline_t *boot = boot_timeline_get();
+
+    if (last_refresh_us && now - last_refresh_us < STATS_REFRESH_INTERVAL_US)
+        return;
+    last_refresh_us = now;
+
+    light_stats_get(&stats);
+    const uint32_t values[ZCL_ATTR_HALLOWEEN_STATS_COUNT] = {
+        [ZCL_ATTR_HALLOWEEN_STATS_WAKE_TIMER_ID] = stats.wakeups[LIGHT_STATS_WAKE_TIMER],
+        [ZCL_ATTR_HALLOWEEN_STATS_WAKE_GPIO_ID] = stats.wakeups[LIGHT_STATS_WAKE_GPIO],
+        [ZCL_ATTR_HALLOWEEN_STATS_WAKE_UART_ID] = stats.wakeups[LIGHT_STATS_WAKE_UART],
+        [ZCL_ATTR_HALLOWEEN_STATS_WAKE_OTHER_ID] = stats.wakeups[LIGHT_STATS_WAKE_OTHER],
+        [ZCL_ATTR_HALLOWEEN_STATS_WAKE_REJECTED_ID] = stats.wakeups[LIGHT_STATS_WAKE_REJECTED],
+        [ZCL_ATTR_HALLOWEEN_STATS_AWAKE_MS_ID] = (uint32_t)(stats.awake_us / 1000),
+        [ZCL_ATTR_HALLOWEEN_STATS_RADIO_TX_ID] = stats.radio_tx,
+        [ZCL_ATTR_HALLOWEEN_STATS_RADIO_RX_ID] = stats.radio_rx,
+        [ZCL_ATTR_HALLOWEEN_STATS_LEDC_ACTIVATIONS_ID] = stats.ledc_activations,
+        [ZCL_ATTR_HALLOWEEN_STATS_TIMER_ACTIVATIONS_ID] = stats.timer_activations,
+        [ZCL_ATTR_HALLOWEEN_STATS_BOOT_COUNT_ID] = boot->boot_count,
+        [ZCL_ATTR_HALLOWEEN_STATS_BOOT_LIGHT_MS_ID] = boot->mark_ms[BOOT_MARK_FIRST_LIGHT],
+        [ZCL_ATTR_HALLOWEEN_STATS_BOOT_JOIN_MS_ID] = boot->mark_ms[BOOT_MARK_JOINED],
+        [ZCL_ATTR_HALLOWEEN_STATS_POLL_INTERVAL_MS_ID] = s_poll.interval_ms,
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR
+        [ZCL_ATTR_HALLOWEEN_STATS_SLEEP_THRESHOLD_MS_ID] = s_sleep_gov.threshold_ms,
+#endif
+    };
+    for (uint16_t attr_id = 0; attr_id < ZCL_ATTR_HALLOWEEN_STATS_COUNT; attr_id++)
+        esp_zcl_utility_set_stats_attr(HA_ESP_LIGHT_ENDPOINT, attr_id, values[attr_id]);
+}
+
+/*
+ * Sleep on a CAN_SLEEP signal. The governor measures each sleep: the wall
+ * time of the call, and the CPU cycles it ran for, which stop while the chip
+ * is actually asleep. Sleeps too short to pay back their entry/exit overhead
+ * are skipped and the stack threshold is raised above them.
+ */
+static void zb_sleep(void)
+{
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR
+    int64_t start_us = esp_timer_get_time();
+    if (!sleep_governor_should_sleep(&s_sleep_gov, start_us))
+        return;
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+#endif
+    light_stats_sleep_enter();
+    esp_zb_sleep_now();
+    light_stats_sleep_exit();
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR
+    int64_t end_us = esp_timer_get_time();
+    uint32_t gap_us = (uint32_t)(end_us - start_us);
+    uint32_t awake_us = (esp_cpu_get_cycle_count() - start_cycles) / (esp_clk_cpu_freq() / 1000000);
+
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR_TRACE
+    LIGHT_BLOG(TAG, SLEEP_SAMPLE, gap_us, awake_us);
+#endif
+    if (sleep_governor_record(&s_sleep_gov, end_us, gap_us, awake_us))
+        esp_zb_sleep_set_threshold(s_sleep_gov.threshold_ms);
+#endif
+}
+#endif //CONFIG_HALLOWEEN_ENABLE_SLEEP
 
 static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
 {
     ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, , TAG, "Failed to start Zigbee commissioning");
 }
 
+/*
+ * Retry commissioning with an exponential backoff: a brownout restart next
+ * to its parent is back within a few hundred ms, while a device whose parent
+ * is gone does not keep its radio busy every second.
+ */
+static void zb_commissioning_retry(uint8_t mode_mask)
+{
+    uint8_t shift = s_commissioning_retries < 8 ? s_commissioning_retries : 8;
+    uint32_t delay_ms = COMMISSIONING_RETRY_MIN_MS << shift;
+
+    if (delay_ms > COMMISSIONING_RETRY_MAX_MS)
+        delay_ms = COMMISSIONING_RETRY_MAX_MS;
+    if (s_commissioning_retries < UINT8_MAX)
+        s_commissioning_retries++;
+    boot_timeline_retry();
+    ESP_LOGI(TAG, "Retrying commissioning in %" PRIu32 " ms", delay_ms);
+    esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, mode_mask, delay_ms);
+}
+
+static void zb_poll_apply(void)
+{
+    uint32_t interval_ms = s_poll.interval_ms;
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    /* a sync beacon waits at the parent for the next poll, which should not be far */
+    if (s_sync_listen_us >= 0 && interval_ms > CONFIG_HALLOWEEN_SYNC_POLL_MS)
+        interval_ms = CONFIG_HALLOWEEN_SYNC_POLL_MS;
+#endif
+    esp_zb_zdo_pim_set_long_poll_interval(interval_ms);
+    esp_zcl_utility_set_stats_attr(HA_ESP_LIGHT_ENDPOINT, ZCL_ATTR_HALLOWEEN_STATS_POLL_INTERVAL_MS_ID, interval_ms);
+}
+
+static void zb_poll_step_cb(uint8_t param)
+{
+    uint32_t delay_ms = poll_scheduler_step(&s_poll);
+
+    zb_poll_apply();
+    if (delay_ms)
+        esp_zb_scheduler_alarm(zb_poll_step_cb, 0, delay_ms);
+}
+
+/*
+ * Poll fast for a while after anything happened, so that follow-up commands
+ * (a slider drag, a scene change) do not wait in the parent's queue, then
+ * back off to the idle interval.
+ */
+static void zb_poll_activity(void)
+{
+    bool was_fast = s_poll.interval_ms == s_poll.fast_ms;
+    uint32_t delay_ms = poll_scheduler_activity(&s_poll);
+
+    esp_zb_scheduler_alarm_cancel(zb_poll_step_cb, 0);
+    if (!was_fast)
+        zb_poll_apply();
+    esp_zb_scheduler_alarm(zb_poll_step_cb, 0, delay_ms);
+}
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+/* Shared time for the effects, on the light task */
+static int64_t zb_sync_clock(void)
+{
+    time_sync_line_t line;
+    bool locked;
+
+    portENTER_CRITICAL(&s_sync_lock);
+    line = s_sync_line;
+    locked = s_sync_locked;
+    portEXIT_CRITICAL(&s_sync_lock);
+    return locked ? time_sync_line_remote(&line, esp_timer_get_time()) : LIGHT_EFFECT_NO_CLOCK;
+}
+
+static void zb_sync_listen(bool listen)
+{
+    if (listen == (s_sync_listen_us >= 0))
+        return;
+    s_sync_listen_us = listen ? esp_timer_get_time() : -1;
+    zb_poll_apply();
+}
+
+static void zb_sync_window_cb(uint8_t open);
+
+/* Poll fast from @p open_us until the beacon arrives, or until @p close_us */
+static void zb_sync_window_arm(int64_t open_us, int64_t close_us)
+{
+    int64_t now = esp_timer_get_time();
+
+    s_sync_open_us = open_us;
+    s_sync_close_us = close_us;
+    esp_zb_scheduler_alarm_cancel(zb_sync_window_cb, 1);
+    esp_zb_scheduler_alarm_cancel(zb_sync_window_cb, 0);
+    if (open_us > now)
+        esp_zb_scheduler_alarm(zb_sync_window_cb, 1, (uint32_t)((open_us - now) / 1000));
+    else
+        zb_sync_listen(true);
+    esp_zb_scheduler_alarm(zb_sync_window_cb, 0, close_us > now ? (uint32_t)((close_us - now) / 1000) : 0);
+}
+
+static void zb_sync_window_cb(uint8_t open)
+{
+    zb_sync_listen(open);
+    /* the beacon went missing, the next one comes a period later */
+    if (!open && s_sync.period_us > 0)
+        zb_sync_window_arm(s_sync_open_us + s_sync.period_us, s_sync_close_us + s_sync.period_us);
+}
+
+/* SyncBeacon from the coordinator: the shared time it was sent at */
+static esp_err_t zb_sync_command_handler(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t open, close;
+    uint32_t time_s;
+    uint16_t time_ms;
+
+    ESP_RETURN_ON_FALSE(message->info.command.id == ZCL_CMD_HALLOWEEN_LIGHT_SYNC, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "Unexpected light command(0x%x)", message->info.command.id);
+    ESP_RETURN_ON_FALSE(message->data.value && message->data.size >= sizeof(time_s) + sizeof(time_ms), ESP_ERR_INVALID_ARG,
+                        TAG, "Short sync beacon");
+    memcpy(&time_s, message->data.value, sizeof(time_s));
+    memcpy(&time_ms, (const uint8_t *)message->data.value + sizeof(time_s), sizeof(time_ms));
+
+    /* it was not there at the previous poll: a fast one, or as far as we know an idle one */
+    bool fast = s_sync_listen_us >= 0 && now - s_sync_listen_us >= CONFIG_HALLOWEEN_SYNC_POLL_MS * 1000LL;
+    int64_t wait_us = (fast ? CONFIG_HALLOWEEN_SYNC_POLL_MS : s_poll.idle_ms) * 1000LL;
+    time_sync_add(&s_sync, now, time_s * 1000000LL + time_ms * 1000LL, wait_us);
+    if (!s_sync_locked)
+        ESP_LOGI(TAG, "Effects synced to the coordinator clock");
+    portENTER_CRITICAL(&s_sync_lock);
+    s_sync_line = s_sync.line;
+    s_sync_locked = true;
+    portEXIT_CRITICAL(&s_sync_lock);
+
+    zb_sync_listen(false);
+    esp_zb_scheduler_alarm_cancel(zb_sync_window_cb, 1);
+    esp_zb_scheduler_alarm_cancel(zb_sync_window_cb, 0);
+    if (time_sync_window(&s_sync, CONFIG_HALLOWEEN_SYNC_POLL_MS * 1000LL, &open, &close))
+        zb_sync_window_arm(open, close);
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    /* good enough for the schedule until the Time cluster is written */
+    if (!s_time_valid)
+        zb_schedule_set_time(time_s);
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    return ESP_OK;
+}
+
+/* beacons come every few minutes on their own, they are no reason to poll fast for a while */
+static bool zb_sync_is_beacon(esp_zb_core_action_callback_id_t callback_id, const void *message)
+{
+    const esp_zb_zcl_custom_cluster_command_message_t *command = message;
+
+    return callback_id == ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID && command &&
+           command->info.cluster == ZCL_CLUSTER_ID_HALLOWEEN_LIGHT && command->info.command.id == ZCL_CMD_HALLOWEEN_LIGHT_SYNC;
+}
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+
+static void zb_joined(void)
+{
+    s_commissioning_retries = 0;
+    boot_timeline_mark(BOOT_MARK_JOINED);
+    boot_timeline_report();
+    zb_poll_activity();
+    zb_report_joined();
+    ota_update_confirm();
+}
+
 void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
 {
     uint32_t *p_sg_p       = signal_struct->p_app_signal;
@@ -47,18 +840,22 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         break;
     case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:
     case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:
+        boot_timeline_mark(BOOT_MARK_REBOOT_SIGNAL);
+        /* the schedule runs from the stored clock, joined or not */
+        zb_schedule_run();
         if (err_status == ESP_OK) {
-            ESP_LOGI(TAG, "Deferred driver initialization %s", deferred_driver_init() ? "failed" : "successful");
+            /* the driver is already up since app_main(), in the restored state */
             ESP_LOGI(TAG, "Device started up in %s factory-reset mode", esp_zb_bdb_is_factory_new() ? "" : "non");
             if (esp_zb_bdb_is_factory_new()) {
                 ESP_LOGI(TAG, "Start network steering");
                 esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
             } else {
                 ESP_LOGI(TAG, "Device rebooted");
+                zb_joined();
             }
         } else {
-            ESP_LOGW(TAG, "%s failed with status: %s, retrying", esp_zb_zdo_signal_to_string(sig_type), esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_INITIALIZATION, 1000);
+            ESP_LOGW(TAG, "%s failed with status: %s", esp_zb_zdo_signal_to_string(sig_type), esp_err_to_name(err_status));
+            zb_commissioning_retry(ESP_ZB_BDB_MODE_INITIALIZATION);
         }
         break;
     case ESP_ZB_BDB_SIGNAL_STEERING:
@@ -69,21 +866,25 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
                      extended_pan_id[7], extended_pan_id[6], extended_pan_id[5], extended_pan_id[4],
                      extended_pan_id[3], extended_pan_id[2], extended_pan_id[1], extended_pan_id[0],
                      esp_zb_get_pan_id(), esp_zb_get_current_channel(), esp_zb_get_short_address());
+            zb_joined();
         } else {
             ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_NETWORK_STEERING, 1000);
+            zb_commissioning_retry(ESP_ZB_BDB_MODE_NETWORK_STEERING);
         }
         break;
 #if CONFIG_HALLOWEEN_ENABLE_SLEEP
     case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
         //ESP_LOGI(TAG, "Zigbee can sleep");
-		//esp_zb_sleep_set_threshold(1000);
-        esp_zb_sleep_now();
+        zb_stats_refresh();
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+        zb_battery_sample();
+#endif
+        light_blog_idle();
+        zb_sleep();
         break;
 #endif //CONFIG_HALLOWEEN_ENABLE_SLEEP
     default:
-        ESP_LOGI(TAG, "ZDO signal: %s (0x%x), status: %s", esp_zb_zdo_signal_to_string(sig_type), sig_type,
-                 esp_err_to_name(err_status));
+        LIGHT_BLOG(TAG, ZDO_SIGNAL, sig_type, err_status);
         break;
     }
 }
@@ -92,46 +893,470 @@ static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t
 {
     esp_err_t ret = ESP_OK;
     bool light_state = 0;
+    uint8_t channel;
 
     ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
     ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "Received message: error status(%d)",
                         message->info.status);
 
-    ESP_LOGI(TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)", message->info.dst_endpoint, message->info.cluster, message->attribute.id, message->attribute.data.size);
-    if (message->info.dst_endpoint == HA_ESP_LIGHT_ENDPOINT) 
+    LIGHT_BLOG(TAG, ATTR_RECEIVED, message->info.dst_endpoint, message->info.cluster, message->attribute.id, message->attribute.data.size);
+    if (LIGHT_ENDPOINT_IS_CHANNEL(message->info.dst_endpoint)) 
     {
+        channel = LIGHT_ENDPOINT_CHANNEL(message->info.dst_endpoint);
+        light_trace_record(LIGHT_TRACE_DISPATCH, message->info.cluster);
         if (message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF) 
         {
-            if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL) 
+            if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL &&
+                message->attribute.data.value)
             {
-                light_state = message->attribute.data.value ? *(bool *)message->attribute.data.value : light_state;
-                ESP_LOGI(TAG, "Light sets to %s", light_state ? "On" : "Off");
-                light_driver_set_power(light_state);
+                light_state = *(bool *)message->attribute.data.value;
+                LIGHT_BLOG(TAG, LIGHT_POWER, light_state);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+                s_power_writes[channel]++;
+#endif
+                light_coalesce_power(channel, light_state);
+                zb_report_on_off(channel, light_state, false);
             }
         }
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
         else if (message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL)
         {
-            if (message->attribute.id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID)
+            if (message->attribute.id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8 &&
+                message->attribute.data.value)
             {
                 uint8_t value = *(uint8_t *)message->attribute.data.value;
-                ESP_LOGI(TAG, "Light level change to:%d", value);
-                light_driver_set_brightness(value);
+                LIGHT_BLOG(TAG, LIGHT_LEVEL, value);
+                s_level_writes[channel]++;
+                light_coalesce_level(channel, value);
+                zb_report_level(channel, value, false);
             }
             
         }
 #endif
+#if CONFIG_HALLOWEEN_BLINK_ENABLE || CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+        else if (message->info.cluster == ZCL_CLUSTER_ID_HALLOWEEN_LIGHT && channel == 0)
+        {
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+            if (message->attribute.id == ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM &&
+                message->attribute.data.value)
+            {
+                uint8_t effect = *(uint8_t *)message->attribute.data.value;
+                LIGHT_BLOG(TAG, LIGHT_EFFECT, effect);
+                ESP_RETURN_ON_FALSE(light_driver_set_effect(effect), ESP_ERR_INVALID_ARG, TAG, "Unknown effect %d", effect);
+                light_state_set_effect(effect);
+                zb_report_effect(effect, false);
+            }
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+            if (message->attribute.id == ZCL_ATTR_HALLOWEEN_LIGHT_RUNTIME_MIN_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16 &&
+                message->attribute.data.value)
+            {
+                zb_battery_set_runtime(*(uint16_t *)message->attribute.data.value);
+            }
+#endif //CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+        }
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE || CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+        else if ((message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_TIME || message->info.cluster == ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE) &&
+                 channel == 0)
+        {
+            ret = zb_schedule_attribute(message->info.cluster, &message->attribute);
+        }
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    }
+    return ret;
+}
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+static void zb_level_set_attributes(uint8_t channel, uint8_t level, bool with_on_off)
+{
+    s_level_target[channel] = level;
+    esp_zb_zcl_set_attribute_val(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                 ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &level, false);
+    light_state_set_level(channel, level);
+    zb_report_level(channel, level, true);
+    if (with_on_off && level <= LEVEL_TRANSITION_MIN_LEVEL) {
+        bool off = false;
+        esp_zb_zcl_set_attribute_val(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &off, false);
+        zb_light_set_power(channel, false);
+        zb_report_on_off(channel, false, true);
+    }
+}
+
+/* Runs on the light task once the hardware ramp has finished, or a Stop or switch-off has cut it short */
+static void zb_level_transition_done(uint8_t channel, uint8_t level, void *arg)
+{
+    uintptr_t tag = (uintptr_t)arg;
+
+    esp_zb_lock_acquire(portMAX_DELAY);
+    if ((uint8_t)(tag >> 16) == s_level_writes[channel])
+        zb_level_set_attributes(channel, level, (tag & 1) && (uint8_t)(tag >> 8) == s_power_writes[channel]);
+    esp_zb_lock_release();
+}
+
+/*
+ * Move, Step, Stop and MoveToLevel are registered as privilege commands, so
+ * they arrive here instead of being run by the stack as a stream of
+ * CurrentLevel updates. The whole transition becomes one LEDC fade and one
+ * attribute update at its end.
+ */
+static esp_err_t zb_level_command_handler(const esp_zb_zcl_privilege_command_message_t *message)
+{
+    level_transition_t transition;
+    uint8_t channel;
+
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    ESP_RETURN_ON_FALSE(LIGHT_ENDPOINT_IS_CHANNEL(message->info.dst_endpoint) &&
+                        message->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "Unexpected privilege command: endpoint(%d), cluster(0x%x)", message->info.dst_endpoint,
+                        message->info.cluster);
+    channel = LIGHT_ENDPOINT_CHANNEL(message->info.dst_endpoint);
+    light_trace_record(LIGHT_TRACE_DISPATCH, message->info.cluster);
+    /* writes still held back by the coalescing window are older than this command, and set where it starts */
+    light_coalesce_flush();
+    ESP_RETURN_ON_ERROR(level_transition_parse(message->info.command.id, message->data, message->size,
+                                               s_level_target[channel], &transition),
+                        TAG, "Invalid level command(0x%x)", message->info.command.id);
+
+    if (transition.stop) {
+        light_driver_stop_fade(channel, zb_level_transition_done, zb_transition_arg(channel, false));
+        return ESP_OK;
+    }
+    LIGHT_BLOG(TAG, LEVEL_COMMAND, message->info.command.id, transition.target, transition.time_ms);
+    if (transition.with_on_off && transition.target > LEVEL_TRANSITION_MIN_LEVEL) {
+        bool on = true;
+        esp_zb_zcl_set_attribute_val(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &on, false);
+        zb_light_set_power(channel, true);
+        zb_report_on_off(channel, true, true);
+    }
+    if (transition.time_ms == 0) {
+        s_level_writes[channel]++;
+        light_driver_set_brightness(channel, transition.target);
+        zb_level_set_attributes(channel, transition.target, transition.with_on_off);
+    } else {
+        s_level_target[channel] = transition.target;
+        light_driver_fade_brightness(channel, transition.target, transition.time_ms, zb_level_transition_done,
+                                     zb_transition_arg(channel, transition.with_on_off));
+    }
+    return ESP_OK;
+}
+
+static void zb_level_commands_register(void)
+{
+    static const uint8_t commands[] = {
+        LEVEL_CMD_MOVE_TO_LEVEL, LEVEL_CMD_MOVE, LEVEL_CMD_STEP, LEVEL_CMD_STOP,
+        LEVEL_CMD_MOVE_TO_LEVEL_WITH_ON_OFF, LEVEL_CMD_MOVE_WITH_ON_OFF, LEVEL_CMD_STEP_WITH_ON_OFF,
+        LEVEL_CMD_STOP_WITH_ON_OFF,
+    };
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        for (size_t i = 0; i < sizeof(commands); i++) {
+            ESP_ERROR_CHECK(esp_zb_zcl_add_privilege_command(LIGHT_CHANNEL_ENDPOINT(channel),
+                                                             ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, commands[i]));
+        }
+    }
+}
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+static scene_table_t s_scenes;
+
+/* The whole display as its attributes show it */
+static void zb_scene_snapshot(light_scene_t *scene)
+{
+    esp_zb_zcl_attr_t *attr;
+
+    *scene = (light_scene_t) { .effect = LIGHT_DRIVER_EFFECT_NONE };
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        attr = esp_zb_zcl_get_attribute(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID);
+        if (attr && *(bool *)attr->data_p)
+            scene->on |= 1 << channel;
+        scene->level[channel] = LIGHT_STATE_DEFAULT_LEVEL;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        attr = esp_zb_zcl_get_attribute(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID);
+        if (attr)
+            scene->level[channel] = *(uint8_t *)attr->data_p;
+#endif
+    }
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    attr = esp_zb_zcl_get_attribute(HA_ESP_LIGHT_ENDPOINT, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                    ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID);
+    if (attr)
+        scene->effect = *(uint8_t *)attr->data_p;
+#endif
+}
+
+/* Bring back @p scene with one driver command, then set and report the attributes as if each had been written */
+static void zb_scene_apply(const light_scene_t *scene, uint32_t time_ms)
+{
+    /* writes still held back by the coalescing window are older than the recall */
+    light_coalesce_flush();
+    light_driver_set_scene(scene, time_ms);
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        bool on = scene->on >> channel & 1;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        s_power_writes[channel]++;
+        s_level_writes[channel]++;
+#endif
+        esp_zb_zcl_set_attribute_val(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &on, false);
+        light_state_set_power(channel, on);
+        zb_report_on_off(channel, on, true);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        uint8_t level = scene->level[channel];
+        s_level_target[channel] = level;
+        esp_zb_zcl_set_attribute_val(LIGHT_CHANNEL_ENDPOINT(channel), ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                     ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &level, false);
+        light_state_set_level(channel, level);
+        zb_report_level(channel, level, true);
+#endif
+    }
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    uint8_t effect = scene->effect;
+    esp_zb_zcl_set_attribute_val(HA_ESP_LIGHT_ENDPOINT, ZCL_CLUSTER_ID_HALLOWEEN_LIGHT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, &effect, false);
+    light_state_set_effect(effect);
+    zb_report_effect(effect, true);
+#endif
+}
+
+/* The stack has stored the scene of this endpoint; endpoint 10 keeps the whole display next to it */
+static esp_err_t zb_scene_store_handler(const esp_zb_zcl_store_scene_message_t *message)
+{
+    light_scene_t scene;
+
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    if (message->info.dst_endpoint != HA_ESP_LIGHT_ENDPOINT)
+        return ESP_OK;
+    zb_scene_snapshot(&scene);
+    scene_table_put(&s_scenes, message->group_id, message->scene_id, &scene);
+    ESP_LOGI(TAG, "Stored scene %d of group 0x%04x", message->scene_id, message->group_id);
+    return scene_store_save(&s_scenes);
+}
+
+/*
+ * Whether the stack's scene entry still holds what the snapshot was taken
+ * with. The stack removes and adds scenes without telling the application, so
+ * an entry added again since differs from the snapshot. The entry only holds
+ * the On/Off and Level values of its own endpoint, so every field is checked
+ * against the string of that endpoint; the other strings of the snapshot have
+ * nothing to be checked against, StoreScene replaces them all.
+ */
+static bool zb_scene_matches(const light_scene_t *scene, uint8_t endpoint,
+                             const esp_zb_zcl_scenes_extension_field_t *field_set)
+{
+    uint8_t channel = LIGHT_ENDPOINT_CHANNEL(endpoint);
+
+    for (const esp_zb_zcl_scenes_extension_field_t *field = field_set; field; field = field->next) {
+        if (field->length < 1 || !field->extension_field_attribute_value_list)
+            continue;
+        uint8_t value = field->extension_field_attribute_value_list[0];
+        if (field->cluster_id == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF && value != (scene->on >> channel & 1))
+            return false;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        if (field->cluster_id == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL && value != scene->level[channel])
+            return false;
+#endif
+    }
+    return true;
+}
+
+/*
+ * RecallScene of endpoint 10 with a snapshot: every string and the effect in
+ * one driver command. Other endpoints, and scenes stored before this option
+ * or added with AddScene, keep the stack's per-endpoint recall.
+ */
+static esp_err_t zb_scene_recall_handler(const esp_zb_zcl_recall_scene_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    if (message->info.dst_endpoint != HA_ESP_LIGHT_ENDPOINT)
+        return ESP_OK;
+    light_trace_record(LIGHT_TRACE_DISPATCH, ESP_ZB_ZCL_CLUSTER_ID_SCENES);
+    const light_scene_t *scene = scene_table_find(&s_scenes, message->group_id, message->scene_id);
+    if (!scene)
+        return ESP_OK;
+
+    if (!zb_scene_matches(scene, message->info.dst_endpoint, message->field_set)) {
+        ESP_LOGW(TAG, "Scene %d of group 0x%04x changed, dropping its snapshot", message->scene_id, message->group_id);
+        scene_table_remove(&s_scenes, message->group_id, message->scene_id);
+        return scene_store_save(&s_scenes);
     }
+    /* the stack hands over the TransitionTime of the scene entry, in seconds as AddScene gives it */
+    zb_scene_apply(scene, message->transition_time * 1000);
+    return ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_SCENES_ENABLE
+
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+/*
+ * The OTA client downloads the image block by block, each one is written (or
+ * decoded) to the next app partition as it arrives. Every block is activity,
+ * so the light polls fast for the next one throughout the download.
+ */
+static esp_err_t zb_ota_upgrade_handler(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    if (message->info.status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        ota_update_abort();
+        return ESP_OK;
+    }
+    switch (message->upgrade_status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        ESP_LOGI(TAG, "OTA upgrade of version 0x%" PRIx32 " starts", message->ota_header.file_version);
+        ota_update_abort();
+        ret = ota_update_begin(message->ota_header.image_size);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        ret = ota_update_write(message->payload, message->payload_size);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        ESP_LOGI(TAG, "OTA upgrade received");
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        ret = ota_update_check();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        ret = ota_update_finish();
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "OTA upgrade done, restarting");
+            /* the restart must not lose a state change still waiting for its commit */
+            light_state_commit();
+            esp_restart();
+        }
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        ota_update_abort();
+        break;
+    default:
+        break;
+    }
+    if (ret != ESP_OK)
+        ota_update_abort();
     return ret;
 }
+#endif //CONFIG_HALLOWEEN_OTA_ENABLE
+
+#if CONFIG_HALLOWEEN_TRACE_ENABLE
+/* Trace commands of the statistics cluster: read the ring in chunks over the air, or print it on the console */
+static esp_err_t zb_trace_command_handler(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    /* octet string length, U32 first seq, U8 count, entries */
+    uint8_t payload[1 + 4 + 1 + TRACE_READ_ENTRIES_MAX * sizeof(light_trace_entry_t)];
+    uint32_t seq = 0;
+
+    switch (message->info.command.id) {
+    case ZCL_CMD_HALLOWEEN_STATS_TRACE_DUMP:
+        light_trace_dump();
+        return ESP_OK;
+    case ZCL_CMD_HALLOWEEN_STATS_TRACE_READ:
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (message->data.value && message->data.size >= sizeof(seq))
+        memcpy(&seq, message->data.value, sizeof(seq));
+
+    uint32_t first;
+    size_t count = light_trace_read(seq, (light_trace_entry_t *)&payload[6], TRACE_READ_ENTRIES_MAX, &first);
+    payload[0] = 4 + 1 + count * sizeof(light_trace_entry_t);
+    memcpy(&payload[1], &first, sizeof(first));
+    payload[5] = count;
+
+    esp_zb_zcl_custom_cluster_cmd_resp_t resp = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = message->info.src_address.u.short_addr,
+            .dst_endpoint = message->info.src_endpoint,
+            .src_endpoint = message->info.dst_endpoint,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = ZCL_CLUSTER_ID_HALLOWEEN_STATS,
+        .custom_cmd_id = ZCL_CMD_HALLOWEEN_STATS_TRACE_READ,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
+        .data = {
+            .type = ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+            .size = payload[0] + 1,
+            .value = payload,
+        },
+    };
+    esp_zb_zcl_custom_cluster_cmd_resp(&resp);
+    return ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE
+
+#if CONFIG_HALLOWEEN_TRACE_ENABLE || CONFIG_HALLOWEEN_SYNC_ENABLE
+static esp_err_t zb_custom_command_handler(const esp_zb_zcl_custom_cluster_command_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
+    switch (message->info.cluster) {
+#if CONFIG_HALLOWEEN_TRACE_ENABLE
+    case ZCL_CLUSTER_ID_HALLOWEEN_STATS:
+        return zb_trace_command_handler(message);
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    case ZCL_CLUSTER_ID_HALLOWEEN_LIGHT:
+        return zb_sync_command_handler(message);
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+    default:
+        ESP_LOGW(TAG, "Unexpected custom cluster(0x%x)", message->info.cluster);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE || CONFIG_HALLOWEEN_SYNC_ENABLE
+
+static void zb_coalesce_flush_cb(uint8_t param)
+{
+    light_coalesce_flush();
+}
+
+static void zb_coalesce_schedule(uint32_t delay_ms)
+{
+    esp_zb_scheduler_alarm(zb_coalesce_flush_cb, 0, delay_ms);
+}
 
 static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
 {
     esp_err_t ret = ESP_OK;
+    bool activity = true;
+
+    light_trace_record(LIGHT_TRACE_ACTION, callback_id);
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    activity = !zb_sync_is_beacon(callback_id, message);
+#endif
+    if (activity)
+        zb_poll_activity();
     switch (callback_id) {
     case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
         ret = zb_attribute_handler((esp_zb_zcl_set_attr_value_message_t *)message);
         break;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    case ESP_ZB_CORE_CMD_PRIVILEGE_COMMAND_REQ_CB_ID:
+        ret = zb_level_command_handler((esp_zb_zcl_privilege_command_message_t *)message);
+        break;
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+    case ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID:
+        ret = zb_scene_store_handler((esp_zb_zcl_store_scene_message_t *)message);
+        break;
+    case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+        ret = zb_scene_recall_handler((esp_zb_zcl_recall_scene_message_t *)message);
+        break;
+#endif //CONFIG_HALLOWEEN_SCENES_ENABLE
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+    case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+        ret = zb_ota_upgrade_handler((esp_zb_zcl_ota_upgrade_value_message_t *)message);
+        break;
+#endif //CONFIG_HALLOWEEN_OTA_ENABLE
+#if CONFIG_HALLOWEEN_TRACE_ENABLE || CONFIG_HALLOWEEN_SYNC_ENABLE
+    case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID:
+        ret = zb_custom_command_handler((esp_zb_zcl_custom_cluster_command_message_t *)message);
+        break;
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE || CONFIG_HALLOWEEN_SYNC_ENABLE
     default:
         ESP_LOGW(TAG, "Receive Zigbee action(0x%x) callback", callback_id);
         break;
@@ -167,50 +1392,124 @@ static void esp_zb_task(void *pvParameters)
     esp_zb_sleep_enable(true);
 #endif //CONFIG_HALLOWEEN_ENABLE_SLEEP
     esp_zb_init(&zb_nwk_cfg);
+#if CONFIG_HALLOWEEN_SLEEP_GOVERNOR
+    const sleep_governor_config_t sleep_gov_cfg = SLEEP_GOVERNOR_CONFIG_DEFAULT();
+    sleep_governor_init(&s_sleep_gov, &sleep_gov_cfg);
+    esp_zb_sleep_set_threshold(s_sleep_gov.threshold_ms);
+#endif
     /* Maximum TX power */
     esp_zb_set_tx_power(IEEE802154_TXPOWER_VALUE_MAX);
+    zcl_basic_manufacturer_info_t info = {
+        .manufacturer_name = ESP_MANUFACTURER_NAME,
+        .model_identifier = ESP_MODEL_IDENTIFIER,
+    };
+    /* one light endpoint per LED channel */
+    esp_zb_ep_list_t *esp_zb_on_off_light_ep = esp_zb_ep_list_create();
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        esp_zb_endpoint_config_t ep_cfg = {
+            .endpoint = LIGHT_CHANNEL_ENDPOINT(channel),
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_version = 0,
+        };
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
-	/* set the dimmable light device config */
-    esp_zb_color_dimmable_light_cfg_t light_cfg = ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG();
+        /* set the dimmable light device config */
+        esp_zb_color_dimmable_light_cfg_t light_cfg = ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG();
 #if CONFIG_HALLOWEEN_BATTERY_DEVICE
-    light_cfg.basic_cfg.power_source = 0x03; //Battery
+        light_cfg.basic_cfg.power_source = 0x03; //Battery
 #endif
-	light_cfg.on_off_cfg.on_off = LIGHT_DEFAULT_ON;
-	light_cfg.level_cfg.current_level = LIGHT_DEFAULT_BRIGHTNESS;
-    esp_zb_ep_list_t *esp_zb_on_off_light_ep = esp_zb_color_dimmable_light_ep_create(HA_ESP_LIGHT_ENDPOINT, &light_cfg);
+        light_cfg.on_off_cfg.on_off = s_light_state.on[channel];
+        light_cfg.level_cfg.current_level = s_light_state.level[channel];
+        ep_cfg.app_device_id = ESP_ZB_HA_COLOR_DIMMABLE_LIGHT_DEVICE_ID;
+        esp_zb_ep_list_add_ep(esp_zb_on_off_light_ep, esp_zb_color_dimmable_light_clusters_create(&light_cfg), ep_cfg);
 #else
-	/* set the on-off light device config */
-    esp_zb_on_off_light_cfg_t light_cfg = ESP_ZB_DEFAULT_ON_OFF_LIGHT_CONFIG();
-	light_cfg.on_off_cfg.on_off = LIGHT_DEFAULT_ON;
-    esp_zb_ep_list_t *esp_zb_on_off_light_ep = esp_zb_on_off_light_ep_create(HA_ESP_LIGHT_ENDPOINT, &light_cfg);
+        /* set the on-off light device config */
+        esp_zb_on_off_light_cfg_t light_cfg = ESP_ZB_DEFAULT_ON_OFF_LIGHT_CONFIG();
+        light_cfg.on_off_cfg.on_off = s_light_state.on[channel];
+        ep_cfg.app_device_id = ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID;
+        esp_zb_ep_list_add_ep(esp_zb_on_off_light_ep, esp_zb_on_off_light_clusters_create(&light_cfg), ep_cfg);
 #endif
-    zcl_basic_manufacturer_info_t info = {
-        .manufacturer_name = ESP_MANUFACTURER_NAME,
-        .model_identifier = ESP_MODEL_IDENTIFIER,
+        esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_on_off_light_ep, LIGHT_CHANNEL_ENDPOINT(channel), &info);
+    }
+    esp_zcl_utility_add_ep_stats_cluster(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT);
+#if CONFIG_HALLOWEEN_BLINK_ENABLE || CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    esp_zcl_utility_add_ep_light_cluster(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT, s_light_state.effect,
+                                         CONFIG_HALLOWEEN_BATTERY_RUNTIME_MIN);
+#else
+    esp_zcl_utility_add_ep_light_cluster(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT, s_light_state.effect, 0);
+#endif
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE || CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+#if CONFIG_HALLOWEEN_BATTERY_MONITOR
+    esp_zcl_utility_add_ep_power_config_cluster(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT);
+    zb_battery_init();
+#endif //CONFIG_HALLOWEEN_BATTERY_MONITOR
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+    schedule_store_load(&s_schedule);
+    esp_zcl_utility_add_ep_schedule_clusters(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT, &s_schedule);
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+    scene_store_load(&s_scenes);
+#endif //CONFIG_HALLOWEEN_SCENES_ENABLE
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+    const esp_zb_ota_cluster_cfg_t ota_cfg = {
+        .ota_upgrade_file_version = CONFIG_HALLOWEEN_OTA_FILE_VERSION,
+        .ota_upgrade_downloaded_file_ver = 0xffffffff,     /* none yet */
+        .ota_upgrade_manufacturer = CONFIG_HALLOWEEN_OTA_MANUFACTURER,
+        .ota_upgrade_image_type = CONFIG_HALLOWEEN_OTA_IMAGE_TYPE,
     };
-
-    esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT, &info);
+    const esp_zb_zcl_ota_upgrade_client_variable_t ota_client = {
+        .timer_query = CONFIG_HALLOWEEN_OTA_QUERY_MIN,
+        .hw_version = OTA_UPGRADE_HW_VERSION,
+        .max_data_size = OTA_UPGRADE_MAX_DATA_SIZE,
+    };
+    esp_zcl_utility_add_ep_ota_cluster(esp_zb_on_off_light_ep, HA_ESP_LIGHT_ENDPOINT, &ota_cfg, &ota_client);
+#endif //CONFIG_HALLOWEEN_OTA_ENABLE
     esp_zb_device_register(esp_zb_on_off_light_ep);
+    zb_report_init();
     esp_zb_core_action_handler_register(zb_action_handler);
+    const light_coalesce_ops_t coalesce_ops = {
+        .set_power = zb_light_set_power,
+        .set_level = zb_light_set_level,
+        .schedule = zb_coalesce_schedule,
+        .now_us = esp_timer_get_time,
+    };
+    ESP_ERROR_CHECK(light_coalesce_init(&coalesce_ops, CONFIG_HALLOWEEN_COALESCE_WINDOW_MS));
+    poll_scheduler_init(&s_poll, CONFIG_HALLOWEEN_POLL_FAST_MS, CONFIG_HALLOWEEN_POLL_IDLE_MS,
+                        CONFIG_HALLOWEEN_POLL_FAST_WINDOW_MS, POLL_BACKOFF_POLLS_PER_STEP);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    zb_level_commands_register();
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
     esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
+    boot_timeline_mark(BOOT_MARK_ZB_START);
     ESP_ERROR_CHECK(esp_zb_start(false));
     esp_zb_stack_main_loop();
 }
 
 void app_main(void)
 {
-	light_driver_init(LIGHT_DEFAULT_ON);
+    boot_timeline_init();
     esp_zb_platform_config_t config = {
         .radio_config = ESP_ZB_DEFAULT_RADIO_CONFIG(),
         .host_config = ESP_ZB_DEFAULT_HOST_CONFIG(),
     };
     ESP_ERROR_CHECK(nvs_flash_init());
+    /* come up in the state the user left the light in, before the stack even starts */
+    light_state_load(&s_light_state);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    memcpy(s_level_target, s_light_state.level, sizeof(s_level_target));
+#endif
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    light_driver_set_clock(zb_sync_clock);
+#endif
+	light_driver_init(s_light_state.on, s_light_state.level, s_light_state.effect);
+    boot_timeline_mark(BOOT_MARK_FIRST_LIGHT);
 #if CONFIG_HALLOWEEN_ENABLE_SLEEP
     /* esp zigbee light sleep initialization*/
     ESP_ERROR_CHECK(esp_zb_power_save_init());
 #endif //CONFIG_HALLOWEEN_ENABLE_SLEEP
     /* load Zigbee platform config to initialization */
     ESP_ERROR_CHECK(esp_zb_platform_config(&config));
+    boot_timeline_mark(BOOT_MARK_PLATFORM_CONFIG);
 	
     xTaskCreate(esp_zb_task, "Zigbee_main", 4096, NULL, 5, NULL);
 }
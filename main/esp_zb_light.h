@@ -16,6 +16,20 @@
 #define ED_KEEP_ALIVE                   3000                                 /* 3000 millisecond */
 #endif
 #define HA_ESP_LIGHT_ENDPOINT           10                                   /* esp light bulb device endpoint, used to process light controlling commands */
+#define LIGHT_CHANNEL_ENDPOINT(ch)      (HA_ESP_LIGHT_ENDPOINT + (ch))       /* endpoint of LED channel ch, the first one also carries the statistics */
+#define LIGHT_ENDPOINT_CHANNEL(ep)      ((uint8_t)((ep) - HA_ESP_LIGHT_ENDPOINT))
+#define LIGHT_ENDPOINT_IS_CHANNEL(ep)   ((ep) >= HA_ESP_LIGHT_ENDPOINT && (ep) < HA_ESP_LIGHT_ENDPOINT + LIGHT_CHANNELS)
+#define STATS_REFRESH_INTERVAL_US       (10 * 1000000LL)                     /* how often the statistics cluster is refreshed */
+#define TRACE_READ_ENTRIES_MAX          8                                    /* trace entries per TraceRead response */
+#define COMMISSIONING_RETRY_MIN_MS      100                                  /* first commissioning retry, doubled on each failure */
+#define COMMISSIONING_RETRY_MAX_MS      30000                                /* longest commissioning retry interval */
+#define POLL_BACKOFF_POLLS_PER_STEP     4                                    /* polls at each interval while backing off to idle */
+#define SCHEDULE_RECHECK_S              3600                                 /* longest schedule alarm, the clock is looked at again after it */
+#define SCHEDULE_CATCH_UP_S             3600                                 /* entries missed by up to this much still run, e.g. during a rejoin */
+#define SCHEDULE_DEEP_SLEEP_DELAY_MS    5000                                 /* after an entry, time for its reports before deep sleep */
+#define SCHEDULE_DEEP_SLEEP_EARLY_S     30                                   /* wake from deep sleep this much before the next entry */
+#define OTA_UPGRADE_MAX_DATA_SIZE       64                                   /* OTA block, the most an unfragmented secured frame has room for */
+#define OTA_UPGRADE_HW_VERSION          0x0101                               /* hardware version the OTA client reports */
 #define ESP_ZB_PRIMARY_CHANNEL_MASK     ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK /* Zigbee primary channel mask use in the example */
 
 /* Basic manufacturer information */
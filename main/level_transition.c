@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "level_transition.h"
+
+#define MOVE_MODE_UP    0x00
+#define MOVE_MODE_DOWN  0x01
+#define TRANSITION_TIME_DEFAULT 0xffff
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* Transition time is given in tenths of a second; 0xffff means "use OnOffTransitionTime" (0 here) */
+static uint32_t transition_ms(uint16_t tenths)
+{
+    return tenths == TRANSITION_TIME_DEFAULT ? 0 : tenths * 100u;
+}
+
+static uint8_t clamp_level(int level)
+{
+    if (level < LEVEL_TRANSITION_MIN_LEVEL) {
+        return LEVEL_TRANSITION_MIN_LEVEL;
+    }
+    if (level > LEVEL_TRANSITION_MAX_LEVEL) {
+        return LEVEL_TRANSITION_MAX_LEVEL;
+    }
+    return (uint8_t)level;
+}
+
+esp_err_t level_transition_parse(uint8_t cmd_id, const uint8_t *payload, size_t size, uint8_t current,
+                                 level_transition_t *out)
+{
+    if (!out || (size && !payload)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = (level_transition_t) {
+        .target = current,
+        .with_on_off = cmd_id >= LEVEL_CMD_MOVE_TO_LEVEL_WITH_ON_OFF,
+    };
+
+    switch (cmd_id) {
+    case LEVEL_CMD_MOVE_TO_LEVEL:
+    case LEVEL_CMD_MOVE_TO_LEVEL_WITH_ON_OFF:
+        if (size < 3) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        out->target = payload[0] > LEVEL_TRANSITION_MAX_LEVEL ? LEVEL_TRANSITION_MAX_LEVEL : payload[0];
+        out->time_ms = transition_ms(get_u16(&payload[1]));
+        break;
+    case LEVEL_CMD_MOVE:
+    case LEVEL_CMD_MOVE_WITH_ON_OFF: {
+        if (size < 2) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        uint8_t rate = payload[1] == 0xff ? LEVEL_TRANSITION_DEFAULT_RATE : payload[1];
+        if (rate == 0) {
+            break;  /* a zero rate has no effect */
+        }
+        out->target = payload[0] == MOVE_MODE_DOWN ? LEVEL_TRANSITION_MIN_LEVEL : LEVEL_TRANSITION_MAX_LEVEL;
+        int distance = out->target > current ? out->target - current : current - out->target;
+        out->time_ms = (uint32_t)distance * 1000u / rate;
+        break;
+    }
+    case LEVEL_CMD_STEP:
+    case LEVEL_CMD_STEP_WITH_ON_OFF:
+        if (size < 4) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        out->target = clamp_level(payload[0] == MOVE_MODE_DOWN ? current - payload[1] : current + payload[1]);
+        out->time_ms = transition_ms(get_u16(&payload[2]));
+        break;
+    case LEVEL_CMD_STOP:
+    case LEVEL_CMD_STOP_WITH_ON_OFF:
+        out->stop = true;
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Level Control cluster command IDs (ZCL 3.10.2.3) */
+#define LEVEL_CMD_MOVE_TO_LEVEL             0x00
+#define LEVEL_CMD_MOVE                      0x01
+#define LEVEL_CMD_STEP                      0x02
+#define LEVEL_CMD_STOP                      0x03
+#define LEVEL_CMD_MOVE_TO_LEVEL_WITH_ON_OFF 0x04
+#define LEVEL_CMD_MOVE_WITH_ON_OFF          0x05
+#define LEVEL_CMD_STEP_WITH_ON_OFF          0x06
+#define LEVEL_CMD_STOP_WITH_ON_OFF          0x07
+
+#define LEVEL_TRANSITION_MIN_LEVEL          1
+#define LEVEL_TRANSITION_MAX_LEVEL          254
+/** rate used when a Move command asks for the default (0xff), in levels per second */
+#define LEVEL_TRANSITION_DEFAULT_RATE       100
+
+/** what a Level Control command asks the light to do */
+typedef struct {
+    uint8_t target;     /* level at the end of the transition */
+    uint32_t time_ms;   /* transition time, 0 for an immediate change */
+    bool stop;          /* Stop: freeze the running transition */
+    bool with_on_off;   /* *WithOnOff variant: also drive the On/Off attribute */
+} level_transition_t;
+
+/**
+ * @brief Decode a Level Control command.
+ *
+ * @param[in]  cmd_id  Command identifier (LEVEL_CMD_*)
+ * @param[in]  payload Command payload
+ * @param[in]  size    Payload size
+ * @param[in]  current Current level, the origin of Move and Step
+ * @param[out] out     Decoded transition
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_SIZE: Payload too short
+ *      - ESP_ERR_NOT_SUPPORTED: Unknown command
+ */
+esp_err_t level_transition_parse(uint8_t cmd_id, const uint8_t *payload, size_t size, uint8_t current,
+                                 level_transition_t *out);
+
+#ifdef __cplusplus
+}
+#endif
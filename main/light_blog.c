@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <stdio.h>
+#include "esp_log.h"
+#include "light_blog.h"
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+#include "driver/usb_serial_jtag.h"
+#endif
+
+#if CONFIG_HALLOWEEN_BINARY_LOG
+#define BLOG_RECORDS            CONFIG_HALLOWEEN_BINARY_LOG_RECORDS
+#define BLOG_RECORDS_PER_LINE   8
+
+/* on the wire: U32 timestamp (ms), U8 id, U8 nargs, nargs x U32, little endian */
+typedef struct {
+    uint32_t time_ms;
+    uint8_t id;
+    uint8_t nargs;
+    uint32_t args[LIGHT_BLOG_ARGS_MAX];
+} blog_record_t;
+
+static blog_record_t s_ring[BLOG_RECORDS];
+static size_t s_head;
+static size_t s_count;
+
+static void blog_put_hex(uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        printf("%02x", (unsigned)(value >> (8 * i)) & 0xff);
+    }
+}
+
+void light_blog_flush(void)
+{
+    size_t tail = (s_head + BLOG_RECORDS - s_count) % BLOG_RECORDS;
+
+    for (size_t n = 0; n < s_count; n++) {
+        const blog_record_t *r = &s_ring[(tail + n) % BLOG_RECORDS];
+        if (n % BLOG_RECORDS_PER_LINE == 0) {
+            printf("BLOG:");
+        }
+        blog_put_hex(r->time_ms, 4);
+        blog_put_hex(r->id, 1);
+        blog_put_hex(r->nargs, 1);
+        for (int a = 0; a < r->nargs; a++) {
+            blog_put_hex(r->args[a], 4);
+        }
+        if (n % BLOG_RECORDS_PER_LINE == BLOG_RECORDS_PER_LINE - 1 || n == s_count - 1) {
+            printf("\n");
+        }
+    }
+    s_count = 0;
+}
+
+void light_blog_write(const char *tag, light_blog_id_t id, size_t nargs, const uint32_t *args)
+{
+    blog_record_t *r = &s_ring[s_head];
+
+    r->time_ms = esp_log_timestamp();
+    r->id = id;
+    r->nargs = nargs;
+    for (size_t a = 0; a < nargs; a++) {
+        r->args[a] = args[a];
+    }
+    s_head = (s_head + 1) % BLOG_RECORDS;
+    if (++s_count == BLOG_RECORDS) {
+        light_blog_flush();
+    }
+}
+
+void light_blog_idle(void)
+{
+    if (s_count == 0) {
+        return;
+    }
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    if (usb_serial_jtag_is_connected()) {
+        light_blog_flush();
+    }
+#endif
+}
+#else
+static const char *const s_formats[LIGHT_BLOG_MAX] = {
+#define LIGHT_BLOG_FORMAT(id, fmt) [LIGHT_BLOG_##id] = fmt,
+    LIGHT_BLOG_FORMATS(LIGHT_BLOG_FORMAT)
+#undef LIGHT_BLOG_FORMAT
+};
+
+void light_blog_write(const char *tag, light_blog_id_t id, size_t nargs, const uint32_t *args)
+{
+    char text[128];
+    uint32_t a[LIGHT_BLOG_ARGS_MAX] = { 0 };
+
+    for (size_t i = 0; i < nargs; i++) {
+        a[i] = args[i];
+    }
+    snprintf(text, sizeof(text), s_formats[id], a[0], a[1], a[2], a[3]);
+    ESP_LOGI(tag, "%s", text);
+}
+
+void light_blog_idle(void)
+{
+}
+
+void light_blog_flush(void)
+{
+}
+#endif //CONFIG_HALLOWEEN_BINARY_LOG
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hot path log messages: X(id, format). The format takes up to
+ * LIGHT_BLOG_ARGS_MAX integer arguments (%d, %u, %x, ...) and no strings.
+ * tools/blog_decode.py reads this list, so only append new entries at the
+ * end to keep old dumps decodable.
+ */
+#define LIGHT_BLOG_FORMATS(X) \
+    X(ATTR_RECEIVED,    "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)") \
+    X(LIGHT_POWER,      "Light sets to %d") \
+    X(LIGHT_LEVEL,      "Light level change to:%d") \
+    X(LEVEL_COMMAND,    "Level command(0x%x): to %d in %u ms") \
+    X(ZDO_SIGNAL,       "ZDO signal: 0x%x, status: %d") \
+    X(SLEEP_SAMPLE,     "Sleep gap %u us, awake %u us") \
+    X(LIGHT_EFFECT,     "Light effect change to:%d") \
+    X(REPORT_SENT,      "Reports sent, attributes:0x%x") \
+    X(BATTERY_SAMPLE,   "Battery %u mV, %u %%, level cap %u") \
+    X(SCHEDULE_RUN,     "Schedule entries 0x%x at %u")
+
+typedef enum {
+#define LIGHT_BLOG_ENUM(id, fmt) LIGHT_BLOG_##id,
+    LIGHT_BLOG_FORMATS(LIGHT_BLOG_ENUM)
+#undef LIGHT_BLOG_ENUM
+    LIGHT_BLOG_MAX,
+} light_blog_id_t;
+
+#define LIGHT_BLOG_ARGS_MAX 4
+
+#define LIGHT_BLOG_NARGS_(a, b, c, d, n, ...) n
+#define LIGHT_BLOG_NARGS(...) LIGHT_BLOG_NARGS_(__VA_ARGS__, 4, 3, 2, 1, 0)
+
+/**
+ * @brief Log message @p id of LIGHT_BLOG_FORMATS with 1 to 4 integer arguments.
+ *
+ * With CONFIG_HALLOWEEN_BINARY_LOG the message id and raw arguments go into a
+ * RAM ring and no text is formatted; otherwise this is an ESP_LOGI.
+ * Call from the Zigbee task only.
+ */
+#define LIGHT_BLOG(tag, id, ...) \
+    light_blog_write(tag, LIGHT_BLOG_##id, LIGHT_BLOG_NARGS(__VA_ARGS__), (const uint32_t[]) { __VA_ARGS__ })
+
+void light_blog_write(const char *tag, light_blog_id_t id, size_t nargs, const uint32_t *args);
+
+/**
+ * @brief Flush the ring if a console is attached. Call when about to sleep.
+ *
+ * Without a console the ring is only flushed when it fills up.
+ */
+void light_blog_idle(void);
+
+/**
+ * @brief Print all buffered records as "BLOG:<hex>" lines, decoded by tools/blog_decode.py.
+ */
+void light_blog_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "light_cmd.h"
+
+#define LIGHT_CMD_MASK  (LIGHT_CMD_QUEUE_LEN - 1)
+
+void light_cmd_queue_init(light_cmd_queue_t *queue)
+{
+    for (uint32_t i = 0; i < LIGHT_CMD_QUEUE_LEN; i++)
+        __atomic_store_n(&queue->slots[i].seq, i, __ATOMIC_RELAXED);
+    queue->tail = 0;
+    __atomic_store_n(&queue->head, 0, __ATOMIC_RELEASE);
+}
+
+bool light_cmd_post(light_cmd_queue_t *queue, const light_cmd_t *cmd)
+{
+    uint32_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    light_cmd_slot_t *slot;
+
+    for (;;) {
+        slot = &queue->slots[pos & LIGHT_CMD_MASK];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            /* the slot is free for this position: claim it, or retry with the head another producer moved */
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            /* still holds the command of the previous round */
+            return false;
+        } else {
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+    slot->cmd = *cmd;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool light_cmd_take(light_cmd_queue_t *queue, light_cmd_t *cmd)
+{
+    uint32_t pos = queue->tail;
+    light_cmd_slot_t *slot = &queue->slots[pos & LIGHT_CMD_MASK];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1)
+        return false;
+    *cmd = slot->cmd;
+    /* free the slot for the producers of the next round */
+    __atomic_store_n(&slot->seq, pos + LIGHT_CMD_QUEUE_LEN, __ATOMIC_RELEASE);
+    queue->tail = pos + 1;
+    return true;
+}
+
+/* effects only play on channel 0 */
+static uint8_t light_cmd_channel(const light_cmd_t *cmd)
+{
+    return cmd->type == LIGHT_CMD_EFFECT ? 0 : cmd->channel;
+}
+
+bool light_cmd_superseded(const light_cmd_t *batch, size_t count, size_t index)
+{
+    const light_cmd_t *cmd = &batch[index];
+
+    if (cmd->type != LIGHT_CMD_POWER && cmd->type != LIGHT_CMD_LEVEL && cmd->type != LIGHT_CMD_SCENE)
+        return false;
+    for (size_t i = index + 1; i < count; i++) {
+        if (batch[i].type == LIGHT_CMD_SCENE)
+            return true;
+        if (cmd->type != LIGHT_CMD_SCENE && light_cmd_channel(&batch[i]) == cmd->channel)
+            return batch[i].type == cmd->type;
+    }
+    return false;
+}
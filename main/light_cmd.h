@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Commands for the light driver task. Any task posts them into a bounded
+ * lock-free ring (sequence-numbered slots, many producers, one consumer)
+ * and the driver task takes them out in order. Producers never block: a
+ * full queue rejects the command.
+ */
+
+/** queue length, a power of two */
+#define LIGHT_CMD_QUEUE_LEN     32
+/** channels a scene command carries, the most CONFIG_HALLOWEEN_LED_CHANNELS allows */
+#define LIGHT_CMD_CHANNELS_MAX  6
+
+typedef enum {
+    LIGHT_CMD_POWER,        /* value: on/off */
+    LIGHT_CMD_LEVEL,        /* value: brightness */
+    LIGHT_CMD_FADE,         /* value: target brightness, reached after time_ms, then done */
+    LIGHT_CMD_STOP_FADE,    /* freeze a ramp, done gets the level it reached */
+    LIGHT_CMD_EFFECT,       /* value: effect of channel 0 */
+    LIGHT_CMD_LEVEL_CAP,    /* value: highest level any channel shows */
+    LIGHT_CMD_SCENE,        /* scene.on_mask: on bit per channel, scene.level: of every channel, value: effect, ramp of time_ms */
+} light_cmd_type_t;
+
+/** completion callback of a fade or stop command, runs on the driver task */
+typedef void (*light_cmd_done_t)(uint8_t channel, uint8_t level, void *arg);
+
+typedef struct {
+    uint8_t type;           /* light_cmd_type_t */
+    uint8_t channel;
+    uint8_t value;
+    uint32_t time_ms;
+    union {
+        struct {
+            light_cmd_done_t done;
+            void *arg;
+        };
+        struct {
+            uint8_t on_mask;                    /* bit n: channel n on */
+            uint8_t level[LIGHT_CMD_CHANNELS_MAX];
+        } scene;                                /* LIGHT_CMD_SCENE, fits in place of the callback */
+    };
+} light_cmd_t;
+
+typedef struct {
+    uint32_t seq;           /* position the slot is ready for: pos when free, pos + 1 when filled */
+    light_cmd_t cmd;
+} light_cmd_slot_t;
+
+typedef struct {
+    uint32_t head;          /* next position to claim, shared by the producers */
+    uint32_t tail;          /* next position to take, consumer only */
+    light_cmd_slot_t slots[LIGHT_CMD_QUEUE_LEN];
+} light_cmd_queue_t;
+
+/**
+ * @brief Empty the queue. Call before any producer or the consumer uses it.
+ */
+void light_cmd_queue_init(light_cmd_queue_t *queue);
+
+/**
+ * @brief Post a command (any task).
+ *
+ * @return false when the queue is full; the command is not queued then
+ */
+bool light_cmd_post(light_cmd_queue_t *queue, const light_cmd_t *cmd);
+
+/**
+ * @brief Take the oldest command (consumer only).
+ *
+ * A command whose producer has claimed its slot but not finished writing it
+ * ends the take; that producer wakes the consumer again once it is done.
+ *
+ * @return false when there is no complete command
+ */
+bool light_cmd_take(light_cmd_queue_t *queue, light_cmd_t *cmd);
+
+/**
+ * @brief Whether batch[index] can be skipped because the next command for the same
+ *        channel is a power or level command of the same kind, which overrides it,
+ *        or a later scene command sets every channel anyway.
+ */
+bool light_cmd_superseded(const light_cmd_t *batch, size_t count, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "light_coalesce.h"
+
+static light_coalesce_ops_t s_ops;
+static int64_t s_window_us;
+static int64_t s_window_end_us;     /* writes before this are held back */
+static bool s_scheduled;
+
+typedef struct {
+    bool power_pending;
+    bool power;
+    bool level_pending;
+    uint8_t level;
+} coalesce_channel_t;
+
+static coalesce_channel_t s_channels[LIGHT_CHANNELS];
+
+static void coalesce_write(void)
+{
+    int64_t now = s_ops.now_us();
+
+    if (now >= s_window_end_us) {
+        light_coalesce_flush();
+    } else if (!s_scheduled) {
+        s_scheduled = true;
+        s_ops.schedule((uint32_t)((s_window_end_us - now + 999) / 1000));
+    }
+}
+
+esp_err_t light_coalesce_init(const light_coalesce_ops_t *ops, uint32_t window_ms)
+{
+    if (!ops || !ops->set_power || !ops->set_level || !ops->schedule || !ops->now_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ops = *ops;
+    s_window_us = window_ms * 1000LL;
+    s_window_end_us = 0;
+    s_scheduled = false;
+    for (int i = 0; i < LIGHT_CHANNELS; i++) {
+        s_channels[i].power_pending = false;
+        s_channels[i].level_pending = false;
+    }
+    return ESP_OK;
+}
+
+void light_coalesce_power(uint8_t channel, bool on)
+{
+    if (channel >= LIGHT_CHANNELS) {
+        return;
+    }
+    s_channels[channel].power = on;
+    s_channels[channel].power_pending = true;
+    coalesce_write();
+}
+
+void light_coalesce_level(uint8_t channel, uint8_t level)
+{
+    if (channel >= LIGHT_CHANNELS) {
+        return;
+    }
+    s_channels[channel].level = level;
+    s_channels[channel].level_pending = true;
+    coalesce_write();
+}
+
+void light_coalesce_flush(void)
+{
+    bool applied = false;
+
+    s_scheduled = false;
+    for (uint8_t i = 0; i < LIGHT_CHANNELS; i++) {
+        coalesce_channel_t *ch = &s_channels[i];
+        if (ch->power_pending) {
+            ch->power_pending = false;
+            applied = true;
+            s_ops.set_power(i, ch->power);
+        }
+        if (ch->level_pending) {
+            ch->level_pending = false;
+            applied = true;
+            s_ops.set_level(i, ch->level);
+        }
+    }
+    if (applied) {
+        s_window_end_us = s_ops.now_us() + s_window_us;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "light_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** where coalesced writes end up, and how the trailing flush is scheduled */
+typedef struct {
+    void (*set_power)(uint8_t channel, bool on);
+    void (*set_level)(uint8_t channel, uint8_t level);
+    void (*schedule)(uint32_t delay_ms);    /* call light_coalesce_flush() in delay_ms, in the caller's context */
+    int64_t (*now_us)(void);
+} light_coalesce_ops_t;
+
+/**
+ * @brief Set up the coalescing stage between the attribute handler and the driver.
+ *
+ * The first write after a quiet period is applied at once and opens a
+ * window of @p window_ms. Writes inside the window only replace the pending
+ * target of their attribute; at the end of the window the latest targets
+ * are applied, On/Off before level, and a new window opens. The window is
+ * shared by all LIGHT_CHANNELS channels, so a scene touching every string
+ * still costs one flush.
+ */
+esp_err_t light_coalesce_init(const light_coalesce_ops_t *ops, uint32_t window_ms);
+
+/** @brief Write the On/Off target of @p channel. */
+void light_coalesce_power(uint8_t channel, bool on);
+
+/** @brief Write the level target of @p channel. */
+void light_coalesce_level(uint8_t channel, uint8_t level);
+
+/**
+ * @brief Apply the pending targets now.
+ *
+ * Called from light_coalesce_ops_t::schedule, and before anything that
+ * drives the light directly so that it is not overridden by an older write.
+ */
+void light_coalesce_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,39 +3,109 @@
  *
  */
 
+#include <string.h>
 #include "esp_log.h"
 #include "light_driver.h"
-#include <driver/rtc_io.h>
-#include "esp_sleep.h"
-#include "driver/ledc.h"
+#include "light_hal.h"
+#include "light_cmd.h"
+#include "effect_program.h"
 #if CONFIG_HALLOWEEN_BLINK_ENABLE
-#include "esp_timer.h"
+#include "light_effect.h"
+#include "effect_gen.h"
+#endif
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+#include "light_brightness_lut.h"
+#endif
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+#include "audio_player.h"
 #endif
 
 #define MM_LED_GPIO		4
-#define MM_LED_LEDC_CH 	1
+#define MM_LED_LEDC_TIMER	1
 
 #define MM_AUDIO_GPIO	 5
 #define MM_AUDIO_LEDC_CH 2
+#define MM_AUDIO_LEDC_TIMER 2
+#define MM_AUDIO_FREQ	 80
 
 #define BLINK_TIME_ON_MS   1100
 #define BLINK_TIME_OFF_MS  800
 
+/* one LED string */
+typedef struct {
+    int gpio;
+    uint8_t ledc_ch;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    bool started;                       /* PWM output running */
+    bool powered;                       /* switched on, levels set while off wait for it */
+    uint8_t brightness_last;
+    bool fade_active;
+    light_driver_fade_cb_t fade_done;
+    void *fade_arg;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+    uint8_t dither_level;               /* level being dithered, 0 when not dithering */
+#endif
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+} mm_channel_t;
+
+/*
+ * The LED strings take LEDC channels 1, 0, 3, 4, 5 first. Channel 2 also drives
+ * the audio output, so only a sixth string uses it and 6 strings exclude audio
+ * (the HALLOWEEN_LED_CHANNELS range in Kconfig).
+ */
+#define MM_CHANNEL(gpio_num, ch)  { .gpio = (gpio_num), .ledc_ch = (ch) }
+
+static mm_channel_t mm_channels[LIGHT_CHANNELS] = {
+    MM_CHANNEL(MM_LED_GPIO, 1),
+#if LIGHT_CHANNELS >= 2
+    MM_CHANNEL(CONFIG_HALLOWEEN_LED_GPIO_2, 0),
+#endif
+#if LIGHT_CHANNELS >= 3
+    MM_CHANNEL(CONFIG_HALLOWEEN_LED_GPIO_3, 3),
+#endif
+#if LIGHT_CHANNELS >= 4
+    MM_CHANNEL(CONFIG_HALLOWEEN_LED_GPIO_4, 4),
+#endif
+#if LIGHT_CHANNELS >= 5
+    MM_CHANNEL(CONFIG_HALLOWEEN_LED_GPIO_5, 5),
+#endif
+#if LIGHT_CHANNELS >= 6
+    MM_CHANNEL(CONFIG_HALLOWEEN_LED_GPIO_6, MM_AUDIO_LEDC_CH),
+#endif
+};
+
+#if CONFIG_HALLOWEEN_AUDIO_ENABLE
+_Static_assert(LIGHT_CHANNELS <= 5, "the sixth LED string shares its LEDC channel with the audio output");
+#endif
+
 static const char *TAG = "LED";
 static bool mm_light_initialized = false;
+/* commands for the light task, which owns everything below */
+static light_cmd_queue_t mm_cmd_queue;
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
-static bool mm_brightness_started = false;
-static uint8_t mm_brightness_last = LIGHT_DEFAULT_BRIGHTNESS;
+static bool mm_timer_running = false;   /* the LEDC timer shared by all strings */
+static uint8_t mm_level_cap = 255;      /* battery governor limit, on top of the levels set over Zigbee */
+/*
+ * The level each string shows (0 when dark) and its level whether lit or
+ * not, one byte per string, for light_driver_load() and
+ * light_driver_get_brightness() on other tasks. The light task publishes
+ * them after every batch and ramp end, so a reader never sees half of one.
+ */
+static uint64_t mm_lit_levels;
+static uint64_t mm_levels;
+_Static_assert(LIGHT_CHANNELS <= sizeof(mm_lit_levels), "one byte per string");
 
 void light_brightness_init(void);
-void light_brightness_start(void);
-void light_brightness_stop(void);
+void light_brightness_start(mm_channel_t *ch);
+void light_brightness_stop(mm_channel_t *ch);
 #endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
 
 #if CONFIG_HALLOWEEN_BLINK_ENABLE
-void light_effect_init(void);
+void light_blink_init(void);
 void start_effect(void);
 void stop_effect(void);
+static uint8_t mm_effect = LIGHT_DRIVER_EFFECT_BLINK;
+static bool mm_effect_power = false;   /* channel 0 is on, whether an effect plays or not */
 #endif //HALLOWEEN_BLINK_ENABLE
 
 #if CONFIG_HALLOWEEN_AUDIO_ENABLE
@@ -44,245 +114,768 @@ void audio_start(void);
 void audio_stop(void);
 void audio_enable(bool enable);
 static bool mm_audio_started = false;
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+/* the audio pin plays clips from flash instead of the square wave */
+static bool mm_audio_clips = false;
+#endif //CONFIG_HALLOWEEN_AUDIO_CLIPS
 #endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
 
 void led_rtc_init(void);
-static void led_set_power(bool power);
+static void led_set_power(uint8_t channel, bool power);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+static void driver_set_brightness(uint8_t channel, uint8_t value);
+#endif
+
+static void driver_post(const light_cmd_t *cmd)
+{
+    if (!light_cmd_post(&mm_cmd_queue, cmd)) {
+        ESP_LOGW(TAG, "Command queue full, command %d for channel %d dropped", cmd->type, cmd->channel);
+        return;
+    }
+    light_hal_task_wake();
+}
+
+void light_driver_set_power(uint8_t channel, bool power)
+{
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    driver_post(&(light_cmd_t) { .type = LIGHT_CMD_POWER, .channel = channel, .value = power });
+}
 
-void light_driver_set_power(bool power)
+static void driver_set_power(uint8_t channel, bool power)
 {
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    mm_channel_t *ch = &mm_channels[channel];
+    bool was_powered = ch->powered;
+
+    ch->powered = power;
+#endif
 #if CONFIG_HALLOWEEN_BLINK_ENABLE
-	if (power)
-		start_effect();
-	else
-		stop_effect();
-#else //CONFIG_HALLOWEEN_BLINK_ENABLE
-    led_set_power(power);
+    /* the effect plays on the first string */
+    if (channel == 0) {
+        mm_effect_power = power;
+        if (mm_effect != LIGHT_DRIVER_EFFECT_NONE) {
+            if (power)
+                start_effect();
+            else
+                stop_effect();
+            return;
+        }
+    }
 #endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    /* a string switched on again carries on with its ramp */
+    if (power && was_powered && ch->fade_active)
+        return;
+#endif
+    led_set_power(channel, power);
+}
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+bool light_driver_set_effect(uint8_t effect)
+{
+    if (effect >= LIGHT_DRIVER_EFFECT_MAX)
+        return false;
+    driver_post(&(light_cmd_t) { .type = LIGHT_CMD_EFFECT, .value = effect });
+    return true;
+}
 
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+void light_driver_set_clock(int64_t (*clock)(void))
+{
+    light_effect_set_clock(clock);
 }
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
 
-void light_driver_set_brightness(uint8_t value)
+static void driver_set_effect(uint8_t effect)
 {
+    if (effect == mm_effect)
+        return;
+
+    mm_effect = effect;
+    if (!mm_effect_power)
+        return;
+    light_effect_stop();
+    if (effect == LIGHT_DRIVER_EFFECT_NONE)
+        led_set_power(0, true);
+    else
+        start_effect();
+}
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
-	if (value > 0 && !mm_brightness_started)
-		light_brightness_start();
-	
-    mm_brightness_last = value;
+/* perceptual curve and polarity are baked into the generated table */
+static inline uint32_t light_level_to_duty(uint8_t value)
+{
+    return light_brightness_lut[value < mm_level_cap ? value : mm_level_cap];
+}
 
-#if CONFIG_HALLOWEEN_LED_LEVEL_HIGH
-    uint32_t duty_cycle = (1023 * value) / 255; // LEDC resolution set to 10bits, thus: 100% = 1023
+/* inverse of light_level_to_duty(), only needed when a ramp is frozen */
+static uint8_t light_duty_to_level(uint32_t duty)
+{
+    int lo = 0, hi = 255;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+#if LIGHT_BRIGHTNESS_ACTIVE_LOW
+        bool below = light_brightness_lut[mid] >= duty;
 #else
-    uint32_t duty_cycle = (1023 * (255-value)) / 255; // LEDC resolution set to 10bits, thus: 100% = 1023
+        bool below = light_brightness_lut[mid] <= duty;
 #endif
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, MM_LED_LEDC_CH, duty_cycle);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, MM_LED_LEDC_CH);
-	
-	if (value == 0 && mm_brightness_started)
-		light_brightness_stop();
-	
+        if (below)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+static void light_fade_done(uint8_t ledc_ch, void *arg);
+static void driver_publish(void);
+
+static void light_fade_cancel(mm_channel_t *ch)
+{
+    if (ch->fade_active) {
+        light_hal_pwm_fade_stop(ch->ledc_ch);
+        ch->fade_active = false;
+    }
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+    ch->dither_level = 0;
+#endif
+}
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+#define DITHER_PERIODS_PER_BATCH (LIGHT_HAL_FADE_RANGES_MAX / 2)
+/* PWM periods per dither LSB, so that a whole dither period lasts ~5 ms (200 Hz, no visible flicker) */
+#define DITHER_CYCLES_PER_LSB \
+    ((CONFIG_HALLOWEEN_BRIGHTNESS_FREQ / (200 << LIGHT_BRIGHTNESS_DITHER_BITS)) ? \
+     (CONFIG_HALLOWEEN_BRIGHTNESS_FREQ / (200 << LIGHT_BRIGHTNESS_DITHER_BITS)) : 1)
+
+/*
+ * The lowest levels sit between two duty steps. Alternate the two in
+ * hardware (weights from light_brightness_dither) and re-arm from the fade
+ * callback every DITHER_PERIODS_PER_BATCH dither periods.
+ */
+static void light_dither_arm(mm_channel_t *ch)
+{
+    light_hal_fade_range_t ranges[LIGHT_HAL_FADE_RANGES_MAX];
+    uint8_t frac = light_brightness_dither[ch->dither_level];
+    const uint8_t period = 1 << LIGHT_BRIGHTNESS_DITHER_BITS;
+
+    for (int i = 0; i < DITHER_PERIODS_PER_BATCH; i++) {
+        /* hold the table duty, step one LSB brighter, hold, step back */
+        ranges[2 * i] = (light_hal_fade_range_t) {
+            .step_num = 1, .cycle_num = (period - frac) * DITHER_CYCLES_PER_LSB, .scale = 1, .increase = !LIGHT_BRIGHTNESS_ACTIVE_LOW,
+        };
+        ranges[2 * i + 1] = (light_hal_fade_range_t) {
+            .step_num = 1, .cycle_num = frac * DITHER_CYCLES_PER_LSB, .scale = 1, .increase = LIGHT_BRIGHTNESS_ACTIVE_LOW,
+        };
+    }
+    ch->fade_done = NULL;
+    ch->fade_active = light_hal_pwm_fade(ch->ledc_ch, light_level_to_duty(ch->dither_level), ranges,
+                                         LIGHT_HAL_FADE_RANGES_MAX, light_fade_done, ch) == ESP_OK;
+}
+
+static void light_dither_start(mm_channel_t *ch, uint8_t value)
+{
+    if (value == 0 || value >= LIGHT_BRIGHTNESS_DITHER_LEVELS || light_brightness_dither[value] == 0)
+        return;
+    ch->dither_level = value;
+    light_dither_arm(ch);
+}
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+
+static void light_fade_done(uint8_t ledc_ch, void *arg)
+{
+    mm_channel_t *ch = arg;
+    light_driver_fade_cb_t done = ch->fade_done;
+
+    if (!ch->fade_active)
+        return;
+    ch->fade_active = false;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+    if (ch->dither_level) {
+        light_dither_arm(ch);
+        return;
+    }
+#endif
+    if (ch->brightness_last == 0)
+        light_brightness_stop(ch);
+    else if (ch->brightness_last > mm_level_cap)
+        light_hal_pwm_set_duty(ch->ledc_ch, light_level_to_duty(ch->brightness_last));
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+    else
+        light_dither_start(ch, ch->brightness_last);
+#endif
+    driver_publish();
+    if (done)
+        done((uint8_t)(ch - mm_channels), ch->brightness_last, ch->fade_arg);
+}
+
+void light_driver_fade_brightness(uint8_t channel, uint8_t value, uint32_t time_ms, light_driver_fade_cb_t done, void *arg)
+{
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    driver_post(&(light_cmd_t) {
+        .type = LIGHT_CMD_FADE, .channel = channel, .value = value, .time_ms = time_ms, .done = done, .arg = arg,
+    });
+}
+
+static void driver_fade_brightness(uint8_t channel, uint8_t value, uint32_t time_ms, light_driver_fade_cb_t done, void *arg)
+{
+    light_hal_fade_range_t ranges[EFFECT_PROGRAM_FRAME_RANGES_MAX];
+    size_t count = 0;
+    uint32_t from = light_level_to_duty(0);
+    mm_channel_t *ch = &mm_channels[channel];
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    /* effects own the channel, the new level applies to their next batch */
+    if (channel == 0 && light_effect_running())
+        time_ms = 0;
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+    /* a string switched off only keeps the level */
+    if (!ch->powered)
+        time_ms = 0;
+    if (time_ms > 0) {
+        light_fade_cancel(ch);
+        if (ch->started)
+            from = light_hal_pwm_get_duty(ch->ledc_ch);
+        count = effect_program_ramp_ranges(from, light_level_to_duty(value), time_ms,
+                                           CONFIG_HALLOWEEN_BRIGHTNESS_FREQ, ranges);
+    }
+    if (count == 0) {
+        driver_set_brightness(channel, value);
+        if (done)
+            done(channel, value, arg);
+        return;
+    }
+
+    if (!ch->started)
+        light_brightness_start(ch);
+    ch->brightness_last = value;
+    ch->fade_done = done;
+    ch->fade_arg = arg;
+    ch->fade_active = true;
+    if (light_hal_pwm_fade(ch->ledc_ch, from, ranges, count, light_fade_done, ch) != ESP_OK) {
+        ESP_LOGW(TAG, "Hardware fade failed, setting brightness %d directly", value);
+        ch->fade_active = false;
+        driver_set_brightness(channel, value);
+        if (done)
+            done(channel, value, arg);
+    }
+}
+
+void light_driver_stop_fade(uint8_t channel, light_driver_fade_cb_t done, void *arg)
+{
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    driver_post(&(light_cmd_t) { .type = LIGHT_CMD_STOP_FADE, .channel = channel, .done = done, .arg = arg });
+}
+
+static uint8_t driver_stop_fade(uint8_t channel)
+{
+    mm_channel_t *ch = &mm_channels[channel];
+    if (ch->fade_active) {
+        light_fade_cancel(ch);
+        ch->brightness_last = light_duty_to_level(light_hal_pwm_get_duty(ch->ledc_ch));
+    }
+    return ch->brightness_last;
+}
+
+void light_driver_set_level_cap(uint8_t cap)
+{
+    driver_post(&(light_cmd_t) { .type = LIGHT_CMD_LEVEL_CAP, .value = cap });
+}
+
+/* lit strings show the new cap right away, ramps when they end, effects with their next batch */
+static void driver_set_level_cap(uint8_t cap)
+{
+    if (cap == mm_level_cap)
+        return;
+    mm_level_cap = cap;
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        mm_channel_t *ch = &mm_channels[channel];
+        if (!ch->started || ch->fade_active)
+            continue;
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+        if (channel == 0 && light_effect_running())
+            continue;
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+        light_hal_pwm_set_duty(ch->ledc_ch, light_level_to_duty(ch->brightness_last));
+    }
+}
+
+static void driver_publish(void)
+{
+    uint64_t lit = 0, levels = 0;
+
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        const mm_channel_t *ch = &mm_channels[channel];
+        bool on = ch->started;
+        levels |= (uint64_t)ch->brightness_last << (8 * channel);
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+        /* an effect counts as its full brightness */
+        on = on || (channel == 0 && mm_effect_power);
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+        if (on)
+            lit |= (uint64_t)ch->brightness_last << (8 * channel);
+    }
+    __atomic_store_n(&mm_lit_levels, lit, __ATOMIC_RELEASE);
+    __atomic_store_n(&mm_levels, levels, __ATOMIC_RELEASE);
+}
+
+uint32_t light_driver_load(uint8_t cap)
+{
+    uint64_t lit = __atomic_load_n(&mm_lit_levels, __ATOMIC_ACQUIRE);
+    uint32_t load = 0;
+
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        uint8_t level = lit >> (8 * channel);
+        if (level == 0)
+            continue;
+        uint32_t duty = light_brightness_lut[level < cap ? level : cap];
+#if LIGHT_BRIGHTNESS_ACTIVE_LOW
+        duty = LIGHT_BRIGHTNESS_DUTY_MAX - duty;
+#endif
+        load += duty * 1000 / LIGHT_BRIGHTNESS_DUTY_MAX;
+    }
+    return load;
+}
+
+uint8_t light_driver_get_brightness(uint8_t channel)
+{
+    return channel < LIGHT_CHANNELS ? (uint8_t)(__atomic_load_n(&mm_levels, __ATOMIC_ACQUIRE) >> (8 * channel)) : 0;
+}
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+
+void light_driver_set_brightness(uint8_t channel, uint8_t value)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    driver_post(&(light_cmd_t) { .type = LIGHT_CMD_LEVEL, .channel = channel, .value = value });
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+}
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+static void driver_set_brightness(uint8_t channel, uint8_t value)
+{
+    mm_channel_t *ch = &mm_channels[channel];
+
+    light_fade_cancel(ch);
+    ch->brightness_last = value;
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    /* a running effect picks the new brightness up with its next batch */
+    if (channel == 0 && light_effect_running())
+        return;
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+	/* a string switched off keeps the level until it is switched on */
+	if (!ch->powered)
+		return;
+
+	if (value > 0 && !ch->started)
+		light_brightness_start(ch);
+
+    light_hal_pwm_set_duty(ch->ledc_ch, light_level_to_duty(value));
+
+	if (value == 0 && ch->started)
+		light_brightness_stop(ch);
+#if CONFIG_HALLOWEEN_BRIGHTNESS_DITHER
+	else
+		light_dither_start(ch, value);
+#endif
+}
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+
+_Static_assert(LIGHT_CHANNELS <= LIGHT_CMD_CHANNELS_MAX, "scene command too small for the LED channels");
+
+void light_driver_set_scene(const light_scene_t *scene, uint32_t time_ms)
+{
+    light_cmd_t cmd = { .type = LIGHT_CMD_SCENE, .value = scene->effect, .time_ms = time_ms };
+
+    cmd.scene.on_mask = scene->on;
+    memcpy(cmd.scene.level, scene->level, sizeof(scene->level));
+    driver_post(&cmd);
+}
+
+/* the effect first, so that powering channel 0 below starts the new one */
+static void driver_set_scene(const light_cmd_t *cmd)
+{
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    if (cmd->value < LIGHT_DRIVER_EFFECT_MAX)
+        driver_set_effect(cmd->value);
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+    for (uint8_t channel = 0; channel < LIGHT_CHANNELS; channel++) {
+        bool on = cmd->scene.on_mask >> channel & 1;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        mm_channel_t *ch = &mm_channels[channel];
+        if (on && ch->started && cmd->time_ms > 0) {
+            driver_fade_brightness(channel, cmd->scene.level[channel], cmd->time_ms, NULL, NULL);
+            continue;
+        }
+        light_fade_cancel(ch);
+        ch->brightness_last = cmd->scene.level[channel];
 #endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        driver_set_power(channel, on);
+    }
 }
 
-void light_driver_init(bool power)
+static void driver_apply(const light_cmd_t *cmd)
+{
+    switch (cmd->type) {
+    case LIGHT_CMD_POWER:
+        driver_set_power(cmd->channel, cmd->value);
+        break;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    case LIGHT_CMD_LEVEL:
+        driver_set_brightness(cmd->channel, cmd->value);
+        break;
+    case LIGHT_CMD_FADE:
+        driver_fade_brightness(cmd->channel, cmd->value, cmd->time_ms, cmd->done, cmd->arg);
+        break;
+    case LIGHT_CMD_STOP_FADE: {
+        uint8_t level = driver_stop_fade(cmd->channel);
+        if (cmd->done)
+            cmd->done(cmd->channel, level, cmd->arg);
+        break;
+    }
+    case LIGHT_CMD_LEVEL_CAP:
+        driver_set_level_cap(cmd->value);
+        break;
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    case LIGHT_CMD_EFFECT:
+        driver_set_effect(cmd->value);
+        break;
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+    case LIGHT_CMD_SCENE:
+        driver_set_scene(cmd);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Light task work function: take everything posted so far and apply it in
+ * order, skipping power and level commands the same batch overrides. The
+ * batch is static, there is only the one light task to run this.
+ */
+static void driver_run(void)
+{
+    static light_cmd_t batch[LIGHT_CMD_QUEUE_LEN];
+    size_t count;
+
+    do {
+        count = 0;
+        while (count < LIGHT_CMD_QUEUE_LEN && light_cmd_take(&mm_cmd_queue, &batch[count]))
+            count++;
+        for (size_t i = 0; i < count; i++) {
+            if (!light_cmd_superseded(batch, count, i))
+                driver_apply(&batch[i]);
+        }
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+        driver_publish();
+#endif
+    } while (count == LIGHT_CMD_QUEUE_LEN);
+}
+
+void light_driver_init(const bool power[LIGHT_CHANNELS], const uint8_t level[LIGHT_CHANNELS], uint8_t effect)
 {
     if(mm_light_initialized)
         return;
-	
-#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE 
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+	if (effect < LIGHT_DRIVER_EFFECT_MAX)
+		mm_effect = effect;
+#endif //CONFIG_HALLOWEEN_BLINK_ENABLE
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+	/* the channels start dark, light_driver_set_power() below applies the levels */
+	for (int i = 0; i < LIGHT_CHANNELS; i++)
+		mm_channels[i].brightness_last = level[i];
 	light_brightness_init();
-    light_driver_set_brightness(mm_brightness_last);
-	ESP_LOGI(TAG, "Initialized LED with brightness.");
+	ESP_LOGI(TAG, "Initialized %d LED channel(s) with brightness.", LIGHT_CHANNELS);
 #else //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
 	led_rtc_init();
-	ESP_LOGI(TAG, "Initialized LED with RTC.");
+	ESP_LOGI(TAG, "Initialized %d LED channel(s) with RTC.", LIGHT_CHANNELS);
 #endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
-	
-#if CONFIG_HALLOWEEN_BLINK_ENABLE
-	light_effect_init();
-	ESP_LOGI(TAG, "Initialized LED blink effect.");
-#endif //HALLOWEEN_BLINK_ENABLE
 
 #if CONFIG_HALLOWEEN_AUDIO_ENABLE
 	audio_init();
 	ESP_LOGI(TAG, "Initialized audio.");
 #endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
 
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+	light_blink_init();
+	ESP_LOGI(TAG, "Initialized LED blink effect.");
+#endif //HALLOWEEN_BLINK_ENABLE
+
+	light_cmd_queue_init(&mm_cmd_queue);
+	ESP_ERROR_CHECK(light_hal_task_start(driver_run));
     mm_light_initialized = true;
-	light_driver_set_power(power);
+	for (uint8_t i = 0; i < LIGHT_CHANNELS; i++)
+		light_driver_set_power(i, power[i]);
 }
 
 void led_rtc_init(void)
 {
-    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
-    esp_sleep_pd_config(ESP_PD_DOMAIN_VDDSDIO, ESP_PD_OPTION_ON);
-	
-    rtc_gpio_init(MM_LED_GPIO);
-    rtc_gpio_set_direction(MM_LED_GPIO, RTC_GPIO_MODE_OUTPUT_ONLY);
-    rtc_gpio_pulldown_dis(MM_LED_GPIO);
-    rtc_gpio_pullup_dis(MM_LED_GPIO);
+	for (int i = 0; i < LIGHT_CHANNELS; i++)
+		light_hal_gpio_init(mm_channels[i].gpio);
 }
 
-void led_rtc_power(bool power)
+void led_rtc_power(uint8_t channel, bool power)
 {
-	rtc_gpio_hold_dis(MM_LED_GPIO);
 #if CONFIG_HALLOWEEN_LED_LEVEL_HIGH
-	rtc_gpio_set_level(MM_LED_GPIO, power);
+	light_hal_gpio_set(mm_channels[channel].gpio, power);
 #else
-	rtc_gpio_set_level(MM_LED_GPIO, !power);
+	light_hal_gpio_set(mm_channels[channel].gpio, !power);
 #endif
-    rtc_gpio_hold_en(MM_LED_GPIO);
 }
 
-static void led_set_power(bool power)
+static void led_set_power(uint8_t channel, bool power)
 {
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
     if (power)
     {
-        light_driver_set_brightness(mm_brightness_last);
+        driver_set_brightness(channel, mm_channels[channel].brightness_last);
     }
     else
     {
-		light_brightness_stop();
+        /* a ramp cut short by switching off reports the level it reached, switching on again resumes from there */
+        mm_channel_t *ch = &mm_channels[channel];
+        light_driver_fade_cb_t done = ch->fade_active ? ch->fade_done : NULL;
+
+        if (done)
+            driver_stop_fade(channel);
+        light_brightness_stop(ch);
+        if (done)
+            done(channel, ch->brightness_last, ch->fade_arg);
     }
 #else //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
-    led_rtc_power(power);
+    led_rtc_power(channel, power);
 #endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
 
 #if CONFIG_HALLOWEEN_AUDIO_ENABLE
-	audio_enable(power);
+	if (channel == 0)
+		audio_enable(power);
 #endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
 }
 
 #if CONFIG_HALLOWEEN_BLINK_ENABLE
-static esp_timer_handle_t blink_timer;
-static bool blink_state = false;
-static bool blink_en = false;
+/* default program: the classic on/off blink */
+static const light_keyframe_t blink_frames[] = {
+    { .level = 255, .fade_ms = 0, .hold_ms = BLINK_TIME_ON_MS },
+    { .level = 0,   .fade_ms = 0, .hold_ms = BLINK_TIME_OFF_MS },
+};
+
+/* procedural effects, LIGHT_DRIVER_EFFECT_CANDLE onwards in effect_gen_kind_t order */
+static effect_gen_t mm_effect_gen;
 
-static void effect_timer_callback(void* arg) {
-    if (!blink_en) return;
+static bool effect_gen_frame(void *ctx, light_keyframe_t *frame)
+{
+    effect_gen_next(ctx, frame);
+    return true;
+}
+
+static void effect_gen_restart(void *ctx, uint32_t seed)
+{
+    effect_gen_t *gen = ctx;
+    effect_gen_init(gen, (effect_gen_kind_t)gen->kind, seed);
+}
 
-    blink_state = !blink_state;
+static const light_effect_program_t gen_program = {
+    .next = effect_gen_frame,
+    .ctx = &mm_effect_gen,
+    .restart = effect_gen_restart,
+};
 
-    if (blink_state) {
-		led_set_power(1);
-        // Set timer to ON_TIME
-        esp_timer_stop(blink_timer);
-        esp_timer_start_once(blink_timer, BLINK_TIME_ON_MS * 1000ULL);
-    } else {
-		led_set_power(0);
-        // Set timer to OFF_TIME
-        esp_timer_stop(blink_timer);
-        esp_timer_start_once(blink_timer, BLINK_TIME_OFF_MS * 1000ULL);
-    }
+static const light_effect_program_t blink_program = {
+    .frames = blink_frames,
+    .count = sizeof(blink_frames) / sizeof(blink_frames[0]),
+    .loop = true,
+};
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+/* keyframe levels are relative to the brightness set over Zigbee */
+static uint32_t led_effect_duty(uint8_t level)
+{
+    return light_level_to_duty((mm_channels[0].brightness_last * level) / 255);
+}
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+
+static void led_effect_set_level(uint8_t level)
+{
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    light_hal_pwm_set_duty(mm_channels[0].ledc_ch, led_effect_duty(level));
+#else
+    led_rtc_power(0, level > 0);
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+}
+
+#if CONFIG_HALLOWEEN_AUDIO_ENABLE
+static uint32_t audio_effect_duty(uint8_t level)
+{
+    return level ? 2 : 0;
+}
+
+static void audio_effect_set_level(uint8_t level)
+{
+    audio_enable(level > 0);
 }
+#endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
 
-void light_effect_init(void)
-{			
-	/* timer for efekt */
-    const esp_timer_create_args_t timer_args = {
-        .callback = &effect_timer_callback,
-        .name = "blink_timer"
+void light_blink_init(void)
+{
+    const light_effect_output_t outputs[] = {
+        {
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+            .pwm_channel = mm_channels[0].ledc_ch,
+            .pwm_freq_hz = CONFIG_HALLOWEEN_BRIGHTNESS_FREQ,
+            .level_to_duty = led_effect_duty,
+#else
+            .pwm_channel = LIGHT_EFFECT_NO_PWM,
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+            .set_level = led_effect_set_level,
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+            .lp_core = true,
+            .lp_gpio = mm_channels[0].gpio,
+#if !CONFIG_HALLOWEEN_LED_LEVEL_HIGH
+            .lp_invert = true,
+#endif
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+        },
+#if CONFIG_HALLOWEEN_AUDIO_ENABLE
+        {
+            .pwm_channel = MM_AUDIO_LEDC_CH,
+            .pwm_freq_hz = MM_AUDIO_FREQ,
+            .level_to_duty = audio_effect_duty,
+            .set_level = audio_effect_set_level,
+        },
+#endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
     };
-    esp_timer_create(&timer_args, &blink_timer);
+    size_t count = sizeof(outputs) / sizeof(outputs[0]);
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+    /* clips play on their own while the effect runs, the effect only drives the LED */
+    if (mm_audio_clips)
+        count = 1;
+#endif //CONFIG_HALLOWEEN_AUDIO_CLIPS
+    ESP_ERROR_CHECK(light_effect_init(outputs, count));
 }
 
-void start_effect(void) 
+void start_effect(void)
 {
-    if (blink_en) return;
-    blink_en = true;
-    blink_state = false;
-    esp_timer_start_once(blink_timer, 1000);
+    if (light_effect_running()) return;
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    mm_channel_t *ch = &mm_channels[0];
+    /* the effect takes over a ramp at its end level, as ramps that start under an effect do */
+    light_driver_fade_cb_t done = ch->fade_active ? ch->fade_done : NULL;
+
+    light_fade_cancel(ch);
+    if (done)
+        done(0, ch->brightness_last, ch->fade_arg);
+    /* hardware fades need the PWM timers running */
+    if (!ch->started)
+        light_brightness_start(ch);
+#if CONFIG_HALLOWEEN_AUDIO_ENABLE
+    audio_enable(true);
+#endif //CONFIG_HALLOWEEN_AUDIO_ENABLE
+#endif //CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+    if (mm_effect == LIGHT_DRIVER_EFFECT_BLINK) {
+        light_effect_start(&blink_program);
+    } else {
+        effect_gen_init(&mm_effect_gen, (effect_gen_kind_t)(mm_effect - LIGHT_DRIVER_EFFECT_CANDLE),
+                        (uint32_t)light_hal_time_us());
+        light_effect_start(&gen_program);
+    }
 }
 
-void stop_effect(void) 
+void stop_effect(void)
 {
-    blink_en = false;
-    esp_timer_stop(blink_timer);
-	led_set_power(0);
+    light_effect_stop();
+	led_set_power(0, 0);
 }
 #endif
 
 #if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+/*
+ * All strings run from one LEDC timer. Their turn-on points (hpoint) are
+ * spread evenly over the PWM period, so the MOSFETs switch on one after the
+ * other instead of all at once: the peak battery current is the current of
+ * the strings that overlap, not of all of them. An on-time that runs past
+ * the end of the period wraps around to its start.
+ */
 void light_brightness_init(void)
-{	
-    const ledc_timer_config_t light_brightness_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_1,
-        .freq_hz = (CONFIG_HALLOWEEN_BRIGHTNESS_FREQ),
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    const ledc_channel_config_t light_brightness_channel = {
-        .gpio_num = MM_LED_GPIO,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = MM_LED_LEDC_CH,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_1,
-        .duty = 0,
-        .hpoint = 0,
-        .sleep_mode = LEDC_SLEEP_MODE_KEEP_ALIVE
-    };
-
-    ledc_timer_config(&light_brightness_timer);
-    ledc_channel_config(&light_brightness_channel);
-	   
-	mm_brightness_started = true;
+{
+    light_hal_pwm_timer_config(MM_LED_LEDC_TIMER, CONFIG_HALLOWEEN_BRIGHTNESS_FREQ, LIGHT_BRIGHTNESS_DUTY_BITS);
+	for (int i = 0; i < LIGHT_CHANNELS; i++) {
+		uint32_t hpoint = (uint32_t)(((uint64_t)i << LIGHT_BRIGHTNESS_DUTY_BITS) / LIGHT_CHANNELS);
+		light_hal_pwm_channel_config(mm_channels[i].ledc_ch, mm_channels[i].gpio, MM_LED_LEDC_TIMER,
+		                             light_level_to_duty(0), hpoint);
+		mm_channels[i].started = true;
+	}
+	mm_timer_running = true;
 }
 
-void light_brightness_start(void)
+void light_brightness_start(mm_channel_t *ch)
 {
-    ledc_timer_resume(LEDC_LOW_SPEED_MODE, LEDC_TIMER_1);
-	mm_brightness_started = true;
+	if (!mm_timer_running)
+		light_hal_pwm_timer_resume(MM_LED_LEDC_TIMER);
+	mm_timer_running = true;
+	ch->started = true;
 }
 
-void light_brightness_stop(void)
+/* stop one string, and the shared timer with the last one */
+void light_brightness_stop(mm_channel_t *ch)
 {
-	ledc_stop(LEDC_LOW_SPEED_MODE, MM_LED_LEDC_CH, 0);
-	ledc_timer_pause(LEDC_LOW_SPEED_MODE, LEDC_TIMER_1);	
-	mm_brightness_started = false;
+	light_fade_cancel(ch);
+	light_hal_pwm_stop(ch->ledc_ch, LIGHT_BRIGHTNESS_ACTIVE_LOW);
+	ch->started = false;
+	for (int i = 0; i < LIGHT_CHANNELS; i++) {
+		if (mm_channels[i].started)
+			return;
+	}
+	light_hal_pwm_timer_pause(MM_LED_LEDC_TIMER);
+	mm_timer_running = false;
 }
 #endif
 
 #if CONFIG_HALLOWEEN_AUDIO_ENABLE
 void audio_init(void)
-{	
-    const ledc_timer_config_t audio_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_2,
-        .freq_hz = 80,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    const ledc_channel_config_t audio_channel = {
-        .gpio_num = MM_AUDIO_GPIO,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = MM_AUDIO_LEDC_CH,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_2,
-        .duty = 2,
-        .hpoint = 0,
-        .sleep_mode = LEDC_SLEEP_MODE_KEEP_ALIVE
-    };
+{
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+	if (audio_player_init(MM_AUDIO_GPIO) == ESP_OK) {
+		mm_audio_clips = true;
+		return;
+	}
+	ESP_LOGW(TAG, "No sound clips, falling back to the square wave.");
+#endif //CONFIG_HALLOWEEN_AUDIO_CLIPS
+    ESP_ERROR_CHECK(light_hal_pwm_timer_config(MM_AUDIO_LEDC_TIMER, MM_AUDIO_FREQ, 10));
+    ESP_ERROR_CHECK(light_hal_pwm_channel_config(MM_AUDIO_LEDC_CH, MM_AUDIO_GPIO, MM_AUDIO_LEDC_TIMER, 2, 0));
 
-    ESP_ERROR_CHECK(ledc_timer_config(&audio_timer));
-    ESP_ERROR_CHECK(ledc_channel_config(&audio_channel));
-	
 	mm_audio_started = true;
 }
 
 void audio_start(void)
-{	
+{
 	if(mm_audio_started)
 		return;
 
-    ledc_timer_resume(LEDC_LOW_SPEED_MODE, LEDC_TIMER_2);
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+	if (mm_audio_clips)
+		audio_player_start();
+	else
+#endif //CONFIG_HALLOWEEN_AUDIO_CLIPS
+    light_hal_pwm_timer_resume(MM_AUDIO_LEDC_TIMER);
 	mm_audio_started = true;
 }
 
 void audio_stop(void)
 {
-	ledc_timer_pause(LEDC_LOW_SPEED_MODE, LEDC_TIMER_2);
+#if CONFIG_HALLOWEEN_AUDIO_CLIPS
+	if (mm_audio_clips)
+		audio_player_stop();
+	else
+#endif //CONFIG_HALLOWEEN_AUDIO_CLIPS
+	light_hal_pwm_timer_pause(MM_AUDIO_LEDC_TIMER);
 	mm_audio_started = false;
 }
 
@@ -6,11 +6,19 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * The setters below only post a command and return; the light task applies
+ * the commands in order (see light_cmd.h), so they can be called from any
+ * task and never wait for the LEDC driver.
+ */
+
 /* light intensity level */
 #define LIGHT_DEFAULT_ON  1
 #define LIGHT_DEFAULT_OFF 0
@@ -19,26 +27,157 @@ extern "C" {
 #define LIGHT_DEFAULT_BRIGHTNESS 125
 #endif
 
+/* independently switched LED strings, channel 0 is the one effects play on */
+#define LIGHT_CHANNELS CONFIG_HALLOWEEN_LED_CHANNELS
+
+/* effects of channel 0, the values of the Effect attribute (ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID) */
+#define LIGHT_DRIVER_EFFECT_NONE        0   /* steady light */
+#define LIGHT_DRIVER_EFFECT_BLINK       1
+#define LIGHT_DRIVER_EFFECT_CANDLE      2
+#define LIGHT_DRIVER_EFFECT_LIGHTNING   3
+#define LIGHT_DRIVER_EFFECT_HEARTBEAT   4
+#define LIGHT_DRIVER_EFFECT_DYING_BULB  5
+#define LIGHT_DRIVER_EFFECT_MAX         6
+
 /**
 * @brief Set light power (on/off).
 *
-* @param  power  The light power to be set
+* @param  channel  The LED channel, 0 - LIGHT_CHANNELS-1
+* @param  power    The light power to be set
 */
-void light_driver_set_power(bool power);
+void light_driver_set_power(uint8_t channel, bool power);
 
 /**
 * @brief Set light brightness (0 - 100%).
 *
-* @param  value  The light brightness value to be set
+* @param  channel  The LED channel
+* @param  value    The light brightness value to be set
+*/
+void light_driver_set_brightness(uint8_t channel, uint8_t value);
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+/**
+* @brief Completion callback of light_driver_fade_brightness() and light_driver_stop_fade(), runs on the light task.
+*
+* @param  channel  The LED channel
+* @param  level    The brightness reached
+* @param  arg      User argument
 */
-void light_driver_set_brightness(uint8_t value);
+typedef void (*light_driver_fade_cb_t)(uint8_t channel, uint8_t level, void *arg);
+
+/**
+* @brief Ramp the light brightness in hardware.
+*
+* The whole ramp runs as one LEDC fade; @p done is called once at its end, or
+* as soon as the command is applied when @p time_ms is 0. Switching the channel
+* off cuts the ramp short and calls @p done with the level reached, which is
+* where the channel comes back on; switching it on again while on keeps the ramp. Any other brightness change (a new level,
+* ramp or scene, or light_driver_stop_fade()) cancels the ramp without calling
+* @p done.
+*
+* @param  channel  The LED channel
+* @param  value    The target brightness
+* @param  time_ms  The ramp duration
+* @param  done     The completion callback, may be NULL
+* @param  arg      The completion callback argument
+*/
+void light_driver_fade_brightness(uint8_t channel, uint8_t value, uint32_t time_ms, light_driver_fade_cb_t done, void *arg);
+
+/**
+* @brief Freeze a running brightness ramp.
+*
+* @param  channel  The LED channel
+* @param  done     Called with the brightness the ramp had reached (or the current one), may be NULL
+* @param  arg      The callback argument
+*/
+void light_driver_stop_fade(uint8_t channel, light_driver_fade_cb_t done, void *arg);
+
+/**
+* @brief Limit the brightness every channel shows (effects included), for the battery governor.
+*
+* The levels set over Zigbee are kept and come back when the cap is raised.
+* A running ramp still ends at its own target and is capped after it.
+*
+* @param  cap  Highest level, 255 for no cap
+*/
+void light_driver_set_level_cap(uint8_t cap);
+
+/**
+* @brief Summed PWM duty of the channels that are on, if their level were capped at @p cap.
+*
+* Any task may call it. It reads the levels the light task published after
+* its last batch or ramp end, so commands still queued are not counted yet.
+*
+* @param  cap  Level cap to evaluate
+* @return Permille of one channel at full duty
+*/
+uint32_t light_driver_load(uint8_t cap);
+
+/**
+* @brief Get the light brightness (target of a running ramp) as of the last batch the light task applied.
+*
+* The value lags behind commands still queued, and writes the caller holds
+* back (light_coalesce.h): a producer that needs its own latest level has to
+* track it.
+*
+* @param  channel  The LED channel
+*/
+uint8_t light_driver_get_brightness(uint8_t channel);
+#endif
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+/**
+* @brief Select the effect channel 0 plays while it is on.
+*
+* A running effect is replaced right away.
+*
+* @param  effect  One of LIGHT_DRIVER_EFFECT_*
+* @return false for an unknown effect, which is ignored
+*/
+bool light_driver_set_effect(uint8_t effect);
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+/**
+* @brief Play effects in step with other lights on a shared clock, see light_effect_set_clock().
+*
+* Call before light_driver_init().
+*
+* @param clock Shared time in us, LIGHT_EFFECT_NO_CLOCK (INT64_MIN) while unknown; called on the light task
+*/
+void light_driver_set_clock(int64_t (*clock)(void));
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+#endif
+
+/** the whole display, as a scene recall sets it */
+typedef struct {
+    uint8_t on;                         /* bit per channel */
+    uint8_t level[LIGHT_CHANNELS];      /* kept while off, ignored without brightness support */
+    uint8_t effect;                     /* LIGHT_DRIVER_EFFECT_* of channel 0, ignored without effect support */
+} light_scene_t;
+
+/**
+* @brief Set power, brightness and effect of every channel with one command.
+*
+* The light task applies the scene in one pass: strings that are lit and stay
+* on ramp to their level over @p time_ms, the others switch right away. A
+* scene overrides the power and level commands posted before it.
+*
+* @param  scene    The scene, copied into the command
+* @param  time_ms  The ramp duration
+*/
+void light_driver_set_scene(const light_scene_t *scene, uint32_t time_ms);
 
 /**
 * @brief color light driver init, be invoked where you want to use color light
 *
-* @param power power on/off
+* The channels come up directly in the given state, without showing the
+* default brightness first. All of them share one LEDC timer.
+*
+* @param power  power on/off of each channel
+* @param level  brightness of each channel (ignored without brightness support)
+* @param effect LIGHT_DRIVER_EFFECT_* of channel 0 (ignored without effect support)
 */
-void light_driver_init(bool power);
+void light_driver_init(const bool power[LIGHT_CHANNELS], const uint8_t level[LIGHT_CHANNELS], uint8_t effect);
 
 #ifdef __cplusplus
 } // extern "C"
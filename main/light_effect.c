@@ -0,0 +1,515 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "light_effect.h"
+#include "light_hal.h"
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+#include "lp_sequencer.h"
+#endif
+
+static const char *TAG = "EFFECT";
+
+static light_effect_output_t s_outputs[LIGHT_EFFECT_OUTPUTS_MAX];
+static size_t s_output_count;
+static bool s_use_fade;
+static light_hal_timer_t s_step_timer;
+
+static const light_effect_program_t *s_program;
+static uint8_t s_frame;
+static light_keyframe_t s_gen_frame;                /* generated keyframe not played yet */
+static bool s_gen_pending;
+static bool s_running;
+static uint32_t s_duty[LIGHT_EFFECT_OUTPUTS_MAX];   /* duty each output has when the next batch starts */
+
+static light_effect_stats_t s_stats;
+static int64_t s_started_us;
+
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+static bool s_use_lp;
+static bool s_lp_active;                            /* the running program is played by the LP core */
+static light_hal_timer_t s_refill_timer;
+#endif
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+/* further off than this the program jumps to where it should be instead of catching up */
+#define EFFECT_SYNC_JUMP_US         (3 * 1000000LL)
+/* a fade batch ends after this long at most, to compare with the clock again */
+#define EFFECT_SYNC_BATCH_MS        2000
+#define EFFECT_SYNC_EPOCH_US        (LIGHT_EFFECT_SYNC_EPOCH_MS * 1000LL)
+
+static int64_t (*s_clock)(void);
+static int64_t s_sync_next_us;                      /* shared time the next keyframe starts at, or LIGHT_EFFECT_NO_CLOCK */
+static int64_t s_sync_epoch_us;                     /* generator: end of the current epoch */
+static light_keyframe_t s_sync_frame;               /* played before the next keyframe of the program */
+static bool s_sync_pending;
+static bool s_sync_hold;                            /* s_sync_frame only waits, rather than replace the next keyframe */
+static uint8_t s_level;                             /* level of the last keyframe played */
+
+static void effect_sync_epoch(void);
+static void effect_sync_clip(light_keyframe_t *frame);
+static bool effect_sync_consume(void);
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+
+static void effect_fade_done(uint8_t channel, void *arg);
+
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE || CONFIG_HALLOWEEN_SYNC_ENABLE
+static uint32_t effect_frame_ms(const light_keyframe_t *frame)
+{
+    return (uint32_t)frame->fade_ms + frame->hold_ms;
+}
+#endif
+
+/* Keyframe to play next, or NULL when a one-shot program is finished */
+static const light_keyframe_t *effect_next_frame(void)
+{
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    if (s_sync_pending) {
+        return &s_sync_frame;
+    }
+#endif
+    if (s_program->next) {
+        if (!s_gen_pending) {
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+            effect_sync_epoch();
+#endif
+            if (!s_program->next(s_program->ctx, &s_gen_frame)) {
+                return NULL;
+            }
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+            effect_sync_clip(&s_gen_frame);
+#endif
+        }
+        s_gen_pending = true;
+        return &s_gen_frame;
+    }
+    if (s_frame >= s_program->count) {
+        if (!s_program->loop) {
+            return NULL;
+        }
+        s_frame = 0;
+    }
+    return &s_program->frames[s_frame];
+}
+
+/* the keyframe effect_next_frame() returned has been played */
+static void effect_consume_frame(void)
+{
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    if (effect_sync_consume()) {
+        return;
+    }
+#endif
+    s_frame++;
+    s_gen_pending = false;
+}
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+/* Keep s_sync_next_us with the keyframe being consumed; true for a hold the program does not know about */
+static bool effect_sync_consume(void)
+{
+    const light_keyframe_t *frame = s_sync_pending ? &s_sync_frame :
+                                    s_program->next ? &s_gen_frame : &s_program->frames[s_frame];
+    bool hold = s_sync_pending && s_sync_hold;
+
+    s_level = frame->level;
+    if (s_sync_next_us != LIGHT_EFFECT_NO_CLOCK && !hold) {
+        s_sync_next_us += effect_frame_ms(frame) * 1000LL;
+    }
+    s_sync_pending = false;
+    return hold;
+}
+
+/* a synced generator starts over at every epoch */
+static void effect_sync_epoch(void)
+{
+    if (!s_program->restart || s_sync_next_us == LIGHT_EFFECT_NO_CLOCK || s_sync_next_us < s_sync_epoch_us) {
+        return;
+    }
+    s_program->restart(s_program->ctx, (uint32_t)(s_sync_epoch_us / EFFECT_SYNC_EPOCH_US));
+    s_sync_epoch_us += EFFECT_SYNC_EPOCH_US;
+}
+
+/* and its keyframes end with the epoch, the hold first */
+static void effect_sync_clip(light_keyframe_t *frame)
+{
+    if (!s_program->restart || s_sync_next_us == LIGHT_EFFECT_NO_CLOCK) {
+        return;
+    }
+    int64_t left_ms = (s_sync_epoch_us - s_sync_next_us) / 1000;
+    if (effect_frame_ms(frame) <= left_ms) {
+        return;
+    }
+    uint32_t cut = effect_frame_ms(frame) - (uint32_t)left_ms;
+    uint16_t hold_cut = cut < frame->hold_ms ? cut : frame->hold_ms;
+    frame->hold_ms -= hold_cut;
+    frame->fade_ms -= cut - hold_cut;
+}
+
+/* Where the program is at shared time @p now: start of its cycle, of the epoch, or right now */
+static void effect_sync_align(int64_t now)
+{
+    if (!s_program->next && s_program->loop) {
+        int64_t period = 0;
+        for (uint8_t i = 0; i < s_program->count; i++) {
+            period += effect_frame_ms(&s_program->frames[i]) * 1000LL;
+        }
+        if (period > 0) {
+            int64_t phase = now % period;
+            s_frame = 0;
+            s_sync_next_us = now - (phase < 0 ? phase + period : phase);
+            return;
+        }
+    } else if (s_program->restart) {
+        int64_t epoch = now / EFFECT_SYNC_EPOCH_US - (now % EFFECT_SYNC_EPOCH_US < 0);
+        s_program->restart(s_program->ctx, (uint32_t)epoch);
+        s_gen_pending = false;
+        s_sync_next_us = epoch * EFFECT_SYNC_EPOCH_US;
+        s_sync_epoch_us = s_sync_next_us + EFFECT_SYNC_EPOCH_US;
+        return;
+    }
+    s_sync_next_us = now;
+}
+
+/*
+ * Line the program up with the shared time before its next keyframe is
+ * taken. Late, skip keyframes and start the next one that far into it;
+ * early, hold the current level. Far off, or when the clock has just
+ * become known, jump to where the program should be.
+ */
+static void effect_sync_correct(void)
+{
+    int64_t now = s_clock ? s_clock() : LIGHT_EFFECT_NO_CLOCK;
+    const light_keyframe_t *frame;
+
+    if (now == LIGHT_EFFECT_NO_CLOCK || s_sync_pending) {
+        return;
+    }
+    int64_t late = s_sync_next_us == LIGHT_EFFECT_NO_CLOCK ? INT64_MAX : now - s_sync_next_us;
+    if (late > EFFECT_SYNC_JUMP_US || late < -EFFECT_SYNC_JUMP_US) {
+        effect_sync_align(now);
+        late = now - s_sync_next_us;
+    }
+    while (late >= 1000 && (frame = effect_next_frame()) != NULL) {
+        if (effect_frame_ms(frame) * 1000LL > late) {
+            uint32_t cut = (uint32_t)(late / 1000);
+            uint16_t fade_cut = cut < frame->fade_ms ? cut : frame->fade_ms;
+            s_sync_frame = *frame;
+            s_sync_frame.fade_ms -= fade_cut;
+            s_sync_frame.hold_ms -= cut - fade_cut;
+            s_sync_hold = false;
+            s_sync_pending = true;
+            s_sync_next_us += cut * 1000LL;
+            return;
+        }
+        effect_consume_frame();
+        late = now - s_sync_next_us;
+    }
+    if (late <= -1000) {
+        s_sync_frame = (light_keyframe_t) { .level = s_level, .hold_ms = (uint16_t)(-late / 1000) };
+        s_sync_hold = true;
+        s_sync_pending = true;
+    }
+}
+
+void light_effect_set_clock(int64_t (*clock)(void))
+{
+    s_clock = clock;
+}
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+
+static void effect_finish(void)
+{
+    s_running = false;
+    s_stats.running_us += light_hal_time_us() - s_started_us;
+}
+
+/*
+ * Pack as many whole keyframes as fit into one hardware fade per output and
+ * start them together. Only the first output reports completion, which is
+ * the single wakeup of the batch.
+ */
+static void effect_run_batch(void)
+{
+    light_hal_fade_range_t ranges[LIGHT_EFFECT_OUTPUTS_MAX][LIGHT_HAL_FADE_RANGES_MAX];
+    size_t counts[LIGHT_EFFECT_OUTPUTS_MAX] = { 0 };
+    uint32_t duty[LIGHT_EFFECT_OUTPUTS_MAX];
+    const light_keyframe_t *frame;
+    size_t frames = 0;
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    uint32_t batch_ms = 0;
+
+    effect_sync_correct();
+#endif
+    for (size_t o = 0; o < s_output_count; o++) {
+        duty[o] = s_duty[o];
+    }
+    while ((frame = effect_next_frame()) != NULL && frames < LIGHT_HAL_FADE_RANGES_MAX) {
+        uint32_t to[LIGHT_EFFECT_OUTPUTS_MAX];
+        bool fits = true;
+
+        for (size_t o = 0; o < s_output_count; o++) {
+            to[o] = s_outputs[o].level_to_duty(frame->level);
+            size_t need = effect_program_frame_ranges(frame, duty[o], to[o], s_outputs[o].pwm_freq_hz, NULL);
+            fits = fits && counts[o] + need <= LIGHT_HAL_FADE_RANGES_MAX;
+        }
+        if (!fits) {
+            break;
+        }
+        for (size_t o = 0; o < s_output_count; o++) {
+            counts[o] += effect_program_frame_ranges(frame, duty[o], to[o], s_outputs[o].pwm_freq_hz,
+                                                     &ranges[o][counts[o]]);
+            duty[o] = to[o];
+        }
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+        batch_ms += effect_frame_ms(frame);
+#endif
+        effect_consume_frame();
+        frames++;
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+        if (s_sync_next_us != LIGHT_EFFECT_NO_CLOCK && batch_ms >= EFFECT_SYNC_BATCH_MS) {
+            break;
+        }
+#endif
+    }
+
+    if (counts[0] == 0) {
+        /* one-shot program done, or a program without any duration */
+        effect_finish();
+        return;
+    }
+    for (size_t o = 0; o < s_output_count; o++) {
+        if (counts[o] == 0) {
+            continue;
+        }
+        esp_err_t err = light_hal_pwm_fade(s_outputs[o].pwm_channel, s_duty[o], ranges[o], counts[o],
+                                           o == 0 ? effect_fade_done : NULL, NULL);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start fade on channel %d: %s", s_outputs[o].pwm_channel, esp_err_to_name(err));
+        }
+        s_duty[o] = duty[o];
+    }
+}
+
+static void effect_fade_done(uint8_t channel, void *arg)
+{
+    if (!s_running) {
+        return;
+    }
+    s_stats.wakeups++;
+    effect_run_batch();
+}
+
+static void effect_step_cb(void *arg)
+{
+    if (!s_running) {
+        return;
+    }
+    s_stats.wakeups++;
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    effect_sync_correct();
+#endif
+
+    const light_keyframe_t *frame = effect_next_frame();
+    if (!frame) {
+        effect_finish();
+        return;
+    }
+    for (size_t o = 0; o < s_output_count; o++) {
+        s_outputs[o].set_level(frame->level);
+    }
+    effect_consume_frame();
+
+    uint32_t ms = frame->fade_ms + frame->hold_ms;
+    light_hal_timer_start_once(s_step_timer, (ms ? ms : 1) * 1000ULL);
+}
+
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+/* Queue keyframes for the LP core until it is full; false once the program has no more */
+static bool effect_lp_fill(lp_seq_t *seq)
+{
+    const light_keyframe_t *frame;
+    while ((frame = effect_next_frame()) != NULL) {
+        if (!lp_seq_push(seq, frame->level > 0, effect_frame_ms(frame))) {
+            return true;
+        }
+        effect_consume_frame();
+    }
+    return false;
+}
+
+/* top the queue up once three quarters of what is in it has been played */
+static void effect_lp_arm_refill(const lp_seq_t *seq)
+{
+    uint32_t ms = lp_seq_queued_ms(seq) * 3 / 4;
+    light_hal_timer_start_once(s_refill_timer, (ms ? ms : 1) * 1000ULL);
+}
+
+static void effect_lp_refill_cb(void *arg)
+{
+    if (!s_running) {
+        return;
+    }
+    s_stats.wakeups++;
+
+    lp_seq_t *seq = light_hal_lp_seq();
+    if (!effect_lp_fill(seq) && lp_seq_queued_ms(seq) == 0) {
+        light_hal_lp_seq_stop();
+        s_lp_active = false;
+        effect_finish();
+        return;
+    }
+    effect_lp_arm_refill(seq);
+}
+
+/*
+ * A looping table program is queued once and replayed by the LP core for
+ * as long as it runs; generators and one-shot programs are streamed.
+ */
+static esp_err_t effect_lp_start(void)
+{
+    lp_seq_t *seq = light_hal_lp_seq();
+    bool loop = !s_program->next && s_program->loop;
+
+    lp_seq_reset(seq, loop, s_outputs[0].lp_invert);
+    if (loop) {
+        for (uint8_t i = 0; i < s_program->count; i++) {
+            if (!lp_seq_push(seq, s_program->frames[i].level > 0, effect_frame_ms(&s_program->frames[i]))) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+        }
+    } else {
+        effect_lp_fill(seq);
+    }
+    esp_err_t err = light_hal_lp_seq_start(s_outputs[0].lp_gpio);
+    if (err == ESP_OK && !loop) {
+        effect_lp_arm_refill(seq);
+    }
+    return err;
+}
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+
+esp_err_t light_effect_init(const light_effect_output_t *outputs, size_t count)
+{
+    if (!outputs || count == 0 || count > LIGHT_EFFECT_OUTPUTS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_output_count = count;
+    s_use_fade = true;
+    for (size_t o = 0; o < count; o++) {
+        s_outputs[o] = outputs[o];
+        s_use_fade = s_use_fade && outputs[o].pwm_channel != LIGHT_EFFECT_NO_PWM;
+    }
+    if (s_use_fade && light_hal_pwm_fade_install() != ESP_OK) {
+        ESP_LOGW(TAG, "Hardware fades not available, stepping effects from a timer");
+        s_use_fade = false;
+    }
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    s_use_lp = !s_use_fade && count == 1 && outputs[0].lp_core;
+    if (s_use_lp) {
+        esp_err_t err = light_hal_timer_create(effect_lp_refill_cb, NULL, "effect_refill", &s_refill_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    if (!s_use_fade) {
+        return light_hal_timer_create(effect_step_cb, NULL, "effect_timer", &s_step_timer);
+    }
+    return ESP_OK;
+}
+
+esp_err_t light_effect_start(const light_effect_program_t *program)
+{
+    if (!program || (!program->next && (!program->frames || program->count == 0))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    light_effect_stop();
+
+    s_program = program;
+    s_frame = 0;
+    s_gen_pending = false;
+    s_running = true;
+    s_started_us = light_hal_time_us();
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    s_sync_next_us = LIGHT_EFFECT_NO_CLOCK;
+    s_sync_pending = false;
+    s_level = 0;
+#endif
+
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    bool use_lp = s_use_lp;
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+    use_lp = use_lp && !s_clock;
+#endif
+    if (use_lp) {
+        esp_err_t err = effect_lp_start();
+        s_lp_active = err == ESP_OK;
+        if (s_lp_active) {
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "LP core cannot play the effect (%s), stepping it from a timer", esp_err_to_name(err));
+        s_frame = 0;
+        s_gen_pending = false;
+    }
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    if (s_use_fade) {
+        for (size_t o = 0; o < s_output_count; o++) {
+            s_duty[o] = s_outputs[o].level_to_duty(0);
+        }
+        effect_run_batch();
+    } else {
+        light_hal_timer_start_once(s_step_timer, 1000);
+    }
+    return ESP_OK;
+}
+
+void light_effect_stop(void)
+{
+    if (!s_running) {
+        return;
+    }
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    if (s_lp_active) {
+        light_hal_lp_seq_stop();
+        light_hal_timer_stop(s_refill_timer);
+        s_lp_active = false;
+    } else
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+    if (s_use_fade) {
+        for (size_t o = 0; o < s_output_count; o++) {
+            light_hal_pwm_fade_stop(s_outputs[o].pwm_channel);
+        }
+    } else {
+        light_hal_timer_stop(s_step_timer);
+    }
+    effect_finish();
+
+    light_effect_stats_t stats;
+    light_effect_get_stats(&stats);
+    ESP_LOGI(TAG, "Effect stopped, %u wakeups/min", (unsigned)light_effect_wakeups_per_min(&stats));
+}
+
+bool light_effect_running(void)
+{
+    return s_running;
+}
+
+void light_effect_get_stats(light_effect_stats_t *stats)
+{
+    *stats = s_stats;
+    if (s_running) {
+        stats->running_us += light_hal_time_us() - s_started_us;
+    }
+}
+
+uint32_t light_effect_wakeups_per_min(const light_effect_stats_t *stats)
+{
+    if (stats->running_us <= 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)stats->wakeups * 60000000ULL) / (uint64_t)stats->running_us);
+}
@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "effect_program.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** maximum number of outputs driven by one effect (LED + audio) */
+#define LIGHT_EFFECT_OUTPUTS_MAX    2
+/** light_effect_output_t::pwm_channel of an output that is not a PWM channel */
+#define LIGHT_EFFECT_NO_PWM         0xff
+/** what the light_effect_set_clock() clock returns while there is no shared time */
+#define LIGHT_EFFECT_NO_CLOCK       INT64_MIN
+/** synced generators start over at every multiple of this much shared time */
+#define LIGHT_EFFECT_SYNC_EPOCH_MS  60000
+
+/** one output the effect program is played on */
+typedef struct {
+    uint8_t pwm_channel;                        /* PWM channel or LIGHT_EFFECT_NO_PWM */
+    uint32_t pwm_freq_hz;                       /* PWM frequency of pwm_channel */
+    uint32_t (*level_to_duty)(uint8_t level);   /* keyframe level to PWM duty (hardware fades) */
+    void (*set_level)(uint8_t level);           /* apply a keyframe level directly (timer stepping) */
+    bool lp_core;                               /* on/off output on an RTC GPIO the LP core can drive */
+    int lp_gpio;                                /* that GPIO */
+    bool lp_invert;                             /* the output is on with lp_gpio low */
+} light_effect_output_t;
+
+typedef struct {
+    uint32_t wakeups;       /* CPU wakeups caused by the effect engine */
+    int64_t running_us;     /* total time effects have been running */
+} light_effect_stats_t;
+
+/**
+ * @brief Set up the effect engine.
+ *
+ * When every output is a PWM channel and the target supports multi-range
+ * hardware fades, programs run as batches of LEDC fades with one wakeup per
+ * batch. A single LP core output (CONFIG_HALLOWEEN_EFFECT_LP_CORE) is played
+ * by the LP core, with one wakeup per queue refill and none at all for a
+ * looping program that fits the queue. Otherwise each keyframe is applied
+ * from a software timer.
+ *
+ * @param outputs Outputs, the first one paces the program
+ * @param count   Number of outputs, at most LIGHT_EFFECT_OUTPUTS_MAX
+ * @return ESP_OK on success
+ */
+esp_err_t light_effect_init(const light_effect_output_t *outputs, size_t count);
+
+#if CONFIG_HALLOWEEN_SYNC_ENABLE
+/**
+ * @brief Play programs on a time base shared with other devices.
+ *
+ * A looping table then starts at the multiples of its length, a generator
+ * with a restart callback at the multiples of LIGHT_EFFECT_SYNC_EPOCH_MS
+ * with the epoch number as seed, so every device plays the same keyframe at
+ * the same time. At every wakeup the engine compares the clock with where
+ * the program is, and catches up by shortening keyframes or waits with a
+ * hold. Hardware fade batches are kept short enough for that, and the LP
+ * core is not used: it steps on its own.
+ *
+ * @param clock Shared time in us, LIGHT_EFFECT_NO_CLOCK while unknown; called on the light task
+ */
+void light_effect_set_clock(int64_t (*clock)(void));
+#endif //CONFIG_HALLOWEEN_SYNC_ENABLE
+
+/**
+ * @brief Start playing @p program from its first keyframe. Replaces a running program.
+ */
+esp_err_t light_effect_start(const light_effect_program_t *program);
+
+/**
+ * @brief Stop the running program. Outputs keep their current level.
+ */
+void light_effect_stop(void);
+
+/**
+ * @brief Whether a program is running.
+ */
+bool light_effect_running(void);
+
+/**
+ * @brief Accumulated wakeup statistics.
+ */
+void light_effect_get_stats(light_effect_stats_t *stats);
+
+/**
+ * @brief Average effect wakeups per minute of effect run time.
+ */
+uint32_t light_effect_wakeups_per_min(const light_effect_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
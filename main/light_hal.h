@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lp_sequencer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Thin hardware layer under light_driver.c. The firmware backend
+ * (light_hal_esp.c) maps it onto LEDC, RTC GPIO and esp_timer; the host
+ * backend (host/light_hal_mock.c) records every call on a simulated clock.
+ *
+ * Fade and timer callbacks, and the work function of light_hal_task_start(),
+ * all run on one light task, so the driver state needs no locking.
+ */
+
+/** maximum number of linear ranges in one hardware fade */
+#define LIGHT_HAL_FADE_RANGES_MAX   16
+/** maximum value of each light_hal_fade_range_t field */
+#define LIGHT_HAL_FADE_PARAM_MAX    1023
+
+/**
+ * One linear piece of a hardware fade: the duty moves by @c scale every
+ * @c cycle_num PWM periods, @c step_num times. A zero scale holds the duty.
+ */
+typedef struct {
+    uint16_t step_num;
+    uint16_t cycle_num;
+    uint16_t scale;
+    bool increase;
+} light_hal_fade_range_t;
+
+/** fade completion callback, runs on the light task */
+typedef void (*light_hal_fade_cb_t)(uint8_t channel, void *arg);
+
+/** one-shot software timer handle */
+typedef struct light_hal_timer_s *light_hal_timer_t;
+
+/** software timer callback, runs on the light task */
+typedef void (*light_hal_timer_cb_t)(void *arg);
+
+/** work function of the light task */
+typedef void (*light_hal_task_fn_t)(void);
+
+/**
+ * @brief Start the light task. Call before the first fade or timer.
+ *
+ * @param fn Run on the light task after every light_hal_task_wake()
+ * @return ESP_OK on success
+ */
+esp_err_t light_hal_task_start(light_hal_task_fn_t fn);
+
+/**
+ * @brief Have the light task run its work function soon. Any task; never blocks.
+ */
+void light_hal_task_wake(void);
+
+/**
+ * @brief Configure a PWM timer.
+ *
+ * @param timer           PWM timer number
+ * @param freq_hz         PWM frequency
+ * @param resolution_bits Duty resolution in bits
+ * @return ESP_OK on success
+ */
+esp_err_t light_hal_pwm_timer_config(uint8_t timer, uint32_t freq_hz, uint8_t resolution_bits);
+
+/**
+ * @brief Attach a PWM channel to a GPIO and a configured PWM timer.
+ *
+ * The channel keeps running in light sleep.
+ *
+ * @param channel PWM channel number
+ * @param gpio    Output GPIO
+ * @param timer   PWM timer number
+ * @param duty    Initial duty
+ * @param hpoint  Counter value at which the output turns on
+ * @return ESP_OK on success
+ */
+esp_err_t light_hal_pwm_channel_config(uint8_t channel, int gpio, uint8_t timer, uint32_t duty, uint32_t hpoint);
+
+/**
+ * @brief Set and latch a new PWM duty.
+ */
+void light_hal_pwm_set_duty(uint8_t channel, uint32_t duty);
+
+/**
+ * @brief Duty the channel currently outputs, including mid-fade.
+ */
+uint32_t light_hal_pwm_get_duty(uint8_t channel);
+
+/**
+ * @brief Stop PWM output and park the pin at @p idle_level.
+ */
+void light_hal_pwm_stop(uint8_t channel, uint32_t idle_level);
+
+/**
+ * @brief Pause the PWM timer counter.
+ */
+void light_hal_pwm_timer_pause(uint8_t timer);
+
+/**
+ * @brief Resume the PWM timer counter.
+ */
+void light_hal_pwm_timer_resume(uint8_t timer);
+
+/**
+ * @brief Install the hardware fade service. Call once before light_hal_pwm_fade().
+ */
+esp_err_t light_hal_pwm_fade_install(void);
+
+/**
+ * @brief Run a sequence of linear fade ranges on a channel entirely in hardware.
+ *
+ * The channel starts at @p start_duty and walks through @p ranges without
+ * CPU involvement. @p done (may be NULL) is called once when the last range
+ * has finished.
+ *
+ * @param channel    PWM channel number
+ * @param start_duty Duty at the start of the first range
+ * @param ranges     Fade ranges, at most LIGHT_HAL_FADE_RANGES_MAX
+ * @param count      Number of ranges
+ * @param done       Completion callback
+ * @param arg        Completion callback argument
+ * @return ESP_OK on success
+ */
+esp_err_t light_hal_pwm_fade(uint8_t channel, uint32_t start_duty, const light_hal_fade_range_t *ranges, size_t count,
+                             light_hal_fade_cb_t done, void *arg);
+
+/**
+ * @brief Abort a running fade; the channel keeps the duty it had reached. No callback is issued.
+ */
+void light_hal_pwm_fade_stop(uint8_t channel);
+
+/**
+ * @brief Configure @p gpio as an RTC output that survives light sleep.
+ */
+void light_hal_gpio_init(int gpio);
+
+/**
+ * @brief Drive an RTC output and latch it with the RTC GPIO hold.
+ */
+void light_hal_gpio_set(int gpio, bool level);
+
+/**
+ * @brief Hand @p gpio (set up with light_hal_gpio_init()) to the LP core and start it.
+ *
+ * The LP core plays the steps queued in light_hal_lp_seq() on the pin, waking
+ * only itself for each step, until light_hal_lp_seq_stop().
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without an LP core
+ */
+esp_err_t light_hal_lp_seq_start(int gpio);
+
+/**
+ * @brief Stop the LP core. The pin keeps its level until light_hal_gpio_set().
+ */
+void light_hal_lp_seq_stop(void);
+
+/**
+ * @brief The step queue shared with the LP core. Reset it only while the LP core is stopped.
+ */
+lp_seq_t *light_hal_lp_seq(void);
+
+/**
+ * @brief Create a one-shot software timer.
+ *
+ * @param[in]  cb    Callback, runs on the light task
+ * @param[in]  arg   Callback argument
+ * @param[in]  name  Timer name
+ * @param[out] out   Created timer
+ * @return ESP_OK on success
+ */
+esp_err_t light_hal_timer_create(light_hal_timer_cb_t cb, void *arg, const char *name, light_hal_timer_t *out);
+
+/**
+ * @brief (Re)arm a one-shot timer, replacing any pending expiry.
+ */
+void light_hal_timer_start_once(light_hal_timer_t timer, uint64_t timeout_us);
+
+/**
+ * @brief Disarm a timer. Stopping an idle timer is not an error.
+ */
+void light_hal_timer_stop(light_hal_timer_t timer);
+
+/**
+ * @brief Monotonic time in microseconds.
+ */
+int64_t light_hal_time_us(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
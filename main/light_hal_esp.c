@@ -0,0 +1,337 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "light_hal.h"
+#include "light_stats.h"
+#include "light_trace.h"
+#include <driver/rtc_io.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/ledc.h"
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+#include "ulp_lp_core.h"
+#include "ulp_lp_effect.h"
+
+extern const uint8_t lp_effect_bin_start[] asm("_binary_lp_effect_bin_start");
+extern const uint8_t lp_effect_bin_end[] asm("_binary_lp_effect_bin_end");
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+
+static const char *TAG = "LIGHT_HAL";
+
+#define LIGHT_HAL_TIMERS_MAX    8
+
+/*
+ * Light task stack. The deepest chain of this firmware's own code on it is a
+ * batch whose ramp ends at once and runs its done callback, which sets the
+ * attributes and switches the string off (driver_run > driver_fade_brightness
+ * > light_fade_done > zb_level_transition_done > zb_level_set_attributes >
+ * light_driver_set_power): 456 bytes by GCC's call graph stack info on a
+ * 64-bit host, less on the C6. The Zigbee lock, attribute and report calls of
+ * the callback, ESP_LOG and an interrupt frame come on top. Debug builds log
+ * every new low of the free stack, see light_task().
+ */
+#define LIGHT_HAL_TASK_STACK    3072
+
+typedef struct {
+    light_hal_fade_cb_t done;
+    void *arg;
+} fade_slot_t;
+
+struct light_hal_timer_s {
+    esp_timer_handle_t handle;
+    light_hal_timer_cb_t cb;
+    void *arg;
+    volatile bool pending;      /* expired, callback not run yet */
+};
+
+static fade_slot_t s_fade_slots[LEDC_CHANNEL_MAX];
+static uint32_t s_fade_pending;     /* channels whose fade has ended, one bit each */
+static struct light_hal_timer_s s_timers[LIGHT_HAL_TIMERS_MAX];
+static size_t s_timer_count;
+static TaskHandle_t s_task;
+static light_hal_task_fn_t s_task_fn;
+
+/* LEDC fade-end interrupt: flag the channel for the light task */
+static bool IRAM_ATTR fade_end_isr(const ledc_cb_param_t *param, void *user_arg)
+{
+    BaseType_t woken = pdFALSE;
+    if (param->event == LEDC_FADE_END_EVT) {
+        __atomic_fetch_or(&s_fade_pending, 1u << param->channel, __ATOMIC_RELEASE);
+        vTaskNotifyGiveFromISR(s_task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/* esp_timer task: flag the timer for the light task */
+static void timer_expired(void *arg)
+{
+    struct light_hal_timer_s *timer = arg;
+    timer->pending = true;
+    xTaskNotifyGive(s_task);
+}
+
+/* Fade ends, timer expiries and driver commands, one after the other */
+static void light_task(void *arg)
+{
+#if LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG
+    UBaseType_t stack_free_min = LIGHT_HAL_TASK_STACK;
+#endif
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t fades = __atomic_exchange_n(&s_fade_pending, 0, __ATOMIC_ACQUIRE);
+        while (fades) {
+            uint8_t channel = (uint8_t)__builtin_ctz(fades);
+            fades &= fades - 1;
+            fade_slot_t slot = s_fade_slots[channel];
+            if (slot.done) {
+                slot.done(channel, slot.arg);
+            }
+        }
+        for (size_t i = 0; i < s_timer_count; i++) {
+            if (s_timers[i].pending) {
+                s_timers[i].pending = false;
+                s_timers[i].cb(s_timers[i].arg);
+            }
+        }
+        s_task_fn();
+#if LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG
+        UBaseType_t stack_free = uxTaskGetStackHighWaterMark(NULL);
+        if (stack_free < stack_free_min) {
+            stack_free_min = stack_free;
+            ESP_LOGD(TAG, "Light task stack: %u of %d bytes never used", (unsigned)stack_free, LIGHT_HAL_TASK_STACK);
+        }
+#endif
+    }
+}
+
+esp_err_t light_hal_task_start(light_hal_task_fn_t fn)
+{
+    ESP_RETURN_ON_FALSE(!s_task, ESP_ERR_INVALID_STATE, TAG, "Light task already running");
+    s_task_fn = fn;
+    ESP_RETURN_ON_FALSE(xTaskCreate(light_task, "light", LIGHT_HAL_TASK_STACK, NULL, 6, &s_task) == pdPASS, ESP_ERR_NO_MEM, TAG,
+                        "Failed to create light task");
+    return ESP_OK;
+}
+
+void light_hal_task_wake(void)
+{
+    xTaskNotifyGive(s_task);
+}
+
+esp_err_t light_hal_pwm_timer_config(uint8_t timer, uint32_t freq_hz, uint8_t resolution_bits)
+{
+    const ledc_timer_config_t timer_cfg = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = (ledc_timer_bit_t)resolution_bits,
+        .timer_num = (ledc_timer_t)timer,
+        .freq_hz = freq_hz,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    return ledc_timer_config(&timer_cfg);
+}
+
+esp_err_t light_hal_pwm_channel_config(uint8_t channel, int gpio, uint8_t timer, uint32_t duty, uint32_t hpoint)
+{
+    const ledc_channel_config_t channel_cfg = {
+        .gpio_num = gpio,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel = (ledc_channel_t)channel,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = (ledc_timer_t)timer,
+        .duty = duty,
+        .hpoint = hpoint,
+        .sleep_mode = LEDC_SLEEP_MODE_KEEP_ALIVE
+    };
+    return ledc_channel_config(&channel_cfg);
+}
+
+void light_hal_pwm_set_duty(uint8_t channel, uint32_t duty)
+{
+    light_stats_ledc_activation();
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, duty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel);
+    light_trace_record(LIGHT_TRACE_LEDC_DUTY, channel);
+}
+
+uint32_t light_hal_pwm_get_duty(uint8_t channel)
+{
+    return ledc_get_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel);
+}
+
+void light_hal_pwm_stop(uint8_t channel, uint32_t idle_level)
+{
+    ledc_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, idle_level);
+}
+
+void light_hal_pwm_timer_pause(uint8_t timer)
+{
+    ledc_timer_pause(LEDC_LOW_SPEED_MODE, (ledc_timer_t)timer);
+}
+
+void light_hal_pwm_timer_resume(uint8_t timer)
+{
+    light_stats_ledc_activation();
+    ledc_timer_resume(LEDC_LOW_SPEED_MODE, (ledc_timer_t)timer);
+}
+
+esp_err_t light_hal_pwm_fade_install(void)
+{
+    static bool installed;
+
+    if (installed) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(ledc_fade_func_install(0), TAG, "Failed to install LEDC fade");
+    installed = true;
+    return ESP_OK;
+}
+
+esp_err_t light_hal_pwm_fade(uint8_t channel, uint32_t start_duty, const light_hal_fade_range_t *ranges, size_t count,
+                             light_hal_fade_cb_t done, void *arg)
+{
+#if SOC_LEDC_GAMMA_CURVE_FADE_SUPPORTED
+    ledc_fade_param_config_t params[LIGHT_HAL_FADE_RANGES_MAX];
+
+    ESP_RETURN_ON_FALSE(channel < LEDC_CHANNEL_MAX && count > 0 && count <= LIGHT_HAL_FADE_RANGES_MAX,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid fade on channel %d (%d ranges)", channel, (int)count);
+    for (size_t i = 0; i < count; i++) {
+        params[i] = (ledc_fade_param_config_t) {
+            .dir = ranges[i].increase ? 1 : 0,
+            .cycle_num = ranges[i].cycle_num,
+            .scale = ranges[i].scale,
+            .step_num = ranges[i].step_num,
+        };
+    }
+    s_fade_slots[channel] = (fade_slot_t) {
+        .done = done,
+        .arg = arg,
+    };
+    if (done) {
+        ledc_cbs_t cbs = {
+            .fade_cb = fade_end_isr,
+        };
+        ESP_RETURN_ON_ERROR(ledc_cb_register(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, &cbs, NULL), TAG,
+                            "Failed to register fade callback");
+    }
+    light_stats_ledc_activation();
+    light_trace_record(LIGHT_TRACE_LEDC_FADE, channel);
+    return ledc_set_multi_fade_and_start(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, start_duty, params, count,
+                                         LEDC_FADE_NO_WAIT);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void light_hal_pwm_fade_stop(uint8_t channel)
+{
+    s_fade_slots[channel].done = NULL;
+    ledc_fade_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel);
+    __atomic_fetch_and(&s_fade_pending, ~(1u << channel), __ATOMIC_RELAXED);
+}
+
+void light_hal_gpio_init(int gpio)
+{
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+    esp_sleep_pd_config(ESP_PD_DOMAIN_VDDSDIO, ESP_PD_OPTION_ON);
+
+    rtc_gpio_init(gpio);
+    rtc_gpio_set_direction(gpio, RTC_GPIO_MODE_OUTPUT_ONLY);
+    rtc_gpio_pulldown_dis(gpio);
+    rtc_gpio_pullup_dis(gpio);
+}
+
+void light_hal_gpio_set(int gpio, bool level)
+{
+    rtc_gpio_hold_dis(gpio);
+    rtc_gpio_set_level(gpio, level);
+    light_trace_record(LIGHT_TRACE_GPIO, level);
+    rtc_gpio_hold_en(gpio);
+}
+
+#if CONFIG_HALLOWEEN_EFFECT_LP_CORE
+esp_err_t light_hal_lp_seq_start(int gpio)
+{
+    static bool loaded;
+
+    if (!loaded) {
+        ESP_RETURN_ON_ERROR(ulp_lp_core_load_binary(lp_effect_bin_start, lp_effect_bin_end - lp_effect_bin_start),
+                            TAG, "LP core load failed");
+        loaded = true;
+    }
+    ulp_led_gpio = gpio;
+    /* the LP core drives the pin now, light_hal_gpio_set() holds it again afterwards */
+    rtc_gpio_hold_dis(gpio);
+    ulp_lp_core_cfg_t cfg = {
+        .wakeup_source = ULP_LP_CORE_WAKEUP_SOURCE_HP_CPU | ULP_LP_CORE_WAKEUP_SOURCE_LP_TIMER,
+    };
+    return ulp_lp_core_run(&cfg);
+}
+
+void light_hal_lp_seq_stop(void)
+{
+    ulp_lp_core_stop();
+}
+
+lp_seq_t *light_hal_lp_seq(void)
+{
+    return (lp_seq_t *)&ulp_seq;
+}
+#else
+esp_err_t light_hal_lp_seq_start(int gpio)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void light_hal_lp_seq_stop(void)
+{
+}
+
+lp_seq_t *light_hal_lp_seq(void)
+{
+    static lp_seq_t seq;
+    return &seq;
+}
+#endif //CONFIG_HALLOWEEN_EFFECT_LP_CORE
+
+esp_err_t light_hal_timer_create(light_hal_timer_cb_t cb, void *arg, const char *name, light_hal_timer_t *out)
+{
+    ESP_RETURN_ON_FALSE(s_timer_count < LIGHT_HAL_TIMERS_MAX, ESP_ERR_NO_MEM, TAG, "No timer left for %s", name);
+    struct light_hal_timer_s *timer = &s_timers[s_timer_count];
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_expired,
+        .arg = timer,
+        .name = name
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &timer->handle), TAG, "Failed to create timer %s", name);
+    timer->cb = cb;
+    timer->arg = arg;
+    s_timer_count++;
+    *out = timer;
+    return ESP_OK;
+}
+
+void light_hal_timer_start_once(light_hal_timer_t timer, uint64_t timeout_us)
+{
+    light_stats_timer_activation();
+    esp_timer_stop(timer->handle);
+    timer->pending = false;
+    esp_timer_start_once(timer->handle, timeout_us);
+}
+
+void light_hal_timer_stop(light_hal_timer_t timer)
+{
+    esp_timer_stop(timer->handle);
+    timer->pending = false;
+}
+
+int64_t light_hal_time_us(void)
+{
+    return esp_timer_get_time();
+}
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "light_state.h"
+
+#define STATE_NAMESPACE     "light"
+#define STATE_KEY           "state"
+#define STATE_VERSION       2
+#define STATE_CHANNELS_MAX  6       /* HALLOWEEN_LED_CHANNELS range */
+
+static const char *TAG = "LIGHT_STATE";
+
+/* as stored in NVS */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t effect;
+    uint8_t channels;
+    uint8_t on[STATE_CHANNELS_MAX];
+    uint8_t level[STATE_CHANNELS_MAX];
+} state_blob_t;
+
+/* version 1, single channel */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t on;
+    uint8_t level;
+    uint8_t effect;
+} state_blob_v1_t;
+
+_Static_assert(LIGHT_CHANNELS <= STATE_CHANNELS_MAX, "state blob too small for the LED channels");
+
+static bool state_equal(const light_state_t *a, const light_state_t *b)
+{
+    for (int i = 0; i < LIGHT_CHANNELS; i++) {
+        if (a->on[i] != b->on[i] || a->level[i] != b->level[i])
+            return false;
+    }
+    return a->effect == b->effect;
+}
+
+/* restore from a stored blob; a different channel count keeps what fits */
+static bool state_from_blob(const void *data, size_t size, light_state_t *state)
+{
+    const state_blob_v1_t *v1 = data;
+    const state_blob_t *blob = data;
+
+    if (size == sizeof(*v1) && v1->version == 1) {
+        state->on[0] = v1->on;
+        state->level[0] = v1->level;
+        state->effect = v1->effect;
+        return true;
+    }
+    if (size != sizeof(*blob) || blob->version != STATE_VERSION)
+        return false;
+    for (int i = 0; i < LIGHT_CHANNELS && i < blob->channels; i++) {
+        state->on[i] = blob->on[i];
+        state->level[i] = blob->level[i];
+    }
+    state->effect = blob->effect;
+    return true;
+}
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static light_state_t s_state = LIGHT_STATE_DEFAULT();  /* latest state */
+static light_state_t s_stored = LIGHT_STATE_DEFAULT(); /* what NVS holds */
+static esp_timer_handle_t s_commit_timer;
+static SemaphoreHandle_t s_commit_mutex;    /* the esp_timer and Zigbee tasks both commit */
+
+static void state_commit_cb(void *arg)
+{
+    light_state_commit();
+}
+
+esp_err_t light_state_load(light_state_t *state)
+{
+    light_state_t defaults = LIGHT_STATE_DEFAULT();
+    state_blob_t blob;
+    size_t size = sizeof(blob);
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    *state = defaults;
+    if (!s_commit_mutex) {
+        s_commit_mutex = xSemaphoreCreateMutex();
+        ESP_RETURN_ON_FALSE(s_commit_mutex, ESP_ERR_NO_MEM, TAG, "Failed to create commit mutex");
+    }
+    if (!s_commit_timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = state_commit_cb,
+            .name = "light_state",
+        };
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &s_commit_timer), TAG, "Failed to create commit timer");
+    }
+
+    err = nvs_open(STATE_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK) {
+        err = nvs_get_blob(handle, STATE_KEY, &blob, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_ERR_NOT_FOUND;
+    } else if (err == ESP_OK && !state_from_blob(&blob, size, state)) {
+        ESP_LOGW(TAG, "Ignoring stored state version %d", blob.version);
+        err = ESP_ERR_NOT_FOUND;
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Restored %s, level %d, effect %d (channel 0)", state->on[0] ? "on" : "off", state->level[0],
+                 state->effect);
+    } else if (err != ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "Failed to read stored state: %s", esp_err_to_name(err));
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_state = *state;
+    s_stored = *state;
+    portEXIT_CRITICAL(&s_lock);
+    return err;
+}
+
+static void state_changed(void)
+{
+    /* the first change arms the timer, later ones ride along with its commit */
+    if (s_commit_timer && !esp_timer_is_active(s_commit_timer)) {
+        esp_timer_start_once(s_commit_timer, CONFIG_HALLOWEEN_STATE_COMMIT_DELAY_MS * 1000ULL);
+    }
+}
+
+void light_state_set_power(uint8_t channel, bool on)
+{
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    portENTER_CRITICAL(&s_lock);
+    s_state.on[channel] = on;
+    portEXIT_CRITICAL(&s_lock);
+    state_changed();
+}
+
+void light_state_set_level(uint8_t channel, uint8_t level)
+{
+    if (channel >= LIGHT_CHANNELS)
+        return;
+    portENTER_CRITICAL(&s_lock);
+    s_state.level[channel] = level;
+    portEXIT_CRITICAL(&s_lock);
+    state_changed();
+}
+
+void light_state_set_effect(uint8_t effect)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_state.effect = effect;
+    portEXIT_CRITICAL(&s_lock);
+    state_changed();
+}
+
+static esp_err_t state_store(const light_state_t *state)
+{
+    nvs_handle_t handle;
+    state_blob_t blob = {
+        .version = STATE_VERSION,
+        .effect = state->effect,
+        .channels = LIGHT_CHANNELS,
+    };
+
+    for (int i = 0; i < LIGHT_CHANNELS; i++) {
+        blob.on[i] = state->on[i];
+        blob.level[i] = state->level[i];
+    }
+    ESP_RETURN_ON_ERROR(nvs_open(STATE_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS");
+    esp_err_t err = nvs_set_blob(handle, STATE_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to store state");
+    return ESP_OK;
+}
+
+esp_err_t light_state_commit(void)
+{
+    light_state_t state;
+    esp_err_t err = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(s_commit_mutex, ESP_ERR_INVALID_STATE, TAG, "State not loaded");
+    if (s_commit_timer) {
+        esp_timer_stop(s_commit_timer);
+    }
+    /* the snapshot is taken under the mutex too, so an older one never lands after a newer one */
+    xSemaphoreTake(s_commit_mutex, portMAX_DELAY);
+    portENTER_CRITICAL(&s_lock);
+    state = s_state;
+    portEXIT_CRITICAL(&s_lock);
+    if (!state_equal(&state, &s_stored)) {   /* equal: a burst that ended where it started */
+        err = state_store(&state);
+        if (err == ESP_OK) {
+            s_stored = state;
+        }
+    }
+    xSemaphoreGive(s_commit_mutex);
+    return err;
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "light_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** user-visible light state that survives a reboot */
+typedef struct {
+    bool on[LIGHT_CHANNELS];
+    uint8_t level[LIGHT_CHANNELS];  /* CurrentLevel, kept even when brightness is disabled */
+    uint8_t effect;                 /* LIGHT_DRIVER_EFFECT_* of channel 0 */
+} light_state_t;
+
+#if CONFIG_HALLOWEEN_BRIGHTNESS_ENABLE
+#define LIGHT_STATE_DEFAULT_LEVEL   LIGHT_DEFAULT_BRIGHTNESS
+#else
+#define LIGHT_STATE_DEFAULT_LEVEL   254
+#endif
+
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+#define LIGHT_STATE_DEFAULT_EFFECT  LIGHT_DRIVER_EFFECT_BLINK
+#else
+#define LIGHT_STATE_DEFAULT_EFFECT  LIGHT_DRIVER_EFFECT_NONE
+#endif
+
+/** state of a device that has never stored one */
+#define LIGHT_STATE_DEFAULT()                                                   \
+    {                                                                           \
+        .on = { [0 ... LIGHT_CHANNELS - 1] = LIGHT_DEFAULT_ON },                \
+        .level = { [0 ... LIGHT_CHANNELS - 1] = LIGHT_STATE_DEFAULT_LEVEL },    \
+        .effect = LIGHT_STATE_DEFAULT_EFFECT,                                   \
+    }
+
+/**
+ * @brief Load the stored state from NVS, nvs_flash_init() must have been called.
+ *
+ * @param[out] state Stored state, LIGHT_STATE_DEFAULT() when there is none
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NOT_FOUND: Nothing stored yet, @p state holds the defaults
+ *      - Others: NVS error, @p state holds the defaults
+ */
+esp_err_t light_state_load(light_state_t *state);
+
+/**
+ * @brief Record a new On/Off state of @p channel.
+ *
+ * Changes are committed to NVS CONFIG_HALLOWEEN_STATE_COMMIT_DELAY_MS after
+ * the first one, together with everything that changed in the meantime, and
+ * only if the result differs from what is stored.
+ */
+void light_state_set_power(uint8_t channel, bool on);
+
+/** @brief Record a new level of @p channel, committed like light_state_set_power(). */
+void light_state_set_level(uint8_t channel, uint8_t level);
+
+/** @brief Record a new effect, committed like light_state_set_power(). */
+void light_state_set_effect(uint8_t effect);
+
+/**
+ * @brief Commit a pending change right away, e.g. before a restart.
+ */
+esp_err_t light_state_commit(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "light_stats.h"
+#include "esp_attr.h"
+#include "esp_ieee802154.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+static light_stats_t s_stats;
+static int64_t s_awake_since_us;
+static int64_t s_sleep_enter_us;
+
+/* counters bumped from ISRs and several tasks, a relaxed atomic add is all they need */
+#define STATS_INC(field) __atomic_fetch_add(&s_stats.field, 1, __ATOMIC_RELAXED)
+
+static light_stats_wake_cause_t stats_wake_cause(void)
+{
+    switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return LIGHT_STATS_WAKE_TIMER;
+    case ESP_SLEEP_WAKEUP_GPIO:
+    case ESP_SLEEP_WAKEUP_EXT1:
+        return LIGHT_STATS_WAKE_GPIO;
+    case ESP_SLEEP_WAKEUP_UART:
+        return LIGHT_STATS_WAKE_UART;
+    case ESP_SLEEP_WAKEUP_UNDEFINED:
+        return LIGHT_STATS_WAKE_REJECTED;
+    default:
+        return LIGHT_STATS_WAKE_OTHER;
+    }
+}
+
+void light_stats_sleep_enter(void)
+{
+    s_sleep_enter_us = esp_timer_get_time();
+    s_stats.awake_us += s_sleep_enter_us - s_awake_since_us;
+}
+
+void light_stats_sleep_exit(void)
+{
+    light_stats_wake_cause_t cause = stats_wake_cause();
+
+    /* esp_timer keeps counting through light sleep, so this is wall time */
+    s_awake_since_us = esp_timer_get_time();
+    if (cause == LIGHT_STATS_WAKE_REJECTED) {
+        /* never slept: the time in between was awake too */
+        s_stats.awake_us += s_awake_since_us - s_sleep_enter_us;
+    }
+    STATS_INC(wakeups[cause]);
+}
+
+void IRAM_ATTR light_stats_ledc_activation(void)
+{
+    STATS_INC(ledc_activations);
+}
+
+void IRAM_ATTR light_stats_timer_activation(void)
+{
+    STATS_INC(timer_activations);
+}
+
+void light_stats_get(light_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->awake_us += esp_timer_get_time() - s_awake_since_us;
+}
+
+/*
+ * The Zigbee library drives the 802.15.4 driver directly. These wrappers
+ * (linked with -Wl,--wrap, see CMakeLists.txt) count its frames on the way
+ * through without touching the library.
+ */
+esp_err_t __real_esp_ieee802154_transmit(const uint8_t *frame, bool cca);
+esp_err_t __real_esp_ieee802154_transmit_at(const uint8_t *frame, bool cca, uint32_t time);
+void __real_esp_ieee802154_receive_done(uint8_t *frame, esp_ieee802154_frame_info_t *frame_info);
+
+esp_err_t IRAM_ATTR __wrap_esp_ieee802154_transmit(const uint8_t *frame, bool cca)
+{
+    STATS_INC(radio_tx);
+    return __real_esp_ieee802154_transmit(frame, cca);
+}
+
+esp_err_t IRAM_ATTR __wrap_esp_ieee802154_transmit_at(const uint8_t *frame, bool cca, uint32_t time)
+{
+    STATS_INC(radio_tx);
+    return __real_esp_ieee802154_transmit_at(frame, cca, time);
+}
+
+void IRAM_ATTR __wrap_esp_ieee802154_receive_done(uint8_t *frame, esp_ieee802154_frame_info_t *frame_info)
+{
+    STATS_INC(radio_rx);
+    __real_esp_ieee802154_receive_done(frame, frame_info);
+}
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** why the chip left light sleep */
+typedef enum {
+    LIGHT_STATS_WAKE_TIMER,     /* stack alarm, data poll, keep alive */
+    LIGHT_STATS_WAKE_GPIO,
+    LIGHT_STATS_WAKE_UART,
+    LIGHT_STATS_WAKE_OTHER,
+    LIGHT_STATS_WAKE_REJECTED,  /* sleep was refused, the chip stayed awake */
+    LIGHT_STATS_WAKE_CAUSE_MAX,
+} light_stats_wake_cause_t;
+
+typedef struct {
+    uint32_t wakeups[LIGHT_STATS_WAKE_CAUSE_MAX];
+    uint64_t awake_us;          /* time spent out of light sleep since boot */
+    uint32_t radio_tx;          /* 802.15.4 frames handed to the radio */
+    uint32_t radio_rx;          /* 802.15.4 frames received */
+    uint32_t ledc_activations;  /* LEDC duty updates, fades and timer resumes */
+    uint32_t timer_activations; /* esp_timer one-shots armed by the light */
+} light_stats_t;
+
+/**
+ * @brief Note that the chip is about to enter light sleep.
+ *
+ * Called right before esp_zb_sleep_now(), closes the current awake period.
+ */
+void light_stats_sleep_enter(void);
+
+/**
+ * @brief Note that light sleep has ended, reads the wakeup cause.
+ *
+ * Called right after esp_zb_sleep_now() returns, opens a new awake period.
+ */
+void light_stats_sleep_exit(void);
+
+/** @brief Count one LEDC activation. Safe from any context. */
+void light_stats_ledc_activation(void);
+
+/** @brief Count one esp_timer activation. Safe from any context. */
+void light_stats_timer_activation(void);
+
+/**
+ * @brief Snapshot of the counters, the awake time includes the running awake period.
+ */
+void light_stats_get(light_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
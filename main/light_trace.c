@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "light_trace.h"
+
+#if CONFIG_HALLOWEEN_TRACE_ENABLE
+#include <stdio.h>
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+#define TRACE_ENTRIES   CONFIG_HALLOWEEN_TRACE_ENTRIES
+#define TRACE_MASK      (TRACE_ENTRIES - 1)
+
+_Static_assert((TRACE_ENTRIES & TRACE_MASK) == 0, "CONFIG_HALLOWEEN_TRACE_ENTRIES must be a power of two");
+
+static light_trace_entry_t s_ring[TRACE_ENTRIES];
+static uint32_t s_head;         /* sequence number of the next entry */
+static uint16_t s_id;           /* trace id of the last LIGHT_TRACE_ACTION */
+
+/*
+ * A writer claims its slot with one atomic add and fills it in; writers never
+ * wait on each other or on a reader. A reader racing a writer on the same
+ * slot may see a half-written entry, acceptable for a trace.
+ */
+void IRAM_ATTR light_trace_record(light_trace_stage_t stage, uint8_t arg)
+{
+    uint16_t id = stage == LIGHT_TRACE_ACTION ? __atomic_add_fetch(&s_id, 1, __ATOMIC_RELAXED)
+                                              : __atomic_load_n(&s_id, __ATOMIC_RELAXED);
+    uint32_t seq = __atomic_fetch_add(&s_head, 1, __ATOMIC_RELAXED);
+
+    s_ring[seq & TRACE_MASK] = (light_trace_entry_t) {
+        .time_us = (uint32_t)esp_timer_get_time(),
+        .id = id,
+        .stage = stage,
+        .arg = arg,
+    };
+}
+
+size_t light_trace_read(uint32_t seq, light_trace_entry_t *out, size_t max, uint32_t *first)
+{
+    uint32_t head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+    uint32_t oldest = head > TRACE_ENTRIES ? head - TRACE_ENTRIES : 0;
+    size_t n = 0;
+
+    if (seq < oldest) {
+        seq = oldest;
+    }
+    *first = seq;
+    while (seq < head && n < max) {
+        out[n++] = s_ring[seq++ & TRACE_MASK];
+    }
+    return n;
+}
+
+void light_trace_dump(void)
+{
+    light_trace_entry_t entry;
+    uint32_t seq = 0;
+
+    while (light_trace_read(seq, &entry, 1, &seq) == 1) {
+        printf("TRACE,%lu,%lu,%u,%u,%u\n", (unsigned long)seq, (unsigned long)entry.time_us, entry.id, entry.stage,
+               entry.arg);
+        seq++;
+    }
+}
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** stages a Zigbee command goes through on its way to the LED */
+typedef enum {
+    LIGHT_TRACE_ACTION = 1,     /* zb_action_handler entered, starts a new trace id; arg = callback id */
+    LIGHT_TRACE_DISPATCH,       /* zb_attribute_handler / command handler dispatches; arg = cluster id */
+    LIGHT_TRACE_LEDC_DUTY,      /* ledc_update_duty; arg = channel */
+    LIGHT_TRACE_LEDC_FADE,      /* LEDC hardware fade started; arg = channel */
+    LIGHT_TRACE_GPIO,           /* rtc_gpio_set_level; arg = level */
+} light_trace_stage_t;
+
+/** one ring entry, also the wire format of a trace dump (little endian) */
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;   /* esp_timer time, low 32 bits */
+    uint16_t id;        /* trace id of the command being handled */
+    uint8_t stage;      /* light_trace_stage_t */
+    uint8_t arg;
+} light_trace_entry_t;
+
+#if CONFIG_HALLOWEEN_TRACE_ENABLE
+/**
+ * @brief Record a stage of the current command. Lock-free, no I/O.
+ *
+ * LIGHT_TRACE_ACTION opens a new trace id, every other stage is tagged with
+ * the id of the last action.
+ */
+void light_trace_record(light_trace_stage_t stage, uint8_t arg);
+
+/**
+ * @brief Copy entries out of the ring.
+ *
+ * @param[in]  seq   Sequence number of the first entry wanted (0 for the oldest)
+ * @param[out] out   Entries
+ * @param[in]  max   Room in @p out
+ * @param[out] first Sequence number of out[0], later than @p seq if those were overwritten
+ * @return Number of entries copied
+ */
+size_t light_trace_read(uint32_t seq, light_trace_entry_t *out, size_t max, uint32_t *first);
+
+/**
+ * @brief Print the whole ring to the console, one "TRACE,<seq>,<time_us>,<id>,<stage>,<arg>" line per entry.
+ *
+ * tools/trace_latency.py turns the output into latency percentiles.
+ */
+void light_trace_dump(void);
+#else
+static inline void light_trace_record(light_trace_stage_t stage, uint8_t arg) {}
+#endif //CONFIG_HALLOWEEN_TRACE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+/*
+ * LP core effect player: plays one step of the queue the HP core fills
+ * (see lp_sequencer.h) and sleeps on the LP timer until the next one.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ulp_lp_core_gpio.h"
+#include "ulp_lp_core_utils.h"
+#include "ulp_lp_core_lp_timer_shared.h"
+#include "lp_sequencer.h"
+
+/* poll period while the queue is empty */
+#define LP_EFFECT_IDLE_MS   100
+
+lp_seq_t seq;
+uint32_t led_gpio;
+
+int main(void)
+{
+    bool pin;
+    uint32_t ms = lp_seq_next(&seq, &pin);
+
+    if (ms) {
+        ulp_lp_core_gpio_set_level((lp_io_num_t)led_gpio, pin);
+    }
+    ulp_lp_core_lp_timer_set_wakeup_time((uint64_t)(ms ? ms : LP_EFFECT_IDLE_MS) * 1000);
+    /* returning halts the core until the LP timer wakes it */
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "lp_sequencer.h"
+
+#define LP_SEQ_MASK (LP_SEQ_STEPS - 1)
+
+void lp_seq_reset(lp_seq_t *seq, bool loop, bool invert)
+{
+    seq->head = 0;
+    seq->tail = 0;
+    seq->loop = loop;
+    seq->invert = invert;
+}
+
+uint32_t lp_seq_free(const lp_seq_t *seq)
+{
+    if (seq->loop)
+        return LP_SEQ_STEPS - seq->head;
+    return LP_SEQ_STEPS - (seq->head - seq->tail);
+}
+
+bool lp_seq_push(lp_seq_t *seq, bool on, uint32_t ms)
+{
+    uint32_t slots = ms > LP_SEQ_STEP_MS_MAX ? (ms + LP_SEQ_STEP_MS_MAX - 1) / LP_SEQ_STEP_MS_MAX : 1;
+    if (slots > lp_seq_free(seq))
+        return false;
+
+    uint32_t head = seq->head;
+    do {
+        uint32_t step_ms = ms > LP_SEQ_STEP_MS_MAX ? LP_SEQ_STEP_MS_MAX : ms;
+        seq->steps[head & LP_SEQ_MASK] = (lp_seq_step_t) { .ms = (uint16_t)(step_ms ? step_ms : 1), .on = on };
+        ms -= step_ms;
+        head++;
+    } while (ms);
+    /* the steps must be in memory before the LP core sees the new head */
+    __sync_synchronize();
+    seq->head = head;
+    return true;
+}
+
+uint32_t lp_seq_queued_ms(const lp_seq_t *seq)
+{
+    uint32_t ms = 0;
+    uint32_t from = seq->loop ? 0 : seq->tail;
+    for (uint32_t i = from; i != seq->head; i++)
+        ms += seq->steps[i & LP_SEQ_MASK].ms;
+    return ms;
+}
+
+uint32_t lp_seq_next(lp_seq_t *seq, bool *pin)
+{
+    uint32_t head = seq->head;
+    uint32_t index;
+
+    if (seq->loop) {
+        if (head == 0)
+            return 0;
+        index = seq->tail % head;
+        seq->tail = index + 1;
+    } else {
+        if (seq->tail == head)
+            return 0;
+        index = seq->tail & LP_SEQ_MASK;
+    }
+    __sync_synchronize();
+    const lp_seq_step_t step = seq->steps[index];
+    if (!seq->loop)
+        seq->tail++;
+    *pin = step.on ? !seq->invert : seq->invert;
+    return step.ms;
+}
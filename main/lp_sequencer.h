@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * On/off step queue between the HP core, which turns effect keyframes into
+ * steps, and the LP core, which plays them on an RTC GPIO while the HP core
+ * sleeps. Built into both firmwares (and the host), so it only uses plain C.
+ * The HP core only writes head, the LP core only writes tail.
+ */
+
+/** queue length, a power of two */
+#define LP_SEQ_STEPS        32
+/** longest step, longer ones are queued as several */
+#define LP_SEQ_STEP_MS_MAX  0xffff
+
+typedef struct {
+    uint16_t ms;
+    uint8_t on;
+    uint8_t reserved;
+} lp_seq_step_t;
+
+typedef struct {
+    volatile uint32_t head;     /* steps queued */
+    volatile uint32_t tail;     /* steps played */
+    uint32_t loop;              /* replay steps [0, head) forever instead of consuming them */
+    uint32_t invert;            /* the LED is on with the pin low */
+    lp_seq_step_t steps[LP_SEQ_STEPS];
+} lp_seq_t;
+
+/**
+ * @brief Empty the queue. HP core, with the LP core stopped.
+ *
+ * @param seq    Queue
+ * @param loop   Play the queued steps over and over (a looping program that fits the queue)
+ * @param invert Pin level for on is low
+ */
+void lp_seq_reset(lp_seq_t *seq, bool loop, bool invert);
+
+/**
+ * @brief Queue a step (HP core). Steps longer than LP_SEQ_STEP_MS_MAX take several slots.
+ *
+ * @return false when there is not enough room; nothing is queued then
+ */
+bool lp_seq_push(lp_seq_t *seq, bool on, uint32_t ms);
+
+/**
+ * @brief Free slots.
+ */
+uint32_t lp_seq_free(const lp_seq_t *seq);
+
+/**
+ * @brief Total duration of the steps not played yet, in ms. A looping queue reports one round.
+ */
+uint32_t lp_seq_queued_ms(const lp_seq_t *seq);
+
+/**
+ * @brief Take the next step (LP core).
+ *
+ * @param[in]  seq  Queue
+ * @param[out] pin  Pin level to drive for the step
+ * @return Step duration in ms, 0 when the queue is empty (@p pin is not set then)
+ */
+uint32_t lp_seq_next(lp_seq_t *seq, bool *pin);
+
+#ifdef __cplusplus
+}
+#endif
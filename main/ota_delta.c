@@ -0,0 +1,246 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <string.h>
+#include "ota_delta.h"
+
+enum {
+    DELTA_HEADER,
+    DELTA_TOKEN,
+    DELTA_LEN_EXT,
+    DELTA_ARG,
+    DELTA_LITERAL,
+    DELTA_DONE,
+    DELTA_ERROR,
+};
+
+/* one nibble at a time, 64 bytes of table */
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+uint32_t ota_delta_crc32(uint32_t crc, const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0f];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void ota_delta_init(ota_delta_t *delta, const ota_delta_io_t *io)
+{
+    memset(delta, 0, offsetof(ota_delta_t, buf));
+    delta->io = *io;
+    delta->state = DELTA_HEADER;
+}
+
+bool ota_delta_done(const ota_delta_t *delta)
+{
+    return delta->state == DELTA_DONE;
+}
+
+/* Append to the new image, writing the buffer out when it fills and at the end */
+static esp_err_t delta_out(ota_delta_t *delta, const uint8_t *data, size_t len)
+{
+    delta->crc = ota_delta_crc32(delta->crc, data, len);
+    delta->out_pos += len;
+    while (len > 0) {
+        size_t n = OTA_DELTA_BUF_LEN - delta->buf_len;
+        n = n < len ? n : len;
+        memcpy(&delta->buf[delta->buf_len], data, n);
+        delta->buf_len += n;
+        data += n;
+        len -= n;
+        if (delta->buf_len == OTA_DELTA_BUF_LEN || delta->out_pos == delta->new_size) {
+            esp_err_t err = delta->io.write(delta->io.ctx, delta->buf, delta->buf_len);
+            if (err != ESP_OK)
+                return err;
+            delta->buf_len = 0;
+        }
+    }
+    if (delta->out_pos == delta->new_size) {
+        if (delta->crc != delta->new_crc)
+            return ESP_ERR_INVALID_CRC;
+        delta->state = DELTA_DONE;
+    }
+    return ESP_OK;
+}
+
+/* The reference has to be the very image the stream was made against; the output buffer is still empty */
+static esp_err_t delta_header(ota_delta_t *delta)
+{
+    uint32_t crc = 0;
+
+    if (get_u32(&delta->header[0]) != OTA_DELTA_MAGIC)
+        return ESP_ERR_INVALID_VERSION;
+    delta->new_size = get_u32(&delta->header[4]);
+    delta->new_crc = get_u32(&delta->header[8]);
+    delta->old_size = get_u32(&delta->header[12]);
+    if (delta->new_size == 0)
+        return ESP_ERR_INVALID_SIZE;
+    if (delta->old_size == 0)
+        return ESP_OK;
+    if (!delta->io.read_old)
+        return ESP_ERR_INVALID_CRC;
+    for (uint32_t offset = 0; offset < delta->old_size; offset += OTA_DELTA_BUF_LEN) {
+        uint32_t n = delta->old_size - offset < OTA_DELTA_BUF_LEN ? delta->old_size - offset : OTA_DELTA_BUF_LEN;
+        esp_err_t err = delta->io.read_old(delta->io.ctx, offset, delta->buf, n);
+        if (err != ESP_OK)
+            return err;
+        crc = ota_delta_crc32(crc, delta->buf, n);
+    }
+    return crc == get_u32(&delta->header[16]) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+/* Copy from what has been produced, @p distance back; the part still in the buffer comes from RAM */
+static esp_err_t delta_copy_out(ota_delta_t *delta, uint32_t distance)
+{
+    uint8_t chunk[OTA_DELTA_CHUNK];
+
+    if (distance == 0 || distance > delta->out_pos)
+        return ESP_ERR_INVALID_SIZE;
+    while (delta->len > 0) {
+        uint32_t from = delta->out_pos - distance;
+        uint32_t written = delta->out_pos - delta->buf_len;
+        /* never more than the distance, an overlapping copy repeats what it has just produced */
+        uint32_t n = delta->len < distance ? delta->len : distance;
+        n = n < OTA_DELTA_CHUNK ? n : OTA_DELTA_CHUNK;
+        if (from < written) {
+            n = n < written - from ? n : written - from;
+            esp_err_t err = delta->io.read_out(delta->io.ctx, from, chunk, n);
+            if (err != ESP_OK)
+                return err;
+        } else {
+            memcpy(chunk, &delta->buf[from - written], n);
+        }
+        delta->len -= n;
+        esp_err_t err = delta_out(delta, chunk, n);
+        if (err != ESP_OK)
+            return err;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t delta_copy_old(ota_delta_t *delta, uint32_t zigzag)
+{
+    uint8_t chunk[OTA_DELTA_CHUNK];
+    int64_t from = (int64_t)delta->old_pos + (int32_t)((zigzag >> 1) ^ -(zigzag & 1));
+
+    if (!delta->io.read_old || from < 0 || from + delta->len > delta->old_size)
+        return ESP_ERR_INVALID_SIZE;
+    delta->old_pos = (uint32_t)from + delta->len;
+    while (delta->len > 0) {
+        uint32_t n = delta->len < OTA_DELTA_CHUNK ? delta->len : OTA_DELTA_CHUNK;
+        esp_err_t err = delta->io.read_old(delta->io.ctx, (uint32_t)from, chunk, n);
+        if (err != ESP_OK)
+            return err;
+        from += n;
+        delta->len -= n;
+        err = delta_out(delta, chunk, n);
+        if (err != ESP_OK)
+            return err;
+    }
+    return ESP_OK;
+}
+
+/* Length of the token known: a literal reads its bytes next, a copy its argument */
+static esp_err_t delta_token_len(ota_delta_t *delta)
+{
+    delta->len += delta->op == OTA_DELTA_OP_LITERAL ? 1 : OTA_DELTA_MIN_MATCH;
+    if (delta->len > delta->new_size - delta->out_pos)
+        return ESP_ERR_INVALID_SIZE;
+    delta->state = delta->op == OTA_DELTA_OP_LITERAL ? DELTA_LITERAL : DELTA_ARG;
+    delta->value = 0;
+    delta->shift = 0;
+    return ESP_OK;
+}
+
+/* Add a varint byte, true once the last one is in */
+static bool delta_varint(ota_delta_t *delta, uint8_t byte, esp_err_t *err)
+{
+    if (delta->shift > 28 || (delta->shift == 28 && (byte & 0x70))) {
+        *err = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+    delta->value |= (uint32_t)(byte & 0x7f) << delta->shift;
+    delta->shift += 7;
+    return !(byte & 0x80);
+}
+
+esp_err_t ota_delta_feed(ota_delta_t *delta, const uint8_t *data, size_t len)
+{
+    esp_err_t err = ESP_OK;
+    size_t i = 0;
+
+    if (delta->state == DELTA_ERROR)
+        return ESP_ERR_INVALID_STATE;
+    while (i < len && err == ESP_OK) {
+        switch (delta->state) {
+        case DELTA_HEADER:
+            delta->header[delta->header_len++] = data[i++];
+            if (delta->header_len == OTA_DELTA_HEADER_LEN) {
+                err = delta_header(delta);
+                delta->state = DELTA_TOKEN;
+            }
+            break;
+        case DELTA_TOKEN:
+            delta->op = data[i] >> 6;
+            delta->len = data[i++] & 0x3f;
+            if (delta->op > OTA_DELTA_OP_COPY_OLD)
+                err = ESP_ERR_INVALID_VERSION;
+            else if (delta->len == OTA_DELTA_LEN_EXT) {
+                delta->state = DELTA_LEN_EXT;
+                delta->value = 0;
+                delta->shift = 0;
+            } else
+                err = delta_token_len(delta);
+            break;
+        case DELTA_LEN_EXT:
+            if (delta_varint(delta, data[i++], &err)) {
+                if (delta->value > UINT32_MAX - OTA_DELTA_LEN_EXT - OTA_DELTA_MIN_MATCH)
+                    err = ESP_ERR_INVALID_SIZE;
+                else {
+                    delta->len += delta->value;
+                    err = delta_token_len(delta);
+                }
+            }
+            break;
+        case DELTA_ARG:
+            if (delta_varint(delta, data[i++], &err)) {
+                delta->state = DELTA_TOKEN;
+                err = delta->op == OTA_DELTA_OP_COPY_OUT ? delta_copy_out(delta, delta->value)
+                                                         : delta_copy_old(delta, delta->value);
+            }
+            break;
+        case DELTA_LITERAL: {
+            size_t n = len - i < delta->len ? len - i : delta->len;
+            delta->len -= n;
+            if (delta->len == 0)
+                delta->state = DELTA_TOKEN;
+            err = delta_out(delta, &data[i], n);
+            i += n;
+            break;
+        }
+        default:
+            /* the image is complete, nothing may follow */
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+    }
+    if (err != ESP_OK)
+        delta->state = DELTA_ERROR;
+    return err;
+}
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming decoder of compressed and delta-coded firmware images. The
+ * stream is a header and a sequence of tokens, each of which appends to the
+ * new image:
+ *
+ *   literal    the next bytes of the stream
+ *   copy out   bytes already produced, a distance back
+ *   copy old   bytes of the image the device runs (the reference of a delta)
+ *
+ * Without a reference it is plain LZ77 compression. A copy can reach back
+ * to the start of the new image: everything but the last OTA_DELTA_BUF_LEN
+ * bytes is read back from where it was written, so the decoder needs no
+ * window in RAM. It takes the stream in chunks of any size, e.g. one OTA
+ * block at a time. Pure C, built on the host as well (host/ota_bench).
+ *
+ * Header, little endian:
+ *   U32 magic "HZD1", U32 new size, U32 new CRC-32, U32 reference size (0 for none), U32 reference CRC-32
+ * Token byte: op in the top 2 bits, n in the low 6 bits, n = 63 is followed by a varint (LEB128) added to it.
+ *   op 0: literal of n + 1 bytes, which follow
+ *   op 1: copy out of n + OTA_DELTA_MIN_MATCH bytes, then varint distance (>= 1)
+ *   op 2: copy old of n + OTA_DELTA_MIN_MATCH bytes, then zigzag varint offset from the end of the previous copy old
+ */
+
+/** tag of the element of a Zigbee OTA file that carries a stream (manufacturer-specific range) */
+#define OTA_DELTA_ELEMENT_TAG   0xF000
+#define OTA_DELTA_MAGIC         0x31445a48  /* "HZD1" */
+#define OTA_DELTA_HEADER_LEN    20
+#define OTA_DELTA_MIN_MATCH     4
+#define OTA_DELTA_LEN_EXT       63          /* n that is followed by a varint */
+/** output staging buffer, written out whole */
+#define OTA_DELTA_BUF_LEN       1024
+/** copies move this much at a time through the stack */
+#define OTA_DELTA_CHUNK         64
+
+typedef enum {
+    OTA_DELTA_OP_LITERAL,
+    OTA_DELTA_OP_COPY_OUT,
+    OTA_DELTA_OP_COPY_OLD,
+} ota_delta_op_t;
+
+typedef struct {
+    /** read the reference image, NULL when there is none */
+    esp_err_t (*read_old)(void *ctx, uint32_t offset, void *buf, size_t len);
+    /** read back what write() has been given */
+    esp_err_t (*read_out)(void *ctx, uint32_t offset, void *buf, size_t len);
+    /** append to the new image */
+    esp_err_t (*write)(void *ctx, const void *buf, size_t len);
+    void *ctx;
+} ota_delta_io_t;
+
+typedef struct {
+    ota_delta_io_t io;
+    uint8_t state;
+    uint8_t op;                     /* ota_delta_op_t of the current token */
+    uint8_t shift;                  /* of the varint being read */
+    uint8_t header_len;
+    uint8_t header[OTA_DELTA_HEADER_LEN];
+    uint32_t value;                 /* varint being read */
+    uint32_t len;                   /* bytes the current token has still to produce */
+    uint32_t new_size;
+    uint32_t new_crc;
+    uint32_t old_size;
+    uint32_t old_pos;               /* end of the previous copy old */
+    uint32_t out_pos;               /* bytes produced */
+    uint32_t crc;                   /* of the bytes produced */
+    uint16_t buf_len;
+    uint8_t buf[OTA_DELTA_BUF_LEN]; /* the last bytes produced, not written yet */
+} ota_delta_t;
+
+/**
+ * @brief Start decoding a stream.
+ */
+void ota_delta_init(ota_delta_t *delta, const ota_delta_io_t *io);
+
+/**
+ * @brief Decode the next @p len bytes of the stream.
+ *
+ * The reference is checked against its CRC as soon as the header is in.
+ * Once the last byte of the new image is produced it is written out and its
+ * CRC checked.
+ *
+ * @return
+ *      - ESP_OK: On success, more may follow
+ *      - ESP_ERR_INVALID_VERSION: Not a stream of this format
+ *      - ESP_ERR_INVALID_CRC: Reference is not the image the stream was made against, or the new image is corrupt
+ *      - ESP_ERR_INVALID_SIZE: Stream reaches outside of either image, or goes on after the end
+ *      - Others: Error of an io callback; the decoder stops at the first error
+ */
+esp_err_t ota_delta_feed(ota_delta_t *delta, const uint8_t *data, size_t len);
+
+/**
+ * @brief Whether the whole new image has been produced, written and checked.
+ */
+bool ota_delta_done(const ota_delta_t *delta);
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as zlib), start with 0.
+ */
+uint32_t ota_delta_crc32(uint32_t crc, const void *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
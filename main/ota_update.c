@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "ota_delta.h"
+#include "ota_update.h"
+
+#define OTA_TAG_UPGRADE_IMAGE   0x0000
+#define OTA_ELEMENT_HEADER_LEN  6           /* U16 tag, U32 length */
+
+#if CONFIG_HALLOWEEN_OTA_ENABLE || CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE
+static const char *TAG = "OTA";
+#endif
+
+#if CONFIG_HALLOWEEN_OTA_ENABLE
+typedef struct {
+    const esp_partition_t *running;
+    const esp_partition_t *next;
+    esp_ota_handle_t handle;
+    uint8_t header[OTA_ELEMENT_HEADER_LEN];
+    uint8_t header_len;
+    uint16_t tag;
+    uint32_t element_len;
+    uint32_t received;                      /* of the element */
+    uint32_t written;                       /* to the next partition */
+    ota_delta_t delta;
+} ota_update_t;
+
+/* only allocated while an update runs */
+static ota_update_t *s_ota;
+
+static esp_err_t ota_read_old(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    ota_update_t *ota = ctx;
+    return esp_partition_read(ota->running, offset, buf, len);
+}
+
+static esp_err_t ota_read_out(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    ota_update_t *ota = ctx;
+    return esp_partition_read(ota->next, offset, buf, len);
+}
+
+static esp_err_t ota_write(void *ctx, const void *buf, size_t len)
+{
+    ota_update_t *ota = ctx;
+    ESP_RETURN_ON_ERROR(esp_ota_write(ota->handle, buf, len), TAG, "Failed to write %u bytes at 0x%" PRIx32,
+                        (unsigned)len, ota->written);
+    ota->written += len;
+    return ESP_OK;
+}
+
+esp_err_t ota_update_begin(uint32_t image_size)
+{
+    ESP_RETURN_ON_FALSE(!s_ota, ESP_ERR_INVALID_STATE, TAG, "Update already running");
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+    ESP_RETURN_ON_FALSE(next, ESP_ERR_NOT_FOUND, TAG, "No OTA partition");
+    s_ota = calloc(1, sizeof(*s_ota));
+    ESP_RETURN_ON_FALSE(s_ota, ESP_ERR_NO_MEM, TAG, "No memory for the update");
+    s_ota->running = running;
+    s_ota->next = next;
+    /* sequential writes erase sector by sector on the way, no long erase up front */
+    esp_err_t err = esp_ota_begin(next, OTA_WITH_SEQUENTIAL_WRITES, &s_ota->handle);
+    if (err != ESP_OK) {
+        free(s_ota);
+        s_ota = NULL;
+        ESP_RETURN_ON_ERROR(err, TAG, "Failed to begin update of %s", next->label);
+    }
+    ESP_LOGI(TAG, "Update of %" PRIu32 " bytes into %s", image_size, next->label);
+    return ESP_OK;
+}
+
+/* The element header is in: the tag says how the rest gets to the partition */
+static esp_err_t ota_element_start(ota_update_t *ota)
+{
+    ota->tag = ota->header[0] | ota->header[1] << 8;
+    ota->element_len = ota->header[2] | ota->header[3] << 8 | (uint32_t)ota->header[4] << 16 |
+                       (uint32_t)ota->header[5] << 24;
+    ESP_RETURN_ON_FALSE(ota->element_len <= ota->next->size || ota->tag == OTA_DELTA_ELEMENT_TAG, ESP_ERR_INVALID_SIZE,
+                        TAG, "Image of %" PRIu32 " bytes does not fit", ota->element_len);
+    switch (ota->tag) {
+    case OTA_TAG_UPGRADE_IMAGE:
+        return ESP_OK;
+    case OTA_DELTA_ELEMENT_TAG: {
+        const ota_delta_io_t io = {
+            .read_old = ota_read_old,
+            .read_out = ota_read_out,
+            .write = ota_write,
+            .ctx = ota,
+        };
+        ota_delta_init(&ota->delta, &io);
+        return ESP_OK;
+    }
+    default:
+        ESP_LOGE(TAG, "Unknown element tag 0x%04x", ota->tag);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+esp_err_t ota_update_write(const uint8_t *data, size_t len)
+{
+    ESP_RETURN_ON_FALSE(s_ota, ESP_ERR_INVALID_STATE, TAG, "No update running");
+    while (len > 0 && s_ota->header_len < OTA_ELEMENT_HEADER_LEN) {
+        s_ota->header[s_ota->header_len++] = *data++;
+        len--;
+        if (s_ota->header_len == OTA_ELEMENT_HEADER_LEN)
+            ESP_RETURN_ON_ERROR(ota_element_start(s_ota), TAG, "Invalid element");
+    }
+    /* anything after the element, e.g. a signature, is not used */
+    len = len < s_ota->element_len - s_ota->received ? len : s_ota->element_len - s_ota->received;
+    if (len == 0)
+        return ESP_OK;
+    s_ota->received += len;
+    if (s_ota->tag == OTA_DELTA_ELEMENT_TAG) {
+        esp_err_t err = ota_delta_feed(&s_ota->delta, data, len);
+        if (err == ESP_ERR_INVALID_CRC && s_ota->written == 0)
+            ESP_LOGE(TAG, "Delta made against another image than the running one");
+        return err;
+    }
+    return ota_write(s_ota, data, len);
+}
+
+esp_err_t ota_update_check(void)
+{
+    ESP_RETURN_ON_FALSE(s_ota, ESP_ERR_INVALID_STATE, TAG, "No update running");
+    ESP_RETURN_ON_FALSE(s_ota->header_len == OTA_ELEMENT_HEADER_LEN && s_ota->received == s_ota->element_len,
+                        ESP_ERR_INVALID_SIZE, TAG, "Image incomplete, %" PRIu32 " of %" PRIu32 " bytes", s_ota->received,
+                        s_ota->element_len);
+    ESP_RETURN_ON_FALSE(s_ota->tag != OTA_DELTA_ELEMENT_TAG || ota_delta_done(&s_ota->delta), ESP_ERR_INVALID_SIZE,
+                        TAG, "Stream ended before the image");
+    /* esp_ota_end() checks the app image itself, its hash included */
+    esp_err_t err = esp_ota_end(s_ota->handle);
+    s_ota->handle = 0;
+    ESP_RETURN_ON_ERROR(err, TAG, "Invalid image");
+    ESP_LOGI(TAG, "Image of %" PRIu32 " bytes from %" PRIu32 " received", s_ota->written, s_ota->received);
+    return ESP_OK;
+}
+
+esp_err_t ota_update_finish(void)
+{
+    ESP_RETURN_ON_FALSE(s_ota && !s_ota->handle, ESP_ERR_INVALID_STATE, TAG, "No checked update");
+    esp_err_t err = esp_ota_set_boot_partition(s_ota->next);
+    free(s_ota);
+    s_ota = NULL;
+    return err;
+}
+
+bool ota_update_running(void)
+{
+    return s_ota != NULL;
+}
+
+void ota_update_abort(void)
+{
+    if (!s_ota)
+        return;
+    if (s_ota->handle)
+        esp_ota_abort(s_ota->handle);
+    ESP_LOGW(TAG, "Update aborted after %" PRIu32 " bytes", s_ota->received);
+    free(s_ota);
+    s_ota = NULL;
+}
+#endif //CONFIG_HALLOWEEN_OTA_ENABLE
+
+/* also without OTA support: an image built without it may still have been installed over the air */
+void ota_update_confirm(void)
+{
+#if CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE
+    esp_ota_img_states_t state;
+
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGI(TAG, "New image is back on the network, keeping it");
+        esp_ota_mark_app_valid_cancel_rollback();
+    }
+#endif
+}
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Writes the image of a Zigbee OTA upgrade into the app partition that is
+ * not running, block by block as the OTA Upgrade client receives them. The
+ * file carries one element: tag 0x0000 is the application image as is,
+ * OTA_DELTA_ELEMENT_TAG the image compressed or delta-coded against the
+ * running one (host/ota_pack), decoded on the fly by ota_delta.c.
+ */
+
+/**
+ * @brief Start an update into the next OTA partition.
+ *
+ * @param image_size Size of the upgrade image as the OTA client announced it
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_STATE: An update is running already
+ *      - ESP_ERR_NOT_FOUND: No partition to update into
+ *      - Others: Error of esp_ota_begin()
+ */
+esp_err_t ota_update_begin(uint32_t image_size);
+
+/**
+ * @brief Take the next block of the upgrade image, the element header may be split over blocks.
+ *
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NOT_SUPPORTED: Unknown element tag
+ *      - ESP_ERR_INVALID_CRC: Delta made against another image than the running one, or corrupt image
+ *      - Others: Error of the decoder or of the flash write; the update has to be aborted
+ */
+esp_err_t ota_update_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief The whole image has been received: check it is complete and valid.
+ */
+esp_err_t ota_update_check(void);
+
+/**
+ * @brief Boot the new image at the next restart, after ota_update_check().
+ */
+esp_err_t ota_update_finish(void);
+
+/**
+ * @brief Whether an update is being downloaded.
+ */
+bool ota_update_running(void);
+
+/**
+ * @brief Give up the running update, if any.
+ */
+void ota_update_abort(void);
+
+/**
+ * @brief Keep the running image: with rollback enabled, a new image that never gets here is replaced by the previous
+ *        one at the next reset. Call once the light is back on the network.
+ */
+void ota_update_confirm(void);
+
+#ifdef __cplusplus
+}
+#endif
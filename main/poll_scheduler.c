@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "poll_scheduler.h"
+
+void poll_scheduler_init(poll_scheduler_t *sched, uint32_t fast_ms, uint32_t idle_ms, uint32_t fast_window_ms,
+                         uint8_t polls_per_step)
+{
+    *sched = (poll_scheduler_t) {
+        .fast_ms = fast_ms ? fast_ms : 1,
+        .idle_ms = idle_ms > fast_ms ? idle_ms : fast_ms,
+        .fast_window_ms = fast_window_ms,
+        .polls_per_step = polls_per_step ? polls_per_step : 1,
+    };
+    sched->interval_ms = sched->idle_ms;
+}
+
+uint32_t poll_scheduler_activity(poll_scheduler_t *sched)
+{
+    sched->interval_ms = sched->fast_ms;
+    return sched->fast_window_ms ? sched->fast_window_ms : sched->fast_ms;
+}
+
+uint32_t poll_scheduler_step(poll_scheduler_t *sched)
+{
+    if (sched->interval_ms >= sched->idle_ms / 2) {
+        sched->interval_ms = sched->idle_ms;
+        return 0;
+    }
+    sched->interval_ms *= 2;
+    return sched->interval_ms * sched->polls_per_step;
+}
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Poll interval of the sleepy end device: fast right after activity, then
+ * doubling step by step back to the idle interval.
+ */
+typedef struct {
+    uint32_t fast_ms;           /* interval while interactive */
+    uint32_t idle_ms;           /* interval when nothing happens */
+    uint32_t fast_window_ms;    /* how long to stay fast after activity */
+    uint8_t polls_per_step;     /* polls at each interval before doubling it */
+    uint32_t interval_ms;       /* current interval */
+} poll_scheduler_t;
+
+/**
+ * @brief Set up a scheduler that starts at the idle interval.
+ */
+void poll_scheduler_init(poll_scheduler_t *sched, uint32_t fast_ms, uint32_t idle_ms, uint32_t fast_window_ms,
+                         uint8_t polls_per_step);
+
+/**
+ * @brief Something happened (command received, button pressed): poll fast.
+ *
+ * @return Delay until poll_scheduler_step() should be called
+ */
+uint32_t poll_scheduler_activity(poll_scheduler_t *sched);
+
+/**
+ * @brief Back off one step: double the interval, up to the idle interval.
+ *
+ * @return Delay until the next step, 0 once the idle interval is reached
+ */
+uint32_t poll_scheduler_step(poll_scheduler_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_HALLOWEEN_SCENES_ENABLE
+#include <stddef.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "scene_store.h"
+
+#define SCENE_NAMESPACE     "light"
+#define SCENE_KEY           "scenes"
+#define SCENE_VERSION       2       /* 2: channel count in the header */
+
+static const char *TAG = "SCENES";
+
+/* as stored in NVS, its size changes with the number of channels */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t channels;       /* LIGHT_CHANNELS of the firmware that stored it */
+    uint8_t count;
+    scene_entry_t entries[SCENE_STORE_ENTRIES];
+} scene_blob_t;
+
+static int scene_table_index(const scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    for (int i = 0; i < table->count; i++) {
+        if (table->entries[i].group_id == group_id && table->entries[i].scene_id == scene_id)
+            return i;
+    }
+    return -1;
+}
+
+const light_scene_t *scene_table_find(const scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    int i = scene_table_index(table, group_id, scene_id);
+    return i >= 0 ? &table->entries[i].scene : NULL;
+}
+
+bool scene_table_remove(scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    int i = scene_table_index(table, group_id, scene_id);
+    if (i < 0)
+        return false;
+    memmove(&table->entries[i], &table->entries[i + 1], (table->count - i - 1) * sizeof(scene_entry_t));
+    table->count--;
+    return true;
+}
+
+void scene_table_put(scene_table_t *table, uint16_t group_id, uint8_t scene_id, const light_scene_t *scene)
+{
+    if (!scene_table_remove(table, group_id, scene_id) && table->count == SCENE_STORE_ENTRIES) {
+        ESP_LOGW(TAG, "Table full, dropping scene %d of group 0x%04x", table->entries[0].scene_id,
+                 table->entries[0].group_id);
+        scene_table_remove(table, table->entries[0].group_id, table->entries[0].scene_id);
+    }
+    table->entries[table->count++] = (scene_entry_t) { .group_id = group_id, .scene_id = scene_id, .scene = *scene };
+}
+
+/* a blob of another layout is dropped, the log says which */
+static bool scene_blob_valid(const scene_blob_t *blob, size_t size)
+{
+    if (size < offsetof(scene_blob_t, entries)) {
+        ESP_LOGW(TAG, "Ignoring stored scenes: %u bytes, too short for the header", (unsigned)size);
+    } else if (blob->version != SCENE_VERSION) {
+        ESP_LOGW(TAG, "Ignoring stored scenes: version %d, expected %d", blob->version, SCENE_VERSION);
+    } else if (blob->channels != LIGHT_CHANNELS) {
+        ESP_LOGW(TAG, "Ignoring stored scenes: stored for %d channels, this firmware has %d", blob->channels,
+                 LIGHT_CHANNELS);
+    } else if (size != sizeof(*blob) || blob->count > SCENE_STORE_ENTRIES) {
+        ESP_LOGW(TAG, "Ignoring stored scenes: %u bytes with %d entries, expected %u bytes with at most %d",
+                 (unsigned)size, blob->count, (unsigned)sizeof(*blob), SCENE_STORE_ENTRIES);
+    } else {
+        return true;
+    }
+    return false;
+}
+
+esp_err_t scene_store_load(scene_table_t *table)
+{
+    scene_blob_t blob;
+    size_t size = 0;
+    nvs_handle_t handle;
+
+    memset(table, 0, sizeof(*table));
+    esp_err_t err = nvs_open(SCENE_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK) {
+        /* the length first: a blob of more channels does not fit the buffer */
+        err = nvs_get_blob(handle, SCENE_KEY, NULL, &size);
+        if (err == ESP_OK && size > sizeof(blob)) {
+            nvs_close(handle);
+            ESP_LOGW(TAG, "Ignoring stored scenes: %u bytes, expected %u (more channels?)", (unsigned)size,
+                     (unsigned)sizeof(blob));
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (err == ESP_OK)
+            err = nvs_get_blob(handle, SCENE_KEY, &blob, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+        return ESP_ERR_NOT_FOUND;
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to read stored scenes");
+    if (!scene_blob_valid(&blob, size))
+        return ESP_ERR_NOT_FOUND;
+    table->count = blob.count;
+    memcpy(table->entries, blob.entries, sizeof(table->entries));
+    ESP_LOGI(TAG, "Restored %d scenes", table->count);
+    return ESP_OK;
+}
+
+esp_err_t scene_store_save(const scene_table_t *table)
+{
+    nvs_handle_t handle;
+    scene_blob_t blob = {
+        .version = SCENE_VERSION,
+        .channels = LIGHT_CHANNELS,
+        .count = table->count,
+    };
+
+    memcpy(blob.entries, table->entries, sizeof(blob.entries));
+    ESP_RETURN_ON_ERROR(nvs_open(SCENE_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS");
+    esp_err_t err = nvs_set_blob(handle, SCENE_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to store scenes");
+    return ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_SCENES_ENABLE
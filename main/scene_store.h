@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "light_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Whole-display snapshots of the scenes stored on endpoint 10, by group and
+ * scene ID. The stack keeps each endpoint's On/Off and level in its own
+ * scene table; this one adds every channel and the effect, so that a recall
+ * is one light_driver_set_scene() call.
+ */
+
+/** scenes kept, the oldest one makes room for a new one */
+#define SCENE_STORE_ENTRIES     16
+
+typedef struct __attribute__((packed)) {
+    uint16_t group_id;
+    uint8_t scene_id;
+    light_scene_t scene;
+} scene_entry_t;
+
+typedef struct {
+    uint8_t count;
+    scene_entry_t entries[SCENE_STORE_ENTRIES];     /* stored longest ago first */
+} scene_table_t;
+
+/**
+ * @brief The snapshot of a scene, NULL when there is none.
+ */
+const light_scene_t *scene_table_find(const scene_table_t *table, uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Add or replace the snapshot of a scene; it becomes the newest entry.
+ */
+void scene_table_put(scene_table_t *table, uint16_t group_id, uint8_t scene_id, const light_scene_t *scene);
+
+/**
+ * @brief Drop the snapshot of a scene.
+ *
+ * @return false when there was none
+ */
+bool scene_table_remove(scene_table_t *table, uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Load the stored snapshots from NVS, nvs_flash_init() must have been called.
+ *
+ * @param[out] table Stored snapshots, empty when there are none
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NOT_FOUND: Nothing stored yet
+ *      - Others: NVS error
+ */
+esp_err_t scene_store_load(scene_table_t *table);
+
+/**
+ * @brief Store @p table right away; scenes are stored rarely, so there is no delayed commit.
+ */
+esp_err_t scene_store_save(const scene_table_t *table);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <math.h>
+#include "schedule.h"
+
+#define DAY_S           86400
+#define WEEK_DAYS       7
+#define DEG             (M_PI / 180.0)
+
+static bool zone_dst(const schedule_zone_t *zone, uint32_t utc)
+{
+    if (zone->dst_shift_s == 0 || zone->dst_start == zone->dst_end)
+        return false;
+    if (zone->dst_start < zone->dst_end)
+        return utc >= zone->dst_start && utc < zone->dst_end;
+    return utc >= zone->dst_start || utc < zone->dst_end;
+}
+
+uint32_t schedule_local(const schedule_zone_t *zone, uint32_t utc)
+{
+    return utc + zone->zone_s + (zone_dst(zone, utc) ? zone->dst_shift_s : 0);
+}
+
+/* UTC time of local second-of-epoch @p local, see the rules in schedule.h */
+static uint32_t zone_utc(const schedule_zone_t *zone, int64_t local)
+{
+    int64_t standard = local - zone->zone_s;
+    int64_t summer = standard - zone->dst_shift_s;
+
+    if (summer >= 0 && zone_dst(zone, (uint32_t)summer))
+        return (uint32_t)summer;
+    if (standard < 0 || !zone_dst(zone, (uint32_t)standard))
+        return standard < 0 ? 0 : (uint32_t)standard;
+    /* skipped by the change to DST */
+    return zone->dst_start;
+}
+
+/*
+ * Sunrise or sunset of day @p day at the zone's position (sunrise equation,
+ * ~1 minute), in seconds since the epoch. False in polar day or night.
+ */
+static bool sun_event(const schedule_zone_t *zone, int32_t day, bool rise, int64_t *utc)
+{
+    double lat = zone->latitude / 100.0 * DEG;
+    double lon = zone->longitude / 100.0;
+    /* days from J2000.0 (2000-01-01 12:00 UTC) to the local solar noon */
+    double j = day - lon / 360.0;
+    double m = fmod(357.5291 + 0.98560028 * j, 360.0) * DEG;
+    double c = 1.9148 * sin(m) + 0.02 * sin(2 * m) + 0.0003 * sin(3 * m);
+    double lambda = fmod(m / DEG + c + 180.0 + 102.9372, 360.0) * DEG;
+    double transit = j + 0.0053 * sin(m) - 0.0069 * sin(2 * lambda);
+    double decl = asin(sin(lambda) * sin(23.4397 * DEG));
+    double cos_w = (sin(-0.833 * DEG) - sin(lat) * sin(decl)) / (cos(lat) * cos(decl));
+
+    if (cos_w < -1.0 || cos_w > 1.0)
+        return false;
+    double w = acos(cos_w) / DEG / 360.0;
+    *utc = (int64_t)llround((transit + (rise ? -w : w) + 0.5) * DAY_S);
+    return true;
+}
+
+bool schedule_occurrence(const schedule_zone_t *zone, const schedule_entry_t *entry, int32_t day, uint32_t *utc)
+{
+    int64_t at;
+
+    /* 2000-01-01 was a Saturday */
+    if (day < 0 || !(entry->days & (1u << ((day + 6) % WEEK_DAYS))))
+        return false;
+    switch (entry->anchor) {
+    case SCHEDULE_AT_TIME:
+        *utc = zone_utc(zone, (int64_t)day * DAY_S + entry->minute * 60);
+        return true;
+    case SCHEDULE_AT_SUNRISE:
+    case SCHEDULE_AT_SUNSET:
+        if (!sun_event(zone, day, entry->anchor == SCHEDULE_AT_SUNRISE, &at))
+            return false;
+        at += entry->minute * 60;
+        if (at < 0)
+            return false;
+        *utc = (uint32_t)at;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int32_t schedule_day(const schedule_zone_t *zone, uint32_t utc)
+{
+    return (int32_t)(schedule_local(zone, utc) / DAY_S);
+}
+
+bool schedule_next(const schedule_t *sched, uint32_t now, uint32_t *at)
+{
+    int32_t today = schedule_day(&sched->zone, now);
+    bool found = false;
+    uint32_t utc;
+
+    /* offsets move an occurrence up to a day off its local date */
+    for (int32_t day = today - 1; day <= today + WEEK_DAYS + 1; day++) {
+        for (uint8_t i = 0; i < sched->count; i++) {
+            if (schedule_occurrence(&sched->zone, &sched->entries[i], day, &utc) && utc > now && (!found || utc < *at)) {
+                *at = utc;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+uint32_t schedule_due(const schedule_t *sched, uint32_t from, uint32_t to)
+{
+    uint32_t mask = 0;
+    uint32_t utc;
+
+    for (int32_t day = schedule_day(&sched->zone, from) - 1; day <= schedule_day(&sched->zone, to) + 1; day++) {
+        for (uint8_t i = 0; i < sched->count; i++) {
+            if (schedule_occurrence(&sched->zone, &sched->entries[i], day, &utc) && utc > from && utc <= to)
+                mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+static void state_apply(schedule_state_t *state, const schedule_entry_t *entry)
+{
+    for (uint8_t ch = 0; ch < SCHEDULE_CHANNELS_MAX; ch++) {
+        if (entry->channel != SCHEDULE_CHANNEL_ALL && entry->channel != ch)
+            continue;
+        switch (entry->action) {
+        case SCHEDULE_ACTION_OFF:
+        case SCHEDULE_ACTION_ON:
+            state->on[ch] = entry->action == SCHEDULE_ACTION_ON;
+            break;
+        case SCHEDULE_ACTION_LEVEL:
+            state->level[ch] = entry->value;
+            break;
+        case SCHEDULE_ACTION_EFFECT:
+            if (ch == 0)
+                state->effect = entry->value;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void schedule_state(const schedule_t *sched, uint32_t now, schedule_state_t *state)
+{
+    int32_t today = schedule_day(&sched->zone, now);
+    uint32_t last[SCHEDULE_ENTRIES_MAX];
+    uint8_t order[SCHEDULE_ENTRIES_MAX];
+    uint8_t fired = 0;
+    uint32_t utc;
+
+    for (uint8_t ch = 0; ch < SCHEDULE_CHANNELS_MAX; ch++) {
+        state->on[ch] = -1;
+        state->level[ch] = -1;
+    }
+    state->effect = -1;
+
+    /* the latest time each entry fired, then replay them in that order */
+    for (uint8_t i = 0; i < sched->count; i++) {
+        bool found = false;
+        for (int32_t day = today + 1; day >= today - WEEK_DAYS - 1 && !found; day--) {
+            if (schedule_occurrence(&sched->zone, &sched->entries[i], day, &utc) && utc <= now) {
+                last[i] = utc;
+                found = true;
+            }
+        }
+        if (!found)
+            continue;
+        uint8_t pos = fired++;
+        while (pos > 0 && last[order[pos - 1]] > last[i]) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+    for (uint8_t k = 0; k < fired; k++)
+        state_apply(state, &sched->entries[order[k]]);
+}
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Weekly on/off/level/effect schedule evaluated on the device. Times are
+ * ZCL UTC times, seconds since 2000-01-01 00:00 UTC; entries are written in
+ * local time or relative to sunrise/sunset at the configured position, with
+ * the time zone and daylight saving period of the ZCL Time cluster. Pure C,
+ * built on the host as well.
+ *
+ * Local times that do not exist (the hour skipped when DST starts) fire at
+ * the change; local times that happen twice (when DST ends) fire the first
+ * time only.
+ */
+
+/** entries in one schedule */
+#define SCHEDULE_ENTRIES_MAX    16
+/** channels a schedule state tracks (HALLOWEEN_LED_CHANNELS range) */
+#define SCHEDULE_CHANNELS_MAX   6
+/** schedule_entry_t.channel: every channel */
+#define SCHEDULE_CHANNEL_ALL    0xff
+/** seconds from the Unix epoch to the ZCL one */
+#define SCHEDULE_UNIX_OFFSET    946684800u
+
+typedef enum {
+    SCHEDULE_AT_TIME,           /* minute: minute of the local day */
+    SCHEDULE_AT_SUNRISE,        /* minute: offset from sunrise */
+    SCHEDULE_AT_SUNSET,         /* minute: offset from sunset */
+} schedule_anchor_t;
+
+typedef enum {
+    SCHEDULE_ACTION_OFF,
+    SCHEDULE_ACTION_ON,
+    SCHEDULE_ACTION_LEVEL,      /* value: level */
+    SCHEDULE_ACTION_EFFECT,     /* value: LIGHT_DRIVER_EFFECT_*, channel 0 only */
+    SCHEDULE_ACTION_MAX,
+} schedule_action_t;
+
+/** one entry, also its over-the-air format (little endian) */
+typedef struct __attribute__((packed)) {
+    uint8_t days;               /* local weekdays, bit 0 Sunday ... bit 6 Saturday */
+    uint8_t anchor;             /* schedule_anchor_t */
+    int16_t minute;
+    uint8_t channel;            /* channel or SCHEDULE_CHANNEL_ALL */
+    uint8_t action;             /* schedule_action_t */
+    uint8_t value;
+    uint8_t reserved;
+} schedule_entry_t;
+
+_Static_assert(sizeof(schedule_entry_t) == 8, "schedule entries go over the air");
+
+/** time zone and position, as the ZCL Time cluster and the schedule cluster hold them */
+typedef struct {
+    int32_t zone_s;             /* standard time - UTC */
+    int32_t dst_shift_s;        /* added during DST */
+    uint32_t dst_start;         /* DST in [dst_start, dst_end), or outside [dst_end, dst_start) in the south */
+    uint32_t dst_end;
+    int16_t latitude;           /* 0.01 degree, north positive */
+    int16_t longitude;          /* 0.01 degree, east positive */
+} schedule_zone_t;
+
+typedef struct {
+    schedule_zone_t zone;
+    schedule_entry_t entries[SCHEDULE_ENTRIES_MAX];
+    uint8_t count;
+} schedule_t;
+
+/** what the schedule says the light should be doing, -1 where no entry has a say */
+typedef struct {
+    int8_t on[SCHEDULE_CHANNELS_MAX];
+    int16_t level[SCHEDULE_CHANNELS_MAX];
+    int16_t effect;
+} schedule_state_t;
+
+/**
+ * @brief Local time of @p utc.
+ */
+uint32_t schedule_local(const schedule_zone_t *zone, uint32_t utc);
+
+/**
+ * @brief When @p entry fires on local day @p day (days since 2000-01-01).
+ *
+ * @return false when it does not fire that day (weekday not selected, no sunrise or sunset)
+ */
+bool schedule_occurrence(const schedule_zone_t *zone, const schedule_entry_t *entry, int32_t day, uint32_t *utc);
+
+/**
+ * @brief First time after @p now any entry fires.
+ *
+ * @return false when the schedule never fires in the coming week
+ */
+bool schedule_next(const schedule_t *sched, uint32_t now, uint32_t *at);
+
+/**
+ * @brief Entries that fire in (@p from, @p to], at most a week apart.
+ *
+ * @return Bit mask of entry indices
+ */
+uint32_t schedule_due(const schedule_t *sched, uint32_t from, uint32_t to);
+
+/**
+ * @brief State the entries that fired during the last week leave the light in at @p now.
+ */
+void schedule_state(const schedule_t *sched, uint32_t now, schedule_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_HALLOWEEN_SCHEDULE_ENABLE
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "schedule_store.h"
+
+#define SCHEDULE_NAMESPACE  "light"
+#define SCHEDULE_KEY        "sched"
+#define SCHEDULE_VERSION    1
+
+static const char *TAG = "SCHEDULE";
+
+/* as stored in NVS */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t count;
+    int32_t zone_s;
+    int32_t dst_shift_s;
+    uint32_t dst_start;
+    uint32_t dst_end;
+    int16_t latitude;
+    int16_t longitude;
+    schedule_entry_t entries[SCHEDULE_ENTRIES_MAX];
+} schedule_blob_t;
+
+esp_err_t schedule_store_load(schedule_t *sched)
+{
+    schedule_blob_t blob;
+    size_t size = sizeof(blob);
+    nvs_handle_t handle;
+
+    memset(sched, 0, sizeof(*sched));
+    esp_err_t err = nvs_open(SCHEDULE_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK) {
+        err = nvs_get_blob(handle, SCHEDULE_KEY, &blob, &size);
+        nvs_close(handle);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+        return ESP_ERR_NOT_FOUND;
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to read stored schedule");
+    if (size != sizeof(blob) || blob.version != SCHEDULE_VERSION || blob.count > SCHEDULE_ENTRIES_MAX) {
+        ESP_LOGW(TAG, "Ignoring stored schedule version %d", blob.version);
+        return ESP_ERR_NOT_FOUND;
+    }
+    sched->zone = (schedule_zone_t) {
+        .zone_s = blob.zone_s,
+        .dst_shift_s = blob.dst_shift_s,
+        .dst_start = blob.dst_start,
+        .dst_end = blob.dst_end,
+        .latitude = blob.latitude,
+        .longitude = blob.longitude,
+    };
+    sched->count = blob.count;
+    memcpy(sched->entries, blob.entries, sizeof(sched->entries));
+    ESP_LOGI(TAG, "Restored %d schedule entries, zone %+" PRId32 " s", sched->count, sched->zone.zone_s);
+    return ESP_OK;
+}
+
+esp_err_t schedule_store_save(const schedule_t *sched)
+{
+    nvs_handle_t handle;
+    schedule_blob_t blob = {
+        .version = SCHEDULE_VERSION,
+        .count = sched->count,
+        .zone_s = sched->zone.zone_s,
+        .dst_shift_s = sched->zone.dst_shift_s,
+        .dst_start = sched->zone.dst_start,
+        .dst_end = sched->zone.dst_end,
+        .latitude = sched->zone.latitude,
+        .longitude = sched->zone.longitude,
+    };
+
+    memcpy(blob.entries, sched->entries, sizeof(blob.entries));
+    ESP_RETURN_ON_ERROR(nvs_open(SCHEDULE_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS");
+    esp_err_t err = nvs_set_blob(handle, SCHEDULE_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to store schedule");
+    return ESP_OK;
+}
+#endif //CONFIG_HALLOWEEN_SCHEDULE_ENABLE
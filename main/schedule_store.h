@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "schedule.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load the stored schedule and time zone from NVS, nvs_flash_init() must have been called.
+ *
+ * @param[out] sched Stored schedule, empty and in UTC when there is none
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NOT_FOUND: Nothing stored yet
+ *      - Others: NVS error
+ */
+esp_err_t schedule_store_load(schedule_t *sched);
+
+/**
+ * @brief Store @p sched right away; the coordinator writes it rarely, so there is no delayed commit.
+ */
+esp_err_t schedule_store_save(const schedule_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include "sleep_governor.h"
+
+#define EWMA_SHIFT  3   /* new sample weighs 1/8 */
+
+static uint32_t ewma(uint32_t avg, uint32_t sample)
+{
+    return (uint32_t)(((uint64_t)avg * ((1 << EWMA_SHIFT) - 1) + sample) >> EWMA_SHIFT);
+}
+
+void sleep_governor_init(sleep_governor_t *gov, const sleep_governor_config_t *config)
+{
+    *gov = (sleep_governor_t) {
+        .config = *config,
+        .threshold_ms = config->min_threshold_ms,
+    };
+}
+
+static uint32_t break_even_us(const sleep_governor_t *gov)
+{
+    return (uint32_t)((uint64_t)gov->overhead_us * gov->config.break_even_pct / 100);
+}
+
+bool sleep_governor_should_sleep(sleep_governor_t *gov, int64_t now_us)
+{
+    if (gov->samples == 0 || gov->gap_us >= break_even_us(gov)) {
+        return true;
+    }
+    if (now_us - gov->last_sleep_us >= (int64_t)gov->config.probe_ms * 1000) {
+        return true;    /* gaps may have grown since, measure again */
+    }
+    gov->skipped++;
+    return false;
+}
+
+bool sleep_governor_record(sleep_governor_t *gov, int64_t now_us, uint32_t gap_us, uint32_t awake_us)
+{
+    if (awake_us > gap_us) {
+        awake_us = gap_us;
+    }
+    if (gov->samples++ == 0) {
+        gov->overhead_us = awake_us;
+    } else {
+        gov->overhead_us = ewma(gov->overhead_us, awake_us);
+    }
+    /* only whether gaps fall below break-even matters: a 4 s poll must not hide a burst of acks */
+    uint32_t gap_cap_us = 2 * break_even_us(gov);
+    if (gap_us > gap_cap_us) {
+        gap_us = gap_cap_us;
+    }
+    gov->gap_us = gov->samples == 1 ? gap_us : ewma(gov->gap_us, gap_us);
+    gov->last_sleep_us = now_us;
+
+    /* the stack should not even offer gaps shorter than the break-even point */
+    uint32_t threshold_ms = (break_even_us(gov) + 999) / 1000;
+    if (threshold_ms < gov->config.min_threshold_ms) {
+        threshold_ms = gov->config.min_threshold_ms;
+    }
+    if (threshold_ms > gov->config.max_threshold_ms) {
+        threshold_ms = gov->config.max_threshold_ms;
+    }
+    if (threshold_ms == gov->threshold_ms) {
+        return false;
+    }
+    gov->threshold_ms = threshold_ms;
+    return true;
+}
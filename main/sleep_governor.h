@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t min_threshold_ms;  /* lowest sleep threshold handed to the stack */
+    uint32_t max_threshold_ms;  /* highest sleep threshold handed to the stack */
+    uint16_t break_even_pct;    /* a gap pays off above this percentage of the entry/exit overhead */
+    uint32_t probe_ms;          /* decline for at most this long, the stack offers again on its next loop */
+} sleep_governor_config_t;
+
+/** defaults for an ESP32-C6 in light sleep */
+#define SLEEP_GOVERNOR_CONFIG_DEFAULT()     \
+    {                                       \
+        .min_threshold_ms = 1,              \
+        .max_threshold_ms = 200,            \
+        .break_even_pct = 150,              \
+        .probe_ms = 10,                     \
+    }
+
+/**
+ * Learns the light sleep entry/exit overhead and the length of the idle gaps
+ * from measured sleeps. Pure, the caller supplies all times.
+ */
+typedef struct {
+    sleep_governor_config_t config;
+    uint32_t overhead_us;       /* average time awake inside one sleep call (EWMA) */
+    uint32_t gap_us;            /* average length of one sleep call (EWMA), capped at twice break-even */
+    uint32_t threshold_ms;      /* current sleep threshold */
+    int64_t last_sleep_us;      /* end of the last sleep */
+    uint32_t samples;
+    uint32_t skipped;           /* sleep opportunities not taken */
+} sleep_governor_t;
+
+/**
+ * @brief Set up the governor, threshold at config.min_threshold_ms.
+ */
+void sleep_governor_init(sleep_governor_t *gov, const sleep_governor_config_t *config);
+
+/**
+ * @brief Decide whether to take a sleep opportunity.
+ *
+ * Declines while recent gaps were too short to pay back the entry/exit
+ * overhead, but never for longer than config.probe_ms.
+ *
+ * @param now_us Current time
+ */
+bool sleep_governor_should_sleep(sleep_governor_t *gov, int64_t now_us);
+
+/**
+ * @brief Feed one measured sleep.
+ *
+ * @param now_us   Time the sleep ended
+ * @param gap_us   Wall time spent in the sleep call
+ * @param awake_us Part of it the CPU was running (entry and exit)
+ * @return true when threshold_ms changed and should be handed to the stack
+ */
+bool sleep_governor_record(sleep_governor_t *gov, int64_t now_us, uint32_t gap_us, uint32_t awake_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "time_sync.h"
+
+#define PPB     1000000000LL
+
+void time_sync_init(time_sync_t *sync)
+{
+    *sync = (time_sync_t) { 0 };
+}
+
+bool time_sync_locked(const time_sync_t *sync)
+{
+    return sync->count > 0;
+}
+
+static int64_t line_at(int64_t base_local, int64_t base_remote, int32_t drift_ppb, int64_t local_us)
+{
+    int64_t dt = local_us - base_local;
+    return base_remote + dt + dt * drift_ppb / PPB;
+}
+
+static int64_t sample_latest(const time_sync_sample_t *s)
+{
+    return s->remote_us + s->wait_us + TIME_SYNC_AIR_US;
+}
+
+/*
+ * Line with @p drift_ppb through the middle of the band, or when there is no
+ * room between the bounds the lowest line that is not earlier than any beacon.
+ */
+static void fit_drift(time_sync_t *sync, int64_t base_local, int32_t drift_ppb)
+{
+    int64_t lo = INT64_MIN, hi = INT64_MAX;
+
+    for (uint8_t k = 0; k < sync->count; k++) {
+        const time_sync_sample_t *s = &sync->samples[k];
+        int64_t at = line_at(base_local, 0, drift_ppb, s->local_us);
+        lo = s->remote_us - at > lo ? s->remote_us - at : lo;
+        hi = sample_latest(s) - at < hi ? sample_latest(s) - at : hi;
+    }
+    bool fits = lo <= hi + 1;   /* rounding of the drift */
+    sync->line.local_us = base_local;
+    sync->line.remote_us = fits ? lo + (hi - lo) / 2 : lo;
+    sync->line.drift_ppb = drift_ppb;
+    sync->slack_us = fits ? (hi > lo ? (hi - lo) / 2 : 0) : -1;
+}
+
+/*
+ * Any two samples bound the drift: the later one's latest against the
+ * earlier one's earliest from above, and the other way round from below.
+ * False when the bounds cross.
+ */
+static bool fit_drift_range(const time_sync_t *sync, int64_t *drift_min, int64_t *drift_max)
+{
+    *drift_min = -TIME_SYNC_DRIFT_MAX_PPB;
+    *drift_max = TIME_SYNC_DRIFT_MAX_PPB;
+    for (uint8_t i = 0; i < sync->count; i++) {
+        for (uint8_t j = 0; j < sync->count; j++) {
+            const time_sync_sample_t *a = &sync->samples[i];
+            const time_sync_sample_t *b = &sync->samples[j];
+            int64_t span = b->local_us - a->local_us;
+            if (span <= 0)
+                continue;
+            int64_t up = (sample_latest(b) - a->remote_us - span) * PPB / span;
+            int64_t down = (b->remote_us - sample_latest(a) - span) * PPB / span;
+            *drift_max = up < *drift_max ? up : *drift_max;
+            *drift_min = down > *drift_min ? down : *drift_min;
+        }
+    }
+    return *drift_min <= *drift_max;
+}
+
+/* Height at @p local_us of the lowest line with @p drift_ppb that is not earlier than any beacon */
+static int64_t fit_lowest_at(const time_sync_t *sync, int64_t local_us, int64_t drift_ppb)
+{
+    int64_t lowest = INT64_MIN;
+
+    for (uint8_t k = 0; k < sync->count; k++) {
+        const time_sync_sample_t *s = &sync->samples[k];
+        int64_t at = s->remote_us - line_at(local_us, 0, (int32_t)drift_ppb, s->local_us);
+        lowest = at > lowest ? at : lowest;
+    }
+    return lowest;
+}
+
+/*
+ * Every drift in the range leaves room in the band, the one in its middle is
+ * taken. A beacon delayed by a relay on the way, or a clock that wandered,
+ * can leave no range at all; then the bounds from the waits are dropped and
+ * the drift is that of the lowest line above the beacons with the least
+ * total gap to them, the lowest one at their mean time. That height is
+ * convex in the drift.
+ */
+static void time_sync_fit(time_sync_t *sync)
+{
+    int64_t base_local = sync->samples[(sync->next + TIME_SYNC_SAMPLES - 1) % TIME_SYNC_SAMPLES].local_us;
+    int64_t first = base_local, last = base_local, sum = 0;
+    int64_t drift_min, drift_max;
+
+    for (uint8_t i = 0; i < sync->count; i++) {
+        int64_t local = sync->samples[i].local_us;
+        first = local < first ? local : first;
+        last = local > last ? local : last;
+        sum += local - base_local;
+    }
+    if (last - first < TIME_SYNC_DRIFT_SPAN_US) {
+        fit_drift(sync, base_local, sync->line.drift_ppb);
+        return;
+    }
+
+    if (!fit_drift_range(sync, &drift_min, &drift_max)) {
+        int64_t mean = base_local + sum / sync->count;
+        drift_min = -TIME_SYNC_DRIFT_MAX_PPB;
+        drift_max = TIME_SYNC_DRIFT_MAX_PPB;
+        while (drift_max - drift_min > 2) {
+            int64_t third = (drift_max - drift_min) / 3;
+            if (fit_lowest_at(sync, mean, drift_min + third) < fit_lowest_at(sync, mean, drift_max - third))
+                drift_max -= third;
+            else
+                drift_min += third;
+        }
+    }
+    fit_drift(sync, base_local, (int32_t)((drift_min + drift_max) / 2));
+    sync->drift_known = true;
+}
+
+void time_sync_add(time_sync_t *sync, int64_t local_us, int64_t remote_us, int64_t wait_us)
+{
+    if (time_sync_locked(sync)) {
+        int64_t late = time_sync_remote(sync, local_us) - remote_us;
+        if (late > TIME_SYNC_JUMP_US || late < -TIME_SYNC_JUMP_US)
+            time_sync_init(sync);
+    }
+    sync->samples[sync->next] = (time_sync_sample_t) { .local_us = local_us, .remote_us = remote_us, .wait_us = wait_us };
+    sync->next = (sync->next + 1) % TIME_SYNC_SAMPLES;
+    if (sync->count < TIME_SYNC_SAMPLES)
+        sync->count++;
+    time_sync_fit(sync);
+
+    /* a missed beacon shows up as a period twice as long, which is not taken */
+    int64_t period = remote_us - sync->last_remote_us;
+    if (sync->count > 1 && period >= TIME_SYNC_PERIOD_MIN_US && period <= TIME_SYNC_PERIOD_MAX_US &&
+        (sync->period_us == 0 || period < sync->period_us + sync->period_us / 2))
+        sync->period_us = period;
+    sync->last_remote_us = remote_us;
+}
+
+bool time_sync_window(const time_sync_t *sync, int64_t poll_us, int64_t *open_local_us, int64_t *close_local_us)
+{
+    if (!time_sync_locked(sync) || sync->period_us == 0)
+        return false;
+    int64_t due = time_sync_local(sync, sync->last_remote_us + sync->period_us);
+    int64_t drift = sync->period_us * (sync->drift_known ? TIME_SYNC_DRIFT_ERR_PPB : TIME_SYNC_DRIFT_MAX_PPB) / PPB;
+    /* in the band the estimate is off by at most the slack, below it it can only be behind */
+    const time_sync_sample_t *last = &sync->samples[(sync->next + TIME_SYNC_SAMPLES - 1) % TIME_SYNC_SAMPLES];
+    int64_t behind = sync->slack_us >= 0 ? sync->slack_us : last->wait_us + TIME_SYNC_AIR_US;
+    int64_t ahead = sync->slack_us >= 0 ? sync->slack_us : 0;
+    /* golden ratio steps through the poll interval, 40503 / 65536 ~ 0.618 */
+    int64_t dither = poll_us * (uint16_t)(sync->next * 40503u) >> 16;
+    *open_local_us = due - behind - drift - TIME_SYNC_GUARD_US - dither;
+    *close_local_us = due + ahead + drift + TIME_SYNC_GUARD_US;
+    return true;
+}
+
+int64_t time_sync_line_remote(const time_sync_line_t *line, int64_t local_us)
+{
+    return line_at(line->local_us, line->remote_us, line->drift_ppb, local_us);
+}
+
+int64_t time_sync_remote(const time_sync_t *sync, int64_t local_us)
+{
+    return time_sync_line_remote(&sync->line, local_us);
+}
+
+int64_t time_sync_local(const time_sync_t *sync, int64_t remote_us)
+{
+    int64_t dt = remote_us - sync->line.remote_us;
+    return sync->line.local_us + dt - dt * sync->line.drift_ppb / (PPB + sync->line.drift_ppb);
+}
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2025 MounMovies
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Estimates the offset and drift of the local clock against a shared
+ * timebase from sync beacons: each one carries the time it was sent at and
+ * is stamped with the local time it arrived at. A sleepy end device gets a
+ * beacon only when it next polls its parent, so every sample is late by a
+ * delay that is never negative and, as the beacon was not there at the
+ * previous poll, at most the time since that poll. The estimate is the line
+ * (offset and drift) that runs through the middle of the band these bounds
+ * leave; when the clock wandered so that no line fits the band, the lowest
+ * line that is not earlier than any beacon. Pure C, built on the host as well.
+ */
+
+/** beacons the fit looks at */
+#define TIME_SYNC_SAMPLES           32
+/** samples have to span this much before the drift is estimated, offset only before */
+#define TIME_SYNC_DRIFT_SPAN_US     (300 * 1000000LL)
+/** parent to radio to timestamp, on top of the wait at the parent */
+#define TIME_SYNC_AIR_US            5000
+/** largest drift taken as real (crystal and RC clocks are well within it) */
+#define TIME_SYNC_DRIFT_MAX_PPB     1000000
+/** drift error still assumed once it has been estimated */
+#define TIME_SYNC_DRIFT_ERR_PPB     100000
+/** the listening window opens this much earlier, and closes this much later, than the beacon can be expected (covers the broadcast jitter of a relay) */
+#define TIME_SYNC_GUARD_US          (100 * 1000)
+/** beacon periods that make sense, others are a beacon that went missing */
+#define TIME_SYNC_PERIOD_MIN_US     (1 * 1000000LL)
+#define TIME_SYNC_PERIOD_MAX_US     (3600 * 1000000LL)
+/** a beacon this much earlier than the estimate allows, or later, restarts the estimate (the sender's clock jumped) */
+#define TIME_SYNC_JUMP_US           (60 * 1000000LL)
+
+typedef struct {
+    int64_t local_us;           /* arrival, local clock */
+    int64_t remote_us;          /* sent, shared clock */
+    int64_t wait_us;            /* longest it can have waited at the parent */
+} time_sync_sample_t;
+
+/** the estimate: shared time = remote_us + (local - local_us) * (1 + drift_ppb / 1e9) */
+typedef struct {
+    int64_t local_us;
+    int64_t remote_us;
+    int32_t drift_ppb;
+} time_sync_line_t;
+
+typedef struct {
+    time_sync_sample_t samples[TIME_SYNC_SAMPLES];
+    uint8_t count;
+    uint8_t next;               /* ring position of the next sample */
+    time_sync_line_t line;
+    bool drift_known;           /* drift_ppb comes from beacons far enough apart */
+    int64_t slack_us;           /* half the band the estimate is in the middle of, -1 below the band */
+    int64_t last_remote_us;     /* newest beacon */
+    int64_t period_us;          /* between beacons, 0 while unknown */
+} time_sync_t;
+
+/**
+ * @brief Start without any beacon.
+ */
+void time_sync_init(time_sync_t *sync);
+
+/**
+ * @brief Whether at least one beacon has arrived.
+ */
+bool time_sync_locked(const time_sync_t *sync);
+
+/**
+ * @brief Add a beacon and fit the estimate again.
+ *
+ * @param local_us  Local time it arrived at
+ * @param remote_us Shared time it was sent at
+ * @param wait_us   Longest it can have waited for the device at the parent: the time since the previous poll
+ */
+void time_sync_add(time_sync_t *sync, int64_t local_us, int64_t remote_us, int64_t wait_us);
+
+/**
+ * @brief Local times to poll fast around the next beacon, so that it waits at the parent as little as possible.
+ *
+ * In the middle of the band the estimate is off either way by at most half
+ * its width; the lowest line runs behind by at most the wait of the newest
+ * beacon. The window opens and closes that much around the time the beacon
+ * is due, and on top of that by what the drift error can add up to over one
+ * period. The opening steps through one fast poll from beacon to
+ * beacon; polls at the same phase every time would delay every beacon
+ * alike, and the fit needs some that arrive right after a poll.
+ *
+ * @param poll_us Fast poll interval
+ * @return false while the beacon period is not known
+ */
+bool time_sync_window(const time_sync_t *sync, int64_t poll_us, int64_t *open_local_us, int64_t *close_local_us);
+
+/**
+ * @brief Shared time at local time @p local_us, needs time_sync_locked().
+ */
+int64_t time_sync_remote(const time_sync_t *sync, int64_t local_us);
+
+/**
+ * @brief Shared time at local time @p local_us on a copy of time_sync_t::line.
+ */
+int64_t time_sync_line_remote(const time_sync_line_t *line, int64_t local_us);
+
+/**
+ * @brief Local time at shared time @p remote_us, needs time_sync_locked().
+ */
+int64_t time_sync_local(const time_sync_t *sync, int64_t remote_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -26,3 +26,150 @@ esp_err_t esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_ep_list_t *ep_li
     ESP_ERROR_CHECK(esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, info->model_identifier));
     return ret;
 }
+
+esp_err_t esp_zcl_utility_add_ep_stats_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id)
+{
+    esp_zb_cluster_list_t *cluster_list = NULL;
+    esp_zb_attribute_list_t *stats_cluster = NULL;
+    uint32_t zero = 0;
+
+    cluster_list = esp_zb_ep_list_get_ep(ep_list, endpoint_id);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_INVALID_ARG, TAG, "Failed to find endpoint id: %d in list: %p", endpoint_id, ep_list);
+    ESP_RETURN_ON_FALSE(esp_zb_cluster_list_get_cluster(cluster_list, ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE),
+                        ESP_ERR_INVALID_ARG, TAG, "Failed to find basic cluster in endpoint: %d", endpoint_id);
+    stats_cluster = esp_zb_zcl_attr_list_create(ZCL_CLUSTER_ID_HALLOWEEN_STATS);
+    ESP_RETURN_ON_FALSE(stats_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create stats cluster");
+    for (uint16_t attr_id = 0; attr_id < ZCL_ATTR_HALLOWEEN_STATS_COUNT; attr_id++) {
+        ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(stats_cluster, attr_id, ESP_ZB_ZCL_ATTR_TYPE_U32,
+                                                              ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &zero));
+    }
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, stats_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+esp_err_t esp_zcl_utility_add_ep_light_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, uint8_t effect, uint16_t runtime_min)
+{
+    esp_zb_cluster_list_t *cluster_list = NULL;
+    esp_zb_attribute_list_t *light_cluster = NULL;
+
+    cluster_list = esp_zb_ep_list_get_ep(ep_list, endpoint_id);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_INVALID_ARG, TAG, "Failed to find endpoint id: %d in list: %p", endpoint_id, ep_list);
+    light_cluster = esp_zb_zcl_attr_list_create(ZCL_CLUSTER_ID_HALLOWEEN_LIGHT);
+    ESP_RETURN_ON_FALSE(light_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create light cluster");
+#if CONFIG_HALLOWEEN_BLINK_ENABLE
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(light_cluster, ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
+                                                          ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE | ESP_ZB_ZCL_ATTR_ACCESS_REPORTING, &effect));
+#endif
+#if CONFIG_HALLOWEEN_BATTERY_GOVERNOR
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(light_cluster, ZCL_ATTR_HALLOWEEN_LIGHT_RUNTIME_MIN_ID, ESP_ZB_ZCL_ATTR_TYPE_U16,
+                                                          ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &runtime_min));
+#endif
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, light_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+esp_err_t esp_zcl_utility_add_ep_power_config_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id)
+{
+    esp_zb_cluster_list_t *cluster_list = NULL;
+    esp_zb_attribute_list_t *power_cluster = NULL;
+    esp_zb_power_config_cluster_cfg_t power_cfg = { 0 };
+    uint8_t unknown = 0xff;
+
+    cluster_list = esp_zb_ep_list_get_ep(ep_list, endpoint_id);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_INVALID_ARG, TAG, "Failed to find endpoint id: %d in list: %p", endpoint_id, ep_list);
+    power_cluster = esp_zb_power_config_cluster_create(&power_cfg);
+    ESP_RETURN_ON_FALSE(power_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create power configuration cluster");
+    ESP_ERROR_CHECK(esp_zb_power_config_cluster_add_attr(power_cluster, ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID, &unknown));
+    ESP_ERROR_CHECK(esp_zb_power_config_cluster_add_attr(power_cluster, ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID,
+                                                         &unknown));
+    return esp_zb_cluster_list_add_power_config_cluster(cluster_list, power_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+esp_err_t esp_zcl_utility_add_ep_schedule_clusters(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, const schedule_t *sched)
+{
+    esp_zb_cluster_list_t *cluster_list = NULL;
+    esp_zb_attribute_list_t *time_cluster = NULL;
+    esp_zb_attribute_list_t *schedule_cluster = NULL;
+    esp_zb_time_cluster_cfg_t time_cfg = { 0 };
+    schedule_zone_t zone = sched->zone;
+    /* the stack sizes a string attribute by its initial value: room for every entry, unused ones never fire */
+    uint8_t entries[1 + sizeof(sched->entries)] = { sizeof(sched->entries) };
+
+    cluster_list = esp_zb_ep_list_get_ep(ep_list, endpoint_id);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_INVALID_ARG, TAG, "Failed to find endpoint id: %d in list: %p", endpoint_id, ep_list);
+    time_cluster = esp_zb_time_cluster_create(&time_cfg);
+    ESP_RETURN_ON_FALSE(time_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create time cluster");
+    ESP_ERROR_CHECK(esp_zb_time_cluster_add_attr(time_cluster, ESP_ZB_ZCL_ATTR_TIME_TIME_ZONE_ID, &zone.zone_s));
+    ESP_ERROR_CHECK(esp_zb_time_cluster_add_attr(time_cluster, ESP_ZB_ZCL_ATTR_TIME_DST_START_ID, &zone.dst_start));
+    ESP_ERROR_CHECK(esp_zb_time_cluster_add_attr(time_cluster, ESP_ZB_ZCL_ATTR_TIME_DST_END_ID, &zone.dst_end));
+    ESP_ERROR_CHECK(esp_zb_time_cluster_add_attr(time_cluster, ESP_ZB_ZCL_ATTR_TIME_DST_SHIFT_ID, &zone.dst_shift_s));
+    ESP_ERROR_CHECK(esp_zb_cluster_list_add_time_cluster(cluster_list, time_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
+    schedule_cluster = esp_zb_zcl_attr_list_create(ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE);
+    ESP_RETURN_ON_FALSE(schedule_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create schedule cluster");
+    memcpy(&entries[1], sched->entries, sched->count * sizeof(schedule_entry_t));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(schedule_cluster, ZCL_ATTR_HALLOWEEN_SCHEDULE_ENTRIES_ID,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, entries));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(schedule_cluster, ZCL_ATTR_HALLOWEEN_SCHEDULE_LATITUDE_ID,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_S16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &zone.latitude));
+    ESP_ERROR_CHECK(esp_zb_custom_cluster_add_custom_attr(schedule_cluster, ZCL_ATTR_HALLOWEEN_SCHEDULE_LONGITUDE_ID,
+                                                          ESP_ZB_ZCL_ATTR_TYPE_S16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &zone.longitude));
+    return esp_zb_cluster_list_add_custom_cluster(cluster_list, schedule_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
+}
+
+esp_err_t esp_zcl_utility_add_ep_ota_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, const esp_zb_ota_cluster_cfg_t *cfg,
+                                            const esp_zb_zcl_ota_upgrade_client_variable_t *client)
+{
+    esp_zb_cluster_list_t *cluster_list = NULL;
+    esp_zb_attribute_list_t *ota_cluster = NULL;
+    esp_zb_ota_cluster_cfg_t ota_cfg = *cfg;
+    esp_zb_zcl_ota_upgrade_client_variable_t variable = *client;
+    /* found with a broadcast Match Descriptor request */
+    uint16_t server_addr = 0xffff;
+    uint8_t server_ep = 0xff;
+
+    cluster_list = esp_zb_ep_list_get_ep(ep_list, endpoint_id);
+    ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_INVALID_ARG, TAG, "Failed to find endpoint id: %d in list: %p", endpoint_id, ep_list);
+    ota_cluster = esp_zb_ota_cluster_create(&ota_cfg);
+    ESP_RETURN_ON_FALSE(ota_cluster, ESP_ERR_NO_MEM, TAG, "Failed to create OTA upgrade cluster");
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, &variable));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ADDR_ID, &server_addr));
+    ESP_ERROR_CHECK(esp_zb_ota_cluster_add_attr(ota_cluster, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_SERVER_ENDPOINT_ID, &server_ep));
+    return esp_zb_cluster_list_add_ota_cluster(cluster_list, ota_cluster, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
+}
+
+esp_err_t esp_zcl_utility_parse_schedule(const uint8_t *value, schedule_t *sched)
+{
+    schedule_entry_t entries[SCHEDULE_ENTRIES_MAX];
+    uint8_t count = 0;
+
+    ESP_RETURN_ON_FALSE(value && value[0] % sizeof(schedule_entry_t) == 0 && value[0] <= sizeof(entries), ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid schedule length %d", value ? value[0] : -1);
+    for (uint8_t i = 0; i < value[0] / sizeof(schedule_entry_t); i++) {
+        schedule_entry_t entry;
+        memcpy(&entry, &value[1 + i * sizeof(entry)], sizeof(entry));
+        if (entry.days == 0)
+            continue;   /* unused slot */
+        ESP_RETURN_ON_FALSE(entry.action < SCHEDULE_ACTION_MAX && entry.anchor <= SCHEDULE_AT_SUNSET, ESP_ERR_INVALID_ARG, TAG,
+                            "Invalid schedule entry %d", i);
+        entries[count++] = entry;
+    }
+    memcpy(sched->entries, entries, count * sizeof(schedule_entry_t));
+    sched->count = count;
+    return ESP_OK;
+}
+
+void esp_zcl_utility_set_battery(uint8_t endpoint_id, uint32_t mv, uint8_t percent)
+{
+    /* 100 mV and half percent units */
+    uint8_t voltage = mv / 100 < 0xff ? (uint8_t)(mv / 100) : 0xfe;
+    uint8_t remaining = (uint8_t)(percent * 2);
+
+    esp_zb_zcl_set_attribute_val(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID, &voltage, false);
+    esp_zb_zcl_set_attribute_val(endpoint_id, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID, &remaining, false);
+}
+
+void esp_zcl_utility_set_stats_attr(uint8_t endpoint_id, uint16_t attr_id, uint32_t value)
+{
+    esp_zb_zcl_set_attribute_val(endpoint_id, ZCL_CLUSTER_ID_HALLOWEEN_STATS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id, &value, false);
+}
@@ -12,6 +12,7 @@ extern "C" {
 #include "esp_err.h"
 #include "esp_check.h"
 #include "esp_zigbee_core.h"
+#include "schedule.h"
 
 /*! Maximum length of ManufacturerName string field */
 #define ESP_ZB_ZCL_CLUSTER_ID_BASIC_MANUFACTURER_NAME_MAX_LEN 32
@@ -19,6 +20,44 @@ extern "C" {
 /*! Maximum length of ModelIdentifier string field */
 #define ESP_ZB_ZCL_CLUSTER_ID_BASIC_MODEL_IDENTIFIER_MAX_LEN 32
 
+/*! Manufacturer-specific cluster with the device's power statistics (read-only) */
+#define ZCL_CLUSTER_ID_HALLOWEEN_STATS                  0xFC00
+#define ZCL_ATTR_HALLOWEEN_STATS_WAKE_TIMER_ID          0x0000  /*!< U32, wakeups by timer */
+#define ZCL_ATTR_HALLOWEEN_STATS_WAKE_GPIO_ID           0x0001  /*!< U32, wakeups by GPIO */
+#define ZCL_ATTR_HALLOWEEN_STATS_WAKE_UART_ID           0x0002  /*!< U32, wakeups by UART */
+#define ZCL_ATTR_HALLOWEEN_STATS_WAKE_OTHER_ID          0x0003  /*!< U32, wakeups by any other source */
+#define ZCL_ATTR_HALLOWEEN_STATS_WAKE_REJECTED_ID       0x0004  /*!< U32, sleep attempts that did not sleep */
+#define ZCL_ATTR_HALLOWEEN_STATS_AWAKE_MS_ID            0x0005  /*!< U32, time awake since boot in ms */
+#define ZCL_ATTR_HALLOWEEN_STATS_RADIO_TX_ID            0x0006  /*!< U32, 802.15.4 frames sent */
+#define ZCL_ATTR_HALLOWEEN_STATS_RADIO_RX_ID            0x0007  /*!< U32, 802.15.4 frames received */
+#define ZCL_ATTR_HALLOWEEN_STATS_LEDC_ACTIVATIONS_ID    0x0008  /*!< U32, LEDC duty updates, fades and resumes */
+#define ZCL_ATTR_HALLOWEEN_STATS_TIMER_ACTIVATIONS_ID   0x0009  /*!< U32, esp_timer one-shots */
+#define ZCL_ATTR_HALLOWEEN_STATS_BOOT_COUNT_ID          0x000A  /*!< U32, resets since power-on + 1 */
+#define ZCL_ATTR_HALLOWEEN_STATS_BOOT_LIGHT_MS_ID       0x000B  /*!< U32, reset to restored light state in ms */
+#define ZCL_ATTR_HALLOWEEN_STATS_BOOT_JOIN_MS_ID        0x000C  /*!< U32, reset to back on the network in ms */
+#define ZCL_ATTR_HALLOWEEN_STATS_POLL_INTERVAL_MS_ID    0x000D  /*!< U32, current poll interval in ms */
+#define ZCL_ATTR_HALLOWEEN_STATS_SLEEP_THRESHOLD_MS_ID  0x000E  /*!< U32, sleep threshold handed to the stack in ms */
+#define ZCL_ATTR_HALLOWEEN_STATS_COUNT                  15
+/*! TraceRead(U32 seq): answered with the same command id, an octet string of U32 first seq, U8 count and
+ *  count light_trace_entry_t entries */
+#define ZCL_CMD_HALLOWEEN_STATS_TRACE_READ              0x00
+/*! TraceDump(): prints the trace ring on the device console */
+#define ZCL_CMD_HALLOWEEN_STATS_TRACE_DUMP              0x01
+
+/*! Manufacturer-specific cluster with the light's own settings */
+#define ZCL_CLUSTER_ID_HALLOWEEN_LIGHT                  0xFC01
+#define ZCL_ATTR_HALLOWEEN_LIGHT_EFFECT_ID              0x0000  /*!< ENUM8, read/write/reportable, effect of the endpoint (LIGHT_DRIVER_EFFECT_*) */
+#define ZCL_ATTR_HALLOWEEN_LIGHT_RUNTIME_MIN_ID         0x0001  /*!< U16, read/write, minutes from the write the battery has to last, 0 = no dimming */
+/*! SyncBeacon(U32 time, U16 ms): the coordinator's clock when it sent the command, ZCL seconds and milliseconds,
+ *  broadcast every one to a few minutes; lights play their effects on this clock. No response */
+#define ZCL_CMD_HALLOWEEN_LIGHT_SYNC                    0x00
+
+/*! Manufacturer-specific cluster with the on-device schedule, next to the Time cluster that holds the clock and time zone */
+#define ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE               0xFC02
+#define ZCL_ATTR_HALLOWEEN_SCHEDULE_ENTRIES_ID          0x0000  /*!< octet string, read/write, up to SCHEDULE_ENTRIES_MAX schedule_entry_t */
+#define ZCL_ATTR_HALLOWEEN_SCHEDULE_LATITUDE_ID         0x0001  /*!< S16, read/write, 0.01 degree north, for sunrise/sunset entries */
+#define ZCL_ATTR_HALLOWEEN_SCHEDULE_LONGITUDE_ID        0x0002  /*!< S16, read/write, 0.01 degree east */
+
 /** optional basic manufacturer information */
 typedef struct zcl_basic_manufacturer_info_s {
     char *manufacturer_name;
@@ -37,6 +76,103 @@ typedef struct zcl_basic_manufacturer_info_s {
  */
 esp_err_t esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, zcl_basic_manufacturer_info_t *info);
 
+/**
+ * @brief Adds the statistics cluster (ZCL_CLUSTER_ID_HALLOWEEN_STATS) next to the basic cluster of endpoint
+ *
+ * All attributes start at 0, keep them up to date with esp_zcl_utility_set_stats_attr().
+ *
+ * @param[in] ep_list The pointer to the endpoint list with @p endpoint_id
+ * @param[in] endpoint_id The endpoint identifier indicating where the ZCL basic cluster resides
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t esp_zcl_utility_add_ep_stats_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id);
+
+/**
+ * @brief Adds the light settings cluster (ZCL_CLUSTER_ID_HALLOWEEN_LIGHT) to endpoint
+ *
+ * Effect is only added with effect support, RuntimeMin only with the battery governor.
+ *
+ * @param[in] ep_list The pointer to the endpoint list with @p endpoint_id
+ * @param[in] endpoint_id The endpoint identifier of the light
+ * @param[in] effect Initial value of the Effect attribute
+ * @param[in] runtime_min Initial value of the RuntimeMin attribute
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t esp_zcl_utility_add_ep_light_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, uint8_t effect, uint16_t runtime_min);
+
+/**
+ * @brief Adds the Power Configuration cluster with BatteryVoltage and BatteryPercentageRemaining to endpoint
+ *
+ * Both start as unknown (0xFF), keep them up to date with esp_zcl_utility_set_battery().
+ *
+ * @param[in] ep_list The pointer to the endpoint list with @p endpoint_id
+ * @param[in] endpoint_id The endpoint identifier of the light
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t esp_zcl_utility_add_ep_power_config_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id);
+
+/**
+ * @brief Adds the Time cluster (Time, TimeZone, DstStart, DstEnd, DstShift, all writable) and the schedule
+ *        cluster (ZCL_CLUSTER_ID_HALLOWEEN_SCHEDULE) to endpoint
+ *
+ * @param[in] ep_list The pointer to the endpoint list with @p endpoint_id
+ * @param[in] endpoint_id The endpoint identifier of the light
+ * @param[in] sched Initial time zone, position and entries
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t esp_zcl_utility_add_ep_schedule_clusters(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, const schedule_t *sched);
+
+/**
+ * @brief Adds the OTA Upgrade cluster as a client to endpoint, it looks for the OTA server itself
+ *
+ * @param[in] ep_list The pointer to the endpoint list with @p endpoint_id
+ * @param[in] endpoint_id The endpoint identifier of the light
+ * @param[in] cfg Running file version, manufacturer code and image type
+ * @param[in] client Query interval, hardware version and block size
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ */
+esp_err_t esp_zcl_utility_add_ep_ota_cluster(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, const esp_zb_ota_cluster_cfg_t *cfg,
+                                            const esp_zb_zcl_ota_upgrade_client_variable_t *client);
+
+/**
+ * @brief Parses a written Entries attribute (octet string) into @p sched
+ *
+ * @param[in] value The attribute value, length byte first
+ * @param[out] sched Schedule whose entries are replaced
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_INVALID_ARG: Not a whole number of entries, too many of them or an unknown action
+ */
+esp_err_t esp_zcl_utility_parse_schedule(const uint8_t *value, schedule_t *sched);
+
+/**
+ * @brief Updates the battery attributes of the Power Configuration cluster, needs the Zigbee lock
+ *
+ * @param[in] endpoint_id The endpoint identifier the cluster was added to
+ * @param[in] mv Battery voltage in mV
+ * @param[in] percent State of charge, 0-100
+ */
+void esp_zcl_utility_set_battery(uint8_t endpoint_id, uint32_t mv, uint8_t percent);
+
+/**
+ * @brief Updates one attribute of the statistics cluster, needs the Zigbee lock
+ *
+ * @param[in] endpoint_id The endpoint identifier the statistics cluster was added to
+ * @param[in] attr_id One of ZCL_ATTR_HALLOWEEN_STATS_*_ID
+ * @param[in] value New value
+ */
+void esp_zcl_utility_set_stats_attr(uint8_t endpoint_id, uint16_t attr_id, uint32_t value);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2025 MounMovies
+#
+"""Decode the binary log (CONFIG_HALLOWEEN_BINARY_LOG) in a console capture.
+
+"BLOG:<hex>" lines are replaced by the text they stand for, everything else
+is passed through. Message formats are read from main/light_blog.h.
+
+    idf.py monitor | tee monitor.log
+    python3 tools/blog_decode.py monitor.log
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main', 'light_blog.h')
+CONVERSION = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l)?([diouxXc%])')
+
+
+def load_formats(path):
+    with open(path) as f:
+        text = f.read()
+    block = text[text.index('#define LIGHT_BLOG_FORMATS(X)'):]
+    block = block[:block.index('\n\n')]
+    return [fmt for _, fmt in re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', block)]
+
+
+def render(fmt, args):
+    values = []
+    for conv in CONVERSION.findall(fmt):
+        if conv == '%':
+            continue
+        value = args[len(values)] if len(values) < len(args) else 0
+        if conv in 'di' and value & 0x80000000:
+            value -= 1 << 32
+        values.append(value)
+    fmt = CONVERSION.sub(lambda m: m.group(0).replace('hh', '').replace('ll', '').replace('l', '').replace('h', ''), fmt)
+    return fmt % tuple(values)
+
+
+def decode(payload, formats):
+    data = bytes.fromhex(payload)
+    pos = 0
+    while pos + 6 <= len(data):
+        time_ms, msg_id, nargs = struct.unpack_from('<IBB', data, pos)
+        pos += 6
+        args = struct.unpack_from('<%dI' % nargs, data, pos)
+        pos += 4 * nargs
+        if msg_id < len(formats):
+            text = render(formats[msg_id], args)
+        else:
+            text = 'unknown message %d %s' % (msg_id, ' '.join('0x%x' % a for a in args))
+        yield 'B (%d) %s' % (time_ms, text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', nargs='?', type=argparse.FileType('r'), default=sys.stdin)
+    parser.add_argument('--header', default=HEADER, help='light_blog.h with the message formats')
+    args = parser.parse_args()
+
+    formats = load_formats(args.header)
+    for line in args.input:
+        start = line.find('BLOG:')
+        if start < 0:
+            sys.stdout.write(line)
+            continue
+        for text in decode(line[start + 5:].strip(), formats):
+            print(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2025 MounMovies
+#
+"""Pack WAV clips into the image of the "audio" data partition.
+
+Every clip is mixed down to mono, resampled to --rate and IMA ADPCM coded in
+the block layout main/audio_clip.h reads (4 bits per sample). Clips keep the
+order they are given in; the firmware plays them by index.
+
+    tools/gen_audio_bank.py -o audio.bin scream.wav creak.wav
+    parttool.py write_partition --partition-name audio --input audio.bin
+"""
+
+import argparse
+import struct
+import sys
+import wave
+
+MAGIC = b'HWAB'
+VERSION = 1
+BLOCK_BYTES = 256
+BLOCK_HEADER = 4
+BLOCK_SAMPLES = 2 * (BLOCK_BYTES - BLOCK_HEADER)
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def clamp(v, lo, hi):
+    return max(lo, min(hi, v))
+
+
+def read_wav(path, rate):
+    with wave.open(path, 'rb') as w:
+        channels, width, src_rate = w.getnchannels(), w.getsampwidth(), w.getframerate()
+        frames = w.readframes(w.getnframes())
+    if width == 1:
+        raw = [(b - 128) << 8 for b in frames]
+    elif width == 2:
+        raw = list(struct.unpack('<%dh' % (len(frames) // 2), frames))
+    else:
+        raise ValueError('%s: %d-bit samples are not supported' % (path, width * 8))
+    mono = [sum(raw[i:i + channels]) // channels for i in range(0, len(raw), channels)]
+    if src_rate == rate or not mono:
+        return mono
+    # linear interpolation is enough for a speaker behind a PDM filter
+    out = []
+    n = len(mono) * rate // src_rate
+    for i in range(n):
+        x = i * src_rate / rate
+        j = int(x)
+        k = min(j + 1, len(mono) - 1)
+        out.append(int(round(mono[j] + (mono[k] - mono[j]) * (x - j))))
+    return out
+
+
+def decode_step(predictor, index, code):
+    """One step of the firmware decoder (audio_adpcm_decode)."""
+    step = STEP_TABLE[index]
+    diff = step >> 3
+    if code & 4:
+        diff += step
+    if code & 2:
+        diff += step >> 1
+    if code & 1:
+        diff += step >> 2
+    predictor = clamp(predictor - diff if code & 8 else predictor + diff, -32768, 32767)
+    return predictor, clamp(index + INDEX_TABLE[code], 0, 88)
+
+
+def encode(samples, gain):
+    out = bytearray()
+    index = 0
+    for start in range(0, len(samples), BLOCK_SAMPLES):
+        block = [clamp(int(s * gain), -32768, 32767) for s in samples[start:start + BLOCK_SAMPLES]]
+        predictor = block[0]
+        out += struct.pack('<hBB', predictor, index, 0)
+        codes = []
+        for s in block:
+            step = STEP_TABLE[index]
+            diff = s - predictor
+            code = 0
+            if diff < 0:
+                code, diff = 8, -diff
+            if diff >= step:
+                code |= 4
+                diff -= step
+            if diff >= step >> 1:
+                code |= 2
+                diff -= step >> 1
+            if diff >= step >> 2:
+                code |= 1
+            predictor, index = decode_step(predictor, index, code)
+            codes.append(code)
+        if len(codes) & 1:
+            codes.append(0)
+        out += bytes(codes[i] | codes[i + 1] << 4 for i in range(0, len(codes), 2))
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('clips', nargs='+', help='WAV files, 8 or 16 bit')
+    parser.add_argument('--rate', type=int, default=16000, help='playback sample rate (default 16000)')
+    parser.add_argument('--gain', type=float, default=1.0, help='gain applied before coding')
+    parser.add_argument('--size', type=lambda v: int(v, 0), help='partition size, fail when the bank is larger')
+    parser.add_argument('-o', '--output', required=True)
+    args = parser.parse_args()
+
+    header_bytes = 12 + 8 * len(args.clips)
+    directory = b''
+    body = b''
+    for path in args.clips:
+        samples = read_wav(path, args.rate)
+        coded = encode(samples, args.gain)
+        directory += struct.pack('<II', header_bytes + len(body), len(samples))
+        body += coded
+        print('%-32s %7d samples %6.2f s %7d bytes' % (path, len(samples), len(samples) / args.rate, len(coded)))
+
+    image = MAGIC + struct.pack('<HHI', VERSION, len(args.clips), args.rate) + directory + body
+    if args.size is not None and len(image) > args.size:
+        print('bank is %d bytes, the partition only %d' % (len(image), args.size), file=sys.stderr)
+        return 1
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2025 MounMovies
+#
+"""Generate light_brightness_lut.h: Zigbee level (0-255) to LEDC duty.
+
+The duty resolution is the largest one the LEDC timer can reach at the
+configured PWM frequency from its slowest clock source (RC_FAST, the one that
+keeps running in light sleep), capped at --max-bits.
+"""
+
+import argparse
+import math
+import sys
+
+LEVELS = 256
+DITHER_FRAC_BITS = 4
+
+
+def duty_resolution(freq_hz, clock_hz, max_bits):
+    bits = int(math.floor(math.log2(clock_hz / freq_hz)))
+    return max(1, min(bits, max_bits))
+
+
+def luminance(level, curve):
+    x = level / (LEVELS - 1)
+    if curve == 'linear':
+        return x
+    if curve == 'gamma22':
+        return x ** 2.2
+    # CIE 1976 lightness L* = 100 * x, inverted to relative luminance Y
+    lightness = 100.0 * x
+    if lightness <= 8.0:
+        return lightness / 903.3
+    return ((lightness + 16.0) / 116.0) ** 3
+
+
+def build(bits, curve):
+    duty_max = (1 << bits) - 1
+    duties = []
+    fracs = []
+    for level in range(LEVELS):
+        exact = luminance(level, curve) * duty_max
+        duty = int(math.floor(exact))
+        frac = int(round((exact - duty) * (1 << DITHER_FRAC_BITS)))
+        if frac == 1 << DITHER_FRAC_BITS:
+            duty, frac = duty + 1, 0
+        if level > 0 and duty == 0 and frac == 0:
+            frac = 1                          # never let a non-zero level be fully dark
+        if duties and duty < duties[-1]:
+            duty, frac = duties[-1], fracs[-1]  # keep the table monotonic
+        duties.append(duty)
+        fracs.append(frac)
+    return duty_max, duties, fracs
+
+
+def emit_table(ctype, name, values, per_line=16):
+    lines = ['static const %s %s[%d] = {' % (ctype, name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join('%d' % v for v in values[i:i + per_line]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--freq', type=int, required=True, help='PWM frequency in Hz')
+    parser.add_argument('--active-low', action='store_true', help='LED driver is on while the pin is low')
+    parser.add_argument('--curve', choices=('cie', 'gamma22', 'linear'), default='cie')
+    parser.add_argument('--clock-hz', type=int, default=17500000, help='slowest LEDC source clock')
+    parser.add_argument('--max-bits', type=int, default=14)
+    parser.add_argument('-o', '--output', required=True)
+    args = parser.parse_args()
+
+    bits = duty_resolution(args.freq, args.clock_hz, args.max_bits)
+    duty_max, duties, fracs = build(bits, args.curve)
+    # Dithering is worth it only where one LSB is a visible fraction of the level
+    dither_levels = sum(1 for d in duties if d < (1 << DITHER_FRAC_BITS))
+    if args.active_low:
+        duties = [duty_max - d for d in duties]
+
+    out = [
+        '/* Generated by tools/gen_brightness_lut.py, do not edit. */',
+        '/* %d Hz, %s curve, active-%s */' % (args.freq, args.curve, 'low' if args.active_low else 'high'),
+        '#pragma once',
+        '',
+        '#include <stdint.h>',
+        '',
+        '#define LIGHT_BRIGHTNESS_DUTY_BITS      %d' % bits,
+        '#define LIGHT_BRIGHTNESS_DUTY_MAX       %d' % duty_max,
+        '#define LIGHT_BRIGHTNESS_ACTIVE_LOW     %d' % (1 if args.active_low else 0),
+        '#define LIGHT_BRIGHTNESS_DITHER_BITS    %d' % DITHER_FRAC_BITS,
+        '#define LIGHT_BRIGHTNESS_DITHER_LEVELS  %d' % dither_levels,
+        '',
+        emit_table('uint16_t', 'light_brightness_lut', duties),
+        '',
+        '/* fractional duty of the lowest levels, in 1/%d LSB */' % (1 << DITHER_FRAC_BITS),
+        emit_table('uint8_t', 'light_brightness_dither', fracs[:max(dither_levels, 1)]),
+        '',
+    ]
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(out))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
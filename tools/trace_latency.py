@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2025 MounMovies
+#
+"""Turn command latency traces into percentiles.
+
+Reads either the console output of a TraceDump command
+("TRACE,<seq>,<time_us>,<id>,<stage>,<arg>" lines, anything else is ignored)
+or TraceRead responses of cluster 0xFC00 given as hex payload lines
+(--hex; with or without the leading octet string length byte).
+
+    python3 tools/trace_latency.py monitor.log
+    python3 tools/trace_latency.py --hex responses.txt
+"""
+
+import argparse
+import struct
+import sys
+
+STAGES = {1: 'action', 2: 'dispatch', 3: 'ledc_duty', 4: 'ledc_fade', 5: 'gpio'}
+ACTUATION = {'ledc_duty', 'ledc_fade', 'gpio'}
+ENTRY = struct.Struct('<IHBB')
+
+
+def parse_text(lines):
+    for line in lines:
+        start = line.find('TRACE,')
+        if start < 0:
+            continue
+        fields = line[start:].strip().split(',')
+        if len(fields) != 6:
+            continue
+        seq, time_us, trace_id, stage, arg = (int(f) for f in fields[1:])
+        yield seq, time_us, trace_id, stage, arg
+
+
+def parse_hex(lines):
+    for line in lines:
+        data = bytes.fromhex(''.join(line.split()))
+        if not data:
+            continue
+        if len(data) >= 6 and data[0] == len(data) - 1:
+            data = data[1:]                 # octet string length
+        first, count = struct.unpack_from('<IB', data)
+        for i in range(count):
+            time_us, trace_id, stage, arg = ENTRY.unpack_from(data, 5 + i * ENTRY.size)
+            yield first + i, time_us, trace_id, stage, arg
+
+
+def latencies(entries):
+    """Per trace id: action -> dispatch, dispatch -> first actuation, action -> first actuation (us)."""
+    by_id = {}
+    seen = set()
+    for seq, time_us, trace_id, stage, _ in sorted(entries):
+        if seq in seen:
+            continue
+        seen.add(seq)
+        by_id.setdefault(trace_id, {}).setdefault(STAGES.get(stage, '?'), time_us)
+
+    spans = {'action->dispatch': [], 'dispatch->actuation': [], 'action->actuation': []}
+    for stages in by_id.values():
+        action = stages.get('action')
+        dispatch = stages.get('dispatch')
+        actuated = [t for name, t in stages.items() if name in ACTUATION]
+        actuation = min(actuated) if actuated else None
+
+        def span(a, b):
+            return (b - a) & 0xffffffff     # time_us is the low 32 bits of esp_timer
+
+        if action is not None and dispatch is not None:
+            spans['action->dispatch'].append(span(action, dispatch))
+        if dispatch is not None and actuation is not None:
+            spans['dispatch->actuation'].append(span(dispatch, actuation))
+        if action is not None and actuation is not None:
+            spans['action->actuation'].append(span(action, actuation))
+    return spans
+
+
+def percentile(values, p):
+    values = sorted(values)
+    k = (len(values) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(values) - 1)
+    return values[lo] + (values[hi] - values[lo]) * (k - lo)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', nargs='?', type=argparse.FileType('r'), default=sys.stdin)
+    parser.add_argument('--hex', action='store_true', help='input is TraceRead payloads in hex')
+    args = parser.parse_args()
+
+    lines = args.input.readlines()
+    entries = list(parse_hex(lines) if args.hex else parse_text(lines))
+    if not entries:
+        sys.exit('no trace entries found')
+
+    print('%-22s %6s %10s %10s %10s %10s' % ('span (us)', 'count', 'p50', 'p90', 'p99', 'max'))
+    for name, values in latencies(entries).items():
+        if not values:
+            print('%-22s %6d' % (name, 0))
+            continue
+        print('%-22s %6d %10.0f %10.0f %10.0f %10d' % (name, len(values), percentile(values, 50),
+                                                      percentile(values, 90), percentile(values, 99), max(values)))
+
+
+if __name__ == '__main__':
+    main()